@@ -89,6 +89,79 @@ class MPICall:
     def f08_args_separator(self):
         return self._SEPARATOR if self.f08_args else self._EMPTY_SEPARATOR
 
+    # Count and datatype of the message of the call, passed to the DLB hooks
+    # to compute its size. The Fortran hooks only get the size if the call
+    # has no send or receive buffer that may be MPI_IN_PLACE.
+
+    @property
+    def c_msg_count(self):
+        if not self._message_params:
+            return '0'
+        buf, count, _ = self._message_params
+        if buf:
+            return '%s != MPI_IN_PLACE ? %s : 0' % (buf, count)
+        return count
+
+    @property
+    def c_msg_datatype(self):
+        if not self._message_params:
+            return 'MPI_DATATYPE_NULL'
+        return self._message_params[2]
+
+    @property
+    def fc_msg_count(self):
+        if not self._message_params or self._message_params[0]:
+            return '0'
+        return '*' + self._message_params[1]
+
+    @property
+    def fc_msg_datatype(self):
+        if not self._message_params or self._message_params[0]:
+            return 'MPI_DATATYPE_NULL'
+        return 'MPI_Type_f2c(*%s)' % self._message_params[2]
+
+    @property
+    def cdesc_msg_count(self):
+        if not self._message_params or self._message_params[0]:
+            return '0'
+        return self._message_params[1]
+
+    @property
+    def cdesc_msg_datatype(self):
+        if not self._message_params or self._message_params[0]:
+            return 'MPI_DATATYPE_NULL'
+        return 'MPI_Type_f2c(%s)' % self._message_params[2]
+
+    @property
+    def _message_params(self):
+        """
+        Return the names of the (buffer, count, datatype) C parameters that
+        describe the message of the call, or None. The buffer is only set if it
+        may be MPI_IN_PLACE, in which case the count is ignored.
+        """
+        # Calls without semantic tags do not communicate, e.g., MPI_Status_set_elements
+        if self.tags == 'MPI_SEMANTIC_UNKNOWN':
+            return None
+
+        param_types = {}
+        for param in self.c_params.split(self._SEPARATOR):
+            m = re.match(r'(.*?)\s*\b(\w+)$', param.strip())
+            if m:
+                param_types[m.group(2)] = m.group(1)
+
+        def is_message(count, datatype):
+            return (param_types.get(count) in ('int', 'MPI_Count')
+                    and param_types.get(datatype) == 'MPI_Datatype')
+
+        if is_message('count', 'datatype'):
+            return (None, 'count', 'datatype')
+        # The send arguments of a scatter are only significant at the root
+        if 'MPI_SEMANTIC_SCATTER' in self.tags and is_message('recvcount', 'recvtype'):
+            return ('recvbuf', 'recvcount', 'recvtype')
+        if is_message('sendcount', 'sendtype'):
+            return ('sendbuf', 'sendcount', 'sendtype')
+        return None
+
     def _drop_const_modifier(self, signature, variables):
         # Split the signature into parameters
         parameter_list = signature.split(self._SEPARATOR)
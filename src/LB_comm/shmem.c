@@ -1,5 +1,5 @@
 /*********************************************************************************/
-/*  Copyright 2009-2021 Barcelona Supercomputing Center                          */
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
 /*                                                                               */
 /*  This file is part of the DLB library.                                        */
 /*                                                                               */
@@ -23,6 +23,8 @@
 
 #include "LB_comm/shmem.h"
 
+#include "apis/dlb_errors.h"
+#include "support/dlb_common.h"
 #include "support/debug.h"
 
 #include <unistd.h>
@@ -36,8 +38,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <limits.h>
 #include <string.h>
 #include <pthread.h>
+#include <stdint.h>
 
 #ifndef _POSIX_THREAD_PROCESS_SHARED
 #error This system does not support process shared mutexes
@@ -52,6 +56,77 @@
 
 #define SHMEM_TIMEOUT_SECONDS 10
 
+/* Process-private shared memories, attached by name */
+typedef struct PrivateShmem {
+    char                filename[SHM_NAME_LENGTH];
+    char                *addr;
+    size_t              size;
+    int                 nattached;
+    struct PrivateShmem *next;
+} private_shmem_t;
+
+static bool use_private_shmem = false;
+static private_shmem_t *private_shmems = NULL;
+static pthread_mutex_t private_shmems_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static char* private_shmem_attach(const char *filename, size_t size) {
+    char *addr;
+    pthread_mutex_lock(&private_shmems_mutex);
+    {
+        private_shmem_t *private_shmem = private_shmems;
+        while (private_shmem != NULL && strcmp(private_shmem->filename, filename) != 0) {
+            private_shmem = private_shmem->next;
+        }
+        if (private_shmem == NULL) {
+            /* Anonymous mappings are zero-initialized, like a new shm object */
+            addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (addr == MAP_FAILED) {
+                fatal("mmap error: %s",  strerror(errno));
+            }
+            private_shmem = malloc(sizeof(private_shmem_t));
+            *private_shmem = (const private_shmem_t) {
+                .addr = addr,
+                .size = size,
+                .nattached = 1,
+                .next = private_shmems,
+            };
+            snprintf(private_shmem->filename, SHM_NAME_LENGTH, "%s", filename);
+            private_shmems = private_shmem;
+        } else {
+            fatal_cond(private_shmem->size != size,
+                    "Private shared memory %s attached with a different size", filename);
+            addr = private_shmem->addr;
+            ++private_shmem->nattached;
+        }
+    }
+    pthread_mutex_unlock(&private_shmems_mutex);
+    return addr;
+}
+
+static void private_shmem_detach(const char *filename) {
+    pthread_mutex_lock(&private_shmems_mutex);
+    {
+        private_shmem_t **prev_next = &private_shmems;
+        while (*prev_next != NULL && strcmp((*prev_next)->filename, filename) != 0) {
+            prev_next = &(*prev_next)->next;
+        }
+        private_shmem_t *private_shmem = *prev_next;
+        if (private_shmem != NULL && --private_shmem->nattached == 0) {
+            if (munmap(private_shmem->addr, private_shmem->size) != 0) {
+                fatal("munmap error: %s", strerror(errno));
+            }
+            *prev_next = private_shmem->next;
+            free(private_shmem);
+        }
+    }
+    pthread_mutex_unlock(&private_shmems_mutex);
+}
+
+void shmem_set_private(bool enable) {
+    use_private_shmem = enable;
+}
+
 static bool shmem_consistency_check_pids(pid_t *pidlist, pid_t pid,
         void (*cleanup_fn)(void*,int), void *shdata) {
     bool registered = false;
@@ -150,21 +225,27 @@ shmem_handler_t* shmem_init(void **shdata, const shmem_props_t *shmem_props) {
     int shmem_color = shmem_props->color;
     get_shmem_filename(handler->shm_filename, shmem_module, shmem_key, shmem_color);
 
-    /* Obtain a file descriptor for the shmem */
-    int fd = shm_open(handler->shm_filename, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
-    if (fd == -1) {
-        fatal("shm_open error: %s", strerror(errno));
-    }
+    handler->is_private = use_private_shmem;
+    if (handler->is_private) {
+        handler->shm_addr = private_shmem_attach(handler->shm_filename, handler->shm_size);
+    } else {
+        /* Obtain a file descriptor for the shmem */
+        int fd = shm_open(handler->shm_filename, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+        if (fd == -1) {
+            fatal("shm_open error: %s", strerror(errno));
+        }
 
-    /* Truncate the regular file to a precise size */
-    if (ftruncate(fd, handler->shm_size) == -1) {
-        fatal("ftruncate error: %s", strerror(errno));
-    }
+        /* Truncate the regular file to a precise size */
+        if (ftruncate(fd, handler->shm_size) == -1) {
+            fatal("ftruncate error: %s", strerror(errno));
+        }
 
-    /* Map shared memory object */
-    handler->shm_addr = mmap(NULL, handler->shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-    if (handler->shm_addr == MAP_FAILED) {
-        fatal("mmap error: %s",  strerror(errno));
+        /* Map shared memory object */
+        handler->shm_addr = mmap(NULL, handler->shm_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+        if (handler->shm_addr == MAP_FAILED) {
+            fatal("mmap error: %s",  strerror(errno));
+        }
     }
 
     /* Set the address for both structs */
@@ -241,6 +322,13 @@ void shmem_finalize(shmem_handler_t* handler, bool (*is_empty_fn)(void)) {
      * the shared memory in this precise moment causing an invalid access to
      * the mutex. */
 
+    /* Private shmems are unmapped once no handler is attached */
+    if (handler->is_private) {
+        private_shmem_detach(handler->shm_filename);
+        free(handler);
+        return;
+    }
+
     /* All processes must unmap shmem */
     if (munmap(handler->shm_addr, handler->shm_size) != 0) {
         fatal("munmap error: %s", strerror(errno));
@@ -348,15 +436,236 @@ bool shmem_exists(const char *shmem_module, const char *shmem_key) {
 }
 
 void shmem_destroy(const char *shmem_module, const char *shmem_key) {
-    char shm_filename[SHM_NAME_LENGTH*2];
-    if (shmem_key && shmem_key[0] != '\0') {
-        snprintf(shm_filename, SHM_NAME_LENGTH*2, "/dev/shm/DLB_%s_%s", shmem_module, shmem_key);
-    } else {
-        snprintf(shm_filename, SHM_NAME_LENGTH*2, "/dev/shm/DLB_%s_%d", shmem_module, getuid());
-    }
+    /* shm_unlink expects the shmem name, not the /dev/shm path */
+    char shm_filename[SHM_NAME_LENGTH];
+    get_shmem_filename(shm_filename, shmem_module, shmem_key, 0);
     shm_unlink(shm_filename);
 }
 
+
+/*********************************************************************************/
+/*  Snapshot                                                                     */
+/*********************************************************************************/
+
+/* Snapshot file layout:
+ *   snapshot_header_t
+ *   nsegments x { snapshot_segment_t, raw shmem contents (shsync + shdata) }
+ */
+
+static const char snapshot_magic[8] = "DLBSNAP";
+enum { SNAPSHOT_VERSION = 1 };
+enum { SNAPSHOT_LOCK_TIMEOUT_NS = 100000000L };
+
+typedef struct {
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    nsegments;
+    uint64_t    shsync_size;
+    int64_t     timestamp;
+} snapshot_header_t;
+
+typedef struct {
+    char        name[SHM_NAME_LENGTH];
+    uint64_t    size;
+} snapshot_segment_t;
+
+/* Copy a whole shared memory file into 'out'. The shmem lock is taken, if
+ * possible, so that the copy is consistent. */
+static int snapshot_segment(FILE *out, const char *dir, const char *name) {
+
+    char path[PATH_MAX];
+    int not_truncated_len = snprintf(path, PATH_MAX, "%s/%s", dir, name);
+    if (not_truncated_len >= PATH_MAX) return DLB_ERR_UNKNOWN;
+
+    int fd = open(path, O_RDWR);
+    if (fd == -1) return DLB_ERR_NOENT;
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) == -1 || (size_t)statbuf.st_size < shmem_shsync__size()) {
+        close(fd);
+        return DLB_ERR_NOENT;
+    }
+    size_t size = statbuf.st_size;
+
+    char *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return DLB_ERR_NOENT;
+
+    /* Lock only initialized shmems, and do not wait forever for a crashed owner */
+    shmem_sync_t *shsync = (shmem_sync_t*)addr;
+    bool locked = false;
+    if (shsync->initialized) {
+        struct timespec timeout;
+        get_time_real(&timeout);
+        add_time(timeout, (struct timespec){.tv_nsec = SNAPSHOT_LOCK_TIMEOUT_NS}, &timeout);
+        locked = pthread_mutex_timedlock(&shsync->shmem_mutex, &timeout) == 0;
+        if (!locked) {
+            warning("Cannot lock shared memory %s, snapshot may be inconsistent", name);
+        }
+    }
+
+    snapshot_segment_t segment = { .size = size };
+    snprintf(segment.name, SHM_NAME_LENGTH, "%s", name);
+    int error = fwrite(&segment, sizeof(segment), 1, out) == 1
+        && fwrite(addr, size, 1, out) == 1 ? DLB_SUCCESS : DLB_ERR_UNKNOWN;
+
+    if (locked) {
+        pthread_mutex_unlock(&shsync->shmem_mutex);
+    }
+    munmap(addr, size);
+
+    return error;
+}
+
+/* Write a snapshot of every DLB shared memory of the current user into
+ * 'filename'. Returns DLB_ERR_NOENT if there is no shared memory to save. */
+DLB_EXPORT_SYMBOL
+int shmem_snapshot__save(const char *filename) {
+
+    const char dir[] = "/dev/shm";
+    DIR *dp = opendir(dir);
+    if (dp == NULL) return DLB_ERR_NOSHMEM;
+
+    FILE *out = fopen(filename, "w");
+    if (out == NULL) {
+        closedir(dp);
+        return DLB_ERR_PERM;
+    }
+
+    snapshot_header_t header = {
+        .version = SNAPSHOT_VERSION,
+        .shsync_size = shmem_shsync__size(),
+        .timestamp = get_time_in_ns(),
+    };
+    memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    int error = fwrite(&header, sizeof(header), 1, out) == 1 ? DLB_SUCCESS : DLB_ERR_UNKNOWN;
+
+    struct dirent *entry;
+    while (error == DLB_SUCCESS && (entry = readdir(dp)) != NULL) {
+        struct stat statbuf;
+        if (strncmp(entry->d_name, "DLB_", 4) == 0
+                && fstatat(dirfd(dp), entry->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) == 0
+                && S_ISREG(statbuf.st_mode)
+                && statbuf.st_uid == getuid()) {
+            int local_error = snapshot_segment(out, dir, entry->d_name);
+            if (local_error == DLB_SUCCESS) {
+                ++header.nsegments;
+            } else if (local_error != DLB_ERR_NOENT) {
+                error = local_error;
+            }
+        }
+    }
+    closedir(dp);
+
+    /* Rewrite header with the final number of segments */
+    if (error == DLB_SUCCESS) {
+        if (fseek(out, 0, SEEK_SET) != 0
+                || fwrite(&header, sizeof(header), 1, out) != 1) {
+            error = DLB_ERR_UNKNOWN;
+        }
+    }
+
+    if (fclose(out) != 0 && error == DLB_SUCCESS) {
+        error = DLB_ERR_UNKNOWN;
+    }
+
+    if (error == DLB_SUCCESS && header.nsegments == 0) {
+        error = DLB_ERR_NOENT;
+    }
+
+    return error;
+}
+
+/* Write a snapshot of the shared memory attached through 'handler' alone into
+ * 'filename'. The caller must hold the shmem lock. */
+int shmem_snapshot__save_handler(const shmem_handler_t *handler, const char *filename) {
+
+    if (handler->is_private) return DLB_ERR_NOSHMEM;
+
+    FILE *out = fopen(filename, "w");
+    if (out == NULL) return DLB_ERR_PERM;
+
+    snapshot_header_t header = {
+        .version = SNAPSHOT_VERSION,
+        .nsegments = 1,
+        .shsync_size = shmem_shsync__size(),
+        .timestamp = get_time_in_ns(),
+    };
+    memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+
+    /* Segment names do not contain the leading '/' of shm_open */
+    snapshot_segment_t segment = { .size = handler->shm_size };
+    snprintf(segment.name, SHM_NAME_LENGTH, "%s", handler->shm_filename + 1);
+
+    int error = fwrite(&header, sizeof(header), 1, out) == 1
+        && fwrite(&segment, sizeof(segment), 1, out) == 1
+        && fwrite(handler->shm_addr, handler->shm_size, 1, out) == 1
+        ? DLB_SUCCESS : DLB_ERR_UNKNOWN;
+
+    if (fclose(out) != 0 && error == DLB_SUCCESS) {
+        error = DLB_ERR_UNKNOWN;
+    }
+
+    return error;
+}
+
+/* Look for the first segment of module 'shmem_module' in the snapshot file and
+ * return a malloc'ed copy of its shdata (the shsync header is skipped) */
+DLB_EXPORT_SYMBOL
+int shmem_snapshot__load(const char *filename, const char *shmem_module,
+        void **shdata, size_t *size) {
+
+    FILE *in = fopen(filename, "r");
+    if (in == NULL) return DLB_ERR_NOENT;
+
+    snapshot_header_t header;
+    if (fread(&header, sizeof(header), 1, in) != 1
+            || memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0
+            || header.version != SNAPSHOT_VERSION) {
+        fclose(in);
+        return DLB_ERR_NOCOMP;
+    }
+
+    /* Segment names are "DLB_<module>_<key>" */
+    char prefix[SHM_NAME_LENGTH];
+    snprintf(prefix, SHM_NAME_LENGTH, "DLB_%s_", shmem_module);
+    size_t prefix_len = strlen(prefix);
+
+    int error = DLB_ERR_NOENT;
+    for (uint32_t i = 0; i < header.nsegments; ++i) {
+        snapshot_segment_t segment;
+        if (fread(&segment, sizeof(segment), 1, in) != 1
+                || segment.size < header.shsync_size) {
+            error = DLB_ERR_NOCOMP;
+            break;
+        }
+        segment.name[SHM_NAME_LENGTH-1] = '\0';
+        if (strncmp(segment.name, prefix, prefix_len) == 0) {
+            size_t shdata_size = segment.size - header.shsync_size;
+            void *data = malloc(shdata_size);
+            if (data == NULL) {
+                error = DLB_ERR_NOMEM;
+            } else if (fseek(in, header.shsync_size, SEEK_CUR) != 0
+                    || fread(data, shdata_size, 1, in) != 1) {
+                free(data);
+                error = DLB_ERR_NOCOMP;
+            } else {
+                *shdata = data;
+                *size = shdata_size;
+                error = DLB_SUCCESS;
+            }
+            break;
+        }
+        if (fseek(in, segment.size, SEEK_CUR) != 0) {
+            error = DLB_ERR_NOCOMP;
+            break;
+        }
+    }
+
+    fclose(in);
+    return error;
+}
+
 int shmem_shsync__version(void) {
     return SHMEM_SYNC_VERSION;
 }
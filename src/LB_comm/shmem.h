@@ -1,5 +1,5 @@
 /*********************************************************************************/
-/*  Copyright 2009-2021 Barcelona Supercomputing Center                          */
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
 /*                                                                               */
 /*  This file is part of the DLB library.                                        */
 /*                                                                               */
@@ -51,6 +51,7 @@ typedef struct {
     char            shm_filename[SHM_NAME_LENGTH];
     char            *shm_addr;
     shmem_sync_t    *shsync;
+    bool            is_private;
 } shmem_handler_t;
 
 typedef struct {
@@ -66,6 +67,9 @@ enum { SHMEM_VERSION_IGNORE = 0 };
 
 shmem_handler_t* shmem_init(void **shdata, const shmem_props_t *shmem_props);
 void shmem_finalize(shmem_handler_t *handler, bool (*is_empty_fn)(void));
+/* Shared memories initialized while private is set are anonymous mappings only
+ * visible to this process, e.g., for simulations, instead of /dev/shm objects */
+void shmem_set_private(bool enable);
 void shmem_lock(shmem_handler_t *handler);
 void shmem_unlock(shmem_handler_t *handler);
 void shmem_lock_maintenance( shmem_handler_t* handler );
@@ -75,6 +79,10 @@ void shmem_release_busy( shmem_handler_t* handler );
 char *get_shm_filename(shmem_handler_t *handler);
 bool shmem_exists(const char *shmem_module, const char *shmem_key);
 void shmem_destroy(const char *shmem_module, const char *shmem_key);
+int shmem_snapshot__save(const char *filename);
+int shmem_snapshot__save_handler(const shmem_handler_t *handler, const char *filename);
+int shmem_snapshot__load(const char *filename, const char *shmem_module,
+        void **shdata, size_t *size);
 int shmem_shsync__version(void);
 size_t shmem_shsync__size(void);
 
@@ -26,6 +26,7 @@
 #include "LB_core/DLB_kernel.h"
 #include "LB_comm/shmem.h"
 #include "apis/dlb_errors.h"
+#include "apis/dlb_types.h"
 #include "support/atomic.h"
 #include "support/debug.h"
 #include "support/mask_utils.h"
@@ -34,16 +35,54 @@
 #include "talp/talp.h"
 
 #include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+enum { BARRIER_MAX_DOMAINS = 8 };
+enum { BARRIER_SPIN_ITERATIONS = 1000 };
+enum { BARRIER_MAX_PENDING = 16 };
+enum { BARRIER_MIN_PROCESSES = 64 };
 
 typedef struct barrier_flags {
     bool initialized:1;
     bool lewi:1;
+    bool futex:1;
 } barrier_flags_t;
 
+/* Arrival counter of the participants of one NUMA domain */
+typedef struct DLB_ALIGN_CACHE barrier_domain_t {
+    atomic_uint count;
+    unsigned int participants;
+} barrier_domain_t;
+
+/* Attached process, so that its domain is known when it is detached or
+ * cleaned up after a crash, and its arrival statistics */
+typedef struct barrier_process_t {
+    pid_t pid;
+    int domain;
+    unsigned int nattached;
+    unsigned int nlast;
+    atomic_int_least64_t arrival;
+} barrier_process_t;
+
+typedef struct barrier_stats_t {
+    atomic_int_least64_t release_time;
+    atomic_uint narrivals;      /* pthread barrier: arrivals since last attach or detach */
+    unsigned int nepisodes;
+    int64_t skew_min;
+    int64_t skew_max;
+    int64_t skew_sum;
+    int64_t skew_last;
+    atomic_uint wait_histogram[DLB_BARRIER_STATS_HIST_SIZE];
+} barrier_stats_t;
+
 typedef struct barrier_t {
     char name[BARRIER_NAME_MAX];
     barrier_flags_t flags;
@@ -52,22 +91,192 @@ typedef struct barrier_t {
     atomic_uint count;
     pthread_barrier_t barrier;
     pthread_rwlock_t rwlock;
+    /* Futex barrier: participants arrive at their domain counter, the last
+     * one of each domain arrives at the root counter, and the last one of
+     * the root increments 'epoch', which is also the futex word */
+    unsigned int ndomains;
+    atomic_uint root_count;
+    atomic_uint nwaiters;
+    atomic_uint DLB_ALIGN_CACHE epoch;
+    barrier_domain_t domains[BARRIER_MAX_DOMAINS];
+    barrier_stats_t stats;
 } barrier_t;
 
+/* Per process, index of the process in the attached processes of each
+ * barrier, or -1 if not attached */
+typedef struct local_barrier_t {
+    int process_index;
+} local_barrier_t;
+
+/* Per thread, arrivals of split-phase barriers not yet waited for */
+typedef struct pending_arrival_t {
+    const barrier_t *barrier;
+    unsigned int epoch;
+    int64_t arrival;
+} pending_arrival_t;
+
+/* The attached processes of each barrier are stored after the barriers, in a
+ * table of max_processes entries per barrier: one per CPU of the node, with a
+ * minimum for oversubscribed nodes */
 typedef struct {
     bool initialized;
     int max_barriers;   // capacity
     int num_barriers;   // size, although detached may be counted
+    int max_processes;  // attached processes per barrier
     barrier_t barriers[];
 } shdata_t;
 
-enum { SHMEM_BARRIER_VERSION = 7 };
+enum { SHMEM_BARRIER_VERSION = 11 };
 enum { SHMEM_TIMEOUT_SECONDS = 1 };
 
 static int max_barriers = 0;
 static shmem_handler_t *shm_handler = NULL;
 static shdata_t *shdata = NULL;
 static const char *shmem_name = "barrier";
+static local_barrier_t *local_barriers = NULL;
+static unsigned int num_online_cpus = 0;
+static __thread pending_arrival_t pending_arrivals[BARRIER_MAX_PENDING];
+
+static inline int get_max_processes(void) {
+    return max_int(mu_get_system_size(), BARRIER_MIN_PROCESSES);
+}
+
+static inline barrier_process_t* get_processes(shdata_t *data, const barrier_t *barrier) {
+    barrier_process_t *table = (barrier_process_t*)&data->barriers[data->max_barriers];
+    return &table[(barrier - data->barriers) * data->max_processes];
+}
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+/* NUMA domain of the calling process, from its process mask if set */
+static int get_process_domain(void) {
+    int cpuid = -1;
+    if (thread_spd != NULL && CPU_COUNT(&thread_spd->process_mask) > 0) {
+        cpuid = mu_get_first_cpu(&thread_spd->process_mask);
+    }
+    if (cpuid < 0) {
+        cpuid = sched_getcpu();
+    }
+    int node_id = mu_get_node_id(cpuid);
+    return node_id > 0 ? node_id % BARRIER_MAX_DOMAINS : 0;
+}
+
+static void update_ndomains(barrier_t *barrier) {
+    unsigned int ndomains = 0;
+    for (int i = 0; i < BARRIER_MAX_DOMAINS; ++i) {
+        if (barrier->domains[i].participants > 0) {
+            ++ndomains;
+        }
+    }
+    barrier->ndomains = ndomains;
+}
+
+static inline long futex_wait(atomic_uint *addr, unsigned int val) {
+    /* Not FUTEX_PRIVATE_FLAG, the futex word is in a process-shared memory */
+    return syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+}
+
+static inline long futex_wake(atomic_uint *addr) {
+    return syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/* Complete the current episode and wake up the participants waiting for it */
+static void futex_barrier_release(barrier_t *barrier, unsigned int epoch) {
+    DLB_ATOMIC_ADD_RLX(&barrier->ntimes, 1);
+    DLB_ATOMIC_ST(&barrier->epoch, epoch + 1);
+    if (DLB_ATOMIC_LD(&barrier->nwaiters) > 0) {
+        futex_wake(&barrier->epoch);
+    }
+}
+
+/* Find the attached process entry of pid, or a free one if pid is not found
+ * and allocate is set */
+static barrier_process_t* find_process(shdata_t *data, barrier_t *barrier,
+        pid_t pid, bool allocate) {
+    barrier_process_t *processes = get_processes(data, barrier);
+    barrier_process_t *free_process = NULL;
+    for (int i = 0; i < data->max_processes; ++i) {
+        barrier_process_t *process = &processes[i];
+        if (process->pid == pid) {
+            return process;
+        } else if (process->pid == 0 && free_process == NULL) {
+            free_process = process;
+        }
+    }
+    return allocate ? free_process : NULL;
+}
+
+/* The remaining participants of the current episode may have already arrived
+ * after a participant of 'domain' has left, complete it if so */
+static void complete_episode(barrier_t *barrier, barrier_domain_t *domain) {
+    if (domain->count > 0 && domain->count == domain->participants) {
+        domain->count = 0;
+        ++barrier->root_count;
+    }
+    update_ndomains(barrier);
+    if (barrier->root_count > 0 && barrier->root_count == barrier->ndomains) {
+        barrier->root_count = 0;
+        DLB_ATOMIC_ST_RLX(&barrier->stats.release_time, get_time_in_ns());
+        futex_barrier_release(barrier, barrier->epoch);
+    }
+}
+
+/* Add or remove the calling process as participant of the barrier, and of
+ * its domain if the barrier is a futex barrier.
+ * The caller must hold the barrier wrlock */
+static int attach_participant(barrier_t *barrier) {
+    pid_t pid = getpid();
+    barrier_process_t *process = find_process(shdata, barrier, pid, true);
+    if (process == NULL) {
+        warning("Barrier %s has reached the maximum number of processes (%d)",
+                barrier->name, shdata->max_processes);
+        return DLB_ERR_NOMEM;
+    }
+    if (process->nattached++ == 0) {
+        process->pid = pid;
+        process->domain = barrier->flags.futex ? get_process_domain() : 0;
+    }
+
+    /* The local entry may belong to a previous barrier in the same spot */
+    local_barrier_t *local = &local_barriers[barrier - shdata->barriers];
+    local->process_index = process - get_processes(shdata, barrier);
+
+    barrier->stats.narrivals = 0;
+    if (barrier->flags.futex) {
+        ++barrier->domains[process->domain].participants;
+        update_ndomains(barrier);
+    }
+    return DLB_SUCCESS;
+}
+
+static void detach_participant(barrier_t *barrier) {
+    local_barrier_t *local = &local_barriers[barrier - shdata->barriers];
+    barrier_process_t *process = &get_processes(shdata, barrier)[local->process_index];
+    int domain_id = process->domain;
+    if (--process->nattached == 0) {
+        /* Free the entry, including its statistics, for other processes */
+        *process = (const barrier_process_t){};
+        *local = (const local_barrier_t){.process_index = -1};
+    }
+    barrier->stats.narrivals = 0;
+    if (!barrier->flags.futex) return;
+
+    barrier_domain_t *domain = &barrier->domains[domain_id];
+    if (domain->participants > 0) {
+        --domain->participants;
+    }
+
+    /* With split-phase barriers, the remaining participants may have already
+     * arrived at the current episode */
+    complete_episode(barrier, domain);
+}
+
 
 static void cleanup_shmem(void *shdata_ptr, int pid) {
 
@@ -76,9 +285,24 @@ static void cleanup_shmem(void *shdata_ptr, int pid) {
     int num_barriers = shared_data->num_barriers;
     for (int i = 0; i < num_barriers; i++) {
         barrier_t *barrier = &shared_data->barriers[i];
-        if (--barrier->participants == 0) {
-            *barrier = (const barrier_t){};
-        } else {
+        barrier_process_t *process = barrier->flags.initialized
+            ? find_process(shared_data, barrier, pid, false) : NULL;
+        if (process != NULL) {
+            /* Remove every attachment of the dead process from its domain,
+             * and its statistics */
+            unsigned int nattached = process->nattached;
+            int domain_id = process->domain;
+            *process = (const barrier_process_t){};
+            barrier->participants -= nattached;
+            if (barrier->participants == 0) {
+                *barrier = (const barrier_t){};
+            } else if (barrier->flags.futex) {
+                barrier_domain_t *domain = &barrier->domains[domain_id];
+                domain->participants -= nattached;
+                complete_episode(barrier, domain);
+            }
+        }
+        if (barrier->participants > 0) {
             shmem_empty = false;
         }
     }
@@ -92,6 +316,11 @@ static void cleanup_shmem(void *shdata_ptr, int pid) {
 static void open_shmem(const char *shmem_key, int shmem_size_multiplier) {
 
     max_barriers = mu_get_system_size() * shmem_size_multiplier;
+    local_barriers = malloc(max_barriers * sizeof(local_barrier_t));
+    for (int i = 0; i < max_barriers; ++i) {
+        local_barriers[i] = (const local_barrier_t){.process_index = -1};
+    }
+    num_online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
     shm_handler = shmem_init((void**)&shdata,
             &(const shmem_props_t) {
                 .size = shmem_barrier__size(),
@@ -116,6 +345,7 @@ int shmem_barrier__init(const char *shmem_key, int shmem_size_multiplier) {
             shdata->initialized = true;
             shdata->num_barriers = 0;
             shdata->max_barriers = max_barriers;
+            shdata->max_processes = get_max_processes();
         } else {
             if (shdata->max_barriers != max_barriers) {
                 error = DLB_ERR_INIT;
@@ -158,8 +388,13 @@ void shmem_barrier__finalize(const char *shmem_key, int shmem_size_multiplier) {
 
     verbose(VB_BARRIER, "Finalizing Barrier Module");
 
+    /* Arrivals of this thread cannot be waited for anymore */
+    memset(pending_arrivals, 0, sizeof(pending_arrivals));
+
     shmem_finalize(shm_handler, NULL /* do not check if empty */);
     shm_handler = NULL;
+    free(local_barriers);
+    local_barriers = NULL;
 }
 
 int shmem_barrier_ext__finalize(void) {
@@ -172,6 +407,8 @@ int shmem_barrier_ext__finalize(void) {
     shmem_finalize(shm_handler, NULL /* do not check if empty */);
     shm_handler = NULL;
     shdata = NULL;
+    free(local_barriers);
+    local_barriers = NULL;
 
     return DLB_SUCCESS;
 }
@@ -200,6 +437,11 @@ int shmem_barrier__get_num_barriers(void) {
     return real_num_barriers;
 }
 
+/* Position of the barrier in the shared memory, from 0 to max_barriers-1 */
+int shmem_barrier__get_index(const barrier_t *barrier) {
+    return barrier - shdata->barriers;
+}
+
 /* Given a barrier_name, find whether the barrier is registered in the shared
  * memory. Note that this function is not thread-safe */
 barrier_t* shmem_barrier__find(const char *barrier_name) {
@@ -222,8 +464,10 @@ barrier_t* shmem_barrier__find(const char *barrier_name) {
 /* Register and attach process to barrier.
  *   barrier_name: barrier name
  *   lewi: whether this barrier does lewi
+ *   futex: whether a new barrier uses the futex implementation, ignored if
+ *          the barrier already exists
  */
-barrier_t* shmem_barrier__register(const char *barrier_name, bool lewi) {
+barrier_t* shmem_barrier__register(const char *barrier_name, bool lewi, bool futex) {
     if (shm_handler == NULL) return NULL;
     if (barrier_name == NULL) return NULL;
 
@@ -264,6 +508,8 @@ barrier_t* shmem_barrier__register(const char *barrier_name, bool lewi) {
         if (barrier == NULL && empty_spot != NULL) {
             barrier = empty_spot;
             *barrier = (const barrier_t){};
+            memset(get_processes(shdata, barrier), 0,
+                    sizeof(barrier_process_t) * shdata->max_processes);
 
             pthread_rwlockattr_t rwlockattr;
             pthread_rwlockattr_init(&rwlockattr);
@@ -277,9 +523,11 @@ barrier_t* shmem_barrier__register(const char *barrier_name, bool lewi) {
                 barrier->flags = (const barrier_flags_t) {
                     .initialized = true,
                     .lewi = lewi,
+                    .futex = futex,
                 };
                 barrier->participants = 1;
                 participants = 1;
+                attach_participant(barrier);
                 snprintf(barrier->name, BARRIER_NAME_MAX, "%s", barrier_name);
                 pthread_barrierattr_t barrierattr;
                 pthread_barrierattr_init(&barrierattr);
@@ -296,17 +544,24 @@ barrier_t* shmem_barrier__register(const char *barrier_name, bool lewi) {
             get_time_real(&timeout);
             timeout.tv_sec += SHMEM_TIMEOUT_SECONDS;
             int timedwrlock_error = pthread_rwlock_timedwrlock(&barrier->rwlock, &timeout);
-            if (likely(timedwrlock_error == 0)) {
+            if (likely(timedwrlock_error == 0)
+                    && attach_participant(barrier) != DLB_SUCCESS) {
+                /* No room for this process */
+                pthread_rwlock_unlock(&barrier->rwlock);
+                barrier = NULL;
+            } else if (likely(timedwrlock_error == 0)) {
                 /* Update participants */
                 participants = ++barrier->participants;
 
-                /* Create new barrier with the number of participants updated */
-                pthread_barrier_destroy(&barrier->barrier);
-                pthread_barrierattr_t attr;
-                pthread_barrierattr_init(&attr);
-                pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
-                pthread_barrier_init(&barrier->barrier, &attr, barrier->participants);
-                pthread_barrierattr_destroy(&attr);
+                if (!barrier->flags.futex) {
+                    /* Create new barrier with the number of participants updated */
+                    pthread_barrier_destroy(&barrier->barrier);
+                    pthread_barrierattr_t attr;
+                    pthread_barrierattr_init(&attr);
+                    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+                    pthread_barrier_init(&barrier->barrier, &attr, barrier->participants);
+                    pthread_barrierattr_destroy(&attr);
+                }
 
                 pthread_rwlock_unlock(&barrier->rwlock);
 
@@ -351,16 +606,23 @@ int shmem_barrier__attach(barrier_t *barrier) {
             return DLB_ERR_PERM;
         }
 
+        if (attach_participant(barrier) != DLB_SUCCESS) {
+            pthread_rwlock_unlock(&barrier->rwlock);
+            return DLB_ERR_NOMEM;
+        }
+
         /* Update participants */
         participants = ++barrier->participants;
 
-        /* Create new barrier with the number of participants updated */
-        pthread_barrier_destroy(&barrier->barrier);
-        pthread_barrierattr_t attr;
-        pthread_barrierattr_init(&attr);
-        pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
-        pthread_barrier_init(&barrier->barrier, &attr, barrier->participants);
-        pthread_barrierattr_destroy(&attr);
+        if (!barrier->flags.futex) {
+            /* Create new barrier with the number of participants updated */
+            pthread_barrier_destroy(&barrier->barrier);
+            pthread_barrierattr_t attr;
+            pthread_barrierattr_init(&attr);
+            pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+            pthread_barrier_init(&barrier->barrier, &attr, barrier->participants);
+            pthread_barrierattr_destroy(&attr);
+        }
 
 #ifdef DEBUG_VERSION
         count = barrier->count;
@@ -376,8 +638,10 @@ int shmem_barrier__attach(barrier_t *barrier) {
 }
 
 /* The detach function may remove the barrier if 'participants' reaches 0 and
- * compete with a barrier creation. This function needs to acquire both locks. */
-int shmem_barrier__detach(barrier_t *barrier) {
+ * compete with a barrier creation. This function needs to acquire both locks.
+ * If 'npending' is provided, the participant is only detached if it is zero,
+ * checked under the barrier wrlock so that no arrival can take place meanwhile */
+static int detach_barrier(barrier_t *barrier, const atomic_int *npending) {
     if (barrier == NULL) return DLB_ERR_UNKNOWN;
     if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
 
@@ -395,12 +659,19 @@ int shmem_barrier__detach(barrier_t *barrier) {
         if (likely(timedwrlock_error == 0)) {
 
             if (!barrier->flags.initialized
-                    || barrier->participants == 0) {
+                    || barrier->participants == 0
+                    || local_barriers[barrier - shdata->barriers].process_index < 0) {
                 pthread_rwlock_unlock(&barrier->rwlock);
                 shmem_unlock(shm_handler);
                 return DLB_ERR_PERM;
             }
 
+            if (npending != NULL && DLB_ATOMIC_LD(npending) > 0) {
+                pthread_rwlock_unlock(&barrier->rwlock);
+                shmem_unlock(shm_handler);
+                return DLB_ERR_REQST;
+            }
+
 #ifdef DEBUG_VERSION
             count = barrier->count;
 #endif
@@ -409,14 +680,18 @@ int shmem_barrier__detach(barrier_t *barrier) {
             /* Update participants */
             participants = --barrier->participants;
 
+            detach_participant(barrier);
+
             if (participants > 0) {
-                /* Create new barrier with the number of participants updated */
-                pthread_barrier_destroy(&barrier->barrier);
-                pthread_barrierattr_t attr;
-                pthread_barrierattr_init(&attr);
-                pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
-                pthread_barrier_init(&barrier->barrier, &attr, barrier->participants);
-                pthread_barrierattr_destroy(&attr);
+                if (!barrier->flags.futex) {
+                    /* Create new barrier with the number of participants updated */
+                    pthread_barrier_destroy(&barrier->barrier);
+                    pthread_barrierattr_t attr;
+                    pthread_barrierattr_init(&attr);
+                    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+                    pthread_barrier_init(&barrier->barrier, &attr, barrier->participants);
+                    pthread_barrierattr_destroy(&attr);
+                }
 
                 pthread_rwlock_unlock(&barrier->rwlock);
             } else {
@@ -454,6 +729,154 @@ int shmem_barrier__detach(barrier_t *barrier) {
     return participants;
 }
 
+int shmem_barrier__detach(barrier_t *barrier) {
+    return detach_barrier(barrier, NULL);
+}
+
+/* Detach only if no thread has arrived and not left yet, according to the
+ * caller's counter 'npending', which must be increased before arriving */
+int shmem_barrier__detach_if_not_pending(barrier_t *barrier, const atomic_int *npending) {
+    return detach_barrier(barrier, npending);
+}
+
+/* Statistics: arrival of the calling process at the current episode */
+static int64_t stats_arrive(barrier_t *barrier) {
+    int64_t now = get_time_in_ns();
+    int index = local_barriers[barrier - shdata->barriers].process_index;
+    if (index >= 0) {
+        DLB_ATOMIC_ST_RLX(&get_processes(shdata, barrier)[index].arrival, now);
+    }
+    return now;
+}
+
+/* Statistics: the last participant completes the episode. The participants of
+ * this episode are those that arrived after the previous release. */
+static void stats_release(barrier_t *barrier, int64_t last_arrival) {
+    barrier_stats_t *stats = &barrier->stats;
+    barrier_process_t *processes = get_processes(shdata, barrier);
+    int64_t previous_release = DLB_ATOMIC_LD_RLX(&stats->release_time);
+    int64_t first_arrival = last_arrival;
+    for (int i = 0; i < shdata->max_processes; ++i) {
+        barrier_process_t *process = &processes[i];
+        if (process->pid == 0) continue;
+        int64_t arrival = DLB_ATOMIC_LD_RLX(&process->arrival);
+        if (arrival > 0 && arrival >= previous_release && arrival < first_arrival) {
+            first_arrival = arrival;
+        }
+    }
+
+    int64_t skew = last_arrival - first_arrival;
+    if (stats->nepisodes == 0 || skew < stats->skew_min) {
+        stats->skew_min = skew;
+    }
+    if (skew > stats->skew_max) {
+        stats->skew_max = skew;
+    }
+    stats->skew_sum += skew;
+    stats->skew_last = skew;
+    ++stats->nepisodes;
+
+    int index = local_barriers[barrier - shdata->barriers].process_index;
+    if (index >= 0) {
+        ++processes[index].nlast;
+    }
+
+    DLB_ATOMIC_ST_RLX(&stats->release_time, get_time_in_ns());
+}
+
+/* Statistics: the calling process leaves the episode it arrived at */
+static void stats_wait(barrier_t *barrier, int64_t arrival) {
+    int64_t wait_us = (DLB_ATOMIC_LD_RLX(&barrier->stats.release_time) - arrival) / 1000;
+    int bucket = 0;
+    while (wait_us > 0 && bucket < DLB_BARRIER_STATS_HIST_SIZE-1) {
+        wait_us >>= 1;
+        ++bucket;
+    }
+    DLB_ATOMIC_ADD_RLX(&barrier->stats.wait_histogram[bucket], 1);
+}
+
+/* Sense-reversing barrier with a two-level combining tree: one counter per
+ * NUMA domain and one root counter for the last arrival of each domain.
+ * Each episode is identified by 'epoch', so that waiting for an episode
+ * can be decoupled from arriving at it. The caller must hold the rdlock,
+ * which only excludes attach and detach operations. */
+static bool futex_barrier_arrive(barrier_t *barrier, pending_arrival_t *arrival) {
+
+    *arrival = (const pending_arrival_t) {
+        .barrier = barrier,
+        .epoch = DLB_ATOMIC_LD_ACQ(&barrier->epoch),
+        .arrival = stats_arrive(barrier),
+    };
+    int process_index = local_barriers[barrier - shdata->barriers].process_index;
+    int domain_id = get_processes(shdata, barrier)[process_index].domain;
+    barrier_domain_t *domain = &barrier->domains[domain_id];
+
+    bool last_in = false;
+    if (DLB_ATOMIC_ADD_FETCH(&domain->count, 1) == domain->participants) {
+        DLB_ATOMIC_ST_RLX(&domain->count, 0);
+        if (DLB_ATOMIC_ADD_FETCH(&barrier->root_count, 1) == barrier->ndomains) {
+            DLB_ATOMIC_ST_RLX(&barrier->root_count, 0);
+            last_in = true;
+        }
+    }
+
+    verbose(VB_BARRIER, "Entering barrier %s%s", barrier->name, last_in ? " (last)" : "");
+
+    if (last_in) {
+        stats_release(barrier, arrival->arrival);
+        futex_barrier_release(barrier, arrival->epoch);
+    }
+
+    return last_in;
+}
+
+/* Wait until the episode 'epoch' is completed. Waiters spin for a short while
+ * and then block on 'epoch' as a futex; only then the wait acts as a blocking
+ * call and CPUs may be lent. */
+static void futex_barrier_wait(barrier_t *barrier, const pending_arrival_t *arrival) {
+
+    unsigned int epoch = arrival->epoch;
+
+    // Spinning is only worth it if the node is not oversubscribed
+    if (barrier->participants <= num_online_cpus) {
+        for (int i = 0; i < BARRIER_SPIN_ITERATIONS
+                && DLB_ATOMIC_LD_ACQ(&barrier->epoch) == epoch; ++i) {
+            cpu_relax();
+        }
+    }
+
+    if (DLB_ATOMIC_LD_ACQ(&barrier->epoch) == epoch) {
+        sync_call_flags_t flags = (const sync_call_flags_t) {
+            .is_dlb_barrier = true,
+            .is_blocking = true,
+            .is_collective = true,
+            .do_lewi = barrier->flags.lewi,
+        };
+        into_sync_call(flags);
+
+        DLB_ATOMIC_ADD(&barrier->nwaiters, 1);
+        while (DLB_ATOMIC_LD_ACQ(&barrier->epoch) == epoch) {
+            futex_wait(&barrier->epoch, epoch);
+        }
+        DLB_ATOMIC_SUB(&barrier->nwaiters, 1);
+
+        out_of_sync_call(flags);
+    }
+
+    stats_wait(barrier, arrival->arrival);
+
+    verbose(VB_BARRIER, "Leaving barrier %s", barrier->name);
+}
+
+static pending_arrival_t* find_pending_arrival(const barrier_t *barrier) {
+    for (int i = 0; i < BARRIER_MAX_PENDING; ++i) {
+        if (pending_arrivals[i].barrier == barrier) {
+            return &pending_arrivals[i];
+        }
+    }
+    return NULL;
+}
+
 void shmem_barrier__barrier(barrier_t *barrier) {
     if (unlikely(shm_handler == NULL)) return;
 
@@ -465,11 +888,34 @@ void shmem_barrier__barrier(barrier_t *barrier) {
             return;
         }
 
+        if (barrier->flags.futex) {
+            /* The rdlock is not held while waiting, so that other processes
+             * may attach or detach. The caller must not detach this
+             * participant until it leaves the barrier. */
+            pending_arrival_t arrival;
+            bool last_in = futex_barrier_arrive(barrier, &arrival);
+            pthread_rwlock_unlock(&barrier->rwlock);
+            if (last_in) {
+                stats_wait(barrier, arrival.arrival);
+            } else {
+                futex_barrier_wait(barrier, &arrival);
+            }
+            return;
+        }
+
+        int64_t arrival = stats_arrive(barrier);
         unsigned int participant_number = DLB_ATOMIC_ADD_FETCH(&barrier->count, 1);
         bool last_in = participant_number == barrier->participants;
 
         verbose(VB_BARRIER, "Entering barrier %s%s", barrier->name, last_in ? " (last)" : "");
 
+        /* 'count' may be increased by the next episode before it is
+         * decreased, only a monotonic counter identifies the last arrival */
+        unsigned int arrival_number = DLB_ATOMIC_ADD_FETCH(&barrier->stats.narrivals, 1);
+        if (arrival_number % barrier->participants == 0) {
+            stats_release(barrier, arrival);
+        }
+
         if (last_in) {
             // Barrier
             pthread_barrier_wait(&barrier->barrier);
@@ -493,6 +939,8 @@ void shmem_barrier__barrier(barrier_t *barrier) {
             out_of_sync_call(flags);
         }
 
+        stats_wait(barrier, arrival);
+
         unsigned int participants_left = DLB_ATOMIC_SUB_FETCH(&barrier->count, 1);
         bool last_out = participants_left == 0;
 
@@ -508,6 +956,116 @@ void shmem_barrier__barrier(barrier_t *barrier) {
     pthread_rwlock_unlock(&barrier->rwlock);
 }
 
+/* Split-phase barrier: arrive at the current episode without blocking */
+int shmem_barrier__arrive(barrier_t *barrier) {
+    if (unlikely(shm_handler == NULL)) return DLB_ERR_NOSHMEM;
+
+    /* Only one pending arrival per thread and barrier */
+    if (find_pending_arrival(barrier) != NULL) return DLB_ERR_PERM;
+    pending_arrival_t *pending = find_pending_arrival(NULL);
+    if (pending == NULL) return DLB_ERR_NOMEM;
+
+    int error = DLB_SUCCESS;
+    pthread_rwlock_rdlock(&barrier->rwlock);
+    {
+        if (unlikely(!barrier->flags.initialized)) {
+            error = DLB_ERR_PERM;
+        } else if (!barrier->flags.futex) {
+            /* A pthread barrier cannot be split */
+            error = DLB_ERR_NOCOMP;
+        } else {
+            futex_barrier_arrive(barrier, pending);
+        }
+    }
+    pthread_rwlock_unlock(&barrier->rwlock);
+
+    return error;
+}
+
+
+
+/* Split-phase barrier: block until the episode of the previous arrival of
+ * this thread is completed. The rdlock is not held, like in the monolithic
+ * barrier, since the participant cannot detach while it has arrived. */
+int shmem_barrier__wait(barrier_t *barrier) {
+    if (unlikely(shm_handler == NULL)) return DLB_ERR_NOSHMEM;
+
+    pending_arrival_t *pending = find_pending_arrival(barrier);
+    if (pending == NULL) return DLB_ERR_PERM;
+
+    futex_barrier_wait(barrier, pending);
+    *pending = (const pending_arrival_t){};
+
+    return DLB_SUCCESS;
+}
+
+/* Split-phase barrier: check, without blocking, whether the episode of the
+ * previous arrival of this thread is completed */
+int shmem_barrier__test(barrier_t *barrier) {
+    if (unlikely(shm_handler == NULL)) return DLB_ERR_NOSHMEM;
+
+    pending_arrival_t *pending = find_pending_arrival(barrier);
+    if (pending == NULL) return DLB_ERR_PERM;
+
+    if (DLB_ATOMIC_LD_ACQ(&barrier->epoch) == pending->epoch) {
+        return DLB_NOTED;
+    }
+
+    stats_wait(barrier, pending->arrival);
+    *pending = (const pending_arrival_t){};
+
+    return DLB_SUCCESS;
+}
+
+static int cmp_processes_by_nlast(const void *elem1, const void *elem2) {
+    const barrier_process_t *process1 = elem1;
+    const barrier_process_t *process2 = elem2;
+    return (process1->nlast < process2->nlast)
+        - (process1->nlast > process2->nlast);
+}
+
+static void get_stats(shdata_t *data, const barrier_t *barrier, dlb_barrier_stats_t *stats) {
+    const barrier_stats_t *barrier_stats = &barrier->stats;
+    *stats = (const dlb_barrier_stats_t) {
+        .num_episodes = barrier_stats->nepisodes,
+        .skew_min = barrier_stats->skew_min,
+        .skew_max = barrier_stats->skew_max,
+        .skew_avg = barrier_stats->nepisodes > 0
+            ? barrier_stats->skew_sum / barrier_stats->nepisodes : 0,
+        .skew_last = barrier_stats->skew_last,
+    };
+    for (int i = 0; i < DLB_BARRIER_STATS_HIST_SIZE; ++i) {
+        stats->wait_histogram[i] = barrier_stats->wait_histogram[i];
+    }
+
+    /* Ranking of the most frequent last arrivals */
+    size_t processes_size = sizeof(barrier_process_t) * data->max_processes;
+    barrier_process_t *processes = malloc(processes_size);
+    if (processes == NULL) return;
+    memcpy(processes, get_processes(data, barrier), processes_size);
+    qsort(processes, data->max_processes, sizeof(barrier_process_t),
+            cmp_processes_by_nlast);
+    for (int i = 0; i < DLB_BARRIER_STATS_RANKING_SIZE && i < data->max_processes; ++i) {
+        if (processes[i].nlast > 0) {
+            stats->last_arrival_pid[i] = processes[i].pid;
+            stats->last_arrival_count[i] = processes[i].nlast;
+        }
+    }
+    free(processes);
+}
+
+/* Obtain the arrival statistics of the barrier, values may be slightly
+ * inconsistent if an episode is completing at the same time */
+int shmem_barrier__get_stats(const barrier_t *barrier, dlb_barrier_stats_t *stats) {
+    if (barrier == NULL || stats == NULL) return DLB_ERR_UNKNOWN;
+    if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
+    if (!barrier->flags.initialized) return DLB_ERR_PERM;
+
+    get_stats(shdata, barrier, stats);
+
+    return DLB_SUCCESS;
+}
+
 void shmem_barrier__print_info(const char *shmem_key, int shmem_size_multiplier) {
 
     /* If the shmem is not opened, obtain a temporary fd */
@@ -543,9 +1101,15 @@ void shmem_barrier__print_info(const char *shmem_key, int shmem_size_multiplier)
         if (barrier->flags.initialized) {
 
             /* Append line to buffer */
+            unsigned int count = barrier->count;
+            if (barrier->flags.futex) {
+                for (int j = 0; j < BARRIER_MAX_DOMAINS; ++j) {
+                    count += barrier->domains[j].count;
+                }
+            }
             snprintf(line, MAX_LINE_LEN,
                     "  | %14s | %12u | %12u | %12u |",
-                    barrier->name, barrier->participants, barrier->count, barrier->ntimes);
+                    barrier->name, barrier->participants, count, barrier->ntimes);
             printbuffer_append(&buffer, line);
         }
     }
@@ -556,6 +1120,42 @@ void shmem_barrier__print_info(const char *shmem_key, int shmem_size_multiplier)
               "%s", buffer.addr);
     }
     printbuffer_destroy(&buffer);
+
+    /* Arrival statistics */
+    printbuffer_init(&buffer);
+    for (int i = 0; i < num_barriers; ++i) {
+        barrier_t *barrier = &shdata_copy->barriers[i];
+        if (barrier->flags.initialized && barrier->stats.nepisodes > 0) {
+            dlb_barrier_stats_t stats;
+            get_stats(shdata_copy, barrier, &stats);
+
+            snprintf(line, MAX_LINE_LEN,
+                    "  | %14s | %12.1f | %12.1f | %12.1f | %8d (%5u) |",
+                    barrier->name, stats.skew_avg / 1e3, stats.skew_min / 1e3,
+                    stats.skew_max / 1e3, stats.last_arrival_pid[0],
+                    stats.last_arrival_count[0]);
+            printbuffer_append(&buffer, line);
+
+            /* Wait histogram, only non-empty buckets */
+            int len = snprintf(line, MAX_LINE_LEN, "  |   wait (us):");
+            for (int j = 0; j < DLB_BARRIER_STATS_HIST_SIZE && len < MAX_LINE_LEN; ++j) {
+                if (stats.wait_histogram[j] > 0) {
+                    len += snprintf(line + len, MAX_LINE_LEN - len, " %s%d:%u",
+                            j == DLB_BARRIER_STATS_HIST_SIZE-1 ? ">=" : "<",
+                            j == DLB_BARRIER_STATS_HIST_SIZE-1 ? 1 << (j-1) : 1 << j,
+                            stats.wait_histogram[j]);
+                }
+            }
+            printbuffer_append(&buffer, line);
+        }
+    }
+
+    if (buffer.addr[0] != '\0' ) {
+        info0("=== Barrier arrival skew ===\n"
+              "  |  Barrier Name  | Avg. (us)    | Min. (us)    | Max. (us)    | Most often last |\n"
+              "%s", buffer.addr);
+    }
+    printbuffer_destroy(&buffer);
     free(shdata_copy);
 }
 
@@ -570,6 +1170,7 @@ int shmem_barrier__version(void) {
 size_t shmem_barrier__size(void) {
     // max_barriers contains a value once shmem is initialized,
     // otherwise return default size
-    return sizeof(shdata_t) + sizeof(barrier_t) * (
-            max_barriers > 0 ? max_barriers : mu_get_system_size());
+    return sizeof(shdata_t)
+        + (sizeof(barrier_t) + sizeof(barrier_process_t) * get_max_processes())
+        * (max_barriers > 0 ? max_barriers : mu_get_system_size());
 }
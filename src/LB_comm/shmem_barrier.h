@@ -20,22 +20,31 @@
 #ifndef SHMEM_BARRIER_H
 #define SHMEM_BARRIER_H
 
+#include "support/atomic.h"
+
 #include <stddef.h>
 #include <stdbool.h>
 
 enum { BARRIER_NAME_MAX = 32 };
 
 typedef struct barrier_t barrier_t;
+typedef struct dlb_barrier_stats_t dlb_barrier_stats_t;
 
 int  shmem_barrier__init(const char *shmem_key, int shmem_size_multiplier);
 void shmem_barrier__finalize(const char *shmem_key, int shmem_size_multiplier);
 int  shmem_barrier__get_max_barriers(void);
 int  shmem_barrier__get_num_barriers(void);
+int  shmem_barrier__get_index(const barrier_t *barrier);
 barrier_t* shmem_barrier__find(const char *barrier_name);
-barrier_t* shmem_barrier__register(const char *barrier_name, bool lewi);
+barrier_t* shmem_barrier__register(const char *barrier_name, bool lewi, bool futex);
 int  shmem_barrier__attach(barrier_t *barrier);
 int  shmem_barrier__detach(barrier_t *barrier);
+int  shmem_barrier__detach_if_not_pending(barrier_t *barrier, const atomic_int *npending);
 void shmem_barrier__barrier(barrier_t *barrier);
+int  shmem_barrier__arrive(barrier_t *barrier);
+int  shmem_barrier__wait(barrier_t *barrier);
+int  shmem_barrier__test(barrier_t *barrier);
+int  shmem_barrier__get_stats(const barrier_t *barrier, dlb_barrier_stats_t *stats);
 
 void shmem_barrier__print_info(const char *shmem_key, int shmem_size_multiplier);
 bool shmem_barrier__exists(void);
@@ -20,6 +20,7 @@
 #include "LB_comm/shmem_cpuinfo.h"
 
 #include "LB_comm/shmem.h"
+#include "LB_comm/shmem_cpuinfo_log.h"
 #include "LB_core/spd.h"
 #include "apis/dlb_errors.h"
 #include "apis/dlb_types.h"
@@ -124,6 +125,14 @@ static inline bool is_borrowed(pid_t pid, int cpu) __attribute__((unused));
 static inline bool is_shmem_empty(void);
 
 
+/* Every operation recorded with --lewi-record is appended to the log the
+ * first time it takes the lock, so that the log keeps the order of the
+ * critical sections */
+static inline void lock_shmem(void) {
+    shmem_lock(shm_handler);
+    shmem_cpuinfo_log__append_pending();
+}
+
 static void update_shmem_timestamp(void) {
     DLB_ATOMIC_ST_REL(&shdata->timestamp_cpu_lent, get_time_in_ns());
 }
@@ -461,7 +470,7 @@ int shmem_cpuinfo__init(pid_t pid, pid_t preinit_pid, const cpu_set_t *process_m
 
     //DLB_INSTR( int idle_count = 0; )
 
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         // Initialize shared memory, if needed
         init_shmem();
@@ -498,7 +507,7 @@ int shmem_cpuinfo_ext__init(const char *shmem_key, int shmem_color) {
 int shmem_cpuinfo_ext__preinit(pid_t pid, const cpu_set_t *mask, dlb_drom_flags_t flags) {
     if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
     int error;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         // Initialize shared memory, if needed
         init_shmem();
@@ -561,7 +570,7 @@ int shmem_cpuinfo__finalize(pid_t pid, const char *shmem_key, int shmem_color) {
     //DLB_INSTR( int idle_count = 0; )
 
     // Lock the shmem to deregister CPUs
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         deregister_process(pid);
         //DLB_INSTR( if (is_idle(cpuid)) idle_count++; )
@@ -591,7 +600,7 @@ int shmem_cpuinfo_ext__postfinalize(pid_t pid) {
     if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
 
     int error = DLB_SUCCESS;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         deregister_process(pid);
     }
@@ -691,7 +700,7 @@ int shmem_cpuinfo__lend_cpu(pid_t pid, int cpuid, array_cpuinfo_task_t *restrict
 
     //DLB_INSTR( int idle_count = 0; )
 
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         lend_cpu(pid, cpuid, tasks);
 
@@ -730,7 +739,7 @@ int shmem_cpuinfo__lend_cpu_mask(pid_t pid, const cpu_set_t *restrict mask,
 
     //DLB_INSTR( int idle_count = 0; )
 
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         for (int cpuid = mu_get_first_cpu(mask);
                 cpuid >= 0 && cpuid < node_size;
@@ -842,7 +851,7 @@ static int reclaim_core(pid_t pid, cpuid_t core_id,
 
 int shmem_cpuinfo__reclaim_all(pid_t pid, array_cpuinfo_task_t *restrict tasks) {
     int error = DLB_NOUPDT;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         cpu_set_t cpus_to_reclaim;
         CPU_OR(&cpus_to_reclaim, &shdata->free_cpus, &shdata->occupied_cores);
@@ -888,7 +897,7 @@ int shmem_cpuinfo__reclaim_cpu(pid_t pid, int cpuid, array_cpuinfo_task_t *restr
 
     //DLB_INSTR( int idle_count = 0; )
 
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         error = reclaim_cpu(pid, cpuid, tasks);
 
@@ -946,7 +955,7 @@ int shmem_cpuinfo__reclaim_cpus(pid_t pid, int ncpus, array_cpuinfo_task_t *rest
     //cpu_set_t recovered_cpus;
     //CPU_ZERO(&recovered_cpus);
 
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         int num_cores = mu_get_num_cores();
         for (int core_id = 0; core_id < num_cores && ncpus>0; ++core_id) {
@@ -991,7 +1000,7 @@ int shmem_cpuinfo__reclaim_cpus(pid_t pid, int ncpus, array_cpuinfo_task_t *rest
 int shmem_cpuinfo__reclaim_cpu_mask(pid_t pid, const cpu_set_t *restrict mask,
         array_cpuinfo_task_t *restrict tasks) {
     int error = DLB_NOUPDT;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         cpu_set_t cpus_to_reclaim;
         CPU_OR(&cpus_to_reclaim, &shdata->free_cpus, &shdata->occupied_cores);
@@ -1195,7 +1204,7 @@ int shmem_cpuinfo__acquire_cpu(pid_t pid, int cpuid, array_cpuinfo_task_t *restr
     if (cpuid >= node_size) return DLB_ERR_PERM;
 
     int error;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         error = acquire_cpu(pid, cpuid, tasks);
     }
@@ -1216,7 +1225,7 @@ int shmem_cpuinfo__acquire_from_cpu_subset(
         array_cpuinfo_task_t *restrict tasks) {
 
     int error;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         error = acquire_cpus_in_array_cpuid_t(pid, array_cpuid, NULL, tasks);
     }
@@ -1286,7 +1295,7 @@ int shmem_cpuinfo__acquire_ncpus_from_cpu_subset(
     static array_cpuid_t non_owned = {};
 
     int error = DLB_NOUPDT;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         /* Lazy init first time, clear afterwards */
         if (likely(owned_idle.items != NULL)) {
@@ -1581,7 +1590,7 @@ int shmem_cpuinfo__borrow_cpu(pid_t pid, int cpuid, array_cpuinfo_task_t *restri
     if (cpuid >= node_size) return DLB_ERR_PERM;
 
     int error;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         error = borrow_cpu(pid, cpuid, tasks);
     }
@@ -1601,7 +1610,7 @@ int shmem_cpuinfo__borrow_from_cpu_subset(
         array_cpuinfo_task_t *restrict tasks) {
 
     int error;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         error = borrow_cpus_in_array_cpuid_t(pid, array_cpuid, NULL, tasks);
     }
@@ -1647,7 +1656,7 @@ int shmem_cpuinfo__borrow_ncpus_from_cpu_subset(
     }
 
     int error = DLB_NOUPDT;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         /* Skip borrow if no CPUs in the free_cpus mask */
         if (CPU_COUNT(&shdata->free_cpus) == 0) {
@@ -1724,7 +1733,7 @@ static int return_cpu(pid_t pid, int cpuid, array_cpuinfo_task_t *restrict tasks
 int shmem_cpuinfo__return_all(pid_t pid, array_cpuinfo_task_t *restrict tasks) {
 
     int error = DLB_NOUPDT;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         for (int cpuid = mu_get_first_cpu(&shdata->occupied_cores);
                 cpuid >= 0;
@@ -1754,7 +1763,7 @@ int shmem_cpuinfo__return_cpu(pid_t pid, int cpuid, array_cpuinfo_task_t *restri
     if (cpuid >= node_size) return DLB_ERR_PERM;
 
     int error;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         if (unlikely(shdata->node_info[cpuid].guest != pid)) {
             error = DLB_ERR_PERM;
@@ -1770,7 +1779,7 @@ int shmem_cpuinfo__return_cpu_mask(pid_t pid, const cpu_set_t *mask,
         array_cpuinfo_task_t *restrict tasks) {
 
     int error = DLB_NOUPDT;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         cpu_set_t cpus_to_return;
         CPU_AND(&cpus_to_return, mask, &shdata->occupied_cores);
@@ -1812,7 +1821,7 @@ static inline void shmem_cpuinfo__return_async(pid_t pid, cpuid_t cpuid) {
  * This function resolves returned CPUs, fixes guest and add a new request */
 void shmem_cpuinfo__return_async_cpu(pid_t pid, cpuid_t cpuid) {
 
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         shmem_cpuinfo__return_async(pid, cpuid);
     }
@@ -1824,7 +1833,7 @@ void shmem_cpuinfo__return_async_cpu(pid_t pid, cpuid_t cpuid) {
  * This function resolves returned CPUs, fixes guest and add a new request */
 void shmem_cpuinfo__return_async_cpu_mask(pid_t pid, const cpu_set_t *mask) {
 
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         for (int cpuid = mu_get_first_cpu(mask);
                 cpuid >= 0 && cpuid < node_size;
@@ -1845,7 +1854,7 @@ void shmem_cpuinfo__return_async_cpu_mask(pid_t pid, const cpu_set_t *mask) {
  * This function deregisters pid, disabling or lending CPUs as needed */
 int shmem_cpuinfo__deregister(pid_t pid, array_cpuinfo_task_t *restrict tasks) {
     int error = DLB_SUCCESS;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         // Remove any request before acquiring and lending
         if (shdata->flags.queues_enabled) {
@@ -1897,7 +1906,7 @@ int shmem_cpuinfo__deregister(pid_t pid, array_cpuinfo_task_t *restrict tasks) {
  * This function resets the initial status of pid: acquire owned, lend guested */
 int shmem_cpuinfo__reset(pid_t pid, array_cpuinfo_task_t *restrict tasks) {
     int error = DLB_SUCCESS;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         // Remove any request before acquiring and lending
         if (shdata->flags.queues_enabled) {
@@ -1941,7 +1950,7 @@ int shmem_cpuinfo__update_max_parallelism(pid_t pid, unsigned int max,
     unsigned int owned_count = 0;
     unsigned int guested_count = 0;
     SMALL_ARRAY(cpuid_t, guested_cpus, node_size);
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         for (cpuid_t cpuid=0; cpuid<node_size; ++cpuid) {
             const cpuinfo_t *cpuinfo = &shdata->node_info[cpuid];
@@ -1994,7 +2003,7 @@ void shmem_cpuinfo__update_ownership(pid_t pid, const cpu_set_t *restrict proces
 
     verbose(VB_SHMEM, "Updating ownership: %s", mu_to_str(process_mask));
 
-    shmem_lock(shm_handler);
+    lock_shmem();
 
     int cpuid;
     for (cpuid=0; cpuid<node_size; ++cpuid) {
@@ -2172,7 +2181,7 @@ int shmem_cpuinfo__check_cpu_availability(pid_t pid, int cpuid) {
         error = DLB_SUCCESS;
     } else if (cpuinfo->guest == NOBODY ) {
         /* Assign new guest if the CPU is empty */
-        shmem_lock(shm_handler);
+        lock_shmem();
         {
             if (cpuinfo->guest == NOBODY) {
                 cpuinfo->guest = pid;
@@ -2208,7 +2217,7 @@ void shmem_cpuinfo__enable_request_queues(void) {
 
 void shmem_cpuinfo__remove_requests(pid_t pid) {
     if (shm_handler == NULL) return;
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         /* Remove any previous request for the specific pid */
         if (shdata->flags.queues_enabled) {
@@ -2245,7 +2254,7 @@ void shmem_cpuinfo__print_info(const char *shmem_key, int shmem_color, int colum
 
     /* Make a full copy of the shared memory */
     shdata_t *shdata_copy = malloc(sizeof(shdata_t) + sizeof(cpuinfo_t)*node_size);
-    shmem_lock(shm_handler);
+    lock_shmem();
     {
         memcpy(shdata_copy, shdata, sizeof(shdata_t) + sizeof(cpuinfo_t)*node_size);
     }
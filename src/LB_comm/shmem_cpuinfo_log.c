@@ -0,0 +1,405 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#include "LB_comm/shmem_cpuinfo_log.h"
+
+#include "LB_comm/shmem.h"
+#include "apis/dlb_errors.h"
+#include "support/debug.h"
+#include "support/dlb_common.h"
+#include "support/mask_utils.h"
+#include "support/mytime.h"
+#include "support/types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+
+/* The log is a ring buffer of the LeWI operations requested by the processes
+ * attached to the cpuinfo shared memory of the same key and color. Each entry
+ * is appended when its operation enters the cpuinfo critical section, so that
+ * the order of the log is the order in which shmem_cpuinfo applied them. */
+typedef struct {
+    bool                initialized;
+    int                 capacity;
+    int                 nprocs;         /* attached (sub)processes */
+    int64_t             head;           /* total number of recorded entries */
+    cpuinfo_log_entry_t entries[];
+} shdata_t;
+
+enum { SHMEM_CPUINFO_LOG_VERSION = 3 };
+enum { LOG_ENTRIES_PER_CPU = 64 };
+
+static shmem_handler_t *shm_handler = NULL;
+static shdata_t *shdata = NULL;
+static int capacity = 0;
+static const char *shmem_name = "cpuinfolog";
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static int subprocesses_attached = 0;
+
+/* Operation requested by this thread and not yet appended */
+static __thread bool pending = false;
+static __thread cpuinfo_log_entry_t pending_entry;
+
+
+/*********************************************************************************/
+/*  Init / Finalize                                                              */
+/*********************************************************************************/
+
+static void open_shmem(const char *shmem_key, int shmem_color, int shmem_size_multiplier) {
+    pthread_mutex_lock(&mutex);
+    {
+        if (shm_handler == NULL) {
+            capacity = mu_get_system_size() * LOG_ENTRIES_PER_CPU * shmem_size_multiplier;
+            shm_handler = shmem_init((void**)&shdata,
+                    &(const shmem_props_t) {
+                        .size = shmem_cpuinfo_log__size(),
+                        .name = shmem_name,
+                        .key = shmem_key,
+                        .color = shmem_color,
+                        .version = SHMEM_CPUINFO_LOG_VERSION,
+                    });
+            subprocesses_attached = 1;
+        } else {
+            ++subprocesses_attached;
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+/* The shared memory is removed when the last process detaches, dump the log
+ * first so that the whole run, including finalize, can be replayed */
+static void dump_log(void) {
+    char filename[SHM_NAME_LENGTH + 16];
+    snprintf(filename, sizeof(filename), "%s.dlbsnap", get_shm_filename(shm_handler) + 1);
+    int error = shmem_snapshot__save_handler(shm_handler, filename);
+    if (error == DLB_SUCCESS) {
+        info0("LeWI operations log saved into %s", filename);
+    } else if (error != DLB_ERR_NOSHMEM) {
+        warning("Cannot save the LeWI operations log into %s", filename);
+    }
+}
+
+static void close_shmem(void) {
+    pthread_mutex_lock(&mutex);
+    {
+        shmem_lock(shm_handler);
+        {
+            if (--shdata->nprocs == 0) {
+                dump_log();
+            }
+        }
+        shmem_unlock(shm_handler);
+
+        if (--subprocesses_attached == 0) {
+            shmem_finalize(shm_handler, NULL);
+            shm_handler = NULL;
+            shdata = NULL;
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+int shmem_cpuinfo_log__init(const char *shmem_key, int shmem_color, int shmem_size_multiplier) {
+    int error = DLB_SUCCESS;
+
+    if (shmem_size_multiplier <= 0) return DLB_ERR_INIT;
+
+    // Shared memory creation
+    open_shmem(shmem_key, shmem_color, shmem_size_multiplier);
+
+    shmem_lock(shm_handler);
+    {
+        // Initialize some values if this is the 1st process attached to the shmem
+        if (!shdata->initialized) {
+            shdata->initialized = true;
+            shdata->capacity = capacity;
+            shdata->head = 0;
+        } else if (shdata->capacity != capacity) {
+            error = DLB_ERR_INIT;
+        }
+        if (error == DLB_SUCCESS) {
+            ++shdata->nprocs;
+        }
+    }
+    shmem_unlock(shm_handler);
+
+    if (error == DLB_ERR_INIT) {
+        warning("Cannot attach to the CPU transitions log because existing size differ."
+                " Existing capacity: %d, expected: %d."
+                " Check for DLB_ARGS consistency among processes or clean up shared memory.",
+                shdata->capacity, capacity);
+        pthread_mutex_lock(&mutex);
+        if (--subprocesses_attached == 0) {
+            shmem_finalize(shm_handler, NULL);
+            shm_handler = NULL;
+            shdata = NULL;
+        }
+        pthread_mutex_unlock(&mutex);
+    }
+
+    return error;
+}
+
+int shmem_cpuinfo_log__finalize(void) {
+    if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
+
+    close_shmem();
+
+    return DLB_SUCCESS;
+}
+
+
+/*********************************************************************************/
+/*  Record                                                                       */
+/*********************************************************************************/
+
+static void append_entry(const cpuinfo_log_entry_t *entry) {
+    shmem_lock(shm_handler);
+    {
+        shdata->entries[shdata->head % shdata->capacity] = *entry;
+        shdata->entries[shdata->head % shdata->capacity].timestamp = get_time_in_ns();
+        ++shdata->head;
+    }
+    shmem_unlock(shm_handler);
+}
+
+/* Register the operation that this thread is about to request. It is appended
+ * by shmem_cpuinfo_log__append_pending, once the operation holds the cpuinfo lock, or
+ * by shmem_cpuinfo_log__record_end if the operation does not take it */
+void shmem_cpuinfo_log__record(cpuinfo_log_op_t op, pid_t pid, int arg,
+        const cpu_set_t *mask) {
+    if (shm_handler == NULL) return;
+
+    pending_entry = (const cpuinfo_log_entry_t) {
+        .pid = pid,
+        .arg = arg,
+        .op = op,
+    };
+    if (mask != NULL) {
+        memcpy(&pending_entry.mask, mask, sizeof(cpu_set_t));
+    }
+    pending = true;
+}
+
+void shmem_cpuinfo_log__record_end(void) {
+    shmem_cpuinfo_log__append_pending();
+}
+
+/* Called with the cpuinfo lock held */
+void shmem_cpuinfo_log__append_pending(void) {
+    if (pending) {
+        pending = false;
+        if (shm_handler != NULL) {
+            append_entry(&pending_entry);
+        }
+    }
+}
+
+
+/*********************************************************************************/
+/*  Read                                                                         */
+/*********************************************************************************/
+
+/* Obtain the recorded entries, in chronological order, from a copy of the log
+ * shared memory (e.g., from a dlb_shm snapshot). 'entries' must be freed by the
+ * caller. 'dropped' is the number of entries overwritten in the ring buffer. */
+DLB_EXPORT_SYMBOL
+int shmem_cpuinfo_log__parse(const void *log_shdata, size_t size,
+        cpuinfo_log_entry_t **entries, int *nelems, int64_t *dropped) {
+
+    const shdata_t *log = log_shdata;
+    if (size < sizeof(shdata_t)
+            || !log->initialized
+            || log->capacity <= 0
+            || log->head < 0
+            || size < sizeof(shdata_t) + sizeof(cpuinfo_log_entry_t) * log->capacity) {
+        return DLB_ERR_NOCOMP;
+    }
+
+    int num_entries = log->head < log->capacity ? log->head : log->capacity;
+    int64_t first = log->head - num_entries;
+
+    cpuinfo_log_entry_t *list = malloc(sizeof(cpuinfo_log_entry_t) * max_int(num_entries, 1));
+    if (list == NULL) return DLB_ERR_NOMEM;
+
+    for (int i = 0; i < num_entries; ++i) {
+        list[i] = log->entries[(first + i) % log->capacity];
+    }
+
+    *entries = list;
+    *nelems = num_entries;
+    *dropped = first;
+
+    return DLB_SUCCESS;
+}
+
+/* Load the log from a snapshot file created with shmem_snapshot__save.
+ * 'entries' must be freed by the caller. */
+DLB_EXPORT_SYMBOL
+int shmem_cpuinfo_log__load(const char *filename,
+        cpuinfo_log_entry_t **entries, int *nelems) {
+
+    void *log_shdata;
+    size_t size;
+    int error = shmem_snapshot__load(filename, shmem_name, &log_shdata, &size);
+    if (error != DLB_SUCCESS) return error;
+
+    int64_t dropped;
+    error = shmem_cpuinfo_log__parse(log_shdata, size, entries, nelems, &dropped);
+    free(log_shdata);
+
+    if (error == DLB_SUCCESS && dropped > 0) {
+        warning("The first %"PRId64" LeWI operations were overwritten in the log,"
+                " the replayed state may be inaccurate."
+                " Consider increasing --shm-size-multiplier.", dropped);
+    }
+
+    return error;
+}
+
+DLB_EXPORT_SYMBOL
+const char* shmem_cpuinfo_log__op_str(cpuinfo_log_op_t op) {
+    switch(op) {
+        case CPUINFO_LOG_INIT:                      return "init";
+        case CPUINFO_LOG_FINALIZE:                  return "finalize";
+        case CPUINFO_LOG_ENABLE:                    return "enable";
+        case CPUINFO_LOG_DISABLE:                   return "disable";
+        case CPUINFO_LOG_SET_MAX_PARALLELISM:       return "set_max_parallelism";
+        case CPUINFO_LOG_UNSET_MAX_PARALLELISM:     return "unset_max_parallelism";
+        case CPUINFO_LOG_INTO_BLOCKING_CALL:        return "into_blocking_call";
+        case CPUINFO_LOG_OUT_OF_BLOCKING_CALL:      return "out_of_blocking_call";
+        case CPUINFO_LOG_LEND:                      return "lend";
+        case CPUINFO_LOG_LEND_CPU:                  return "lend_cpu";
+        case CPUINFO_LOG_LEND_CPUS:                 return "lend_cpus";
+        case CPUINFO_LOG_LEND_CPU_MASK:             return "lend_cpu_mask";
+        case CPUINFO_LOG_RECLAIM:                   return "reclaim";
+        case CPUINFO_LOG_RECLAIM_CPU:               return "reclaim_cpu";
+        case CPUINFO_LOG_RECLAIM_CPUS:              return "reclaim_cpus";
+        case CPUINFO_LOG_RECLAIM_CPU_MASK:          return "reclaim_cpu_mask";
+        case CPUINFO_LOG_ACQUIRE_CPU:               return "acquire_cpu";
+        case CPUINFO_LOG_ACQUIRE_CPUS:              return "acquire_cpus";
+        case CPUINFO_LOG_ACQUIRE_CPU_MASK:          return "acquire_cpu_mask";
+        case CPUINFO_LOG_ACQUIRE_CPUS_IN_MASK:      return "acquire_cpus_in_mask";
+        case CPUINFO_LOG_BORROW:                    return "borrow";
+        case CPUINFO_LOG_BORROW_CPU:                return "borrow_cpu";
+        case CPUINFO_LOG_BORROW_CPUS:               return "borrow_cpus";
+        case CPUINFO_LOG_BORROW_CPU_MASK:           return "borrow_cpu_mask";
+        case CPUINFO_LOG_BORROW_CPUS_IN_MASK:       return "borrow_cpus_in_mask";
+        case CPUINFO_LOG_RETURN:                    return "return";
+        case CPUINFO_LOG_RETURN_CPU:                return "return_cpu";
+        case CPUINFO_LOG_RETURN_CPU_MASK:           return "return_cpu_mask";
+        case CPUINFO_LOG_CHECK_CPU_AVAILABILITY:    return "check_cpu_availability";
+        case CPUINFO_LOG_UPDATE_OWNERSHIP:          return "update_ownership";
+    }
+    return "unknown";
+}
+
+/* Print the operations recorded until the timestamp 'until', if positive */
+DLB_EXPORT_SYMBOL
+void shmem_cpuinfo_log__print(const cpuinfo_log_entry_t *entries, int nelems,
+        int64_t until) {
+
+    if (nelems == 0) return;
+
+    /* Initialize buffer */
+    print_buffer_t buffer;
+    printbuffer_init(&buffer);
+
+    /* Set up line buffer */
+    enum { MAX_LINE_LEN = 512 };
+    enum { MAX_ARGS_LEN = 384 };
+    char line[MAX_LINE_LEN];
+
+    int64_t t0 = entries[0].timestamp;
+    for (int i = 0; i < nelems; ++i) {
+        const cpuinfo_log_entry_t *entry = &entries[i];
+        if (until > 0 && entry->timestamp > until) break;
+
+        /* Print only the arguments that the operation takes */
+        char args[MAX_ARGS_LEN] = "";
+        switch(entry->op) {
+            case CPUINFO_LOG_SET_MAX_PARALLELISM:
+            case CPUINFO_LOG_LEND_CPU:
+            case CPUINFO_LOG_LEND_CPUS:
+            case CPUINFO_LOG_RECLAIM_CPU:
+            case CPUINFO_LOG_RECLAIM_CPUS:
+            case CPUINFO_LOG_ACQUIRE_CPU:
+            case CPUINFO_LOG_ACQUIRE_CPUS:
+            case CPUINFO_LOG_BORROW_CPU:
+            case CPUINFO_LOG_BORROW_CPUS:
+            case CPUINFO_LOG_RETURN_CPU:
+            case CPUINFO_LOG_CHECK_CPU_AVAILABILITY:
+                snprintf(args, MAX_ARGS_LEN, "%d", entry->arg);
+                break;
+            case CPUINFO_LOG_INIT:
+            case CPUINFO_LOG_INTO_BLOCKING_CALL:
+            case CPUINFO_LOG_OUT_OF_BLOCKING_CALL:
+            case CPUINFO_LOG_LEND_CPU_MASK:
+            case CPUINFO_LOG_RECLAIM_CPU_MASK:
+            case CPUINFO_LOG_ACQUIRE_CPU_MASK:
+            case CPUINFO_LOG_BORROW_CPU_MASK:
+            case CPUINFO_LOG_RETURN_CPU_MASK:
+            case CPUINFO_LOG_UPDATE_OWNERSHIP:
+                snprintf(args, MAX_ARGS_LEN, "%s", mu_to_str(&entry->mask));
+                break;
+            case CPUINFO_LOG_ACQUIRE_CPUS_IN_MASK:
+            case CPUINFO_LOG_BORROW_CPUS_IN_MASK:
+                snprintf(args, MAX_ARGS_LEN, "%d, %s", entry->arg, mu_to_str(&entry->mask));
+                break;
+            default:
+                break;
+        }
+
+        snprintf(line, MAX_LINE_LEN, "  %12.6f  %8d  %s(%s)",
+                (entry->timestamp - t0) / 1e9, entry->pid,
+                shmem_cpuinfo_log__op_str(entry->op), args);
+        printbuffer_append(&buffer, line);
+    }
+
+    info0("=== LeWI operations ===\n"
+          "  %12s  %8s  %s\n"
+          "%s", "Time (s)", "PID", "Operation", buffer.addr);
+
+    printbuffer_destroy(&buffer);
+}
+
+
+/*********************************************************************************/
+/*  Misc                                                                         */
+/*********************************************************************************/
+
+bool shmem_cpuinfo_log__exists(void) {
+    return shm_handler != NULL;
+}
+
+int shmem_cpuinfo_log__version(void) {
+    return SHMEM_CPUINFO_LOG_VERSION;
+}
+
+size_t shmem_cpuinfo_log__size(void) {
+    // capacity contains a value once shmem is initialized,
+    // otherwise return default size
+    return sizeof(shdata_t) + sizeof(cpuinfo_log_entry_t) * (
+            capacity > 0 ? capacity : mu_get_system_size() * LOG_ENTRIES_PER_CPU);
+}
@@ -0,0 +1,99 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifndef SHMEM_CPUINFO_LOG_H
+#define SHMEM_CPUINFO_LOG_H
+
+#include <sched.h>
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Operations of the LeWI policy API, see balance_policy_t */
+typedef enum __attribute__((__packed__)) {
+    CPUINFO_LOG_INIT,
+    CPUINFO_LOG_FINALIZE,
+    CPUINFO_LOG_ENABLE,
+    CPUINFO_LOG_DISABLE,
+    CPUINFO_LOG_SET_MAX_PARALLELISM,
+    CPUINFO_LOG_UNSET_MAX_PARALLELISM,
+    CPUINFO_LOG_INTO_BLOCKING_CALL,
+    CPUINFO_LOG_OUT_OF_BLOCKING_CALL,
+    CPUINFO_LOG_LEND,
+    CPUINFO_LOG_LEND_CPU,
+    CPUINFO_LOG_LEND_CPUS,
+    CPUINFO_LOG_LEND_CPU_MASK,
+    CPUINFO_LOG_RECLAIM,
+    CPUINFO_LOG_RECLAIM_CPU,
+    CPUINFO_LOG_RECLAIM_CPUS,
+    CPUINFO_LOG_RECLAIM_CPU_MASK,
+    CPUINFO_LOG_ACQUIRE_CPU,
+    CPUINFO_LOG_ACQUIRE_CPUS,
+    CPUINFO_LOG_ACQUIRE_CPU_MASK,
+    CPUINFO_LOG_ACQUIRE_CPUS_IN_MASK,
+    CPUINFO_LOG_BORROW,
+    CPUINFO_LOG_BORROW_CPU,
+    CPUINFO_LOG_BORROW_CPUS,
+    CPUINFO_LOG_BORROW_CPU_MASK,
+    CPUINFO_LOG_BORROW_CPUS_IN_MASK,
+    CPUINFO_LOG_RETURN,
+    CPUINFO_LOG_RETURN_CPU,
+    CPUINFO_LOG_RETURN_CPU_MASK,
+    CPUINFO_LOG_CHECK_CPU_AVAILABILITY,
+    CPUINFO_LOG_UPDATE_OWNERSHIP,
+} cpuinfo_log_op_t;
+
+/* A LeWI operation requested by a process, with its arguments, so that it can
+ * be replayed through any policy. The resulting CPU states are not recorded */
+typedef struct cpuinfo_log_entry_t {
+    int64_t             timestamp;
+    pid_t               pid;
+    int32_t             arg;        /* cpuid, ncpus or max, if the op takes it */
+    cpuinfo_log_op_t    op;
+    cpu_set_t           mask;       /* process, thread or CPU mask, if the op takes it */
+} cpuinfo_log_entry_t;
+
+/* Init / Finalize */
+int shmem_cpuinfo_log__init(const char *shmem_key, int shmem_color, int shmem_size_multiplier);
+int shmem_cpuinfo_log__finalize(void);
+
+/* Record: the operation is registered before calling the policy, appended
+ * inside the shmem_cpuinfo critical section, and record_end must follow the
+ * policy call */
+void shmem_cpuinfo_log__record(cpuinfo_log_op_t op, pid_t pid, int arg,
+        const cpu_set_t *mask);
+void shmem_cpuinfo_log__record_end(void);
+void shmem_cpuinfo_log__append_pending(void);
+
+/* Read */
+int shmem_cpuinfo_log__parse(const void *shdata, size_t size,
+        cpuinfo_log_entry_t **entries, int *nelems, int64_t *dropped);
+int shmem_cpuinfo_log__load(const char *filename,
+        cpuinfo_log_entry_t **entries, int *nelems);
+const char* shmem_cpuinfo_log__op_str(cpuinfo_log_op_t op);
+void shmem_cpuinfo_log__print(const cpuinfo_log_entry_t *entries, int nelems,
+        int64_t until);
+
+/* Misc */
+bool shmem_cpuinfo_log__exists(void);
+int shmem_cpuinfo_log__version(void);
+size_t shmem_cpuinfo_log__size(void);
+
+#endif /* SHMEM_CPUINFO_LOG_H */
@@ -53,6 +53,15 @@ typedef struct DLB_ALIGN_CACHE pinfo_t {
     cpu_set_t future_process_mask;
     cpu_set_t stolen_cpus;
     unsigned int active_cpus;
+    // DROM migration fields:
+    bool staged;                        // A DROM mask is being applied in steps
+    cpu_set_t staged_process_mask;      // Final mask of the staged DROM request
+    unsigned int migration_budget;      // CPUs that may be moved per interval, 0 = all
+    int64_t migration_interval;         // Length of the budget interval (ns)
+    int64_t migration_interval_start;   // Start of the current budget interval (ns)
+    unsigned int migration_interval_cpus; // CPUs moved during the current interval
+    unsigned int migrated_cpus;         // Total CPUs moved by DROM
+    unsigned int migrated_cpus_cross_numa; // Total CPUs moved to a different NUMA node
     // Cpu Usage fields:
     double cpu_usage;
     double cpu_avg_usage;
@@ -78,7 +87,7 @@ typedef struct {
     pinfo_t process_info[];
 } shdata_t;
 
-enum { SHMEM_PROCINFO_VERSION = 10 };
+enum { SHMEM_PROCINFO_VERSION = 12 };
 
 static shmem_handler_t *shm_handler = NULL;
 static shdata_t *shdata = NULL;
@@ -93,6 +102,8 @@ static pinfo_t *my_pinfo = NULL;
 
 static int set_new_mask(pinfo_t *process, const cpu_set_t *mask, bool sync,
         bool return_stolen, cpu_set_t *free_cpu_mask);
+static int set_staged_mask(pinfo_t *process, const cpu_set_t *mask, bool return_stolen);
+static int issue_staged_step(pinfo_t *process, bool return_stolen);
 static void close_shmem(void);
 
 static pid_t get_parent_pid(pid_t pid) {
@@ -877,8 +888,14 @@ static int shmem_procinfo__setprocessmask_self(const cpu_set_t *mask, dlb_drom_f
     pinfo_t *process = my_pinfo;
     shmem_lock(shm_handler);
     {
-        if (!process->dirty || CPU_EQUAL(mask, &process->future_process_mask)) {
+        if (skip_auto_update && process->migration_budget > 0) {
+            /* The mask will be polled, apply it in steps */
+            error = set_staged_mask(process, mask, return_stolen);
+        } else if (!process->dirty || CPU_EQUAL(mask, &process->future_process_mask)) {
             error = set_new_mask(process, mask, false /* sync */, return_stolen, free_cpu_mask);
+            if (error == DLB_SUCCESS) {
+                process->staged = false;
+            }
         } else {
             error = DLB_ERR_PDIRTY;
         }
@@ -933,13 +950,22 @@ int shmem_procinfo__setprocessmask(pid_t pid, const cpu_set_t *mask, dlb_drom_fl
             error = DLB_ERR_NOPROC;
         }
 
-        // Process already dirty
-        if (!error && process->dirty) {
-            error = DLB_ERR_PDIRTY;
-        }
+        if (!error && process->migration_budget > 0 && !sync
+                && !(flags & DLB_FREE_CPUS_SLURM)) {
+            // Apply the new mask in steps, replacing any staged one
+            error = set_staged_mask(process, mask, return_stolen);
+        } else {
+            // Process already dirty
+            if (!error && process->dirty) {
+                error = DLB_ERR_PDIRTY;
+            }
 
-        // Set new mask if everything ok
-        error = error ? error : set_new_mask(process, mask, sync, return_stolen, free_cpu_mask);
+            // Set new mask if everything ok
+            error = error ? error : set_new_mask(process, mask, sync, return_stolen, free_cpu_mask);
+            if (error == DLB_SUCCESS) {
+                process->staged = false;
+            }
+        }
     }
     shmem_unlock(shm_handler);
 
@@ -991,11 +1017,201 @@ int shmem_procinfo__setprocessmask(pid_t pid, const cpu_set_t *mask, dlb_drom_fl
     return error;
 }
 
+/* Set the masks of several processes as a single transaction: either all the
+ * processes are updated or none of them. CPUs may only be exchanged among the
+ * given processes or taken from the free mask, no CPU is stolen. */
+int shmem_procinfo__setprocessmasks(const pid_t *pidlist, const cpu_set_t *masks,
+        int nelems) {
+    if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
+    if (nelems <= 0) return DLB_NOUPDT;
+
+    int error = DLB_SUCCESS;
+    pinfo_t **processes = malloc(sizeof(pinfo_t*) * nelems);
+    shmem_lock(shm_handler);
+    {
+        if (shdata->flags.allow_cpu_sharing) {
+            error = DLB_ERR_NOCOMP;
+        }
+
+        /* Validate the whole batch before modifying any process: every
+         * process can be updated and the requested CPUs are either free or
+         * owned by some of the given processes */
+        cpu_set_t available_cpus;
+        cpu_set_t requested_cpus;
+        memcpy(&available_cpus, &shdata->free_mask, sizeof(cpu_set_t));
+        CPU_ZERO(&requested_cpus);
+        for (int i = 0; i < nelems && !error; ++i) {
+            processes[i] = get_process(pidlist[i]);
+            if (processes[i] == NULL) {
+                verbose(VB_DROM, "Setting masks: cannot find process with pid %d",
+                        pidlist[i]);
+                error = DLB_ERR_NOPROC;
+            } else if (processes[i]->dirty) {
+                verbose(VB_DROM, "Setting masks: process %d is already dirty",
+                        pidlist[i]);
+                error = DLB_ERR_PDIRTY;
+            } else if (mu_intersects(&requested_cpus, &masks[i])) {
+                verbose(VB_DROM, "Setting masks: mask %s overlaps with other processes",
+                        mu_to_str(&masks[i]));
+                error = DLB_ERR_PERM;
+            } else {
+                for (int j = 0; j < i && !error; ++j) {
+                    if (processes[j] == processes[i]) {
+                        verbose(VB_DROM, "Setting masks: process %d is repeated",
+                                pidlist[i]);
+                        error = DLB_ERR_PERM;
+                    }
+                }
+                CPU_OR(&requested_cpus, &requested_cpus, &masks[i]);
+                CPU_OR(&available_cpus, &available_cpus,
+                        &processes[i]->current_process_mask);
+            }
+        }
+        if (!error && !mu_is_subset(&requested_cpus, &available_cpus)) {
+            verbose(VB_DROM, "Setting masks: some CPUs in %s belong to other processes",
+                    mu_to_str(&requested_cpus));
+            error = DLB_ERR_PERM;
+        }
+
+        if (!error) {
+            /* Release CPUs first so that the rest of processes can acquire
+             * them. After the validation above, no step can fail */
+            for (int i = 0; i < nelems; ++i) {
+                cpu_set_t cpus_to_free;
+                CPU_ZERO(&cpus_to_free);
+                mu_subtract(&cpus_to_free, &processes[i]->current_process_mask, &masks[i]);
+                CPU_OR(&shdata->free_mask, &shdata->free_mask, &cpus_to_free);
+            }
+            for (int i = 0; i < nelems; ++i) {
+                pinfo_t *process = processes[i];
+                cpu_set_t cpus_to_acquire;
+                CPU_ZERO(&cpus_to_acquire);
+                mu_subtract(&cpus_to_acquire, &masks[i], &process->current_process_mask);
+                mu_subtract(&shdata->free_mask, &shdata->free_mask, &cpus_to_acquire);
+                mu_subtract(&process->stolen_cpus, &process->stolen_cpus, &cpus_to_acquire);
+                memcpy(&process->future_process_mask, &masks[i], sizeof(cpu_set_t));
+                process->dirty = !CPU_EQUAL(&process->current_process_mask, &masks[i]);
+                process->staged = false;
+                verbose(VB_DROM, "Process %d setting mask %s", process->pid,
+                        mu_to_str(&masks[i]));
+            }
+        }
+    }
+    shmem_unlock(shm_handler);
+    free(processes);
+
+    return error;
+}
+
+
+/* Set the maximum number of CPUs that DROM may move in pid per interval. Masks
+ * set asynchronously by other processes are then applied in staged steps. */
+int shmem_procinfo__setmigrationbudget(pid_t pid, int migration_budget,
+        int64_t migration_interval_ns) {
+    if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
+    if (migration_budget < 0 || migration_interval_ns < 0) return DLB_ERR_UNKNOWN;
+
+    int error = DLB_SUCCESS;
+    shmem_lock(shm_handler);
+    {
+        pinfo_t *process = get_process(pid);
+        if (process) {
+            process->migration_budget = migration_budget;
+            process->migration_interval = migration_interval_ns;
+            process->migration_interval_start = get_time_in_ns();
+            process->migration_interval_cpus = 0;
+        } else {
+            error = DLB_ERR_NOPROC;
+        }
+    }
+    shmem_unlock(shm_handler);
+
+    return error;
+}
+
 
 /*********************************************************************************/
 /* Generic Getters                                                               */
 /*********************************************************************************/
 
+/* Compute the next mask to be applied from current towards future, moving at
+ * most max_moves CPUs (or all of them if max_moves is 0).
+ * CPUs leaving the mask are paired with CPUs entering it, so that the threads
+ * bound to them are migrated within the same NUMA node whenever possible. */
+static void compute_staged_mask(const cpu_set_t *current, const cpu_set_t *future,
+        unsigned int max_moves, cpu_set_t *staged, unsigned int *moves,
+        unsigned int *cross_numa_moves) {
+
+    cpu_set_t cpus_to_add, cpus_to_remove;
+    CPU_ZERO(&cpus_to_add);
+    CPU_ZERO(&cpus_to_remove);
+    mu_subtract(&cpus_to_add, future, current);
+    mu_subtract(&cpus_to_remove, current, future);
+    memcpy(staged, current, sizeof(cpu_set_t));
+    *moves = 0;
+    *cross_numa_moves = 0;
+
+    /* NUMA nodes covered by the target mask */
+    cpu_set_t future_nodes;
+    mu_get_nodes_intersecting_with_cpuset(&future_nodes, future);
+
+    while ((max_moves == 0 || *moves < max_moves)
+            && (CPU_COUNT(&cpus_to_add) > 0 || CPU_COUNT(&cpus_to_remove) > 0)) {
+
+        int cpu_in = -1;
+        int cpu_out = -1;
+
+        if (CPU_COUNT(&cpus_to_add) > 0 && CPU_COUNT(&cpus_to_remove) > 0) {
+            /* Migration: look for a pair of CPUs in the same NUMA node */
+            for (int cpu = mu_get_first_cpu(&cpus_to_remove);
+                    cpu >= 0 && cpu_in == -1;
+                    cpu = mu_get_next_cpu(&cpus_to_remove, cpu)) {
+                int node_id = mu_get_node_id(cpu);
+                for (int candidate = mu_get_first_cpu(&cpus_to_add);
+                        candidate >= 0;
+                        candidate = mu_get_next_cpu(&cpus_to_add, candidate)) {
+                    if (mu_get_node_id(candidate) == node_id) {
+                        cpu_out = cpu;
+                        cpu_in = candidate;
+                        break;
+                    }
+                }
+            }
+            if (cpu_in == -1) {
+                cpu_out = mu_get_first_cpu(&cpus_to_remove);
+                cpu_in = mu_get_first_cpu(&cpus_to_add);
+                ++*cross_numa_moves;
+            }
+        } else if (CPU_COUNT(&cpus_to_add) > 0) {
+            /* Expansion: prefer CPUs in the NUMA nodes already in use */
+            cpu_set_t staged_nodes, candidates;
+            mu_get_nodes_intersecting_with_cpuset(&staged_nodes, staged);
+            CPU_AND(&candidates, &cpus_to_add, &staged_nodes);
+            cpu_in = CPU_COUNT(&candidates) > 0
+                ? mu_get_first_cpu(&candidates)
+                : mu_get_first_cpu(&cpus_to_add);
+        } else {
+            /* Shrink: prefer CPUs in NUMA nodes that the target mask leaves */
+            cpu_set_t candidates;
+            CPU_ZERO(&candidates);
+            mu_subtract(&candidates, &cpus_to_remove, &future_nodes);
+            cpu_out = CPU_COUNT(&candidates) > 0
+                ? mu_get_last_cpu(&candidates)
+                : mu_get_last_cpu(&cpus_to_remove);
+        }
+
+        if (cpu_in >= 0) {
+            CPU_CLR(cpu_in, &cpus_to_add);
+            CPU_SET(cpu_in, staged);
+        }
+        if (cpu_out >= 0) {
+            CPU_CLR(cpu_out, &cpus_to_remove);
+            CPU_CLR(cpu_out, staged);
+        }
+        ++*moves;
+    }
+}
+
 int shmem_procinfo__polldrom(pid_t pid, int *new_cpus, cpu_set_t *new_mask) {
     int error;
     if (shm_handler == NULL) {
@@ -1004,24 +1220,77 @@ int shmem_procinfo__polldrom(pid_t pid, int *new_cpus, cpu_set_t *new_mask) {
         pinfo_t *process = get_process(pid);
         if (!process) {
             error = DLB_ERR_NOPROC;
-        } else if (!process->dirty) {
+        } else if (!process->dirty && !process->staged) {
             error = DLB_NOUPDT;
         } else {
+            bool staged;
+            cpu_set_t staged_mask;
             shmem_lock(shm_handler);
             {
-                // Update output parameters
-                memcpy(new_mask, &process->future_process_mask, sizeof(cpu_set_t));
-                if (new_cpus != NULL) *new_cpus = CPU_COUNT(&process->future_process_mask);
+                /* Issue the next step of a staged mask, if the budget allows it */
+                if (!process->dirty && process->staged) {
+                    issue_staged_step(process, /* return_stolen */ false);
+                }
 
-                // Upate local info
-                memcpy(&process->current_process_mask, &process->future_process_mask,
-                        sizeof(cpu_set_t));
-                process->dirty = false;
+                if (process->dirty) {
+                    /* Account the migrations, pairing CPUs as in the staged steps */
+                    cpu_set_t applied_mask;
+                    unsigned int moves, cross_numa_moves;
+                    compute_staged_mask(&process->current_process_mask,
+                            &process->future_process_mask, 0, &applied_mask,
+                            &moves, &cross_numa_moves);
+
+                    // Update output parameters
+                    memcpy(new_mask, &process->future_process_mask, sizeof(cpu_set_t));
+                    if (new_cpus != NULL) *new_cpus = CPU_COUNT(new_mask);
+
+                    // Upate local info
+                    memcpy(&process->current_process_mask, &process->future_process_mask,
+                            sizeof(cpu_set_t));
+                    process->dirty = false;
+                    process->staged = process->staged && !CPU_EQUAL(
+                            &process->current_process_mask, &process->staged_process_mask);
+                    process->migrated_cpus += moves;
+                    process->migrated_cpus_cross_numa += cross_numa_moves;
+                    error = DLB_SUCCESS;
+                } else {
+                    /* Budget exhausted for this interval, try again later */
+                    error = DLB_NOUPDT;
+                }
+
+                staged = process->staged;
+                memcpy(&staged_mask, &process->staged_process_mask, sizeof(cpu_set_t));
             }
             shmem_unlock(shm_handler);
-            error = DLB_SUCCESS;
+
+            if (error == DLB_SUCCESS && staged) {
+                verbose(VB_DROM, "Staged mask %s applied, %s still pending",
+                        mu_to_str(new_mask), mu_to_str(&staged_mask));
+            }
+        }
+    }
+    return error;
+}
+
+/* Get the most recent mask assigned to a process, i.e., the staged or future
+ * mask if the process has a pending update, without consuming it */
+int shmem_procinfo__getfuturemask(pid_t pid, cpu_set_t *mask) {
+    if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
+
+    int error = DLB_SUCCESS;
+    shmem_lock(shm_handler);
+    {
+        pinfo_t *process = get_process(pid);
+        if (process == NULL) {
+            error = DLB_ERR_NOPROC;
+        } else {
+            memcpy(mask,
+                    process->staged ? &process->staged_process_mask
+                    : process->dirty ? &process->future_process_mask
+                    : &process->current_process_mask, sizeof(cpu_set_t));
         }
     }
+    shmem_unlock(shm_handler);
     return error;
 }
 
@@ -1187,6 +1456,25 @@ void shmem_procinfo__getactivecpus_list(pid_t *cpuslist, int *nelems, int max_le
     shmem_unlock(shm_handler);
 }
 
+int shmem_procinfo__getmigratedcpus(pid_t pid, int *migrated_cpus, int *cross_numa) {
+    if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
+
+    int error = DLB_SUCCESS;
+    shmem_lock(shm_handler);
+    {
+        pinfo_t *process = get_process(pid);
+        if (process) {
+            *migrated_cpus = process->migrated_cpus;
+            *cross_numa = process->migrated_cpus_cross_numa;
+        } else {
+            error = DLB_ERR_NOPROC;
+        }
+    }
+    shmem_unlock(shm_handler);
+
+    return error;
+}
+
 int shmem_procinfo__getloadavg(pid_t pid, double *load) {
     if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
     int error = DLB_ERR_UNKNOWN;
@@ -1590,3 +1878,74 @@ static int set_new_mask(pinfo_t *process, const cpu_set_t *mask, bool sync,
 
     return error;
 }
+
+/* Issue the next step of a staged mask: the CPUs moved in this step, as many
+ * as the migration budget allows in the current interval, are taken from their
+ * owners and given to the process at the same time, so that every owner moves
+ * the same CPUs in matched steps.
+ * PRE: shmem is locked, process is staged and not dirty */
+static int issue_staged_step(pinfo_t *process, bool return_stolen) {
+    /* Compute how many CPUs may be moved in this step */
+    unsigned int max_moves = 0;
+    if (process->migration_budget > 0) {
+        int64_t now = get_time_in_ns();
+        if (now - process->migration_interval_start >= process->migration_interval) {
+            process->migration_interval_start = now;
+            process->migration_interval_cpus = 0;
+        }
+        if (process->migration_interval_cpus >= process->migration_budget) {
+            /* Budget exhausted for this interval */
+            return DLB_NOUPDT;
+        }
+        max_moves = process->migration_budget - process->migration_interval_cpus;
+    }
+
+    cpu_set_t step_mask;
+    unsigned int moves, cross_numa_moves;
+    compute_staged_mask(&process->current_process_mask, &process->staged_process_mask,
+            max_moves, &step_mask, &moves, &cross_numa_moves);
+
+    /* If some owner is dirty, the step is retried on the next poll */
+    int error = set_new_mask(process, &step_mask, false /* sync */, return_stolen, NULL);
+    if (error == DLB_SUCCESS) {
+        process->migration_interval_cpus += moves;
+        process->staged = !CPU_EQUAL(&step_mask, &process->staged_process_mask);
+    }
+
+    return error;
+}
+
+/* Set a new mask to be applied in steps, replacing the staged one if any.
+ * PRE: shmem is locked, process has a migration budget */
+static int set_staged_mask(pinfo_t *process, const cpu_set_t *mask, bool return_stolen) {
+    // this function cannot be used if allowing CPU sharing
+    if (shdata->flags.allow_cpu_sharing) return DLB_ERR_NOCOMP;
+
+    if (process->dirty) {
+        if (!process->staged) return DLB_ERR_PDIRTY;
+
+        /* A step is pending to be polled, only the final mask is replaced */
+        memcpy(&process->staged_process_mask, mask, sizeof(cpu_set_t));
+        return DLB_SUCCESS;
+    }
+
+    /* Check that the whole mask could be stolen now */
+    cpu_set_t cpus_to_steal;
+    CPU_ZERO(&cpus_to_steal);
+    mu_subtract(&cpus_to_steal, mask, &shdata->free_mask);
+    mu_subtract(&cpus_to_steal, &cpus_to_steal, &process->current_process_mask);
+    int error = steal_mask(process, &cpus_to_steal, false /* sync */, /* dry_run */ true);
+    if (error != DLB_SUCCESS) return error;
+
+    memcpy(&process->staged_process_mask, mask, sizeof(cpu_set_t));
+    process->staged = true;
+    error = issue_staged_step(process, return_stolen);
+    if (error == DLB_NOUPDT) {
+        /* Budget exhausted, the first step will be issued on a poll */
+        error = DLB_SUCCESS;
+    } else if (error != DLB_SUCCESS) {
+        process->staged = false;
+    }
+
+    return error;
+}
@@ -24,6 +24,7 @@
 
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <sched.h>
 
 /* Init / Register */
@@ -44,9 +45,14 @@ int shmem_procinfo_ext__recover_stolen_cpus(int pid);
 int shmem_procinfo__getprocessmask(pid_t pid, cpu_set_t *mask, dlb_drom_flags_t flags);
 int shmem_procinfo__setprocessmask(pid_t pid, const cpu_set_t *mask,
         dlb_drom_flags_t flags, cpu_set_t *free_cpu_mask);
+int shmem_procinfo__setprocessmasks(const pid_t *pidlist, const cpu_set_t *masks,
+        int nelems);
+int shmem_procinfo__setmigrationbudget(pid_t pid, int migration_budget,
+        int64_t migration_interval_ns);
 
 /* Generic Getters */
 int shmem_procinfo__polldrom(pid_t pid, int *new_cpus, cpu_set_t *new_mask);
+int shmem_procinfo__getfuturemask(pid_t pid, cpu_set_t *mask);
 int shmem_procinfo__getpidlist(pid_t *pidlist, int *nelems, int max_len);
 
 /* Statistics */
@@ -59,6 +65,7 @@ double  shmem_procinfo__getnodeavgusage(void);
 int     shmem_procinfo__getactivecpus(pid_t pid);
 void    shmem_procinfo__getactivecpus_list(pid_t *cpuslist, int *nelems, int max_len);
 int     shmem_procinfo__getloadavg(pid_t pid, double *load);
+int     shmem_procinfo__getmigratedcpus(pid_t pid, int *migrated_cpus, int *cross_numa);
 
 int  shmem_procinfo__setcpuusage(pid_t pid, int index, double new_usage);
 int  shmem_procinfo__setcpuavgusage(pid_t pid, double new_avg_usage);
@@ -27,6 +27,7 @@
 #include "support/types.h"
 #include "support/mask_utils.h"
 
+#include <sched.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
@@ -42,6 +43,9 @@ typedef struct DLB_ALIGN_CACHE talp_region_t {
     atomic_int_least64_t useful_time;
     pid_t pid;
     float avg_cpus;
+    /* Published base metrics, odd seq while the owner process is writing */
+    atomic_uint metrics_seq;
+    shmem_talp_metrics_t metrics;
 } talp_region_t;
 
 typedef struct {
@@ -51,7 +55,7 @@ typedef struct {
     talp_region_t talp_region[];
 } shdata_t;
 
-enum { SHMEM_TALP_VERSION = 4 };
+enum { SHMEM_TALP_VERSION = 5 };
 
 static shmem_handler_t *shm_handler = NULL;
 static shdata_t *shdata = NULL;
@@ -374,6 +378,51 @@ int shmem_talp__get_times(int region_id, int64_t *mpi_time, int64_t *useful_time
     return DLB_SUCCESS;
 }
 
+/* Copy the published metrics of a region. If the owner process is publishing
+ * them, retry until a consistent copy is obtained. The owner may have died in
+ * the middle of a publication, so give up after a number of retries. */
+static inline bool read_metrics(const talp_region_t *talp_region,
+        shmem_talp_metrics_t *metrics) {
+
+    enum { MAX_READ_RETRIES = 1000 };
+    for (int retry = 0; retry < MAX_READ_RETRIES; ++retry) {
+        unsigned int seq_begin = seqlock_read_begin(&talp_region->metrics_seq);
+        *metrics = talp_region->metrics;
+        if (!seqlock_read_retry(&talp_region->metrics_seq, seq_begin)) return true;
+        sched_yield();
+    }
+    return false;
+}
+
+/* Obtain the published metrics of every process for a given region name.
+ * Regions that have never been published are skipped. */
+int shmem_talp__get_metricslist(shmem_talp_metrics_t *metrics_list, int *nelems,
+        int max_len, const char *name) {
+    if (shm_handler == NULL) return DLB_ERR_NOSHMEM;
+
+    *nelems = 0;
+    shmem_lock(shm_handler);
+    {
+        int num_regions = shdata->num_regions;
+        for (int region_id = 0; region_id < num_regions && *nelems < max_len; ++region_id) {
+            talp_region_t *talp_region = &shdata->talp_region[region_id];
+            if (talp_region->pid != NOBODY
+                    && DLB_ATOMIC_LD_RLX(&talp_region->metrics_seq) != 0
+                    && strncmp(talp_region->name, name, DLB_MONITOR_NAME_MAX-1) == 0) {
+                if (read_metrics(talp_region, &metrics_list[*nelems])) {
+                    ++(*nelems);
+                } else {
+                    warning("Skipping TALP metrics of process %d, they could not be read",
+                            talp_region->pid);
+                }
+            }
+        }
+    }
+    shmem_unlock(shm_handler);
+
+    return DLB_SUCCESS;
+}
+
 
 /*********************************************************************************/
 /*  Setters                                                                      */
@@ -408,6 +457,29 @@ int shmem_talp__set_avg_cpus(int region_id, float avg_cpus) {
     return DLB_SUCCESS;
 }
 
+/* Only the owner process publishes the metrics of a region. Readers never
+ * block it, they retry if they observe a publication in progress. */
+int shmem_talp__set_metrics(int region_id, const shmem_talp_metrics_t *metrics) {
+    if (unlikely(shm_handler == NULL)) return DLB_ERR_NOSHMEM;
+    if (unlikely(region_id >= max_regions)) return DLB_ERR_NOMEM;
+    if (unlikely(region_id >= shdata->num_regions)) return DLB_ERR_NOENT;
+    if (unlikely(region_id < 0)) return DLB_ERR_NOENT;
+
+    talp_region_t *talp_region = &shdata->talp_region[region_id];
+    if (unlikely(talp_region->pid == NOBODY)) return DLB_ERR_NOENT;
+
+    seqlock_write_begin(&talp_region->metrics_seq);
+    talp_region->metrics = *metrics;
+    talp_region->metrics.pid = talp_region->pid;
+    seqlock_write_end(&talp_region->metrics_seq);
+
+    /* Keep the times of the region consistent with the metrics */
+    DLB_ATOMIC_ST_RLX(&talp_region->mpi_time, metrics->mpi_time);
+    DLB_ATOMIC_ST_RLX(&talp_region->useful_time, metrics->useful_time);
+
+    return DLB_SUCCESS;
+}
+
 
 /*********************************************************************************/
 /* Misc                                                                          */
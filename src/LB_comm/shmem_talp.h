@@ -32,6 +32,35 @@ typedef struct talp_region_list_t {
     float avg_cpus;
 } talp_region_list_t;
 
+/* Base metrics of a region in a process, published to compute node POP
+ * metrics without MPI */
+typedef struct shmem_talp_metrics_t {
+    pid_t pid;
+    int num_cpus;
+    int num_omp_threads;
+    int num_mpi_ranks;              /* 1 if the process is an MPI rank */
+    int num_gpus;
+    float avg_cpus;
+    int64_t cycles;
+    int64_t instructions;
+    int64_t num_measurements;
+    int64_t num_mpi_calls;
+    int64_t num_omp_parallels;
+    int64_t num_omp_tasks;
+    int64_t num_gpu_runtime_calls;
+    int64_t elapsed_time;
+    int64_t useful_time;
+    int64_t mpi_time;
+    int64_t mpi_worker_idle_time;
+    int64_t omp_load_imbalance_time;
+    int64_t omp_scheduling_time;
+    int64_t omp_serialization_time;
+    int64_t gpu_runtime_time;
+    int64_t gpu_useful_time;
+    int64_t gpu_communication_time;
+    int64_t gpu_inactive_time;
+} shmem_talp_metrics_t;
+
 /* Init */
 int shmem_talp__init(const char *shmem_key, int shmem_size_multiplier);
 int shmem_talp_ext__init(const char *shmem_key, int shmem_size_multiplier);
@@ -49,10 +78,13 @@ int shmem_talp__get_region(talp_region_list_t *region, pid_t pid, const char *na
 int shmem_talp__get_regionlist(talp_region_list_t *region_list, int *nelems,
         int max_len, const char *name);
 int shmem_talp__get_times(int region_id, int64_t *mpi_time, int64_t *useful_time);
+int shmem_talp__get_metricslist(shmem_talp_metrics_t *metrics_list, int *nelems,
+        int max_len, const char *name);
 
 /* Setters */
 int shmem_talp__set_times(int region_id, int64_t mpi_time, int64_t useful_time);
 int shmem_talp__set_avg_cpus(int region_id, float avg_cpus);
+int shmem_talp__set_metrics(int region_id, const shmem_talp_metrics_t *metrics);
 
 /* Misc */
 void shmem_talp__print_info(const char *shmem_key, int shmem_size_multiplier);
@@ -23,6 +23,7 @@
 
 #include "LB_core/DLB_kernel.h"
 
+#include "LB_core/cgroup_cpuset.h"
 #include "LB_core/node_barrier.h"
 #include "LB_core/spd.h"
 #include "LB_core/thread_ctx.h"
@@ -31,6 +32,7 @@
 #include "LB_comm/shmem_async.h"
 #include "LB_comm/shmem_barrier.h"
 #include "LB_comm/shmem_cpuinfo.h"
+#include "LB_comm/shmem_cpuinfo_log.h"
 #include "LB_comm/shmem_procinfo.h"
 #include "LB_comm/shmem_talp.h"
 #include "LB_comm/shmem_mngo.h"
@@ -44,16 +46,46 @@
 #include "talp/backend_manager.h"
 #include "talp/talp.h"
 #include "talp/talp_mpi.h"
+#include "talp/talp_writer.h"
 #include "mngo/mngo.h"
 #ifdef MPI_LIB
 #include "mpi/mpi_core.h"
 #endif
 
 #include <limits.h>
+#include <pthread.h>
 #include <sched.h>
 #include <string.h>
 
 
+/* Record a LeWI operation before executing it, only if --lewi-record. The entry
+ * is appended once the policy enters the cpuinfo critical section */
+static inline void record_lewi_op(const subprocess_descriptor_t *spd,
+        cpuinfo_log_op_t op, int arg, const cpu_set_t *mask) {
+    if (unlikely(spd->options.lewi_record) && shmem_cpuinfo_log__exists()) {
+        shmem_cpuinfo_log__record(op, spd->id, arg, mask);
+    }
+}
+
+/* Append the recorded operation if the policy did not enter the cpuinfo
+ * critical section */
+static inline void record_lewi_op_end(const subprocess_descriptor_t *spd) {
+    if (unlikely(spd->options.lewi_record)) {
+        shmem_cpuinfo_log__record_end();
+    }
+}
+
+/* Blocking calls depend on the affinity of the calling thread, record it too */
+static inline void record_lewi_blocking_call(const subprocess_descriptor_t *spd,
+        cpuinfo_log_op_t op) {
+    if (unlikely(spd->options.lewi_record) && shmem_cpuinfo_log__exists()) {
+        cpu_set_t thread_mask;
+        pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &thread_mask);
+        shmem_cpuinfo_log__record(op, spd->id, 0, &thread_mask);
+    }
+}
+
+
 /* Status */
 
 int Initialize(subprocess_descriptor_t *spd, pid_t id, int ncpus,
@@ -141,6 +173,13 @@ int Initialize(subprocess_descriptor_t *spd, pid_t id, int ncpus,
                 memcpy(&spd->process_mask, &new_process_mask, sizeof(cpu_set_t));
                 error = DLB_SUCCESS;
             }
+
+            // Register the DROM migration budget of this process
+            if (error == DLB_SUCCESS && spd->options.drom_migration_budget > 0) {
+                error = shmem_procinfo__setmigrationbudget(spd->id,
+                        spd->options.drom_migration_budget,
+                        (int64_t)spd->options.drom_migration_interval * 1000000LL);
+            }
         } else {
             // If using --lewi-color, we also need to initialize procinfo with cpu sharing
             error = shmem_procinfo__init_with_cpu_sharing(spd->id, spd->options.preinit_pid,
@@ -153,6 +192,12 @@ int Initialize(subprocess_descriptor_t *spd, pid_t id, int ncpus,
         error = shmem_cpuinfo__init(spd->id, spd->options.preinit_pid,
                 &spd->process_mask, spd->options.shm_key, spd->options.lewi_color);
         if (error != DLB_SUCCESS) return error;
+
+        // Optionally, record the LeWI operations of this process
+        if (spd->options.lewi_record) {
+            shmem_cpuinfo_log__init(spd->options.shm_key, spd->options.lewi_color,
+                    spd->options.shm_size_multiplier);
+        }
     } else if (spd->options.talp) {
         // If mask is not needed but TALP is enabled, we still need to
         // initialize shmem_procinfo but allowing CPU sharing
@@ -170,7 +215,9 @@ int Initialize(subprocess_descriptor_t *spd, pid_t id, int ncpus,
     }
 
     // Initialise LeWI
+    record_lewi_op(spd, CPUINFO_LOG_INIT, 0, &spd->process_mask);
     error = spd->lb_funcs.init(spd);
+    record_lewi_op_end(spd);
     if (error != DLB_SUCCESS) return error;
     spd->lewi_enabled = true;
 
@@ -180,7 +227,9 @@ int Initialize(subprocess_descriptor_t *spd, pid_t id, int ncpus,
      */
     if (spd->options.mngo && spd->options.lewi) {
         spd->lewi_enabled = false;
+        record_lewi_op(spd, CPUINFO_LOG_DISABLE, 0, NULL);
         spd->lb_funcs.disable(spd);
+        record_lewi_op_end(spd);
     }
 
     // Initialize TALP
@@ -190,6 +239,11 @@ int Initialize(subprocess_descriptor_t *spd, pid_t id, int ncpus,
         spd->talp_info = NULL;
     }
 
+    // Initialize cgroup cpuset watcher
+    if (spd->options.drom_cgroup) {
+        cgroup_cpuset_init(spd);
+    }
+
     // Print initialization summary
     info0("%s %s", PACKAGE, VERSION);
     if (spd->lb_policy != POLICY_NONE) {
@@ -248,11 +302,16 @@ int Finish(subprocess_descriptor_t *spd) {
 
     pm_finalize(&spd->pm);
 
+    if (spd->options.drom_cgroup) {
+        cgroup_cpuset_finalize(spd);
+    }
     if (spd->options.talp) {
         talp_finalize(spd);
     }
     if (spd->lb_funcs.finalize) {
+        record_lewi_op(spd, CPUINFO_LOG_FINALIZE, 0, NULL);
         spd->lb_funcs.finalize(spd);
+        record_lewi_op_end(spd);
         spd->lb_funcs.finalize = NULL;
     }
     if (spd->options.barrier) {
@@ -264,6 +323,9 @@ int Finish(subprocess_descriptor_t *spd) {
             || spd->options.talp
             || spd->options.ompt
             || spd->options.preinit_pid) {
+        if (spd->options.lewi_record && shmem_cpuinfo_log__exists()) {
+            shmem_cpuinfo_log__finalize();
+        }
         shmem_cpuinfo__finalize(spd->id, spd->options.shm_key, spd->options.lewi_color);
         shmem_procinfo__finalize(spd->id, spd->options.debug_opts & DBG_RETURNSTOLEN,
                 spd->options.shm_key, spd->options.shm_size_multiplier);
@@ -271,6 +333,10 @@ int Finish(subprocess_descriptor_t *spd) {
     if (spd->options.mode == MODE_ASYNC) {
         shmem_async_finalize(spd->id);
     }
+    if (spd->options.talp) {
+        /* Wait for the TALP output files being written in the background */
+        talp_writer_finalize();
+    }
     timer_finalize();
     instrument_event(RUNTIME_EVENT, EVENT_FINALIZE, EVENT_END);
     instrument_finalize();
@@ -312,10 +378,14 @@ int set_lewi_enabled(subprocess_descriptor_t *spd, bool enabled) {
     int error = DLB_SUCCESS;
     if (__sync_bool_compare_and_swap(&spd->lewi_enabled, !enabled, enabled)) {
         if (enabled) {
+            record_lewi_op(spd, CPUINFO_LOG_ENABLE, 0, NULL);
             spd->lb_funcs.enable(spd);
+            record_lewi_op_end(spd);
             instrument_event(DLB_MODE_EVENT, EVENT_ENABLED, EVENT_BEGIN);
         } else {
+            record_lewi_op(spd, CPUINFO_LOG_DISABLE, 0, NULL);
             spd->lb_funcs.disable(spd);
+            record_lewi_op_end(spd);
             instrument_event(DLB_MODE_EVENT, EVENT_DISABLED, EVENT_BEGIN);
         }
     } else {
@@ -334,7 +404,9 @@ int set_max_parallelism(subprocess_descriptor_t *spd, int max) {
         instrument_event(RUNTIME_EVENT, EVENT_MAX_PARALLELISM, EVENT_BEGIN);
         instrument_event(MAX_PAR_EVENT, 0, EVENT_END);
         instrument_event(MAX_PAR_EVENT, max, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_SET_MAX_PARALLELISM, max, NULL);
         error = spd->lb_funcs.set_max_parallelism(spd, max);
+        record_lewi_op_end(spd);
         instrument_event(RUNTIME_EVENT, EVENT_MAX_PARALLELISM, EVENT_END);
     }
     return error;
@@ -349,7 +421,9 @@ int unset_max_parallelism(subprocess_descriptor_t *spd) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_MAX_PARALLELISM, EVENT_BEGIN);
         instrument_event(MAX_PAR_EVENT, 0, EVENT_END);
+        record_lewi_op(spd, CPUINFO_LOG_UNSET_MAX_PARALLELISM, 0, NULL);
         error = spd->lb_funcs.unset_max_parallelism(spd);
+        record_lewi_op_end(spd);
         instrument_event(RUNTIME_EVENT, EVENT_MAX_PARALLELISM, EVENT_END);
     }
     return error;
@@ -366,7 +440,9 @@ void into_sync_call(sync_call_flags_t flags) {
     if (unlikely(spd == NULL)) return;
 
     if (flags.do_lewi && spd->options.lewi && spd->lewi_enabled) {
+        record_lewi_blocking_call(spd, CPUINFO_LOG_INTO_BLOCKING_CALL);
         spd->lb_funcs.into_blocking_call(spd);
+        record_lewi_op_end(spd);
         omptool__into_blocking_call();
     }
     if(spd->options.talp) {
@@ -382,7 +458,9 @@ void out_of_sync_call(sync_call_flags_t flags) {
     if (unlikely(spd == NULL)) return;
 
     if (spd->options.lewi && spd->lewi_enabled && flags.do_lewi) {
+        record_lewi_blocking_call(spd, CPUINFO_LOG_OUT_OF_BLOCKING_CALL);
         spd->lb_funcs.out_of_blocking_call(spd);
+        record_lewi_op_end(spd);
         omptool__outof_blocking_call();
     }
     if(spd->options.talp) {
@@ -403,7 +481,9 @@ int lend(const subprocess_descriptor_t *spd) {
         instrument_event(RUNTIME_EVENT, EVENT_LEND, EVENT_BEGIN);
         instrument_event(GIVE_CPUS_EVENT, CPU_SETSIZE, EVENT_BEGIN);
         omptool__lend_from_api();
+        record_lewi_op(spd, CPUINFO_LOG_LEND, 0, NULL);
         error = spd->lb_funcs.lend(spd);
+        record_lewi_op_end(spd);
         instrument_event(GIVE_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_LEND, EVENT_END);
     }
@@ -419,7 +499,9 @@ int lend_cpu(const subprocess_descriptor_t *spd, int cpuid) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_LEND, EVENT_BEGIN);
         instrument_event(GIVE_CPUS_EVENT, 1, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_LEND_CPU, cpuid, NULL);
         error = spd->lb_funcs.lend_cpu(spd, cpuid);
+        record_lewi_op_end(spd);
         instrument_event(GIVE_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_LEND, EVENT_END);
     }
@@ -435,7 +517,9 @@ int lend_cpus(const subprocess_descriptor_t *spd, int ncpus) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_LEND, EVENT_BEGIN);
         instrument_event(GIVE_CPUS_EVENT, ncpus, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_LEND_CPUS, ncpus, NULL);
         error = spd->lb_funcs.lend_cpus(spd, ncpus);
+        record_lewi_op_end(spd);
         instrument_event(GIVE_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_LEND, EVENT_END);
     }
@@ -451,7 +535,9 @@ int lend_cpu_mask(const subprocess_descriptor_t *spd, const cpu_set_t *mask) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_LEND, EVENT_BEGIN);
         instrument_event(GIVE_CPUS_EVENT, CPU_COUNT(mask), EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_LEND_CPU_MASK, 0, mask);
         error = spd->lb_funcs.lend_cpu_mask(spd, mask);
+        record_lewi_op_end(spd);
         instrument_event(GIVE_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_LEND, EVENT_END);
     }
@@ -470,7 +556,9 @@ int reclaim(const subprocess_descriptor_t *spd) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_RECLAIM, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, CPU_SETSIZE, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_RECLAIM, 0, NULL);
         error = spd->lb_funcs.reclaim(spd);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_RECLAIM, EVENT_END);
     }
@@ -486,7 +574,9 @@ int reclaim_cpu(const subprocess_descriptor_t *spd, int cpuid) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_RECLAIM, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, 1, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_RECLAIM_CPU, cpuid, NULL);
         error = spd->lb_funcs.reclaim_cpu(spd, cpuid);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_RECLAIM, EVENT_END);
     }
@@ -502,7 +592,9 @@ int reclaim_cpus(const subprocess_descriptor_t *spd, int ncpus) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_RECLAIM, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, ncpus, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_RECLAIM_CPUS, ncpus, NULL);
         error = spd->lb_funcs.reclaim_cpus(spd, ncpus);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_RECLAIM, EVENT_END);
     }
@@ -518,7 +610,9 @@ int reclaim_cpu_mask(const subprocess_descriptor_t *spd, const cpu_set_t *mask)
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_RECLAIM, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, CPU_COUNT(mask), EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_RECLAIM_CPU_MASK, 0, mask);
         error = spd->lb_funcs.reclaim_cpu_mask(spd, mask);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_RECLAIM, EVENT_END);
     }
@@ -537,7 +631,9 @@ int acquire_cpu(const subprocess_descriptor_t *spd, int cpuid) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_ACQUIRE, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, 1, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_ACQUIRE_CPU, cpuid, NULL);
         error = spd->lb_funcs.acquire_cpu(spd, cpuid);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_ACQUIRE, EVENT_END);
     }
@@ -553,7 +649,9 @@ int acquire_cpus(const subprocess_descriptor_t *spd, int ncpus) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_ACQUIRE, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, ncpus, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_ACQUIRE_CPUS, ncpus, NULL);
         error = spd->lb_funcs.acquire_cpus(spd, ncpus);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_ACQUIRE, EVENT_END);
     }
@@ -569,7 +667,9 @@ int acquire_cpu_mask(const subprocess_descriptor_t *spd, const cpu_set_t *mask)
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_ACQUIRE, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, CPU_COUNT(mask), EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_ACQUIRE_CPU_MASK, 0, mask);
         error = spd->lb_funcs.acquire_cpu_mask(spd, mask);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_ACQUIRE, EVENT_END);
     }
@@ -585,7 +685,9 @@ int acquire_cpus_in_mask(const subprocess_descriptor_t *spd, int ncpus, const cp
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_ACQUIRE, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, ncpus, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_ACQUIRE_CPUS_IN_MASK, ncpus, mask);
         error = spd->lb_funcs.acquire_cpus_in_mask(spd, ncpus, mask);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_ACQUIRE, EVENT_END);
     }
@@ -604,7 +706,9 @@ int borrow(const subprocess_descriptor_t *spd) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_BORROW, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, CPU_SETSIZE, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_BORROW, 0, NULL);
         error = spd->lb_funcs.borrow(spd);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_BORROW, EVENT_END);
     }
@@ -620,7 +724,9 @@ int borrow_cpu(const subprocess_descriptor_t *spd, int cpuid) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_BORROW, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, 1, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_BORROW_CPU, cpuid, NULL);
         error = spd->lb_funcs.borrow_cpu(spd, cpuid);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_BORROW, EVENT_END);
     }
@@ -636,7 +742,9 @@ int borrow_cpus(const subprocess_descriptor_t *spd, int ncpus) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_BORROW, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, ncpus, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_BORROW_CPUS, ncpus, NULL);
         error = spd->lb_funcs.borrow_cpus(spd, ncpus);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_BORROW, EVENT_END);
     }
@@ -652,7 +760,9 @@ int borrow_cpu_mask(const subprocess_descriptor_t *spd, const cpu_set_t *mask) {
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_BORROW, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, CPU_COUNT(mask), EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_BORROW_CPU_MASK, 0, mask);
         error = spd->lb_funcs.borrow_cpu_mask(spd, mask);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_BORROW, EVENT_END);
     }
@@ -668,7 +778,9 @@ int borrow_cpus_in_mask(const subprocess_descriptor_t *spd, int ncpus, const cpu
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_BORROW, EVENT_BEGIN);
         instrument_event(WANT_CPUS_EVENT, ncpus, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_BORROW_CPUS_IN_MASK, ncpus, mask);
         error = spd->lb_funcs.borrow_cpus_in_mask(spd, ncpus, mask);
+        record_lewi_op_end(spd);
         instrument_event(WANT_CPUS_EVENT, 0, EVENT_END);
         instrument_event(RUNTIME_EVENT, EVENT_BORROW, EVENT_END);
     }
@@ -685,7 +797,9 @@ int return_all(const subprocess_descriptor_t *spd) {
         error = DLB_ERR_DISBLD;
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_RETURN, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_RETURN, 0, NULL);
         error = spd->lb_funcs.return_all(spd);
+        record_lewi_op_end(spd);
         instrument_event(RUNTIME_EVENT, EVENT_RETURN, EVENT_END);
     }
     return error;
@@ -699,7 +813,9 @@ int return_cpu(const subprocess_descriptor_t *spd, int cpuid) {
         error = DLB_ERR_DISBLD;
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_RETURN, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_RETURN_CPU, cpuid, NULL);
         error = spd->lb_funcs.return_cpu(spd, cpuid);
+        record_lewi_op_end(spd);
         instrument_event(RUNTIME_EVENT, EVENT_RETURN, EVENT_END);
     }
     return error;
@@ -713,7 +829,9 @@ int return_cpu_mask(const subprocess_descriptor_t *spd, const cpu_set_t *mask) {
         error = DLB_ERR_DISBLD;
     } else {
         instrument_event(RUNTIME_EVENT, EVENT_RETURN, EVENT_BEGIN);
+        record_lewi_op(spd, CPUINFO_LOG_RETURN_CPU_MASK, 0, mask);
         error = spd->lb_funcs.return_cpu_mask(spd, mask);
+        record_lewi_op_end(spd);
         instrument_event(RUNTIME_EVENT, EVENT_RETURN, EVENT_END);
     }
     return error;
@@ -736,7 +854,9 @@ int poll_drom(const subprocess_descriptor_t *spd, int *new_cpus, cpu_set_t *new_
         if (error == DLB_SUCCESS) {
             if (spd->options.lewi) {
                 /* If LeWI, resolve reclaimed CPUs */
+                record_lewi_op(spd, CPUINFO_LOG_UPDATE_OWNERSHIP, 0, mask);
                 spd->lb_funcs.update_ownership(spd, mask);
+                record_lewi_op_end(spd);
             } else {
                 /* Otherwise, udate owner and guest data */
                 shmem_cpuinfo__update_ownership(spd->id, mask, NULL);
@@ -766,7 +886,9 @@ int drom_setprocessmask(int pid, const_dlb_cpu_set_t mask, dlb_drom_flags_t flag
         /* Mask has been successfully set by own process, do like a poll_drom_update */
         if (thread_spd->options.lewi) {
             /* If LeWI, resolve reclaimed CPUs */
+            record_lewi_op(thread_spd, CPUINFO_LOG_UPDATE_OWNERSHIP, 0, mask);
             thread_spd->lb_funcs.update_ownership(thread_spd, mask);
+            record_lewi_op_end(thread_spd);
         } else {
             /* Otherwise, udate owner and guest data */
             shmem_cpuinfo__update_ownership(thread_spd->id, mask, NULL);
@@ -821,7 +943,9 @@ int check_cpu_availability(const subprocess_descriptor_t *spd, int cpuid) {
     } else if (!spd->lewi_enabled) {
         error = DLB_ERR_DISBLD;
     } else {
+        record_lewi_op(spd, CPUINFO_LOG_CHECK_CPU_AVAILABILITY, cpuid, NULL);
         error = spd->lb_funcs.check_cpu_availability(spd, cpuid);
+        record_lewi_op_end(spd);
     }
     return error;
 }
@@ -0,0 +1,277 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "LB_core/cgroup_cpuset.h"
+
+#include "apis/dlb_errors.h"
+#include "apis/dlb_types.h"
+#include "LB_comm/shmem_procinfo.h"
+#include "support/debug.h"
+#include "support/mask_utils.h"
+#include "support/types.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/* The cpuset file is re-read at least every CGROUP_POLL_MIN_MS, doubling the
+ * interval up to CGROUP_POLL_MAX_MS while it does not change. Inotify events
+ * on the cgroup.events file wake up the watcher immediately, since cgroupfs
+ * does not notify modifications of the cpuset files. */
+enum { CGROUP_POLL_MIN_MS = 100 };
+enum { CGROUP_POLL_MAX_MS = 5000 };
+
+static const char *cgroup_root = "/sys/fs/cgroup";
+static const char *cpuset_filename = "cpuset.cpus.effective";
+static const char *events_filename = "cgroup.events";
+
+/* Per process, private cgroup watcher data */
+typedef struct cgroup_info {
+    char path[PATH_MAX];
+    cpu_set_t cpuset;           /* last effective cpuset applied */
+    cpu_set_t failed_cpuset;    /* last effective cpuset that could not be applied */
+    const subprocess_descriptor_t *spd;
+    int inotify_fd;
+    int wakeup_fd[2];
+    pthread_t thread;
+} cgroup_info_t;
+
+/* Obtain the cgroup v2 directory of the process from /proc/self/cgroup */
+static int get_cgroup_path(char *path, size_t len) {
+    int error = DLB_ERR_NOENT;
+    char line[PATH_MAX];
+    FILE *fd = fopen("/proc/self/cgroup", "r");
+    if (fd != NULL) {
+        while (fgets(line, PATH_MAX, fd) != NULL) {
+            /* cgroup v2 entry has the format "0::<path>" */
+            if (strncmp(line, "0::", 3) == 0) {
+                line[strcspn(line, "\n")] = '\0';
+                size_t not_truncated_len = snprintf(path, len, "%s%s",
+                        cgroup_root, &line[3]);
+                error = not_truncated_len < len ? DLB_SUCCESS : DLB_ERR_NOENT;
+                break;
+            }
+        }
+        fclose(fd);
+    }
+    return error;
+}
+
+int cgroup_cpuset_read(const char *cgroup_path, cpu_set_t *cpuset) {
+    char filename[PATH_MAX];
+    int not_truncated_len = snprintf(filename, PATH_MAX, "%s/%s",
+            cgroup_path, cpuset_filename);
+    if (not_truncated_len >= PATH_MAX) return DLB_ERR_NOENT;
+
+    FILE *fd = fopen(filename, "r");
+    if (fd == NULL) return DLB_ERR_NOENT;
+
+    char buffer[CPU_SETSIZE*4];
+    if (fgets(buffer, sizeof(buffer), fd) == NULL) {
+        buffer[0] = '\0';
+    }
+    fclose(fd);
+
+    buffer[strcspn(buffer, "\n")] = '\0';
+    mu_parse_mask(buffer, cpuset);
+
+    /* An empty cpuset means that the cpuset controller is not enabled */
+    return CPU_COUNT(cpuset) > 0 ? DLB_SUCCESS : DLB_NOUPDT;
+}
+
+/* Translate a change of the cgroup cpuset into a DROM mask update. If the
+ * process owned the whole old cpuset, it takes the whole new one; otherwise,
+ * it only keeps the CPUs still present in the cpuset. The update is applied
+ * in the next DROM poll, like any other external DROM request. */
+int cgroup_cpuset_update(const subprocess_descriptor_t *spd,
+        const cpu_set_t *old_cpuset, const cpu_set_t *new_cpuset) {
+
+    cpu_set_t process_mask;
+    int error = shmem_procinfo__getfuturemask(spd->id, &process_mask);
+    if (error != DLB_SUCCESS) return error;
+
+    cpu_set_t new_mask;
+    if (CPU_EQUAL(&process_mask, old_cpuset)) {
+        memcpy(&new_mask, new_cpuset, sizeof(cpu_set_t));
+    } else {
+        CPU_AND(&new_mask, &process_mask, new_cpuset);
+    }
+
+    if (CPU_COUNT(&new_mask) == 0) {
+        warning("cgroup cpuset %s does not contain any CPU of the process mask,"
+                " ignoring update", mu_to_str(new_cpuset));
+        return DLB_NOUPDT;
+    }
+
+    if (CPU_EQUAL(&new_mask, &process_mask)) {
+        return DLB_NOUPDT;
+    }
+
+    verbose(VB_DROM, "cgroup cpuset changed to %s", mu_to_str(new_cpuset));
+    verbose(VB_DROM, "Setting process mask %s", mu_to_str(&new_mask));
+
+    return shmem_procinfo__setprocessmask(spd->id, &new_mask, DLB_NO_SYNC, NULL);
+}
+
+static void* cgroup_watcher(void *arg) {
+    cgroup_info_t *cgroup_info = arg;
+
+    struct pollfd fds[2] = {
+        { .fd = cgroup_info->wakeup_fd[0], .events = POLLIN },
+        { .fd = cgroup_info->inotify_fd,   .events = POLLIN },
+    };
+    nfds_t nfds = cgroup_info->inotify_fd >= 0 ? 2 : 1;
+    int timeout = CGROUP_POLL_MIN_MS;
+
+    while (true) {
+        if (poll(fds, nfds, timeout) < 0 && errno != EINTR) {
+            warning("cgroup watcher: poll failed: %s", strerror(errno));
+            break;
+        }
+
+        /* Finalization request */
+        if (fds[0].revents & POLLIN) break;
+
+        /* Drain inotify events, the cpuset file is always re-read */
+        if (nfds == 2 && fds[1].revents & POLLIN) {
+            char buffer[4096];
+            while (read(cgroup_info->inotify_fd, buffer, sizeof(buffer)) > 0);
+        }
+
+        bool changed = false;
+        cpu_set_t cpuset;
+        if (cgroup_cpuset_read(cgroup_info->path, &cpuset) == DLB_SUCCESS
+                && !CPU_EQUAL(&cpuset, &cgroup_info->cpuset)) {
+            int error = cgroup_cpuset_update(cgroup_info->spd, &cgroup_info->cpuset, &cpuset);
+            if (error == DLB_SUCCESS || error == DLB_NOUPDT) {
+                memcpy(&cgroup_info->cpuset, &cpuset, sizeof(cpu_set_t));
+                changed = true;
+            } else if (error == DLB_ERR_PERM) {
+                /* Other processes owning CPUs of the cpuset are pending to
+                 * release some CPUs. Retry with backoff, warn only once */
+                if (!CPU_EQUAL(&cpuset, &cgroup_info->failed_cpuset)) {
+                    warning("cgroup cpuset %s contains CPUs that cannot be taken from"
+                            " other processes yet, retrying", mu_to_str(&cpuset));
+                    memcpy(&cgroup_info->failed_cpuset, &cpuset, sizeof(cpu_set_t));
+                }
+            } else {
+                /* if the update failed, e.g., process is dirty, retry soon */
+                changed = true;
+            }
+        }
+
+        timeout = changed ? CGROUP_POLL_MIN_MS : min_int(timeout * 2, CGROUP_POLL_MAX_MS);
+    }
+
+    return NULL;
+}
+
+void cgroup_cpuset_init(subprocess_descriptor_t *spd) {
+
+    spd->cgroup_info = NULL;
+    if (!spd->options.drom) {
+        warning("Option --drom-cgroup requires --drom, cgroup watcher is disabled");
+        return;
+    }
+
+    cgroup_info_t *cgroup_info = malloc(sizeof(cgroup_info_t));
+    *cgroup_info = (const cgroup_info_t) {
+        .spd = spd,
+        .inotify_fd = -1,
+    };
+
+    int error;
+    if (strlen(spd->options.drom_cgroup_path) > 0) {
+        snprintf(cgroup_info->path, PATH_MAX, "%s", spd->options.drom_cgroup_path);
+        error = DLB_SUCCESS;
+    } else {
+        error = get_cgroup_path(cgroup_info->path, PATH_MAX);
+    }
+    error = error ? error : cgroup_cpuset_read(cgroup_info->path, &cgroup_info->cpuset);
+    if (error != DLB_SUCCESS) {
+        warning("Could not read the cgroup v2 cpuset of the process, cgroup watcher"
+                " is disabled");
+        free(cgroup_info);
+        return;
+    }
+
+    if (pipe(cgroup_info->wakeup_fd) != 0) {
+        warning("cgroup watcher: pipe failed: %s", strerror(errno));
+        free(cgroup_info);
+        return;
+    }
+
+    /* Inotify is optional, the watcher falls back to polling */
+    char events_path[PATH_MAX];
+    cgroup_info->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (cgroup_info->inotify_fd >= 0
+            && (snprintf(events_path, PATH_MAX, "%s/%s", cgroup_info->path,
+                    events_filename) >= PATH_MAX
+                || inotify_add_watch(cgroup_info->inotify_fd, events_path,
+                    IN_MODIFY) < 0)) {
+        close(cgroup_info->inotify_fd);
+        cgroup_info->inotify_fd = -1;
+    }
+
+    error = pthread_create(&cgroup_info->thread, NULL, cgroup_watcher, cgroup_info);
+    if (error != 0) {
+        warning("cgroup watcher: pthread_create failed: %s", strerror(error));
+        if (cgroup_info->inotify_fd >= 0) {
+            close(cgroup_info->inotify_fd);
+        }
+        close(cgroup_info->wakeup_fd[0]);
+        close(cgroup_info->wakeup_fd[1]);
+        free(cgroup_info);
+        return;
+    }
+    spd->cgroup_info = cgroup_info;
+
+    verbose(VB_DROM, "Watching cgroup %s, cpuset: %s", cgroup_info->path,
+            mu_to_str(&cgroup_info->cpuset));
+}
+
+void cgroup_cpuset_finalize(subprocess_descriptor_t *spd) {
+    cgroup_info_t *cgroup_info = spd->cgroup_info;
+    if (cgroup_info == NULL) return;
+
+    if (write(cgroup_info->wakeup_fd[1], "", 1) == 1) {
+        pthread_join(cgroup_info->thread, NULL);
+    } else {
+        pthread_cancel(cgroup_info->thread);
+        pthread_join(cgroup_info->thread, NULL);
+    }
+
+    if (cgroup_info->inotify_fd >= 0) {
+        close(cgroup_info->inotify_fd);
+    }
+    close(cgroup_info->wakeup_fd[0]);
+    close(cgroup_info->wakeup_fd[1]);
+    free(cgroup_info);
+    spd->cgroup_info = NULL;
+}
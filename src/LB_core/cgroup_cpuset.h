@@ -0,0 +1,36 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifndef CGROUP_CPUSET_H
+#define CGROUP_CPUSET_H
+
+#include "LB_core/spd.h"
+
+#include <sched.h>
+
+/* Watcher of the cgroup v2 cpuset of the process. Changes in the effective
+ * cpuset are translated into DROM mask updates for the process itself. */
+
+void cgroup_cpuset_init(subprocess_descriptor_t *spd);
+void cgroup_cpuset_finalize(subprocess_descriptor_t *spd);
+int  cgroup_cpuset_read(const char *cgroup_path, cpu_set_t *cpuset);
+int  cgroup_cpuset_update(const subprocess_descriptor_t *spd,
+        const cpu_set_t *old_cpuset, const cpu_set_t *new_cpuset);
+
+#endif /* CGROUP_CPUSET_H */
@@ -27,6 +27,7 @@
 #include "apis/dlb_types.h"
 #include "LB_core/spd.h"
 #include "LB_comm/shmem_barrier.h"
+#include "support/atomic.h"
 #include "support/debug.h"
 #include "support/tracing.h"
 
@@ -40,11 +41,25 @@ typedef struct barrier_info {
     barrier_t *default_barrier;
     barrier_t **barrier_list;
     int max_barriers;
+    atomic_int *npending;   /* per shmem barrier, arrivals not left yet */
 } barrier_info_t;
 
 static const char *default_barrier_name = "default";
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* Arrivals of this subprocess at the barrier that have not left it yet. The
+ * barrier cannot be detached meanwhile, otherwise the episode would be
+ * released without them. The counter is increased before arriving, and
+ * checked by shmem_barrier under the barrier wrlock, which excludes arrivals */
+static atomic_int* get_npending(barrier_info_t *barrier_info, const barrier_t *barrier) {
+    return &barrier_info->npending[shmem_barrier__get_index(barrier)];
+}
+
+static int detach(barrier_info_t *barrier_info, barrier_t *barrier) {
+    return shmem_barrier__detach_if_not_pending(barrier,
+            get_npending(barrier_info, barrier));
+}
+
 /* Parse, for the specific barrier, whether it should do LeWI based on:
  * - if barrier_name == default_barrier_name:
  *      if lewi_barrier and !lewi_barrier_select;
@@ -61,10 +76,11 @@ static bool parse_lewi_barrier(const char *barrier_name, bool lewi_barrier,
             return lewi_barrier;
         }
     } else {
-        if (api_flags == DLB_BARRIER_LEWI_ON) {
+        int lewi_flags = api_flags & (DLB_BARRIER_LEWI_ON | DLB_BARRIER_LEWI_RUNTIME);
+        if (lewi_flags == DLB_BARRIER_LEWI_ON) {
             /* Named barrier: LeWI is forced by API */
             return true;
-        } else if (api_flags == DLB_BARRIER_LEWI_OFF) {
+        } else if (lewi_flags == DLB_BARRIER_LEWI_OFF) {
             /* Named barrier: LeWI is disallowed by API */
             return false;
         }
@@ -125,11 +141,13 @@ void node_barrier_init(subprocess_descriptor_t *spd) {
 
         /* Initialize default barrier */
         barrier_info->default_barrier = shmem_barrier__register(
-                barrier_info->default_barrier_name, lewi_barrier);
+                barrier_info->default_barrier_name, lewi_barrier,
+                spd->options.barrier_futex);
 
         /* Initialize barrier_list */
         barrier_info->max_barriers = shmem_barrier__get_max_barriers();
         barrier_info->barrier_list = calloc(barrier_info->max_barriers, sizeof(void*));
+        barrier_info->npending = calloc(barrier_info->max_barriers, sizeof(atomic_int));
     }
     pthread_mutex_unlock(&mutex);
 
@@ -150,6 +168,7 @@ void node_barrier_finalize(subprocess_descriptor_t *spd) {
                 shmem_barrier__detach(barrier_info->barrier_list[i]);
             }
             free(barrier_info->barrier_list);
+            free(barrier_info->npending);
             *barrier_info = (const barrier_info_t){};
             free(spd->barrier_info);
             spd->barrier_info = NULL;
@@ -192,7 +211,9 @@ barrier_t* node_barrier_register(subprocess_descriptor_t *spd,
             bool lewi_barrier = parse_lewi_barrier(barrier_name,
                     spd->options.lewi_barrier,
                     spd->options.lewi_barrier_select, flags);
-            barrier = shmem_barrier__register(barrier_name, lewi_barrier);
+            bool futex_barrier = spd->options.barrier_futex
+                || flags & DLB_BARRIER_FUTEX;
+            barrier = shmem_barrier__register(barrier_name, lewi_barrier, futex_barrier);
             if (barrier == NULL) return NULL;
         }
 
@@ -217,46 +238,55 @@ barrier_t* node_barrier_register(subprocess_descriptor_t *spd,
     return barrier;
 }
 
+/* Return the barrier to use, the default one if barrier is NULL, or NULL if
+ * the barrier is not registered by this process, e.g., a detached barrier */
+static barrier_t* get_barrier(barrier_info_t *barrier_info, barrier_t *barrier) {
+    if (barrier == NULL) {
+        /* If barrier is not provided we only need to check the reserved
+         * position in barrier_list */
+        return barrier_info->default_barrier;
+    } else if (unlikely(barrier == barrier_info->default_barrier)) {
+        /* barrier provided is the default barrier, nothing to do.
+         * (default_barrier pointer is never exposed, keep this one just in case) */
+        return barrier;
+    }
+
+    /* Otherwise, we need to check whether the provided barrier has
+     * not been detached */
+    int i = 0;
+    int max_barriers = barrier_info->max_barriers;
+    pthread_mutex_lock(&mutex);
+    {
+        while (i<max_barriers
+                && barrier_info->barrier_list[i] != NULL
+                && barrier_info->barrier_list[i] != barrier) {
+            ++i;
+        }
+
+        if (i == max_barriers || barrier_info->barrier_list[i] == NULL) {
+            /* Not found in barrier_list */
+            barrier = NULL;
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+
+    return barrier;
+}
+
 int node_barrier(const subprocess_descriptor_t *spd, barrier_t *barrier) {
     int error;
     barrier_info_t *barrier_info = spd->barrier_info;
     if (barrier_info) {
-        /* Check whether barrier is valid */
-        if (barrier == NULL) {
-            /* If barrier is not provided we only need to check the reserved
-             * position in barrier_list */
-            if (barrier_info->default_barrier != NULL) {
-                barrier = barrier_info->default_barrier;
-            }
-        } else if (unlikely(barrier == barrier_info->default_barrier)) {
-            /* barrier provided is the default barrier, nothing to do.
-             * (default_barrier pointer is never exposed, keep this one just in case) */
-        } else {
-            /* Otherwise, we need to check whether the provided barrier has
-             * not been detached */
-            int i = 0;
-            int max_barriers = barrier_info->max_barriers;
-            pthread_mutex_lock(&mutex);
-            {
-                while (i<max_barriers
-                        && barrier_info->barrier_list[i] != NULL
-                        && barrier_info->barrier_list[i] != barrier) {
-                    ++i;
-                }
-
-                if (i == max_barriers || barrier_info->barrier_list[i] == NULL) {
-                    /* Not found in barrier_list */
-                    barrier = NULL;
-                }
-            }
-            pthread_mutex_unlock(&mutex);
-        }
+        barrier = get_barrier(barrier_info, barrier);
 
         /* If barrier was found, perform the actual barrier */
         if (barrier != NULL) {
+            atomic_int *npending = get_npending(barrier_info, barrier);
+            DLB_ATOMIC_ADD(npending, 1);
             instrument_event(RUNTIME_EVENT, EVENT_BARRIER, EVENT_BEGIN);
             shmem_barrier__barrier(barrier);
             instrument_event(RUNTIME_EVENT, EVENT_BARRIER, EVENT_END);
+            DLB_ATOMIC_SUB(npending, 1);
             error = DLB_SUCCESS;
         } else {
             /* barrier not found in barrier_info, possibly a detached barrier */
@@ -269,6 +299,88 @@ int node_barrier(const subprocess_descriptor_t *spd, barrier_t *barrier) {
     return error;
 }
 
+int node_barrier_arrive(const subprocess_descriptor_t *spd, barrier_t *barrier) {
+    int error;
+    barrier_info_t *barrier_info = spd->barrier_info;
+    if (barrier_info) {
+        barrier = get_barrier(barrier_info, barrier);
+        if (barrier != NULL) {
+            atomic_int *npending = get_npending(barrier_info, barrier);
+            DLB_ATOMIC_ADD(npending, 1);
+            error = shmem_barrier__arrive(barrier);
+            if (error != DLB_SUCCESS) {
+                DLB_ATOMIC_SUB(npending, 1);
+            }
+        } else {
+            error = DLB_NOUPDT;
+        }
+    } else {
+        error = DLB_ERR_NOCOMP;
+    }
+
+    return error;
+}
+
+int node_barrier_wait(const subprocess_descriptor_t *spd, barrier_t *barrier) {
+    int error;
+    barrier_info_t *barrier_info = spd->barrier_info;
+    if (barrier_info) {
+        barrier = get_barrier(barrier_info, barrier);
+        if (barrier != NULL) {
+            instrument_event(RUNTIME_EVENT, EVENT_BARRIER, EVENT_BEGIN);
+            error = shmem_barrier__wait(barrier);
+            instrument_event(RUNTIME_EVENT, EVENT_BARRIER, EVENT_END);
+            if (error == DLB_SUCCESS) {
+                DLB_ATOMIC_SUB(get_npending(barrier_info, barrier), 1);
+            }
+        } else {
+            error = DLB_NOUPDT;
+        }
+    } else {
+        error = DLB_ERR_NOCOMP;
+    }
+
+    return error;
+}
+
+int node_barrier_test(const subprocess_descriptor_t *spd, barrier_t *barrier) {
+    int error;
+    barrier_info_t *barrier_info = spd->barrier_info;
+    if (barrier_info) {
+        barrier = get_barrier(barrier_info, barrier);
+        if (barrier != NULL) {
+            error = shmem_barrier__test(barrier);
+            if (error == DLB_SUCCESS) {
+                DLB_ATOMIC_SUB(get_npending(barrier_info, barrier), 1);
+            }
+        } else {
+            error = DLB_NOUPDT;
+        }
+    } else {
+        error = DLB_ERR_NOCOMP;
+    }
+
+    return error;
+}
+
+int node_barrier_get_stats(const subprocess_descriptor_t *spd, barrier_t *barrier,
+        dlb_barrier_stats_t *stats) {
+    int error;
+    barrier_info_t *barrier_info = spd->barrier_info;
+    if (barrier_info) {
+        barrier = get_barrier(barrier_info, barrier);
+        if (barrier != NULL) {
+            error = shmem_barrier__get_stats(barrier, stats);
+        } else {
+            error = DLB_NOUPDT;
+        }
+    } else {
+        error = DLB_ERR_NOCOMP;
+    }
+
+    return error;
+}
+
 int node_barrier_attach(subprocess_descriptor_t *spd, barrier_t *barrier) {
     int error;
     barrier_info_t *barrier_info = spd->barrier_info;
@@ -281,7 +393,7 @@ int node_barrier_attach(subprocess_descriptor_t *spd, barrier_t *barrier) {
                         spd->options.lewi_barrier_select, 0);
                 barrier_info->default_barrier = shmem_barrier__register(
                         barrier_info->default_barrier_name,
-                        lewi_barrier);
+                        lewi_barrier, spd->options.barrier_futex);
                 // return number of participants
                 error = barrier_info->default_barrier ? 1 : DLB_ERR_NOMEM;
             } else {
@@ -334,7 +446,7 @@ int node_barrier_detach(subprocess_descriptor_t *spd, barrier_t *barrier) {
         if (barrier == NULL) {
             if (barrier_info->default_barrier != NULL) {
                 /* Detach default barrier */
-                error = shmem_barrier__detach(barrier_info->default_barrier);
+                error = detach(barrier_info, barrier_info->default_barrier);
                 if (error >= 0) {
                     barrier_info->default_barrier = NULL;
                 }
@@ -345,7 +457,7 @@ int node_barrier_detach(subprocess_descriptor_t *spd, barrier_t *barrier) {
         } else if (unlikely(barrier == barrier_info->default_barrier)) {
             /* Detach default barrier.
              * (default_barrier pointer is never exposed, keep this one just in case) */
-            error = shmem_barrier__detach(barrier_info->default_barrier);
+            error = detach(barrier_info, barrier_info->default_barrier);
             if (error >= 0) {
                 barrier_info->default_barrier = NULL;
             }
@@ -366,7 +478,7 @@ int node_barrier_detach(subprocess_descriptor_t *spd, barrier_t *barrier) {
                     error = DLB_ERR_PERM;
                 } else {
                     /* Detach */
-                    error = shmem_barrier__detach(barrier);
+                    error = detach(barrier_info, barrier);
 
                     /* Remove barrier from the barrier_list */
                     if (error >= 0) {
@@ -28,6 +28,11 @@ void node_barrier_finalize(subprocess_descriptor_t *spd);
 barrier_t* node_barrier_register(subprocess_descriptor_t *spd,
         const char *barrier_name, int flags);
 int node_barrier(const subprocess_descriptor_t *spd, barrier_t *barrier);
+int node_barrier_arrive(const subprocess_descriptor_t *spd, barrier_t *barrier);
+int node_barrier_wait(const subprocess_descriptor_t *spd, barrier_t *barrier);
+int node_barrier_test(const subprocess_descriptor_t *spd, barrier_t *barrier);
+int node_barrier_get_stats(const subprocess_descriptor_t *spd, barrier_t *barrier,
+        dlb_barrier_stats_t *stats);
 int node_barrier_attach(subprocess_descriptor_t *spd, barrier_t *barrier);
 int node_barrier_detach(subprocess_descriptor_t *spd, barrier_t *barrier);
 
@@ -0,0 +1,287 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "LB_core/node_rebalance.h"
+
+#include "apis/dlb_errors.h"
+#include "apis/dlb_types.h"
+#include "LB_comm/shmem_procinfo.h"
+#include "LB_comm/shmem_talp.h"
+#include "support/debug.h"
+#include "support/dlb_common.h"
+#include "support/mask_utils.h"
+#include "support/types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Distribute the total number of CPUs proportionally to the useful work of
+ * each process, i.e., efficiency * ncpus, assuming ideal thread scalability.
+ * Every process keeps at least one CPU. */
+void node_rebalance_compute_cpus(int nprocs, const float *efficiency,
+        const int *ncpus, int *new_ncpus) {
+
+    int total_cpus = 0;
+    float total_work = 0.0f;
+    for (int i = 0; i < nprocs; ++i) {
+        total_cpus += ncpus[i];
+        total_work += efficiency[i] * ncpus[i];
+    }
+
+    if (total_work <= 0.0f || total_cpus < nprocs) {
+        memcpy(new_ncpus, ncpus, sizeof(int) * nprocs);
+        return;
+    }
+
+    float *target = malloc(sizeof(float) * nprocs);
+    int assigned = 0;
+    for (int i = 0; i < nprocs; ++i) {
+        target[i] = total_cpus * efficiency[i] * ncpus[i] / total_work;
+        new_ncpus[i] = max_int(1, (int)target[i]);
+        assigned += new_ncpus[i];
+    }
+
+    /* Largest remainder: give the CPUs left to the most underassigned processes */
+    while (assigned < total_cpus) {
+        int best = 0;
+        for (int i = 1; i < nprocs; ++i) {
+            if (target[i] - new_ncpus[i] > target[best] - new_ncpus[best]) {
+                best = i;
+            }
+        }
+        ++new_ncpus[best];
+        ++assigned;
+    }
+
+    /* Only if some process was rounded up to one CPU */
+    while (assigned > total_cpus) {
+        int worst = -1;
+        for (int i = 0; i < nprocs; ++i) {
+            if (new_ncpus[i] > 1
+                    && (worst == -1
+                        || target[i] - new_ncpus[i] < target[worst] - new_ncpus[worst])) {
+                worst = i;
+            }
+        }
+        --new_ncpus[worst];
+        --assigned;
+    }
+
+    free(target);
+}
+
+/* Donors release their last CPUs, receivers take them preferably from the
+ * NUMA nodes they already use */
+static void compute_new_masks(node_rebalance_proc_t **procs, int nprocs) {
+
+    cpu_set_t pool;
+    CPU_ZERO(&pool);
+
+    for (int i = 0; i < nprocs; ++i) {
+        node_rebalance_proc_t *proc = procs[i];
+        memcpy(&proc->new_mask, &proc->mask, sizeof(cpu_set_t));
+        for (int n = proc->ncpus; n > proc->new_ncpus; --n) {
+            int cpuid = mu_get_last_cpu(&proc->new_mask);
+            CPU_CLR(cpuid, &proc->new_mask);
+            CPU_SET(cpuid, &pool);
+        }
+    }
+
+    for (int i = 0; i < nprocs; ++i) {
+        node_rebalance_proc_t *proc = procs[i];
+        int cpus_to_add = proc->new_ncpus - proc->ncpus;
+        if (cpus_to_add <= 0) continue;
+
+        cpu_set_t near_cpus;
+        mu_get_nodes_intersecting_with_cpuset(&near_cpus, &proc->mask);
+        CPU_AND(&near_cpus, &near_cpus, &pool);
+
+        const cpu_set_t *candidates[] = { &near_cpus, &pool };
+        for (int c = 0; c < 2 && cpus_to_add > 0; ++c) {
+            for (int cpuid = mu_get_first_cpu(candidates[c]);
+                    cpuid >= 0 && cpus_to_add > 0;
+                    cpuid = mu_get_next_cpu(candidates[c], cpuid)) {
+                if (CPU_ISSET(cpuid, &pool)) {
+                    CPU_SET(cpuid, &proc->new_mask);
+                    CPU_CLR(cpuid, &pool);
+                    --cpus_to_add;
+                }
+            }
+        }
+    }
+}
+
+static const node_rebalance_proc_t* find_proc(const node_rebalance_t *nr, pid_t pid) {
+    for (int i = 0; i < nr->nprocs; ++i) {
+        if (nr->procs[i].pid == pid) {
+            return &nr->procs[i];
+        }
+    }
+    return NULL;
+}
+
+// The init, finalize and step functions are used by the dlb_rebalance utility,
+// they are exported although they do not belong to the public API
+DLB_EXPORT_SYMBOL
+void node_rebalance_init(node_rebalance_t *nr, const char *region_name,
+        float hysteresis, bool dry_run) {
+    mu_init();
+    *nr = (const node_rebalance_t) {
+        .hysteresis = hysteresis,
+        .dry_run = dry_run,
+        .max_procs = mu_get_system_size(),
+    };
+    snprintf(nr->region_name, DLB_MONITOR_NAME_MAX, "%s",
+            region_name != NULL ? region_name : DLB_GLOBAL_REGION_NAME);
+}
+
+DLB_EXPORT_SYMBOL
+void node_rebalance_finalize(node_rebalance_t *nr) {
+    free(nr->procs);
+    nr->procs = NULL;
+    nr->nprocs = 0;
+}
+
+/* Sample the TALP times of every process in the node and, if the load
+ * imbalance since the previous step exceeds the hysteresis threshold,
+ * redistribute the CPUs among them. Returns DLB_NOUPDT if no redistribution
+ * is needed */
+DLB_EXPORT_SYMBOL
+int node_rebalance_step(node_rebalance_t *nr) {
+
+    talp_region_list_t *region_list = malloc(sizeof(talp_region_list_t) * nr->max_procs);
+    int nelems;
+    int error = shmem_talp__get_regionlist(region_list, &nelems, nr->max_procs,
+            nr->region_name);
+    if (error != DLB_SUCCESS) {
+        free(region_list);
+        return error;
+    }
+
+    /* Sample every process registered in both TALP and DROM */
+    node_rebalance_proc_t *procs = malloc(sizeof(node_rebalance_proc_t) * nr->max_procs);
+    node_rebalance_proc_t **balanced_procs = malloc(sizeof(node_rebalance_proc_t*) * nr->max_procs);
+    int nprocs = 0;
+    int nbalanced = 0;
+    for (int i = 0; i < nelems; ++i) {
+        node_rebalance_proc_t *proc = &procs[nprocs];
+        if (shmem_procinfo__getprocessmask(region_list[i].pid, &proc->mask,
+                    DLB_DROM_FLAGS_NONE) != DLB_SUCCESS) {
+            continue;
+        }
+        proc->pid = region_list[i].pid;
+        proc->mpi_time = region_list[i].mpi_time;
+        proc->useful_time = region_list[i].useful_time;
+        proc->efficiency = -1.0f;
+        proc->ncpus = CPU_COUNT(&proc->mask);
+        proc->new_ncpus = proc->ncpus;
+        memcpy(&proc->new_mask, &proc->mask, sizeof(cpu_set_t));
+        ++nprocs;
+
+        const node_rebalance_proc_t *prev = find_proc(nr, proc->pid);
+        if (prev != NULL && proc->ncpus > 0) {
+            int64_t mpi_time = proc->mpi_time - prev->mpi_time;
+            int64_t useful_time = proc->useful_time - prev->useful_time;
+            if (mpi_time >= 0 && useful_time >= 0 && mpi_time + useful_time > 0) {
+                proc->efficiency = (float)useful_time / (useful_time + mpi_time);
+                balanced_procs[nbalanced++] = proc;
+            }
+        }
+    }
+    free(region_list);
+
+    free(nr->procs);
+    nr->procs = procs;
+    nr->nprocs = nprocs;
+    nr->imbalance = 0.0f;
+
+    if (nbalanced < 2) {
+        free(balanced_procs);
+        return DLB_NOUPDT;
+    }
+
+    /* Load balance as in the POP metrics: average over maximum efficiency */
+    float sum_efficiency = 0.0f;
+    float max_efficiency = 0.0f;
+    for (int i = 0; i < nbalanced; ++i) {
+        sum_efficiency += balanced_procs[i]->efficiency;
+        if (balanced_procs[i]->efficiency > max_efficiency) {
+            max_efficiency = balanced_procs[i]->efficiency;
+        }
+    }
+    nr->imbalance = max_efficiency > 0.0f
+        ? 1.0f - sum_efficiency / nbalanced / max_efficiency : 0.0f;
+
+    verbose(VB_DROM, "Node rebalance: region %s, %d processes, imbalance %.2f",
+            nr->region_name, nbalanced, nr->imbalance);
+
+    if (nr->imbalance < nr->hysteresis) {
+        free(balanced_procs);
+        return DLB_NOUPDT;
+    }
+
+    /* Compute the new number of CPUs and masks */
+    float *efficiency = malloc(sizeof(float) * nbalanced);
+    int *ncpus = malloc(sizeof(int) * nbalanced);
+    int *new_ncpus = malloc(sizeof(int) * nbalanced);
+    for (int i = 0; i < nbalanced; ++i) {
+        efficiency[i] = balanced_procs[i]->efficiency;
+        ncpus[i] = balanced_procs[i]->ncpus;
+    }
+    node_rebalance_compute_cpus(nbalanced, efficiency, ncpus, new_ncpus);
+    for (int i = 0; i < nbalanced; ++i) {
+        balanced_procs[i]->new_ncpus = new_ncpus[i];
+    }
+    free(efficiency);
+    free(ncpus);
+    free(new_ncpus);
+    compute_new_masks(balanced_procs, nbalanced);
+
+    /* Apply all the new masks at once, if any */
+    pid_t *pidlist = malloc(sizeof(pid_t) * nbalanced);
+    cpu_set_t *masks = malloc(sizeof(cpu_set_t) * nbalanced);
+    int nchanges = 0;
+    for (int i = 0; i < nbalanced; ++i) {
+        const node_rebalance_proc_t *proc = balanced_procs[i];
+        if (!CPU_EQUAL(&proc->mask, &proc->new_mask)) {
+            verbose(VB_DROM, "Node rebalance: process %d, %d -> %d CPUs, %s",
+                    proc->pid, proc->ncpus, proc->new_ncpus, mu_to_str(&proc->new_mask));
+            pidlist[nchanges] = proc->pid;
+            memcpy(&masks[nchanges], &proc->new_mask, sizeof(cpu_set_t));
+            ++nchanges;
+        }
+    }
+
+    if (nchanges == 0) {
+        error = DLB_NOUPDT;
+    } else if (!nr->dry_run) {
+        error = shmem_procinfo__setprocessmasks(pidlist, masks, nchanges);
+    }
+
+    free(pidlist);
+    free(masks);
+    free(balanced_procs);
+
+    return error;
+}
@@ -0,0 +1,62 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifndef NODE_REBALANCE_H
+#define NODE_REBALANCE_H
+
+#include "apis/dlb_talp.h"
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sched.h>
+
+/* Node-level rebalancing of CPUs among DROM processes. The CPU distribution is
+ * computed from the TALP times that each process exposes in the shared memory
+ * for a given region, and applied through the DROM process masks. */
+
+typedef struct node_rebalance_proc_t {
+    pid_t       pid;
+    int64_t     mpi_time;       /* accumulated MPI time at the last step */
+    int64_t     useful_time;    /* accumulated useful time at the last step */
+    float       efficiency;     /* parallel efficiency since the previous step, or -1 */
+    int         ncpus;
+    int         new_ncpus;
+    cpu_set_t   mask;
+    cpu_set_t   new_mask;
+} node_rebalance_proc_t;
+
+typedef struct node_rebalance_t {
+    char        region_name[DLB_MONITOR_NAME_MAX];
+    float       hysteresis;     /* minimum load imbalance, [0,1], to redistribute CPUs */
+    bool        dry_run;        /* compute the new masks but do not apply them */
+    float       imbalance;      /* load imbalance observed in the last step */
+    int         nprocs;
+    int         max_procs;
+    node_rebalance_proc_t *procs;
+} node_rebalance_t;
+
+void node_rebalance_init(node_rebalance_t *nr, const char *region_name,
+        float hysteresis, bool dry_run);
+void node_rebalance_finalize(node_rebalance_t *nr);
+int  node_rebalance_step(node_rebalance_t *nr);
+void node_rebalance_compute_cpus(int nprocs, const float *efficiency,
+        const int *ncpus, int *new_ncpus);
+
+#endif /* NODE_REBALANCE_H */
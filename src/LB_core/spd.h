@@ -48,6 +48,7 @@ typedef struct SubProcessDescriptor {
     void *talp_info;
     void *barrier_info;
     void *mngo_info;
+    void *cgroup_info;
 } subprocess_descriptor_t;
 
 extern __thread subprocess_descriptor_t *thread_spd;
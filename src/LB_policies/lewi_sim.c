@@ -0,0 +1,796 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "LB_policies/lewi_sim.h"
+
+#include "apis/dlb_errors.h"
+#include "LB_comm/shmem.h"
+#include "LB_comm/shmem_cpuinfo.h"
+#include "LB_comm/shmem_cpuinfo_log.h"
+#include "LB_core/lb_funcs.h"
+#include "LB_core/spd.h"
+#include "LB_numThreads/numThreads.h"
+#include "LB_policies/lewi_mask.h"
+#include "support/debug.h"
+#include "support/dlb_common.h"
+#include "support/mask_utils.h"
+#include "support/options.h"
+#include "support/types.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <float.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Remaining work below this threshold is considered finished */
+#define SIM_EPSILON 1e-9
+
+
+/*********************************************************************************/
+/*  Trace                                                                        */
+/*********************************************************************************/
+
+static int parse_event_type(const char *str, lewi_sim_event_type_t *type) {
+    if (strcmp(str, "compute") == 0)        *type = LEWI_SIM_COMPUTE;
+    else if (strcmp(str, "serial") == 0)    *type = LEWI_SIM_SERIAL;
+    else if (strcmp(str, "mpi") == 0)       *type = LEWI_SIM_MPI;
+    else if (strcmp(str, "barrier") == 0)   *type = LEWI_SIM_BARRIER;
+    else return DLB_ERR_NOCOMP;
+    return DLB_SUCCESS;
+}
+
+static void add_event(lewi_sim_trace_t *trace, int rank,
+        lewi_sim_event_type_t type, double value) {
+
+    /* Grow the array of ranks if needed */
+    if (rank >= trace->nranks) {
+        int nranks = rank + 1;
+        trace->nevents = realloc(trace->nevents, sizeof(int) * nranks);
+        trace->events = realloc(trace->events, sizeof(lewi_sim_event_t*) * nranks);
+        for (int i = trace->nranks; i < nranks; ++i) {
+            trace->nevents[i] = 0;
+            trace->events[i] = NULL;
+        }
+        trace->nranks = nranks;
+    }
+
+    /* Grow the array of events of this rank (capacity is a power of two) */
+    int n = trace->nevents[rank];
+    if (n == 0 || (n & (n - 1)) == 0) {
+        trace->events[rank] = realloc(trace->events[rank],
+                sizeof(lewi_sim_event_t) * (n == 0 ? 1 : n * 2));
+    }
+    trace->events[rank][n] = (const lewi_sim_event_t) {.type = type, .value = value};
+    trace->nevents[rank] = n + 1;
+}
+
+/* Trace format: one event per line, "rank,type[,value]", where type is one of
+ * compute, serial, mpi or barrier. Events of each rank are replayed in order.
+ * Empty lines, lines starting with '#' and a header line are ignored. */
+DLB_EXPORT_SYMBOL
+int lewi_sim_load_trace(const char *filename, lewi_sim_trace_t **trace) {
+
+    FILE *fd = fopen(filename, "r");
+    if (fd == NULL) {
+        warning("Cannot open trace %s: %s", filename, strerror(errno));
+        return DLB_ERR_NOENT;
+    }
+
+    lewi_sim_trace_t *new_trace = malloc(sizeof(lewi_sim_trace_t));
+    *new_trace = (const lewi_sim_trace_t) {};
+
+    int error = DLB_SUCCESS;
+    int line_number = 0;
+    bool first_line = true;
+    char line[256];
+    while (error == DLB_SUCCESS && fgets(line, sizeof(line), fd) != NULL) {
+        ++line_number;
+
+        /* Skip comments and empty lines */
+        char *str = line;
+        while (isspace((unsigned char)*str)) ++str;
+        if (*str == '\0' || *str == '#') continue;
+
+        /* A header line is allowed only before the first event */
+        bool header = first_line && !isdigit((unsigned char)*str);
+        first_line = false;
+        if (header) continue;
+
+        /* Parse fields */
+        int rank;
+        char type_str[16];
+        double value = 0.0;
+        int nfields = sscanf(str, "%d , %15[a-z] , %lf", &rank, type_str, &value);
+        lewi_sim_event_type_t type;
+        if (nfields < 2
+                || rank < 0
+                || value < 0.0
+                || parse_event_type(type_str, &type) != DLB_SUCCESS
+                || (nfields < 3 && type != LEWI_SIM_BARRIER)) {
+            warning("%s:%d: Malformed trace event: %s", filename, line_number, str);
+            error = DLB_ERR_NOCOMP;
+            break;
+        }
+
+        add_event(new_trace, rank, type, value);
+    }
+    fclose(fd);
+
+    if (error == DLB_SUCCESS && new_trace->nranks == 0) {
+        warning("Trace %s does not contain any event", filename);
+        error = DLB_ERR_NOCOMP;
+    }
+
+    if (error == DLB_SUCCESS) {
+        *trace = new_trace;
+    } else {
+        lewi_sim_free_trace(new_trace);
+    }
+
+    return error;
+}
+
+DLB_EXPORT_SYMBOL
+void lewi_sim_free_trace(lewi_sim_trace_t *trace) {
+    if (trace == NULL) return;
+    for (int i = 0; i < trace->nranks; ++i) {
+        free(trace->events[i]);
+    }
+    free(trace->events);
+    free(trace->nevents);
+    free(trace);
+}
+
+
+/*********************************************************************************/
+/*  Simulation                                                                   */
+/*********************************************************************************/
+
+typedef enum sim_rank_state_t {
+    RANK_RUNNING,
+    RANK_IN_BARRIER,
+    RANK_DONE,
+} sim_rank_state_t;
+
+typedef struct sim_rank_t {
+    subprocess_descriptor_t spd;
+    cpu_set_t mask;                 /* CPUs currently enabled by LeWI */
+    int main_cpuid;                 /* CPU of the thread that calls MPI */
+    bool main_cpu_lent;             /* main CPU lent during a blocking call */
+    const lewi_sim_event_t *events;
+    int nevents;
+    int next_event;
+    sim_rank_state_t state;
+    lewi_sim_event_type_t type;     /* type of the current event */
+    double remaining;               /* remaining work of the current event */
+} sim_rank_t;
+
+typedef struct sim_t {
+    sim_rank_t *ranks;
+    int nranks;
+    int ncpus;
+    bool lewi;
+    double time;
+    double useful_time;
+} sim_t;
+
+/* Callbacks to keep track of the CPUs enabled by LeWI, arg is a cpu_set_t */
+static void cb_enable_cpu(int cpuid, void *arg) {
+    cpu_set_t *mask = arg;
+    CPU_SET(cpuid, mask);
+}
+
+static void cb_disable_cpu(int cpuid, void *arg) {
+    cpu_set_t *mask = arg;
+    CPU_CLR(cpuid, mask);
+}
+
+/* Whether the MPI call of the current event lends the main CPU */
+static bool lends_on_blocking_call(const sim_rank_t *rank) {
+    const options_t *options = &rank->spd.options;
+    if (options->lewi_keep_cpu_on_blocking_call) return false;
+    switch (options->lewi_mpi_calls) {
+        case MPISET_ALL:
+            return true;
+        case MPISET_BARRIER:
+        case MPISET_COLLECTIVES:
+            return rank->type == LEWI_SIM_BARRIER;
+        default:
+            return false;
+    }
+}
+
+/* Emulate what the OMPT manager does at the beginning of a parallel region */
+static void begin_parallel(sim_t *sim, sim_rank_t *rank) {
+    if (!sim->lewi) return;
+    omptool_opts_t lewi_ompt = rank->spd.options.lewi_ompt;
+    if (lewi_ompt & OMPTOOL_OPTS_BORROW) {
+        lewi_mask_Return(&rank->spd);
+    }
+    if (lewi_ompt & (OMPTOOL_OPTS_BORROW | OMPTOOL_OPTS_LEND)) {
+        lewi_mask_Reclaim(&rank->spd);
+    }
+    if (lewi_ompt & OMPTOOL_OPTS_BORROW) {
+        lewi_mask_Borrow(&rank->spd);
+    }
+}
+
+/* Emulate what the OMPT manager does at the end of a parallel region */
+static void end_parallel(sim_t *sim, sim_rank_t *rank) {
+    if (!sim->lewi) return;
+    if (rank->spd.options.lewi_ompt & OMPTOOL_OPTS_LEND) {
+        cpu_set_t workers;
+        memcpy(&workers, &rank->mask, sizeof(cpu_set_t));
+        CPU_CLR(rank->main_cpuid, &workers);
+        if (CPU_COUNT(&workers) > 0) {
+            mu_subtract(&rank->mask, &rank->mask, &workers);
+            lewi_mask_LendCpuMask(&rank->spd, &workers);
+        }
+    }
+}
+
+/* Equivalent to lewi_mask_IntoBlockingCall for the main thread of the rank */
+static void into_blocking_call(sim_t *sim, sim_rank_t *rank) {
+    if (!sim->lewi || !lends_on_blocking_call(rank)) return;
+    CPU_CLR(rank->main_cpuid, &rank->mask);
+    lewi_mask_LendCpu(&rank->spd, rank->main_cpuid);
+    rank->main_cpu_lent = true;
+}
+
+/* Equivalent to lewi_mask_OutOfBlockingCall for the main thread of the rank */
+static void out_of_blocking_call(sim_t *sim, sim_rank_t *rank) {
+    if (!rank->main_cpu_lent) return;
+    lewi_mask_AcquireCpu(&rank->spd, rank->main_cpuid);
+    rank->main_cpu_lent = false;
+}
+
+static void begin_event(sim_t *sim, sim_rank_t *rank) {
+    if (rank->next_event == rank->nevents) {
+        /* The rank has finished, its CPUs are no longer needed */
+        rank->state = RANK_DONE;
+        if (sim->lewi && CPU_COUNT(&rank->mask) > 0) {
+            cpu_set_t mask;
+            memcpy(&mask, &rank->mask, sizeof(cpu_set_t));
+            CPU_ZERO(&rank->mask);
+            lewi_mask_LendCpuMask(&rank->spd, &mask);
+        }
+        return;
+    }
+
+    const lewi_sim_event_t *event = &rank->events[rank->next_event];
+    rank->type = event->type;
+    rank->remaining = event->value;
+    rank->state = RANK_RUNNING;
+
+    switch (event->type) {
+        case LEWI_SIM_COMPUTE:
+            begin_parallel(sim, rank);
+            break;
+        case LEWI_SIM_SERIAL:
+            break;
+        case LEWI_SIM_MPI:
+            into_blocking_call(sim, rank);
+            break;
+        case LEWI_SIM_BARRIER:
+            into_blocking_call(sim, rank);
+            rank->state = RANK_IN_BARRIER;
+            break;
+    }
+}
+
+static void end_event(sim_t *sim, sim_rank_t *rank) {
+    switch (rank->type) {
+        case LEWI_SIM_COMPUTE:
+            end_parallel(sim, rank);
+            break;
+        case LEWI_SIM_SERIAL:
+            break;
+        case LEWI_SIM_MPI:
+        case LEWI_SIM_BARRIER:
+            out_of_blocking_call(sim, rank);
+            break;
+    }
+    ++rank->next_event;
+    begin_event(sim, rank);
+}
+
+/* Finish the events without remaining work, which may begin new ones */
+static bool finish_events(sim_t *sim) {
+    bool finished = false;
+    for (int i = 0; i < sim->nranks; ++i) {
+        sim_rank_t *rank = &sim->ranks[i];
+        if (rank->state == RANK_RUNNING && rank->remaining <= SIM_EPSILON) {
+            end_event(sim, rank);
+            finished = true;
+        }
+    }
+    return finished;
+}
+
+/* Release the barrier once every rank that has not finished has reached it */
+static bool release_barrier(sim_t *sim) {
+    int nactive = 0;
+    int nwaiting = 0;
+    for (int i = 0; i < sim->nranks; ++i) {
+        if (sim->ranks[i].state != RANK_DONE) ++nactive;
+        if (sim->ranks[i].state == RANK_IN_BARRIER) ++nwaiting;
+    }
+    if (nwaiting == 0 || nwaiting < nactive) return false;
+
+    /* All ranks are in the barrier at this point */
+    for (int i = 0; i < sim->nranks; ++i) {
+        if (sim->ranks[i].state == RANK_IN_BARRIER) {
+            end_event(sim, &sim->ranks[i]);
+        }
+    }
+    return true;
+}
+
+static bool all_ranks_done(const sim_t *sim) {
+    for (int i = 0; i < sim->nranks; ++i) {
+        if (sim->ranks[i].state != RANK_DONE) return false;
+    }
+    return true;
+}
+
+/* A rank running a parallel region uses all its enabled CPUs, a rank running
+ * serial code only its main CPU. CPUs enabled in more than one rank, i.e.,
+ * reclaimed but not yet returned, are shared evenly. */
+static void compute_rates(const sim_t *sim, double *rates) {
+    int users[CPU_SETSIZE] = {};
+    for (int i = 0; i < sim->nranks; ++i) {
+        const sim_rank_t *rank = &sim->ranks[i];
+        if (rank->state != RANK_RUNNING) continue;
+        if (rank->type == LEWI_SIM_COMPUTE) {
+            for (int cpuid = 0; cpuid < sim->ncpus; ++cpuid) {
+                if (CPU_ISSET(cpuid, &rank->mask)) ++users[cpuid];
+            }
+        } else if (rank->type == LEWI_SIM_SERIAL) {
+            ++users[rank->main_cpuid];
+        }
+    }
+
+    for (int i = 0; i < sim->nranks; ++i) {
+        const sim_rank_t *rank = &sim->ranks[i];
+        rates[i] = 0.0;
+        if (rank->state != RANK_RUNNING) continue;
+        if (rank->type == LEWI_SIM_COMPUTE) {
+            for (int cpuid = 0; cpuid < sim->ncpus; ++cpuid) {
+                if (CPU_ISSET(cpuid, &rank->mask)) rates[i] += 1.0 / users[cpuid];
+            }
+        } else if (rank->type == LEWI_SIM_SERIAL) {
+            rates[i] = 1.0 / users[rank->main_cpuid];
+        } else {
+            /* MPI calls progress in wall time */
+            rates[i] = 1.0;
+        }
+    }
+}
+
+static int simulate(sim_t *sim) {
+    double *rates = malloc(sizeof(double) * sim->nranks);
+
+    for (int i = 0; i < sim->nranks; ++i) {
+        begin_event(sim, &sim->ranks[i]);
+    }
+
+    int error = DLB_SUCCESS;
+    while (true) {
+        while (finish_events(sim) || release_barrier(sim)) {}
+        if (all_ranks_done(sim)) break;
+
+        compute_rates(sim, rates);
+
+        /* Time until the next event finishes */
+        double dt = DBL_MAX;
+        for (int i = 0; i < sim->nranks; ++i) {
+            if (rates[i] > 0.0) {
+                double t = sim->ranks[i].remaining / rates[i];
+                if (t < dt) dt = t;
+            }
+        }
+        if (dt == DBL_MAX) {
+            /* Some rank has no CPU to progress, should not happen */
+            warning("LeWI simulation stalled at time %f", sim->time);
+            error = DLB_ERR_UNKNOWN;
+            break;
+        }
+
+        /* Advance */
+        sim->time += dt;
+        for (int i = 0; i < sim->nranks; ++i) {
+            sim_rank_t *rank = &sim->ranks[i];
+            if (rates[i] > 0.0) {
+                rank->remaining -= rates[i] * dt;
+                if (rank->type == LEWI_SIM_COMPUTE || rank->type == LEWI_SIM_SERIAL) {
+                    sim->useful_time += rates[i] * dt;
+                }
+            }
+        }
+    }
+
+    free(rates);
+    return error;
+}
+
+DLB_EXPORT_SYMBOL
+int lewi_sim_run(const lewi_sim_trace_t *trace, int cpus_per_rank,
+        const char *dlb_args, lewi_sim_result_t *result) {
+
+    int ncpus = trace->nranks * cpus_per_rank;
+    if (cpus_per_rank <= 0 || ncpus > CPU_SETSIZE) {
+        return DLB_ERR_NOCOMP;
+    }
+
+    /* Synthetic node where each rank owns a consecutive block of CPUs, with a
+     * shared memory only visible to this process. Both are restored after
+     * the simulation. */
+    mu_testing_save_sys();
+    mu_testing_set_sys_size(ncpus);
+    shmem_set_private(true);
+
+    sim_t sim = {
+        .ranks = calloc(trace->nranks, sizeof(sim_rank_t)),
+        .nranks = trace->nranks,
+        .ncpus = ncpus,
+    };
+
+    /* Every rank parses the same options */
+    options_t options;
+    options_init(&options, dlb_args);
+    debug_init(&options);
+    options.mode = MODE_POLLING;
+    if (options.shm_key[0] == '\0') {
+        snprintf(options.shm_key, MAX_OPTION_LENGTH, "lewisim%d", getpid());
+    }
+    sim.lewi = options.lewi;
+
+    /* Some shmem_cpuinfo options are read from the thread spd */
+    subprocess_descriptor_t *prev_spd = thread_spd;
+    spd_enter_dlb(&sim.ranks[0].spd);
+
+    int error = DLB_SUCCESS;
+    for (int i = 0; i < sim.nranks; ++i) {
+        sim_rank_t *rank = &sim.ranks[i];
+        rank->spd.id = i + 1;
+        memcpy(&rank->spd.options, &options, sizeof(options_t));
+        CPU_ZERO(&rank->spd.process_mask);
+        for (int cpuid = i * cpus_per_rank; cpuid < (i + 1) * cpus_per_rank; ++cpuid) {
+            CPU_SET(cpuid, &rank->spd.process_mask);
+        }
+        memcpy(&rank->mask, &rank->spd.process_mask, sizeof(cpu_set_t));
+        rank->main_cpuid = i * cpus_per_rank;
+        rank->events = trace->events[i];
+        rank->nevents = trace->nevents[i];
+
+        if (sim.lewi) {
+            error = shmem_cpuinfo__init(rank->spd.id, 0, &rank->spd.process_mask,
+                    options.shm_key, options.lewi_color);
+            if (error != DLB_SUCCESS) break;
+            pm_callback_set(&rank->spd.pm, dlb_callback_enable_cpu,
+                    (dlb_callback_t)cb_enable_cpu, &rank->mask);
+            pm_callback_set(&rank->spd.pm, dlb_callback_disable_cpu,
+                    (dlb_callback_t)cb_disable_cpu, &rank->mask);
+            lewi_mask_Init(&rank->spd);
+        }
+    }
+
+    if (error == DLB_SUCCESS) {
+        error = simulate(&sim);
+    }
+
+    if (sim.lewi) {
+        for (int i = 0; i < sim.nranks; ++i) {
+            sim_rank_t *rank = &sim.ranks[i];
+            if (rank->spd.lewi_info != NULL) {
+                lewi_mask_Finalize(&rank->spd);
+                shmem_cpuinfo__finalize(rank->spd.id, options.shm_key, options.lewi_color);
+            }
+        }
+    }
+
+    thread_spd = prev_spd;
+    free(sim.ranks);
+    shmem_set_private(false);
+    mu_testing_restore_sys();
+
+    if (error == DLB_SUCCESS) {
+        double cpu_time = ncpus * sim.time;
+        *result = (const lewi_sim_result_t) {
+            .ncpus = ncpus,
+            .time_to_solution = sim.time,
+            .useful_time = sim.useful_time,
+            .wasted_time = cpu_time - sim.useful_time,
+            .utilization = cpu_time > 0.0 ? sim.useful_time / cpu_time : 0.0,
+        };
+    }
+
+    return error;
+}
+
+
+/*********************************************************************************/
+/*  Replay                                                                       */
+/*********************************************************************************/
+
+typedef struct replay_process_t {
+    subprocess_descriptor_t spd;
+    cpu_set_t mask;                 /* CPUs currently enabled by LeWI */
+    bool finalized;
+} replay_process_t;
+
+typedef struct replay_t {
+    replay_process_t **processes;
+    int nprocesses;
+    options_t options;
+} replay_t;
+
+static replay_process_t* find_process(const replay_t *replay, pid_t pid) {
+    for (int i = 0; i < replay->nprocesses; ++i) {
+        replay_process_t *process = replay->processes[i];
+        if (process->spd.id == pid && !process->finalized) {
+            return process;
+        }
+    }
+    return NULL;
+}
+
+static int replay_init(replay_t *replay, pid_t pid, const cpu_set_t *process_mask) {
+    if (find_process(replay, pid) != NULL) return DLB_ERR_INIT;
+
+    /* Processes are allocated individually since the policy keeps pointers
+     * to their descriptors */
+    replay_process_t *process = calloc(1, sizeof(replay_process_t));
+    replay->processes = realloc(replay->processes,
+            sizeof(replay_process_t*) * (replay->nprocesses + 1));
+    replay->processes[replay->nprocesses++] = process;
+
+    process->spd.id = pid;
+    memcpy(&process->spd.options, &replay->options, sizeof(options_t));
+    memcpy(&process->spd.process_mask, process_mask, sizeof(cpu_set_t));
+    memcpy(&process->mask, process_mask, sizeof(cpu_set_t));
+    pm_callback_set(&process->spd.pm, dlb_callback_enable_cpu,
+            (dlb_callback_t)cb_enable_cpu, &process->mask);
+    pm_callback_set(&process->spd.pm, dlb_callback_disable_cpu,
+            (dlb_callback_t)cb_disable_cpu, &process->mask);
+    set_lb_funcs(&process->spd.lb_funcs, POLICY_LEWI_MASK);
+
+    int error = shmem_cpuinfo__init(pid, 0, process_mask,
+            replay->options.shm_key, replay->options.lewi_color);
+    if (error != DLB_SUCCESS) {
+        process->finalized = true;
+        return error;
+    }
+    error = process->spd.lb_funcs.init(&process->spd);
+    process->spd.lewi_enabled = true;
+
+    return error;
+}
+
+static void replay_finalize(replay_t *replay, replay_process_t *process) {
+    process->spd.lb_funcs.finalize(&process->spd);
+    shmem_cpuinfo__finalize(process->spd.id, replay->options.shm_key,
+            replay->options.lewi_color);
+    process->finalized = true;
+}
+
+/* The policy lends or reclaims the CPUs of the calling thread in blocking
+ * calls, so the thread takes the recorded affinity during the call */
+static int replay_blocking_call(const subprocess_descriptor_t *spd, bool into,
+        const cpu_set_t *thread_mask) {
+    cpu_set_t prev_mask;
+    pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &prev_mask);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), thread_mask) != 0) {
+        return DLB_ERR_PERM;
+    }
+    int error = into
+        ? spd->lb_funcs.into_blocking_call(spd)
+        : spd->lb_funcs.out_of_blocking_call(spd);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &prev_mask);
+    return error;
+}
+
+/* Execute a recorded operation through the policy */
+static int replay_entry(replay_t *replay, const cpuinfo_log_entry_t *entry) {
+
+    if (entry->op == CPUINFO_LOG_INIT) {
+        return replay_init(replay, entry->pid, &entry->mask);
+    }
+
+    replay_process_t *process = find_process(replay, entry->pid);
+    if (process == NULL) return DLB_ERR_NOPROC;
+
+    subprocess_descriptor_t *spd = &process->spd;
+    const balance_policy_t *lb_funcs = &spd->lb_funcs;
+    int arg = entry->arg;
+    const cpu_set_t *mask = &entry->mask;
+
+    switch(entry->op) {
+        case CPUINFO_LOG_INIT:                      return DLB_ERR_UNKNOWN;
+        case CPUINFO_LOG_FINALIZE:
+            replay_finalize(replay, process);
+            return DLB_SUCCESS;
+        case CPUINFO_LOG_ENABLE:
+            spd->lewi_enabled = true;
+            return lb_funcs->enable(spd);
+        case CPUINFO_LOG_DISABLE:
+            spd->lewi_enabled = false;
+            return lb_funcs->disable(spd);
+        case CPUINFO_LOG_SET_MAX_PARALLELISM:       return lb_funcs->set_max_parallelism(spd, arg);
+        case CPUINFO_LOG_UNSET_MAX_PARALLELISM:     return lb_funcs->unset_max_parallelism(spd);
+        case CPUINFO_LOG_INTO_BLOCKING_CALL:        return replay_blocking_call(spd, true, mask);
+        case CPUINFO_LOG_OUT_OF_BLOCKING_CALL:      return replay_blocking_call(spd, false, mask);
+        case CPUINFO_LOG_LEND:                      return lb_funcs->lend(spd);
+        case CPUINFO_LOG_LEND_CPU:                  return lb_funcs->lend_cpu(spd, arg);
+        case CPUINFO_LOG_LEND_CPUS:                 return lb_funcs->lend_cpus(spd, arg);
+        case CPUINFO_LOG_LEND_CPU_MASK:             return lb_funcs->lend_cpu_mask(spd, mask);
+        case CPUINFO_LOG_RECLAIM:                   return lb_funcs->reclaim(spd);
+        case CPUINFO_LOG_RECLAIM_CPU:               return lb_funcs->reclaim_cpu(spd, arg);
+        case CPUINFO_LOG_RECLAIM_CPUS:              return lb_funcs->reclaim_cpus(spd, arg);
+        case CPUINFO_LOG_RECLAIM_CPU_MASK:          return lb_funcs->reclaim_cpu_mask(spd, mask);
+        case CPUINFO_LOG_ACQUIRE_CPU:               return lb_funcs->acquire_cpu(spd, arg);
+        case CPUINFO_LOG_ACQUIRE_CPUS:              return lb_funcs->acquire_cpus(spd, arg);
+        case CPUINFO_LOG_ACQUIRE_CPU_MASK:          return lb_funcs->acquire_cpu_mask(spd, mask);
+        case CPUINFO_LOG_ACQUIRE_CPUS_IN_MASK:
+            return lb_funcs->acquire_cpus_in_mask(spd, arg, mask);
+        case CPUINFO_LOG_BORROW:                    return lb_funcs->borrow(spd);
+        case CPUINFO_LOG_BORROW_CPU:                return lb_funcs->borrow_cpu(spd, arg);
+        case CPUINFO_LOG_BORROW_CPUS:               return lb_funcs->borrow_cpus(spd, arg);
+        case CPUINFO_LOG_BORROW_CPU_MASK:           return lb_funcs->borrow_cpu_mask(spd, mask);
+        case CPUINFO_LOG_BORROW_CPUS_IN_MASK:
+            return lb_funcs->borrow_cpus_in_mask(spd, arg, mask);
+        case CPUINFO_LOG_RETURN:                    return lb_funcs->return_all(spd);
+        case CPUINFO_LOG_RETURN_CPU:                return lb_funcs->return_cpu(spd, arg);
+        case CPUINFO_LOG_RETURN_CPU_MASK:           return lb_funcs->return_cpu_mask(spd, mask);
+        case CPUINFO_LOG_CHECK_CPU_AVAILABILITY:
+            return lb_funcs->check_cpu_availability(spd, arg);
+        case CPUINFO_LOG_UPDATE_OWNERSHIP:
+            memcpy(&spd->process_mask, mask, sizeof(cpu_set_t));
+            return lb_funcs->update_ownership(spd, mask);
+    }
+
+    return DLB_ERR_UNKNOWN;
+}
+
+/* Execute the operations recorded with --lewi-record until the timestamp
+ * 'until', if positive, through the lewi_mask policy configured with
+ * 'dlb_args' and DLB_ARGS, on a private shared memory. Unlike the recorded
+ * execution, the replay is always in polling mode. Once the operations are
+ * replayed, 'inspect' is called, if not NULL, with the key of the shared
+ * memory, which is removed afterwards. */
+DLB_EXPORT_SYMBOL
+int lewi_sim_replay_log(const cpuinfo_log_entry_t *entries, int nelems, int64_t until,
+        const char *dlb_args, void (*inspect)(const char *shmem_key, void *arg),
+        void *arg) {
+
+    /* The log may come from a node with more CPUs */
+    int system_size = mu_get_system_size();
+    for (int i = 0; i < nelems; ++i) {
+        if (mu_get_last_cpu(&entries[i].mask) >= system_size) {
+            warning("LeWI operation %d of the log uses CPUs beyond the system size (%d)",
+                    i, system_size);
+            return DLB_ERR_NOCOMP;
+        }
+    }
+
+    replay_t replay = {};
+    options_init(&replay.options, dlb_args);
+    debug_init(&replay.options);
+    replay.options.mode = MODE_POLLING;
+    replay.options.lewi_record = false;
+    snprintf(replay.options.shm_key, MAX_OPTION_LENGTH, "replay%d", getpid());
+
+    /* Some shmem_cpuinfo options are read from the thread spd */
+    subprocess_descriptor_t *prev_spd = thread_spd;
+    subprocess_descriptor_t replay_spd = {};
+    memcpy(&replay_spd.options, &replay.options, sizeof(options_t));
+    spd_enter_dlb(&replay_spd);
+
+    /* Keep the shared memory open until it is inspected, even if every
+     * process finalizes before. It is only visible to this process. */
+    shmem_set_private(true);
+    shmem_cpuinfo_ext__init(replay.options.shm_key, replay.options.lewi_color);
+
+    int error = DLB_SUCCESS;
+    int num_skipped = 0;
+    for (int i = 0; i < nelems; ++i) {
+        const cpuinfo_log_entry_t *entry = &entries[i];
+        if (until > 0 && entry->timestamp > until) break;
+
+        int local_error = replay_entry(&replay, entry);
+        if (local_error == DLB_ERR_NOPROC || local_error == DLB_ERR_PERM) {
+            /* The initialization of the process was not recorded, or the
+             * recorded thread affinity is not allowed in this process */
+            ++num_skipped;
+        } else if (local_error == DLB_ERR_INIT) {
+            error = local_error;
+            break;
+        }
+    }
+
+    if (num_skipped > 0) {
+        warning("%d LeWI operations could not be replayed, either because the process"
+                " initialization was overwritten in the log, or because the thread"
+                " affinity of a blocking call is not allowed here", num_skipped);
+    }
+
+    if (error == DLB_SUCCESS && inspect != NULL) {
+        inspect(replay.options.shm_key, arg);
+    }
+
+    /* Finalize the processes that were still running */
+    for (int i = 0; i < replay.nprocesses; ++i) {
+        replay_process_t *process = replay.processes[i];
+        if (!process->finalized) {
+            replay_finalize(&replay, process);
+        }
+        free(process);
+    }
+    free(replay.processes);
+    shmem_cpuinfo_ext__finalize();
+    shmem_set_private(false);
+
+    thread_spd = prev_spd;
+
+    return error;
+}
+
+static void print_replayed_state(const char *shmem_key, void *arg) {
+    const struct { int columns; dlb_printshmem_flags_t print_flags; } *print_args = arg;
+    shmem_cpuinfo__print_info(shmem_key, 0, print_args->columns, print_args->print_flags);
+}
+
+/* Load the log of LeWI operations from a snapshot file created with
+ * shmem_snapshot__save, print them, and print the state of the CPUs after
+ * replaying them through the policy. If 'until' is positive, stop after that
+ * many seconds since the first operation. */
+DLB_EXPORT_SYMBOL
+int lewi_sim_replay(const char *filename, double until, const char *dlb_args,
+        int columns, dlb_printshmem_flags_t print_flags) {
+
+    cpuinfo_log_entry_t *entries;
+    int nelems;
+    int error = shmem_cpuinfo_log__load(filename, &entries, &nelems);
+    if (error != DLB_SUCCESS) return error;
+
+    int64_t until_ns = nelems > 0 && until > 0
+        ? entries[0].timestamp + (int64_t)(until * 1e9) : 0;
+
+    shmem_cpuinfo_log__print(entries, nelems, until_ns);
+
+    struct { int columns; dlb_printshmem_flags_t print_flags; } print_args = {
+        .columns = columns,
+        .print_flags = print_flags,
+    };
+    error = lewi_sim_replay_log(entries, nelems, until_ns, dlb_args,
+            print_replayed_state, &print_args);
+
+    free(entries);
+
+    return error;
+}
@@ -0,0 +1,77 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifndef LEWI_SIM_H
+#define LEWI_SIM_H
+
+#include "apis/dlb_types.h"
+
+#include <stdint.h>
+
+typedef struct cpuinfo_log_entry_t cpuinfo_log_entry_t;
+
+/* Offline LeWI simulator. A trace with the sequence of compute, serial and MPI
+ * intervals of each rank of a node is replayed in a single process, using the
+ * actual lewi_mask policy and shmem_cpuinfo on a shared memory only visible
+ * to this process, i.e., not in /dev/shm, to estimate the CPU utilization and
+ * time-to-solution of a given set of DLB options. The simulator temporarily
+ * overrides the system topology of the mask utils, which is restored when it
+ * returns, so it must not be used while DLB is initialized. */
+
+typedef enum lewi_sim_event_type_t {
+    LEWI_SIM_COMPUTE,   /* parallel region, value: CPU time of work */
+    LEWI_SIM_SERIAL,    /* sequential code, value: wall time */
+    LEWI_SIM_MPI,       /* blocking MPI call, value: wall time */
+    LEWI_SIM_BARRIER,   /* MPI barrier among all ranks, value: unused */
+} lewi_sim_event_type_t;
+
+typedef struct lewi_sim_event_t {
+    lewi_sim_event_type_t type;
+    double value;
+} lewi_sim_event_t;
+
+typedef struct lewi_sim_trace_t {
+    int nranks;
+    int *nevents;
+    lewi_sim_event_t **events;
+} lewi_sim_trace_t;
+
+typedef struct lewi_sim_result_t {
+    int     ncpus;
+    double  time_to_solution;   /* seconds until the last rank finishes */
+    double  useful_time;        /* CPU seconds spent in compute and serial */
+    double  wasted_time;        /* CPU seconds not used for useful work */
+    double  utilization;        /* useful_time / (ncpus * time_to_solution) */
+} lewi_sim_result_t;
+
+int  lewi_sim_load_trace(const char *filename, lewi_sim_trace_t **trace);
+void lewi_sim_free_trace(lewi_sim_trace_t *trace);
+int  lewi_sim_run(const lewi_sim_trace_t *trace, int cpus_per_rank,
+        const char *dlb_args, lewi_sim_result_t *result);
+
+/* Replay of the LeWI operations recorded with --lewi-record (see
+ * shmem_cpuinfo_log) through the lewi_mask policy, so that the resulting CPU
+ * states can be compared among different DLB options */
+int  lewi_sim_replay_log(const cpuinfo_log_entry_t *entries, int nelems, int64_t until,
+        const char *dlb_args, void (*inspect)(const char *shmem_key, void *arg),
+        void *arg);
+int  lewi_sim_replay(const char *filename, double until, const char *dlb_args,
+        int columns, dlb_printshmem_flags_t print_flags);
+
+#endif /* LEWI_SIM_H */
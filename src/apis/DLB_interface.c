@@ -430,6 +430,30 @@ int DLB_BarrierNamedDetach(dlb_barrier_t *barrier) {
     return node_barrier_detach(thread_spd, (barrier_t*)barrier);
 }
 
+DLB_EXPORT_SYMBOL
+int DLB_BarrierArrive(dlb_barrier_t *barrier) {
+    spd_enter_dlb(thread_spd);
+    return node_barrier_arrive(thread_spd, (barrier_t*)barrier);
+}
+
+DLB_EXPORT_SYMBOL
+int DLB_BarrierWait(dlb_barrier_t *barrier) {
+    spd_enter_dlb(thread_spd);
+    return node_barrier_wait(thread_spd, (barrier_t*)barrier);
+}
+
+DLB_EXPORT_SYMBOL
+int DLB_BarrierTest(dlb_barrier_t *barrier) {
+    spd_enter_dlb(thread_spd);
+    return node_barrier_test(thread_spd, (barrier_t*)barrier);
+}
+
+DLB_EXPORT_SYMBOL
+int DLB_BarrierGetStats(dlb_barrier_t *barrier, dlb_barrier_stats_t *stats) {
+    spd_enter_dlb(thread_spd);
+    return node_barrier_get_stats(thread_spd, (barrier_t*)barrier, stats);
+}
+
 DLB_EXPORT_SYMBOL
 int DLB_SetVariable(const char *variable, const char *value) {
     spd_enter_dlb(thread_spd);
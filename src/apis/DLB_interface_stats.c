@@ -112,6 +112,11 @@ int DLB_Stats_GetLoadAvg(int pid, double *load) {
     return shmem_procinfo__getloadavg(pid, load);
 }
 
+DLB_EXPORT_SYMBOL
+int DLB_Stats_GetDromMigrations(int pid, int *migrated_cpus, int *cross_numa) {
+    return shmem_procinfo__getmigratedcpus(pid, migrated_cpus, cross_numa);
+}
+
 DLB_EXPORT_SYMBOL
 int DLB_Stats_GetCpuStateIdle(int cpu, float *percentage) {
     return DLB_SUCCESS;
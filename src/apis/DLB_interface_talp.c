@@ -52,6 +52,8 @@ int DLB_TALP_Attach(void) {
         options_parse_entry("--lewi-color", &lewi_color);
         options_parse_entry("--shm-key", shm_key);
         options_parse_entry("--shm-size-multiplier", &shm_size_multiplier);
+        /* Needed to compute POP metrics out of the shared memory */
+        options_parse_entry("--talp-model", &thread_spd->options.talp_model);
         shm_key_ptr = shm_key;
     } else {
         lewi_color = thread_spd->options.lewi_color;
@@ -157,6 +159,17 @@ int DLB_TALP_QueryPOPNodeMetrics(const char *name, dlb_node_metrics_t *node_metr
     }
 }
 
+DLB_EXPORT_SYMBOL
+int DLB_TALP_QueryPOPMetrics(const char *name, dlb_pop_metrics_t *pop_metrics) {
+    if (shmem_talp__initialized()) {
+        /* Only if a worker process started with --talp-external-profiler */
+        spd_enter_dlb(thread_spd);
+        return talp_query_pop_metrics(name, pop_metrics);
+    } else {
+        return DLB_ERR_NOSHMEM;
+    }
+}
+
 
 /*********************************************************************************/
 /*    TALP Monitoring Regions                                                    */
@@ -246,6 +259,38 @@ int DLB_TALP_CollectPOPMetrics(dlb_monitor_t *monitor, dlb_pop_metrics_t *pop_me
     return talp_collect_pop_metrics(thread_spd, monitor, pop_metrics);
 }
 
+DLB_EXPORT_SYMBOL
+int DLB_TALP_ICollectPOPMetrics(dlb_monitor_t *monitor, dlb_pop_metrics_t *pop_metrics,
+        dlb_talp_request_t **request) {
+    spd_enter_dlb(thread_spd);
+    if (unlikely(!thread_spd->talp_info)) {
+        return DLB_ERR_NOTALP;
+    }
+    return talp_icollect_pop_metrics(thread_spd, monitor, pop_metrics, request);
+}
+
+DLB_EXPORT_SYMBOL
+int DLB_TALP_Test(dlb_talp_request_t **request, int *flag) {
+    spd_enter_dlb(thread_spd);
+    if (unlikely(!thread_spd->talp_info)) {
+        return DLB_ERR_NOTALP;
+    }
+    bool completed;
+    int error = talp_test_request(request, &completed, false);
+    *flag = completed;
+    return error;
+}
+
+DLB_EXPORT_SYMBOL
+int DLB_TALP_Wait(dlb_talp_request_t **request) {
+    spd_enter_dlb(thread_spd);
+    if (unlikely(!thread_spd->talp_info)) {
+        return DLB_ERR_NOTALP;
+    }
+    bool completed;
+    return talp_test_request(request, &completed, true);
+}
+
 DLB_EXPORT_SYMBOL
 int DLB_TALP_CollectPOPNodeMetrics(dlb_monitor_t *monitor, dlb_node_metrics_t *node_metrics) {
     spd_enter_dlb(thread_spd);
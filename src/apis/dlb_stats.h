@@ -117,6 +117,14 @@ int DLB_Stats_GetActiveCpusList(int *cpuslist,int *nelems,int max_len);
  */
 int DLB_Stats_GetLoadAvg(int pid, double *load);
 
+/*! \brief Get the number of CPUs moved by DROM mask updates of a given process
+ *  \param[in] pid Process ID to consult
+ *  \param[out] migrated_cpus total number of CPUs moved
+ *  \param[out] cross_numa number of those CPUs moved to a different NUMA node
+ *  \return error code
+ */
+int DLB_Stats_GetDromMigrations(int pid, int *migrated_cpus, int *cross_numa);
+
 /*! \brief Get the percentage of time that the CPU has been in state IDLE
  *  \param[in] cpu CPU id
  *  \param[out] percentage percentage of state/total
@@ -228,6 +228,9 @@ typedef struct dlb_node_times_t {
     int64_t useful_time;
 } dlb_node_times_t;
 
+/*! Opaque handle of a non-blocking TALP collective */
+typedef struct dlb_talp_request_t dlb_talp_request_t;
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -316,6 +319,25 @@ int DLB_TALP_GetNodeTimes(const char *name, dlb_node_times_t *node_times_list,
  */
 int DLB_TALP_QueryPOPNodeMetrics(const char *name, dlb_node_metrics_t *node_metrics);
 
+/*! \brief From either 1st or 3rd party, query the POP metrics of the processes
+ *          in the node for one region
+ *  \param[in] name Name to identify the region
+ *  \param[out] pop_metrics Allocated structure where the collected metrics will be stored
+ *  \return DLB_SUCCESS on success
+ *  \return DLB_ERR_NOENT if no data for the given name
+ *  \return DLB_ERR_NOSHMEM if cannot find shared memory
+ *
+ *  The metrics are reduced from the values that each process publishes in
+ *  the shared memory, without MPI communication. Processes that are not MPI
+ *  ranks are also taken into account. The global region is published
+ *  periodically on MPI calls and at the end of OpenMP parallel regions, other
+ *  regions when they stop.
+ *
+ *  Note: This function requires DLB_ARGS+=" --talp-external-profiler" even if
+ *  it's called from 1st-party programs.
+ */
+int DLB_TALP_QueryPOPMetrics(const char *name, dlb_pop_metrics_t *pop_metrics);
+
 
 /*********************************************************************************/
 /*                                                                               */
@@ -395,6 +417,9 @@ int DLB_MonitoringRegionStop(dlb_monitor_t *handle);
  *  \param[in] handle Monitoring handle that identifies the region, or DLB_GLOBAL_REGION
  *  \return DLB_SUCCESS on success
  *  \return DLB_ERR_NOTALP if TALP is not enabled
+ *
+ *  If the region is started, all started monitoring regions are updated
+ *  before printing the report, as in DLB_MonitoringRegionsUpdate.
  */
 int DLB_MonitoringRegionReport(const dlb_monitor_t *handle);
 
@@ -404,7 +429,10 @@ int DLB_MonitoringRegionReport(const dlb_monitor_t *handle);
  *
  *  Monitoring regions are only updated in certain situations, like when
  *  starting/stopping a region, or finalizing MPI. This routine forces the
- *  update of all started monitoring regions
+ *  update of all started monitoring regions. The fields of a started region
+ *  read directly from its handle may be outdated until then, especially with
+ *  --talp-lazy-regions, where nested open regions are not updated when other
+ *  regions start or stop.
 */
 int DLB_MonitoringRegionsUpdate(void);
 
@@ -417,6 +445,40 @@ int DLB_MonitoringRegionsUpdate(void);
  */
 int DLB_TALP_CollectPOPMetrics(dlb_monitor_t *monitor, dlb_pop_metrics_t *pop_metrics);
 
+/*! \brief Start a non-blocking MPI collective communication to collect POP metrics.
+ *  \param[in] monitor Monitoring handle that identifies the region,
+ *                     or DLB_GLOBAL_REGION macro (NULL) if global application-wide region
+ *  \param[out] pop_metrics Allocated structure where the collected metrics will be
+ *                          stored when the request completes
+ *  \param[out] request Handle of the request to be completed with DLB_TALP_Test
+ *                      or DLB_TALP_Wait
+ *  \return DLB_SUCCESS on success
+ *  \return DLB_ERR_NOTALP if TALP is not enabled
+ *  \return DLB_ERR_NOMEM if the request cannot be allocated
+ *
+ *  Only the snapshot of the local metrics is taken in this call, which starts
+ *  the MPI reduction. As in MPI, all processes must start their non-blocking
+ *  collectives in the same order. MPI_Finalize completes the requests that
+ *  were never waited for.
+ */
+int DLB_TALP_ICollectPOPMetrics(dlb_monitor_t *monitor, dlb_pop_metrics_t *pop_metrics,
+        dlb_talp_request_t **request);
+
+/*! \brief Test whether a non-blocking TALP collective has completed
+ *  \param[in,out] request Handle of the request, set to NULL on completion
+ *  \param[out] flag Non-zero if the request has completed
+ *  \return DLB_SUCCESS on success
+ *  \return DLB_ERR_NOTALP if TALP is not enabled
+ */
+int DLB_TALP_Test(dlb_talp_request_t **request, int *flag);
+
+/*! \brief Wait for the completion of a non-blocking TALP collective
+ *  \param[in,out] request Handle of the request, set to NULL on completion
+ *  \return DLB_SUCCESS on success
+ *  \return DLB_ERR_NOTALP if TALP is not enabled
+ */
+int DLB_TALP_Wait(dlb_talp_request_t **request);
+
 /*! \brief Perform a node collective communication to collect TALP node metrics.
  *  \param[in] monitor Monitoring handle that identifies the region,
  *                     or DLB_GLOBAL_REGION macro (NULL) if global application-wide region
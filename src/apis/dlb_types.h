@@ -20,6 +20,8 @@
 #ifndef DLB_TYPES_H
 #define DLB_TYPES_H
 
+#include <stdint.h>
+
 // Opaque types
 typedef struct dlb_barrier_t dlb_barrier_t;
 typedef void* dlb_handler_t;
@@ -59,8 +61,27 @@ typedef enum dlb_barrier_flags_e {
     DLB_BARRIER_LEWI_OFF        = 0,
     DLB_BARRIER_LEWI_ON         = 1 << 0,
     DLB_BARRIER_LEWI_RUNTIME    = 1 << 1,
+    DLB_BARRIER_FUTEX           = 1 << 2,
 } dlb_barrier_flags_t;
 
+// Barrier statistics
+enum { DLB_BARRIER_STATS_HIST_SIZE = 16 };
+enum { DLB_BARRIER_STATS_RANKING_SIZE = 4 };
+
+typedef struct dlb_barrier_stats_t {
+    unsigned int    num_episodes;       /* completed episodes with statistics */
+    int64_t         skew_min;           /* first-to-last arrival time, in ns */
+    int64_t         skew_max;
+    int64_t         skew_avg;
+    int64_t         skew_last;
+    /* Number of waits per duration: bucket 0 counts waits shorter than 1 us,
+     * bucket i waits in [2^(i-1), 2^i) us, and the last bucket longer ones */
+    unsigned int    wait_histogram[DLB_BARRIER_STATS_HIST_SIZE];
+    /* Processes that most frequently arrive the last, 0 if unused */
+    int             last_arrival_pid[DLB_BARRIER_STATS_RANKING_SIZE];
+    unsigned int    last_arrival_count[DLB_BARRIER_STATS_RANKING_SIZE];
+} dlb_barrier_stats_t;
+
 // Generic dummy callback type
 typedef void (*dlb_callback_t)(void);
 
@@ -23,6 +23,7 @@
       integer, parameter :: DLB_BARRIER_LEWI_OFF        = 0
       integer, parameter :: DLB_BARRIER_LEWI_ON         = 1
       integer, parameter :: DLB_BARRIER_LEWI_RUNTIME    = 2
+      integer, parameter :: DLB_BARRIER_FUTEX           = 4
 
        interface
         function dlb_init(ncpus, mask, dlb_args) result (ierr)
@@ -292,6 +293,27 @@
             type(c_ptr), value, intent(in) :: handle
         end function dlb_barriernameddetach
 
+        function dlb_barrierarrive(handle)                              &
+     &         result (ierr) bind(c, name='DLB_BarrierArrive')
+            use iso_c_binding
+            integer(kind=c_int) :: ierr
+            type(c_ptr), value, intent(in) :: handle
+        end function dlb_barrierarrive
+
+        function dlb_barrierwait(handle)                                &
+     &         result (ierr) bind(c, name='DLB_BarrierWait')
+            use iso_c_binding
+            integer(kind=c_int) :: ierr
+            type(c_ptr), value, intent(in) :: handle
+        end function dlb_barrierwait
+
+        function dlb_barriertest(handle)                                &
+     &         result (ierr) bind(c, name='DLB_BarrierTest')
+            use iso_c_binding
+            integer(kind=c_int) :: ierr
+            type(c_ptr), value, intent(in) :: handle
+        end function dlb_barriertest
+
         function dlb_setvariable(variable, val) result (ierr)
             use iso_c_binding
             integer(kind=c_int) :: ierr
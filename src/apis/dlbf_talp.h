@@ -55,6 +55,15 @@
             type(dlb_node_metrics_t), intent(out) :: node_metrics
         end function dlb_talp_querypopnodemetrics
 
+        function dlb_talp_querypopmetrics(name, pop_metrics)            &
+                result(ierr)
+            use iso_c_binding
+            import :: dlb_pop_metrics_t
+            integer(kind=c_int) :: ierr
+            character(len=*), intent(in) :: name
+            type(dlb_pop_metrics_t), intent(out) :: pop_metrics
+        end function dlb_talp_querypopmetrics
+
 
         !---------------------------------------------------------------------------!
         ! The functions declared below are intended to be called only from
@@ -127,6 +136,32 @@
             type(dlb_pop_metrics_t), intent(out) :: pop_metrics
         end function dlb_talp_collectpopmetrics
 
+        function dlb_talp_icollectpopmetrics(monitor, pop_metrics,      &
+     &          request)                                                &
+                result (ierr) bind(c, name='DLB_TALP_ICollectPOPMetrics')
+            use iso_c_binding
+            import :: dlb_pop_metrics_t
+            integer(kind=c_int) :: ierr
+            type(c_ptr), value, intent(in) :: monitor
+            type(dlb_pop_metrics_t), asynchronous :: pop_metrics
+            type(c_ptr), intent(out) :: request
+        end function dlb_talp_icollectpopmetrics
+
+        function dlb_talp_test(request, flag)                           &
+                result (ierr) bind(c, name='DLB_TALP_Test')
+            use iso_c_binding
+            integer(kind=c_int) :: ierr
+            type(c_ptr), intent(inout) :: request
+            integer(kind=c_int), intent(out) :: flag
+        end function dlb_talp_test
+
+        function dlb_talp_wait(request)                                 &
+                result (ierr) bind(c, name='DLB_TALP_Wait')
+            use iso_c_binding
+            integer(kind=c_int) :: ierr
+            type(c_ptr), intent(inout) :: request
+        end function dlb_talp_wait
+
         function dlb_talp_collectpopnodemetrics(monitor, node_metrics)  &
                 result (ierr) bind(c, name='DLB_TALP_CollectPOPNodeMetrics')
             use iso_c_binding
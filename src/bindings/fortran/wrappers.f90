@@ -251,6 +251,36 @@ function dlb_talp_querypopnodemetrics(name, node_metrics) result(ierr)
 end function dlb_talp_querypopnodemetrics
 
 
+function dlb_talp_querypopmetrics(name, pop_metrics) result(ierr)
+    use :: iso_c_binding
+    use :: mod_string, only: string_f2c
+    implicit none
+    include 'dlbf_types.h'
+    integer(kind=c_int) :: ierr
+    character(len=*), intent(in) :: name
+    type(dlb_pop_metrics_t), intent(out) :: pop_metrics
+
+    character(kind=c_char) :: name_c(len_trim(name)+1)
+
+    interface
+        function dlb_talp_querypopmetrics_c(name, pop_metrics)          &
+                result(ierr)                                            &
+                bind(c, name='DLB_TALP_QueryPOPMetrics')
+            use :: iso_c_binding
+            import :: dlb_pop_metrics_t
+            integer(kind=c_int) :: ierr
+            character(kind=c_char), intent(in) :: name(*)
+            type(dlb_pop_metrics_t), intent(out) :: pop_metrics
+        end function dlb_talp_querypopmetrics_c
+    end interface
+
+    call string_f2c(name, name_c)
+
+    ierr = dlb_talp_querypopmetrics_c(name_c, pop_metrics)
+
+end function dlb_talp_querypopmetrics
+
+
 function dlb_monitoringregionregister(region_name) result (handle)
     use :: iso_c_binding
     use :: mod_string, only: string_f2c
@@ -0,0 +1,185 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*! \page dlb_lewisim Simulate LeWI policies from a trace.
+ *  \section synopsis SYNOPSIS
+ *      <B>dlb_lewisim</B> [--cpus-per-rank \underline{n}] [--policy \underline{dlb_args}]...
+ *              \underline{trace}
+ *  \section description DESCRIPTION
+ *      The command <B>dlb_lewisim</B> replays offline the trace of the ranks
+ *      of a node with the LeWI policy of the DLB library, and reports the
+ *      node CPU utilization, the wasted CPU time and the time-to-solution
+ *      for each of the given DLB options. No MPI job is needed, so different
+ *      policies can be compared in a fast and repeatable way.
+ *
+ *      The trace is a CSV file with one event per line,
+ *      <I>rank</I>,<I>type</I>[,<I>value</I>], where <I>type</I> is
+ *      <B>compute</B> (a parallel region with <I>value</I> seconds of CPU
+ *      time of work), <B>serial</B> (<I>value</I> seconds of sequential code),
+ *      <B>mpi</B> (a blocking MPI call of <I>value</I> seconds) or
+ *      <B>barrier</B> (an MPI barrier among all ranks). Each rank owns a
+ *      consecutive block of CPUs, and the first CPU of the block runs the
+ *      serial code and the MPI calls.
+ *
+ *      <DL>
+ *          <DT>-c, --cpus-per-rank \underline{n}</DT>
+ *          <DD>Number of CPUs owned by each rank. Default: 4.</DD>
+ *
+ *          <DT>-p, --policy \underline{dlb_args}</DT>
+ *          <DD>DLB options of a policy to simulate, e.g.,
+ *          "--lewi --lewi-keep-one-cpu". This option can be repeated to
+ *          compare several policies. The variable DLB_ARGS is ignored.
+ *          Default: LeWI disabled and "--lewi".</DD>
+ *
+ *          <DT>-h, --help</DT>
+ *          <DD>Display this help.</DD>
+ *      </DL>
+ *  \section author AUTHOR
+ *      Barcelona Supercomputing Center (dlb@bsc.es)
+ *  \section seealso SEE ALSO
+ *      \ref dlb "dlb"(1), \ref dlb_run "dlb_run"(1), \ref dlb_shm "dlb_shm"(1),
+ *      \ref dlb_taskset "dlb_taskset"(1)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "apis/dlb.h"
+#include "LB_policies/lewi_sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+enum { MAX_POLICIES = 16 };
+
+static void __attribute__((__noreturn__)) version(void) {
+    fprintf(stdout, "%s\n", DLB_VERSION_STRING);
+    fprintf(stdout, "Configured with: %s\n", DLB_CONFIGURE_ARGS);
+    exit(EXIT_SUCCESS);
+}
+
+static void __attribute__((__noreturn__)) usage(const char *program, FILE *out) {
+    fprintf(out, "DLB - Dynamic Load Balancing, version %s.\n", VERSION);
+    fprintf(out, (
+                "usage:\n"
+                "\t%1$s [OPTIONS] TRACE\n"
+                "\n"
+                ), program);
+
+    fputs("Simulate LeWI policies on a trace of the ranks of a node.\n\n", out);
+
+    fputs((
+                "Options:\n"
+                "  -c, --cpus-per-rank=N    number of CPUs owned by each rank (default: 4)\n"
+                "  -p, --policy=DLB_ARGS    DLB options of a policy to simulate, can be repeated\n"
+                "                           (default: LeWI disabled and \"--lewi\")\n"
+                "  -h, --help               print this help\n"
+                "\n"
+                "Trace format, one event per line:\n"
+                "  rank,compute,CPU_SECONDS  parallel region\n"
+                "  rank,serial,SECONDS       sequential code\n"
+                "  rank,mpi,SECONDS          blocking MPI call\n"
+                "  rank,barrier              MPI barrier among all ranks\n"
+                ), out);
+
+    exit(out == stderr ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+int main(int argc, char *argv[]) {
+    int cpus_per_rank = 4;
+    const char *policies[MAX_POLICIES];
+    int npolicies = 0;
+
+    int opt;
+    struct option long_options[] = {
+        {"cpus-per-rank", required_argument, NULL, 'c'},
+        {"policy",        required_argument, NULL, 'p'},
+        {"help",          no_argument,       NULL, 'h'},
+        {"version",       no_argument,       NULL, 'v'},
+        {0,               0,                 NULL, 0 }
+    };
+
+    while ((opt = getopt_long(argc, argv, "c:p:hv", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'c':
+                cpus_per_rank = strtol(optarg, NULL, 0);
+                break;
+            case 'p':
+                if (npolicies == MAX_POLICIES) {
+                    fprintf(stderr, "Too many policies, maximum is %d\n", MAX_POLICIES);
+                    exit(EXIT_FAILURE);
+                }
+                policies[npolicies++] = optarg;
+                break;
+            case 'h':
+                usage(argv[0], stdout);
+                break;
+            case 'v':
+                version();
+                break;
+            default:
+                usage(argv[0], stderr);
+        }
+    }
+
+    if (optind != argc - 1 || cpus_per_rank <= 0) {
+        usage(argv[0], stderr);
+    }
+
+    if (npolicies == 0) {
+        policies[npolicies++] = "";
+        policies[npolicies++] = "--lewi";
+    }
+
+    /* Policies are only defined from the command line */
+    unsetenv("DLB_ARGS");
+    unsetenv("LB_ARGS");
+
+    lewi_sim_trace_t *trace;
+    if (lewi_sim_load_trace(argv[optind], &trace) != DLB_SUCCESS) {
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(stdout, "Trace: %s, %d ranks, %d CPUs per rank\n\n",
+            argv[optind], trace->nranks, cpus_per_rank);
+    fprintf(stdout, "%-40s %18s %12s %18s\n",
+            "Policy", "Time-to-solution", "Utilization", "Wasted CPU time");
+
+    int exit_code = EXIT_SUCCESS;
+    for (int i = 0; i < npolicies; ++i) {
+        lewi_sim_result_t result;
+        int error = lewi_sim_run(trace, cpus_per_rank, policies[i], &result);
+        const char *name = policies[i][0] != '\0' ? policies[i] : "(no LeWI)";
+        if (error == DLB_SUCCESS) {
+            fprintf(stdout, "%-40s %16.3f s %10.2f %% %16.3f s\n", name,
+                    result.time_to_solution, result.utilization * 100,
+                    result.wasted_time);
+        } else {
+            fprintf(stdout, "%-40s %s\n", name, DLB_Strerror(error));
+            exit_code = EXIT_FAILURE;
+        }
+    }
+
+    lewi_sim_free_trace(trace);
+
+    return exit_code;
+}
@@ -0,0 +1,216 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*! \page dlb_rebalance Rebalance CPUs among DLB processes of the node.
+ *  \section synopsis SYNOPSIS
+ *      <B>dlb_rebalance</B> [--period \underline{seconds}] [--hysteresis \underline{percent}]
+ *              [--region \underline{name}] [--count \underline{n}] [--dry-run]
+ *  \section description DESCRIPTION
+ *      The command <B>dlb_rebalance</B> periodically reads the TALP metrics
+ *      that every DLB process of the node exposes in the shared memory and
+ *      redistributes the CPUs among them using DROM, giving more CPUs to the
+ *      processes with more useful work and fewer CPUs to the processes that
+ *      spend more time in MPI.
+ *
+ *      Processes need to be run with DROM and TALP enabled, and with the
+ *      option <B>--talp-external-profiler</B> so that their metrics are
+ *      updated in the shared memory during the execution.
+ *
+ *      <DL>
+ *          <DT>-p, --period \underline{seconds}</DT>
+ *          <DD>Time between two rebalancing steps. Default: 5 seconds.</DD>
+ *
+ *          <DT>-t, --hysteresis \underline{percent}</DT>
+ *          <DD>Minimum load imbalance among processes, in percent, to
+ *          redistribute the CPUs. Default: 10.</DD>
+ *
+ *          <DT>-r, --region \underline{name}</DT>
+ *          <DD>TALP region used to compute the load imbalance. Default: Global.</DD>
+ *
+ *          <DT>-c, --count \underline{n}</DT>
+ *          <DD>Stop after \underline{n} rebalancing steps. By default, the command
+ *          runs until it is interrupted.</DD>
+ *
+ *          <DT>-n, --dry-run</DT>
+ *          <DD>Print the new CPU distribution but do not apply it.</DD>
+ *
+ *          <DT>-h, --help</DT>
+ *          <DD>Display this help.</DD>
+ *      </DL>
+ *  \section author AUTHOR
+ *      Barcelona Supercomputing Center (dlb@bsc.es)
+ *  \section seealso SEE ALSO
+ *      \ref dlb "dlb"(1), \ref dlb_run "dlb_run"(1), \ref dlb_shm "dlb_shm"(1),
+ *      \ref dlb_taskset "dlb_taskset"(1)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "apis/dlb.h"
+#include "apis/dlb_talp.h"
+#include "LB_core/node_rebalance.h"
+#include "support/mask_utils.h"
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+static volatile sig_atomic_t stop = 0;
+
+static void sighandler(int signum) {
+    stop = 1;
+}
+
+static void __attribute__((__noreturn__)) version(void) {
+    fprintf(stdout, "%s\n", DLB_VERSION_STRING);
+    fprintf(stdout, "Configured with: %s\n", DLB_CONFIGURE_ARGS);
+    exit(EXIT_SUCCESS);
+}
+
+static void __attribute__((__noreturn__)) usage(const char *program, FILE *out) {
+    fprintf(out, "DLB - Dynamic Load Balancing, version %s.\n", VERSION);
+    fprintf(out, (
+                "usage:\n"
+                "\t%1$s [OPTIONS]\n"
+                "\n"
+                ), program);
+
+    fputs("Rebalance CPUs among DLB processes of the node using TALP metrics.\n\n", out);
+
+    fputs((
+                "Options:\n"
+                "  -p, --period=SECONDS     time between rebalancing steps (default: 5)\n"
+                "  -t, --hysteresis=PERCENT minimum load imbalance to act (default: 10)\n"
+                "  -r, --region=NAME        TALP region to monitor (default: Global)\n"
+                "  -c, --count=N            stop after N steps\n"
+                "  -n, --dry-run            print the new distribution but do not apply it\n"
+                "  -h, --help               print this help\n"
+                ), out);
+
+    exit(out == stderr ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+static void print_step(const node_rebalance_t *nr, int error) {
+    fprintf(stdout, "Region %s, load imbalance: %.2f%%%s\n", nr->region_name,
+            nr->imbalance * 100, nr->dry_run ? " (dry run)" : "");
+    if (error == DLB_NOUPDT) return;
+    for (int i = 0; i < nr->nprocs; ++i) {
+        const node_rebalance_proc_t *proc = &nr->procs[i];
+        if (proc->new_ncpus != proc->ncpus) {
+            /* mu_to_str uses a static buffer */
+            fprintf(stdout, "  PID %d, efficiency %.2f, %s", proc->pid,
+                    proc->efficiency, mu_to_str(&proc->mask));
+            fprintf(stdout, " -> %s\n", mu_to_str(&proc->new_mask));
+        }
+    }
+    if (error != DLB_SUCCESS) {
+        fprintf(stderr, "Could not apply new masks: %s\n", DLB_Strerror(error));
+    }
+}
+
+int main(int argc, char *argv[]) {
+    double period = 5.0;
+    float hysteresis = 0.1f;
+    const char *region_name = DLB_GLOBAL_REGION_NAME;
+    int count = 0;
+    bool dry_run = false;
+
+    int opt;
+    struct option long_options[] = {
+        {"period",     required_argument, NULL, 'p'},
+        {"hysteresis", required_argument, NULL, 't'},
+        {"region",     required_argument, NULL, 'r'},
+        {"count",      required_argument, NULL, 'c'},
+        {"dry-run",    no_argument,       NULL, 'n'},
+        {"help",       no_argument,       NULL, 'h'},
+        {"version",    no_argument,       NULL, 'v'},
+        {0,            0,                 NULL, 0 }
+    };
+
+    while ((opt = getopt_long(argc, argv, "p:t:r:c:nhv", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p':
+                period = strtod(optarg, NULL);
+                break;
+            case 't':
+                hysteresis = strtof(optarg, NULL) / 100.0f;
+                break;
+            case 'r':
+                region_name = optarg;
+                break;
+            case 'c':
+                count = strtol(optarg, NULL, 0);
+                break;
+            case 'n':
+                dry_run = true;
+                break;
+            case 'h':
+                usage(argv[0], stdout);
+                break;
+            case 'v':
+                version();
+                break;
+            default:
+                usage(argv[0], stderr);
+        }
+    }
+
+    if (period <= 0.0 || hysteresis < 0.0f || count < 0) {
+        usage(argv[0], stderr);
+    }
+
+    struct sigaction sa = { .sa_handler = sighandler };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    DLB_TALP_Attach();
+
+    node_rebalance_t nr;
+    node_rebalance_init(&nr, region_name, hysteresis, dry_run);
+
+    /* The first step only takes the initial sample */
+    node_rebalance_step(&nr);
+
+    struct timespec interval = {
+        .tv_sec = (time_t)period,
+        .tv_nsec = (long)((period - (time_t)period) * 1e9),
+    };
+    for (int step = 0; !stop && (count == 0 || step < count); ++step) {
+        nanosleep(&interval, NULL);
+        if (stop) break;
+        int error = node_rebalance_step(&nr);
+        if (error == DLB_ERR_NOSHMEM) {
+            fprintf(stderr, "DLB shared memory not found\n");
+            break;
+        }
+        print_step(&nr, error);
+        fflush(stdout);
+    }
+
+    node_rebalance_finalize(&nr);
+    DLB_TALP_Detach();
+
+    return EXIT_SUCCESS;
+}
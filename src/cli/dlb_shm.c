@@ -19,9 +19,9 @@
 
 /*! \page dlb_shm Manage DLB shared memory.
  *  \section synopsis SYNOPSIS
- *      <B>dlb_shm</B> {--list | --delete | --help}
+ *      <B>dlb_shm</B> {--list | --delete | --snapshot=FILE | --replay=FILE | --help}
  *  \section description DESCRIPTION
- *      Utility command to list or delete the DLB shared memory.
+ *      Utility command to list, delete, save or replay the DLB shared memory.
  *
  *      <DL>
  *          <DT>-l, --list</DT>
@@ -30,6 +30,20 @@
  *          <DT>-d, --delete</DT>
  *          <DD>Delete the DLB shared memory.</DD>
  *
+ *          <DT>-s, --snapshot=FILE</DT>
+ *          <DD>Save a copy of every DLB shared memory of the current user into
+ *          FILE.</DD>
+ *
+ *          <DT>-r, --replay=FILE</DT>
+ *          <DD>Print the LeWI operations recorded with the
+ *          <I>--lewi-record</I> option in the snapshot FILE, and the
+ *          resulting state of the CPUs after replaying them through the LeWI
+ *          policy configured with the DLB_ARGS environment variable.</DD>
+ *
+ *          <DT>--until=SECONDS</DT>
+ *          <DD>With --replay, stop replaying after SECONDS since the first
+ *          recorded operation.</DD>
+ *
  *          <DT>-h, --help</DT>
  *          <DD>Print usage.</DD>
  *      </DL>
@@ -45,6 +59,9 @@
 #endif
 
 #include "apis/dlb.h"
+#include "apis/dlb_errors.h"
+#include "LB_comm/shmem.h"
+#include "LB_policies/lewi_sim.h"
 
 #include <unistd.h>
 #include <stdlib.h>
@@ -72,6 +89,8 @@ static void __attribute__((__noreturn__)) usage(const char *program, FILE *out)
                 "usage:\n"
                 "\t%1$s --list\n"
                 "\t%1$s --delete\n"
+                "\t%1$s --snapshot=FILE\n"
+                "\t%1$s --replay=FILE [--until=SECONDS]\n"
                 "\n"
                 ), program);
 
@@ -83,6 +102,9 @@ static void __attribute__((__noreturn__)) usage(const char *program, FILE *out)
                 "                           optional N argument to override num columns\n"
                 "  --color[=no]             override automatic color detection\n"
                 "  -d, --delete             delete shmem data\n"
+                "  -s, --snapshot=FILE      save all shmem data into FILE\n"
+                "  -r, --replay=FILE        replay the LeWI operations saved in FILE\n"
+                "  --until=SECONDS          stop replaying SECONDS after the first operation\n"
                 /* Options --create and --file are experimental */
                 /* "  -c, --create             create and empty Shared Memory file\n" */
                 /* "  -f, --file=FILE          use only this specific Shared Memory file\n" */
@@ -268,16 +290,51 @@ void delete_shdata( void ) {
     closedir(dp);
 }
 
+void snapshot_shdata(const char *filename) {
+    int error = shmem_snapshot__save(filename);
+    if (error == DLB_ERR_NOENT) {
+        fprintf(stderr, "No DLB shared memory found\n");
+        exit(EXIT_FAILURE);
+    } else if (error != DLB_SUCCESS) {
+        fprintf(stderr, "DLB ERROR: can't write snapshot %s: %s\n",
+                filename, DLB_Strerror(error));
+        exit(EXIT_FAILURE);
+    }
+    fprintf(stdout, "Saved DLB shared memory snapshot into %s\n", filename);
+}
+
+void replay_shdata(const char *filename, double until, int list_columns,
+        dlb_printshmem_flags_t print_flags) {
+    int error = lewi_sim_replay(filename, until, NULL, list_columns, print_flags);
+    if (error == DLB_ERR_NOENT) {
+        fprintf(stderr, "No LeWI operations log found in %s."
+                " Was DLB run with --lewi-record?\n", filename);
+        exit(EXIT_FAILURE);
+    } else if (error == DLB_ERR_NOCOMP) {
+        fprintf(stderr, "DLB WARNING: %s is not a valid snapshot,"
+                " or it was recorded in a larger node\n", filename);
+    } else if (error != DLB_SUCCESS) {
+        fprintf(stderr, "DLB ERROR: can't replay %s: %s\n",
+                filename, DLB_Strerror(error));
+        exit(EXIT_FAILURE);
+    }
+}
+
 int main(int argc, char *argv[]) {
     bool do_create = false;
     bool do_list = false;
     bool do_delete = false;
+    bool do_snapshot = false;
+    bool do_replay = false;
+    const char *snapshot_filename = NULL;
+    double replay_until = 0.0;
     int list_columns = 0;
     dlb_printshmem_flags_t print_flags = DLB_COLOR_AUTO;
 
     /* Long options that have no corresponding short option */
     enum {
-        COLOR_OPTION = CHAR_MAX + 1
+        COLOR_OPTION = CHAR_MAX + 1,
+        UNTIL_OPTION
     };
 
     int opt;
@@ -286,13 +343,16 @@ int main(int argc, char *argv[]) {
         {"list",     optional_argument, NULL, 'l'},
         {"delete",   no_argument,       NULL, 'd'},
         {"file",     required_argument, NULL, 'f'},
+        {"snapshot", required_argument, NULL, 's'},
+        {"replay",   required_argument, NULL, 'r'},
+        {"until",    required_argument, NULL, UNTIL_OPTION},
         {"color",    optional_argument, NULL, COLOR_OPTION},
         {"help",     no_argument,       NULL, 'h'},
         {"version",  no_argument,       NULL, 'v'},
         {0,          0,                 NULL, 0 }
     };
 
-    while ( (opt = getopt_long(argc, argv, "cl::df:hv", long_options, NULL)) != -1 ) {
+    while ( (opt = getopt_long(argc, argv, "cl::df:s:r:hv", long_options, NULL)) != -1 ) {
         switch (opt) {
             case 'c':
                 do_create = true;
@@ -312,6 +372,17 @@ int main(int argc, char *argv[]) {
                 // Prepend '/' if needed
                 sprintf( userdef_shm_filename, "%s%s", optarg[0] == '/' ? "" : "/", optarg );
                 break;
+            case 's':
+                do_snapshot = true;
+                snapshot_filename = optarg;
+                break;
+            case 'r':
+                do_replay = true;
+                snapshot_filename = optarg;
+                break;
+            case UNTIL_OPTION:
+                replay_until = strtod(optarg, NULL);
+                break;
             case COLOR_OPTION:
                 if (optarg && strcasecmp (optarg, "no") == 0) {
                     print_flags &= ~DLB_COLOR_AUTO;
@@ -332,7 +403,7 @@ int main(int argc, char *argv[]) {
     }
 
     // Incompatible options
-    if (do_create + do_list + do_delete != 1) {
+    if (do_create + do_list + do_delete + do_snapshot + do_replay != 1) {
         usage(argv[0], stderr);
     }
 
@@ -345,6 +416,12 @@ int main(int argc, char *argv[]) {
     else if (do_delete) {
         delete_shdata();
     }
+    else if (do_snapshot) {
+        snapshot_shdata(snapshot_filename);
+    }
+    else if (do_replay) {
+        replay_shdata(snapshot_filename, replay_until, list_columns, print_flags);
+    }
     else {
         usage(argv[0], stderr);
     }
@@ -29,6 +29,7 @@
 #include "LB_core/spd.h"
 #include "apis/dlb.h"
 #include "mpi/mpi_calls_coded.h"
+#include "support/atomic.h"
 #include "support/debug.h"
 #include "support/options.h"
 #include "support/tracing.h"
@@ -37,6 +38,7 @@
 #include "mngo/mngo.h"
 
 #include <mpi.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <limits.h>
 #include <string.h>
@@ -52,6 +54,11 @@ int _process_id = -1;
 static int init_from_mpi = 0;
 static int mpi_ready = 0;
 static mpi_set_t lewi_mpi_calls = MPISET_ALL;
+static bool talp_mpi_breakdown = false;
+static bool talp_mpi_auto_regions = false;
+
+/* Return address of the current MPI call in the application, if known */
+static __thread const void *mpi_call_site = NULL;
 
 static MPI_Comm mpi_comm_world;         /* DLB's own MPI_COMM_WORLD */
 static MPI_Comm mpi_comm_node;          /* MPI Communicator specific to the node */
@@ -111,6 +118,13 @@ static void get_mpi_info(void) {
     PMPI_Comm_split(mpi_comm_world, _process_id, 0 /* key */, &mpi_comm_internode);
     PMPI_Comm_rank(mpi_comm_internode, &_node_id);
     PMPI_Comm_size(mpi_comm_internode, &_num_nodes);
+
+    /* Only the communicator of the node roots contains every node, the others
+     * may lack the nodes with fewer processes */
+    int node_info[2] = {_node_id, _num_nodes};
+    PMPI_Bcast(node_info, 2, MPI_INT, 0, mpi_comm_node);
+    _node_id = node_info[0];
+    _num_nodes = node_info[1];
 #else
     char hostname[HOST_NAME_MAX] = {'\0'};
     char (*recvData)[HOST_NAME_MAX] = malloc(_mpi_size * sizeof(char[HOST_NAME_MAX]));
@@ -216,6 +230,8 @@ static void after_init(void) {
 
     if (thread_spd->options.talp & (TALP_COMPONENT_DEFAULT | TALP_COMPONENT_MPI)) {
         talp_mpi_init(thread_spd);
+        talp_mpi_breakdown = thread_spd->options.talp_mpi_breakdown;
+        talp_mpi_auto_regions = thread_spd->options.talp_mpi_auto_regions;
     }
 
     // Initialize MNGO
@@ -250,7 +266,60 @@ static void before_finalize(void) {
 
 static void after_finalize(void) {}
 
-void before_mpi(mpi_call_t mpi_call) {
+/* Slot of each MPI call in the TALP breakdown of MPI calls, assigned on first
+ * use. Slot 0 is shared by the calls that do not get a slot of their own */
+static _Atomic(unsigned char) mpi_call_slots[MPI_NUM_CALL_IDS] = {0};
+static mpi_call_id_t slot_call_ids[MPI_NUM_CALL_SLOTS] = {MPI_CALL_ID_Unknown};
+static int num_call_slots = 1;
+static pthread_mutex_t call_slots_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int assign_mpi_call_slot(mpi_call_id_t call_id) {
+    int slot;
+    bool full = false;
+    pthread_mutex_lock(&call_slots_mutex);
+    {
+        slot = DLB_ATOMIC_LD_RLX(&mpi_call_slots[call_id]);
+        if (slot == 0) {
+            if (num_call_slots < MPI_NUM_CALL_SLOTS) {
+                slot = num_call_slots++;
+                slot_call_ids[slot] = call_id;
+                DLB_ATOMIC_ST_REL(&mpi_call_slots[call_id], slot);
+            } else if (num_call_slots == MPI_NUM_CALL_SLOTS) {
+                /* Warn only once */
+                ++num_call_slots;
+                full = true;
+            }
+        }
+    }
+    pthread_mutex_unlock(&call_slots_mutex);
+
+    if (full) {
+        warning("The TALP breakdown of MPI calls supports up to %d different MPI calls,"
+                " %s and further calls are reported as Other",
+                MPI_NUM_CALL_SLOTS - 1, mpi_call_names[call_id]);
+    }
+
+    return slot;
+}
+
+static inline int get_mpi_call_slot(mpi_call_id_t call_id) {
+    int slot = DLB_ATOMIC_LD_RLX(&mpi_call_slots[call_id]);
+    return likely(slot != 0) ? slot : assign_mpi_call_slot(call_id);
+}
+
+mpi_call_id_t get_mpi_call_slot_id(int slot) {
+    pthread_mutex_lock(&call_slots_mutex);
+    mpi_call_id_t call_id = slot_call_ids[slot];
+    pthread_mutex_unlock(&call_slots_mutex);
+    return call_id;
+}
+
+const char* get_mpi_call_name(mpi_call_id_t call_id) {
+    return call_id == MPI_CALL_ID_Unknown ? "Other" : mpi_call_names[call_id];
+}
+
+void before_mpi(mpi_call_t mpi_call, mpi_call_id_t call_id,
+        int64_t msg_count, MPI_Datatype msg_datatype) {
 
     if (mpi_call & MPI_SEMANTIC_INIT) {
         before_init();
@@ -274,13 +343,36 @@ void before_mpi(mpi_call_t mpi_call) {
                         || (lewi_mpi_calls == MPISET_BARRIER && mpi_call == Barrier)
                         || (lewi_mpi_calls == MPISET_COLLECTIVES && is_collective)),
         };
+
+        if (talp_mpi_breakdown) {
+            flags.mpi_call_slot = get_mpi_call_slot(call_id);
+        }
+
+        /* End the code interval after the previous MPI call site */
+        if (talp_mpi_auto_regions) {
+            talp_mpi_auto_region_stop(thread_spd);
+        }
+
         into_sync_call(flags);
 
+        /* Size of the message buffer, if the call has a single count and
+         * datatype. For receives, this is the capacity of the buffer, not the
+         * size of the received message */
+        if (talp_mpi_breakdown
+                && msg_count > 0
+                && msg_datatype != MPI_DATATYPE_NULL) {
+            int type_size;
+            if (PMPI_Type_size(msg_datatype, &type_size) == MPI_SUCCESS) {
+                talp_mpi_add_bytes(thread_spd, flags.mpi_call_slot,
+                        msg_count * type_size);
+            }
+        }
+
         instrument_event(RUNTIME_EVENT, EVENT_INTO_MPI, EVENT_END);
     }
 }
 
-void after_mpi(mpi_call_t mpi_call) {
+void after_mpi(mpi_call_t mpi_call, mpi_call_id_t call_id) {
 
     if (mpi_call & MPI_SEMANTIC_INIT) {
         after_init();
@@ -304,13 +396,32 @@ void after_mpi(mpi_call_t mpi_call) {
                     || (lewi_mpi_calls == MPISET_BARRIER && mpi_call == Barrier)
                     || (lewi_mpi_calls == MPISET_COLLECTIVES && is_collective)),
         };
+
+        if (talp_mpi_breakdown) {
+            flags.mpi_call_slot = get_mpi_call_slot(call_id);
+        }
+
         out_of_sync_call(flags);
 
+        /* Begin the code interval after this MPI call site */
+        if (talp_mpi_auto_regions) {
+            talp_mpi_auto_region_start(thread_spd, mpi_call_site);
+        }
+
         instrument_event(RUNTIME_EVENT, EVENT_OUTOF_MPI, EVENT_END);
 
         // Poll DROM and update mask if necessary
         DLB_PollDROM_Update();
     }
+
+    /* Calls from wrappers that do not set the call site are not attributed */
+    mpi_call_site = NULL;
+}
+
+/* Called by the MPI interception wrappers before the hooks, since the hooks
+ * do not know the return address of the call */
+void set_mpi_call_site(const void *call_site) {
+    mpi_call_site = call_site;
 }
 
 int is_mpi_ready(void) {
@@ -22,6 +22,7 @@
 
 #include "mpi/mpi_calls_coded.h"
 
+#include <stdint.h>
 #include <unistd.h>
 #include <mpi.h>
 
@@ -32,10 +33,17 @@ extern int _num_nodes;        /* Number of nodes */
 extern int _process_id;       /* Process ID per node */
 extern int _mpis_per_node;    /* Numer of MPI processes per node */
 
-void before_mpi(mpi_call_t mpi_call);
-void after_mpi(mpi_call_t mpi_call);
+void before_mpi(mpi_call_t mpi_call, mpi_call_id_t call_id,
+        int64_t msg_count, MPI_Datatype msg_datatype);
+void after_mpi(mpi_call_t mpi_call, mpi_call_id_t call_id);
+void set_mpi_call_site(const void *call_site);
 int  is_mpi_ready(void);
 void finalize_mpi_core(void);
+/* MPI call of a slot of the TALP breakdown of MPI calls, slot 0 and unused
+ * slots return MPI_CALL_ID_Unknown */
+mpi_call_id_t get_mpi_call_slot_id(int slot);
+/* Name of the MPI call in the TALP breakdown, MPI_CALL_ID_Unknown is "Other" */
+const char* get_mpi_call_name(mpi_call_id_t call_id);
 MPI_Comm getWorldComm(void);
 MPI_Comm getNodeComm(void);
 MPI_Comm getInterNodeComm(void);
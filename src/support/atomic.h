@@ -50,6 +50,8 @@
 #define DLB_ATOMIC_EXCH_RLX(ptr, val)       atomic_exchange_explicit(ptr, val, memory_order_relaxed)
 #define DLB_ATOMIC_CMP_EXCH_WEAK(ptr, expected, desired) \
                                             atomic_compare_exchange_weak(ptr, &expected, desired)
+#define DLB_ATOMIC_FENCE_ACQ()              atomic_thread_fence(memory_order_acquire)
+#define DLB_ATOMIC_FENCE_REL()              atomic_thread_fence(memory_order_release)
 
 #else /* not HAVE_STDATOMIC_H */
 
@@ -79,6 +81,8 @@
 #define DLB_ATOMIC_EXCH_RLX(ptr, val)       __sync_lock_test_and_set(ptr, val)
 #define DLB_ATOMIC_CMP_EXCH_WEAK(ptr, oldval, newval) \
                                             __sync_bool_compare_and_swap(ptr, oldval, newval)
+#define DLB_ATOMIC_FENCE_ACQ()              __sync_synchronize()
+#define DLB_ATOMIC_FENCE_REL()              __sync_synchronize()
 
 #endif
 
@@ -92,6 +96,31 @@
 #define DLB_ALIGN_CACHE __attribute__((aligned(DLB_CACHE_LINE)))
 
 
+/* Sequence lock: a single writer modifies some data between seqlock_write_begin
+ * and seqlock_write_end, and writers never wait for readers. A reader copies
+ * the data after seqlock_read_begin and retries while seqlock_read_retry
+ * returns true, i.e., while the copy may be inconsistent. */
+static inline void seqlock_write_begin(atomic_uint *seq) {
+    unsigned int value = DLB_ATOMIC_LD_RLX(seq);
+    DLB_ATOMIC_ST_RLX(seq, value + 1);
+    DLB_ATOMIC_FENCE_REL();
+}
+
+static inline void seqlock_write_end(atomic_uint *seq) {
+    unsigned int value = DLB_ATOMIC_LD_RLX(seq);
+    DLB_ATOMIC_ST_REL(seq, value + 1);
+}
+
+static inline unsigned int seqlock_read_begin(const atomic_uint *seq) {
+    return DLB_ATOMIC_LD_ACQ(seq);
+}
+
+static inline bool seqlock_read_retry(const atomic_uint *seq, unsigned int seq_begin) {
+    DLB_ATOMIC_FENCE_ACQ();
+    return (seq_begin & 1) || seq_begin != DLB_ATOMIC_LD_RLX(seq);
+}
+
+
 /* If flags does not contain 'bit', atomically:
  *  - set 'bit'
  *  - return true
@@ -408,7 +408,7 @@ void dlb_clean(void) {
         finalize_comm();
 
         /* Destroy shared memories if they still exist */
-        const char *shmem_names[] = {"cpuinfo", "procinfo", "talp", "async"};
+        const char *shmem_names[] = {"cpuinfo", "cpuinfolog", "procinfo", "talp", "async"};
         enum { shmem_nelems = sizeof(shmem_names) / sizeof(shmem_names[0]) };
         int i;
         for (i=0; i<shmem_nelems; ++i) {
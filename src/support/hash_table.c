@@ -0,0 +1,149 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "support/hash_table.h"
+
+#include "support/debug.h"
+
+#include <stdlib.h>
+
+struct hash_table_t {
+    unsigned int            capacity;   /* power of two */
+    unsigned int            count;      /* including tombstones */
+    struct hash_table_t     *retired;   /* previous table */
+    _Atomic(void*)          slots[];
+};
+
+enum { HASH_TABLE_INITIAL_CAPACITY = 64 };
+
+static char hash_table_tombstone;
+#define HASH_TABLE_TOMBSTONE ((void*)&hash_table_tombstone)
+
+unsigned int hash_table_hash_string(const char *str, size_t max_len) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < max_len && str[i] != '\0'; ++i) {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void add(hash_table_t *table, void *entry, unsigned int hash) {
+    unsigned int mask = table->capacity - 1;
+    unsigned int i = hash & mask;
+    while (DLB_ATOMIC_LD_RLX(&table->slots[i]) != NULL) {
+        i = (i + 1) & mask;
+    }
+    DLB_ATOMIC_ST_REL(&table->slots[i], entry);
+    ++table->count;
+}
+
+void hash_table_insert(_Atomic(hash_table_t*) *table_ptr, void *entry,
+        hash_table_hash_func_t hash_func) {
+
+    /* Keep the load factor under 1/2 */
+    hash_table_t *table = DLB_ATOMIC_LD_RLX(table_ptr);
+    if (table == NULL || (table->count + 1) * 2 > table->capacity) {
+        unsigned int capacity = table != NULL
+            ? table->capacity * 2 : HASH_TABLE_INITIAL_CAPACITY;
+        hash_table_t *new_table = calloc(1, sizeof(hash_table_t)
+                + capacity * sizeof(_Atomic(void*)));
+        fatal_cond(!new_table, "Could not allocate hash table."
+                " Please report at "PACKAGE_BUGREPORT);
+        new_table->capacity = capacity;
+        if (table != NULL) {
+            for (unsigned int i = 0; i < table->capacity; ++i) {
+                void *old_entry = DLB_ATOMIC_LD_RLX(&table->slots[i]);
+                if (old_entry != NULL && old_entry != HASH_TABLE_TOMBSTONE) {
+                    add(new_table, old_entry, hash_func(old_entry));
+                }
+            }
+            new_table->retired = table;
+        }
+        DLB_ATOMIC_ST_REL(table_ptr, new_table);
+        table = new_table;
+    }
+
+    add(table, entry, hash_func(entry));
+}
+
+void hash_table_remove(_Atomic(hash_table_t*) *table_ptr, const void *entry,
+        unsigned int hash) {
+
+    hash_table_t *table = DLB_ATOMIC_LD_RLX(table_ptr);
+    if (table == NULL) return;
+
+    unsigned int mask = table->capacity - 1;
+    for (unsigned int i = hash & mask; ; i = (i + 1) & mask) {
+        void *slot_entry = DLB_ATOMIC_LD_RLX(&table->slots[i]);
+        if (slot_entry == NULL) {
+            return;
+        }
+        if (slot_entry == entry) {
+            DLB_ATOMIC_ST_REL(&table->slots[i], HASH_TABLE_TOMBSTONE);
+            return;
+        }
+    }
+}
+
+void* hash_table_lookup(_Atomic(hash_table_t*) *table_ptr, unsigned int hash,
+        hash_table_equal_func_t equal_func, const void *key) {
+
+    hash_table_t *table = DLB_ATOMIC_LD_ACQ(table_ptr);
+    if (table == NULL) return NULL;
+
+    unsigned int mask = table->capacity - 1;
+    for (unsigned int i = hash & mask; ; i = (i + 1) & mask) {
+        void *entry = DLB_ATOMIC_LD_ACQ(&table->slots[i]);
+        if (entry == NULL) {
+            return NULL;
+        }
+        if (entry != HASH_TABLE_TOMBSTONE && equal_func(entry, key)) {
+            return entry;
+        }
+    }
+}
+
+void hash_table_foreach(_Atomic(hash_table_t*) *table_ptr, hash_table_func_t func,
+        void *user_data) {
+
+    hash_table_t *table = DLB_ATOMIC_LD_ACQ(table_ptr);
+    if (table == NULL) return;
+
+    for (unsigned int i = 0; i < table->capacity; ++i) {
+        void *entry = DLB_ATOMIC_LD_ACQ(&table->slots[i]);
+        if (entry != NULL && entry != HASH_TABLE_TOMBSTONE) {
+            func(entry, user_data);
+        }
+    }
+}
+
+void hash_table_destroy(_Atomic(hash_table_t*) *table_ptr) {
+    hash_table_t *table = DLB_ATOMIC_LD_RLX(table_ptr);
+    while (table != NULL) {
+        hash_table_t *retired = table->retired;
+        free(table);
+        table = retired;
+    }
+    DLB_ATOMIC_ST_RLX(table_ptr, NULL);
+}
@@ -0,0 +1,70 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+
+#include "support/atomic.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Open addressing hash table of pointers with linear probing. Lookups do not
+ * lock, while insertions and removals must be serialized by the caller. A full
+ * table is replaced by a new one with twice the capacity, but the previous one
+ * cannot be deallocated until the table is destroyed, since other threads may
+ * still be reading it. Removed entries leave a tombstone so that lookups keep
+ * probing past them. Entries are not owned by the table. */
+typedef struct hash_table_t hash_table_t;
+
+typedef unsigned int (*hash_table_hash_func_t)(const void *entry);
+typedef bool (*hash_table_equal_func_t)(const void *entry, const void *key);
+typedef void (*hash_table_func_t)(void *entry, void *user_data);
+
+/* FNV-1a of, at most, the first max_len characters of str */
+unsigned int hash_table_hash_string(const char *str, size_t max_len);
+
+/* Fibonacci hashing, for keys that are not uniformly distributed */
+static inline unsigned int hash_table_hash_pointer(const void *ptr) {
+    return (unsigned int)(((uint64_t)(uintptr_t)ptr * 0x9e3779b97f4a7c15ull) >> 32);
+}
+
+/* Insert entry, growing the table if needed. hash_func returns the hash of
+ * any entry in the table. The table is allocated on the first insertion. */
+void hash_table_insert(_Atomic(hash_table_t*) *table, void *entry,
+        hash_table_hash_func_t hash_func);
+
+/* Remove entry, hash must be the same as when it was inserted */
+void hash_table_remove(_Atomic(hash_table_t*) *table, const void *entry,
+        unsigned int hash);
+
+/* Return the entry with the given hash for which equal_func(entry, key) is
+ * true, or NULL if not found. It does not lock. */
+void* hash_table_lookup(_Atomic(hash_table_t*) *table, unsigned int hash,
+        hash_table_equal_func_t equal_func, const void *key);
+
+/* Call func for each entry, in no particular order */
+void hash_table_foreach(_Atomic(hash_table_t*) *table, hash_table_func_t func,
+        void *user_data);
+
+/* Deallocate the table and the previous ones, but not the entries */
+void hash_table_destroy(_Atomic(hash_table_t*) *table);
+
+#endif /* HASH_TABLE_H */
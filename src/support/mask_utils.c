@@ -1,5 +1,5 @@
 /*********************************************************************************/
-/*  Copyright 2009-2024 Barcelona Supercomputing Center                          */
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
 /*                                                                               */
 /*  This file is part of the DLB library.                                        */
 /*                                                                               */
@@ -685,6 +685,19 @@ int mu_get_core_id(int cpuid) {
     return -1;
 }
 
+int mu_get_node_id(int cpuid) {
+
+    if (cpuid < 0 || (unsigned)cpuid >= sys.num_cpus) return -1;
+
+    for (unsigned int node_id = 0; node_id < sys.num_nodes; ++node_id) {
+        if (CPU_ISSET_S(cpuid, mu_cpuset_alloc_size, sys.node_masks[node_id].set)) {
+            return node_id;
+        }
+    }
+
+    return -1;
+}
+
 const mu_cpuset_t* mu_get_core_mask(int cpuid) {
 
     if (cpuid < 0 || (unsigned)cpuid >= sys.num_cpus) return NULL;
@@ -1525,3 +1538,41 @@ void mu_testing_init_nohwloc(void) {
     mu_initialized = true;
     print_sys_info();
 }
+
+/* Saved system, while it is temporarily replaced by a synthetic one */
+static struct {
+    mu_system_loc_t sys;
+    bool initialized;
+    unsigned int cpuset_setsize;
+    size_t cpuset_alloc_size;
+    size_t cpuset_num_ulongs;
+} saved_sys;
+
+/* Set aside the current system, uninitialized afterwards, until restored.
+ * Calls do not nest. */
+void mu_testing_save_sys(void) {
+    saved_sys.sys = sys;
+    saved_sys.initialized = mu_initialized;
+    saved_sys.cpuset_setsize = mu_cpuset_setsize;
+    saved_sys.cpuset_alloc_size = mu_cpuset_alloc_size;
+    saved_sys.cpuset_num_ulongs = mu_cpuset_num_ulongs;
+
+    init_mu_struct();
+    mu_initialized = false;
+    mu_cpuset_setsize = CPU_SETSIZE;
+    mu_cpuset_alloc_size = CPU_ALLOC_SIZE(CPU_SETSIZE);
+    mu_cpuset_num_ulongs = CPU_ALLOC_SIZE(CPU_SETSIZE) / sizeof(unsigned long);
+}
+
+/* Deallocate the current system and restore the saved one */
+void mu_testing_restore_sys(void) {
+    if (mu_initialized) {
+        mu_finalize();
+    }
+
+    sys = saved_sys.sys;
+    mu_initialized = saved_sys.initialized;
+    mu_cpuset_setsize = saved_sys.cpuset_setsize;
+    mu_cpuset_alloc_size = saved_sys.cpuset_alloc_size;
+    mu_cpuset_num_ulongs = saved_sys.cpuset_num_ulongs;
+}
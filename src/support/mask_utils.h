@@ -1,5 +1,5 @@
 /*********************************************************************************/
-/*  Copyright 2009-2024 Barcelona Supercomputing Center                          */
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
 /*                                                                               */
 /*  This file is part of the DLB library.                                        */
 /*                                                                               */
@@ -45,6 +45,7 @@ void mu_get_system_description(print_buffer_t *buffer);
 bool mu_system_has_smt(void);
 int  mu_get_num_cores(void);
 int  mu_get_core_id(int cpuid);
+int  mu_get_node_id(int cpuid);
 const mu_cpuset_t* mu_get_core_mask(int cpuid);
 const mu_cpuset_t* mu_get_core_mask_by_coreid(int core_id);
 void mu_get_nodes_intersecting_with_cpuset(cpu_set_t *node_set, const cpu_set_t *cpuset);
@@ -97,5 +98,7 @@ void mu_testing_set_sys_masks(const cpu_set_t *sys_mask,
         const cpu_set_t *core_masks, unsigned int num_cores,
         const cpu_set_t *node_masks, unsigned int num_nodes);
 void mu_testing_init_nohwloc(void);
+void mu_testing_save_sys(void);
+void mu_testing_restore_sys(void);
 
 #endif /* MASK_UTILS_H */
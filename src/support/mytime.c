@@ -20,7 +20,10 @@
 #include "support/mytime.h"
 
 #include "support/debug.h"
+#include "apis/dlb_errors.h"
 
+#include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -166,6 +169,119 @@ void ns_to_human( char *buf, size_t size, int64_t ns ) {
 }
 
 
+/* Fast timer: invariant hardware counter calibrated against CLOCK_MONOTONIC */
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#define HAVE_FAST_COUNTER
+#endif
+
+enum { FAST_TIME_CALIBRATION_NS = 20000000LL };
+
+static struct {
+    bool enabled;
+    uint64_t base_ticks;
+    int64_t base_ns;
+    uint64_t mult;          /* ns per tick, 32.32 fixed point */
+} fast_time = { .enabled = false };
+
+#ifdef HAVE_FAST_COUNTER
+static inline uint64_t read_counter(void) {
+#if defined(__x86_64__)
+    /* rdtsc is not serializing, but it is the cheapest read and the timestamps
+     * are taken at coarse points like MPI calls or parallel regions */
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ volatile("isb; mrs %0, cntvct_el0" : "=r"(ticks) :: "memory");
+    return ticks;
+#endif
+}
+
+/* The counter can be used as a clock only if it runs at a constant rate,
+ * regardless of P-states, and it does not stop in deep C-states. Threads may
+ * migrate, so every CPU must report it */
+static bool counter_is_reliable(void) {
+#if defined(__x86_64__)
+    FILE *fd = fopen("/proc/cpuinfo", "r");
+    if (fd == NULL) return false;
+
+    bool reliable = true;
+    int num_flags = 0;
+    char *line = NULL;
+    size_t len = 0;
+    while (reliable && getline(&line, &len, fd) != -1) {
+        if (strncmp(line, "flags", 5) == 0) {
+            reliable = strstr(line, " constant_tsc") != NULL
+                && strstr(line, " nonstop_tsc") != NULL;
+            ++num_flags;
+        }
+    }
+    free(line);
+    fclose(fd);
+
+    return reliable && num_flags > 0;
+#elif defined(__aarch64__)
+    /* The generic timer is architecturally invariant and synchronized */
+    return true;
+#endif
+}
+
+/* Read the counter right before and after the clock, and take the midpoint */
+static void read_counter_and_clock(uint64_t *ticks, int64_t *ns) {
+    uint64_t ticks_before = read_counter();
+    *ns = get_time_in_ns();
+    uint64_t ticks_after = read_counter();
+    *ticks = ticks_before + (ticks_after - ticks_before) / 2;
+}
+#endif
+
+int fast_time_init(void) {
+#ifdef HAVE_FAST_COUNTER
+    if (!counter_is_reliable()) {
+        return DLB_ERR_NOCOMP;
+    }
+
+    uint64_t ticks_start, ticks_end;
+    int64_t ns_start, ns_end;
+    read_counter_and_clock(&ticks_start, &ns_start);
+    struct timespec sleep_time = { .tv_sec = 0, .tv_nsec = FAST_TIME_CALIBRATION_NS };
+    while (nanosleep(&sleep_time, &sleep_time) != 0) {}
+    read_counter_and_clock(&ticks_end, &ns_end);
+
+    if (ticks_end <= ticks_start || ns_end <= ns_start) {
+        return DLB_ERR_NOCOMP;
+    }
+
+    fast_time.base_ticks = ticks_end;
+    fast_time.base_ns = ns_end;
+    fast_time.mult = ((uint64_t)(ns_end - ns_start) << 32) / (ticks_end - ticks_start);
+    fast_time.enabled = true;
+
+    return DLB_SUCCESS;
+#else
+    return DLB_ERR_NOCOMP;
+#endif
+}
+
+void fast_time_finalize(void) {
+    fast_time.enabled = false;
+}
+
+/* Nanoseconds in the same time base as get_time_in_ns */
+int64_t get_fast_time_in_ns(void) {
+#ifdef HAVE_FAST_COUNTER
+    if (fast_time.enabled) {
+        /* Signed, since another CPU may read a counter value slightly behind
+         * the one taken as base at calibration */
+        int64_t elapsed_ticks = (int64_t)(read_counter() - fast_time.base_ticks);
+        return fast_time.base_ns
+            + (int64_t)(((__int128)elapsed_ticks * (__int128)fast_time.mult) >> 32);
+    }
+#endif
+    return get_time_in_ns();
+}
+
+
 /* Timers */
 
 enum { TIMER_MAX_KEY_LEN = 128 };
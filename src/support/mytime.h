@@ -42,6 +42,10 @@ int64_t timespec_diff( const struct timespec *start, const struct timespec *fini
 void add_tv_to_ts( const struct timeval *t1, const struct timeval *t2, struct timespec *res );
 void ns_to_human( char *buf, size_t size, int64_t ns );
 
+int fast_time_init(void);
+void fast_time_finalize(void);
+int64_t get_fast_time_in_ns(void);
+
 void timer_init(void);
 void *timer_register(const char *key);
 void timer_start(void *handler);
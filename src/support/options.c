@@ -64,6 +64,7 @@ typedef enum OptionTypes {
     OPT_OMPTOPTS_T, // omptool_opts_t
     OPT_TLPSUM_T,   // talp_summary_t
     OPT_TLPMOD_T,   // talp_model_t
+    OPT_TLPTMR_T,   // talp_timer_t
     OPT_TLPCOM_T,   // talp_component_t
     OPT_MNGO_MODE_T,// mngo_mode_t
     OPT_OMPTM_T     // omptm_version_t
@@ -402,6 +403,61 @@ static const opts_dict_t options_dictionary[] = {
         .offset         = offsetof(options_t, lewi_color),
         .type           = OPT_INT_T,
         .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL)
+    }, {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--lewi-record",
+        .default_value  = "no",
+        .description    = OFFSET"Record every LeWI operation (lend, reclaim, acquire, borrow,\n"
+                          OFFSET"return, etc.) with its arguments into a per-node ring buffer.\n"
+                          OFFSET"The log is saved into DLB_cpuinfolog_<key>.dlbsnap when the\n"
+                          OFFSET"last process finalizes, or with 'dlb_shm --snapshot' while the\n"
+                          OFFSET"application runs, and replayed offline through the LeWI policy\n"
+                          OFFSET"with 'dlb_shm --replay'.",
+        .offset         = offsetof(options_t, lewi_record),
+        .type           = OPT_BOOL_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL | OPT_ADVANCED)
+    },
+    // DROM
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--drom-migration-budget",
+        .default_value  = "0",
+        .description    = OFFSET"Maximum number of CPUs that a process moves per interval when\n"
+                          OFFSET"applying a new asynchronous DROM mask. If the new mask differs\n"
+                          OFFSET"in more CPUs, it is applied in staged steps on subsequent DROM\n"
+                          OFFSET"polls, pairing removed and added CPUs within the same NUMA node\n"
+                          OFFSET"when possible. A value of 0 applies every change at once.",
+        .offset         = offsetof(options_t, drom_migration_budget),
+        .type           = OPT_INT_T,
+        .flags          = (option_flags_t)(OPT_OPTIONAL | OPT_ADVANCED)
+    }, {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--drom-migration-interval",
+        .default_value  = "1000",
+        .description    = OFFSET"Length in milliseconds of the interval to which the\n"
+                          OFFSET"--drom-migration-budget option applies.",
+        .offset         = offsetof(options_t, drom_migration_interval),
+        .type           = OPT_INT_T,
+        .flags          = (option_flags_t)(OPT_OPTIONAL | OPT_ADVANCED)
+    }, {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--drom-cgroup",
+        .default_value  = "no",
+        .description    = OFFSET"Watch the cgroup v2 cpuset of the process and translate any\n"
+                          OFFSET"change of cpuset.cpus.effective into a DROM mask update.\n"
+                          OFFSET"Requires --drom.",
+        .offset         = offsetof(options_t, drom_cgroup),
+        .type           = OPT_BOOL_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL | OPT_ADVANCED)
+    }, {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--drom-cgroup-path",
+        .default_value  = "",
+        .description    = OFFSET"Directory of the cgroup to watch with --drom-cgroup. By default,\n"
+                          OFFSET"it is obtained from /proc/self/cgroup.",
+        .offset         = offsetof(options_t, drom_cgroup_path),
+        .type           = OPT_STR_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL | OPT_ADVANCED)
     },
     // talp
     {
@@ -457,8 +513,12 @@ static const opts_dict_t options_dictionary[] = {
                           OFFSET"The output format is determined by the file extension:\n"
                           OFFSET"    *.json   JSON (file is overwritten)\n"
                           OFFSET"    *.csv    CSV  (rows are appended)\n"
+                          OFFSET"    *.talp   Binary columnar format (file is overwritten)\n"
                           OFFSET"    other    Plain text\n"
                           OFFSET"\n"
+                          OFFSET"A .gz or .zst suffix after the extension compresses the\n"
+                          OFFSET"output with zlib or zstd, if available at run time.\n"
+                          OFFSET"\n"
                           OFFSET"The filename may contain replacement tokens:\n"
                           OFFSET"    %h       Hostname\n"
                           OFFSET"    %p       Process ID (PID)\n"
@@ -481,6 +541,18 @@ static const opts_dict_t options_dictionary[] = {
         .type           = OPT_BOOL_T,
         .flags          = (option_flags_t)(OPT_OPTIONAL)
     },
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--talp-collective-output",
+        .default_value  = "no",
+        .description    = OFFSET"Write the per-process records of the process summary from every\n"
+                          OFFSET"MPI rank in parallel to a single file using MPI-IO, instead of\n"
+                          OFFSET"gathering them in rank 0. Only supported when the output format\n"
+                          OFFSET"is CSV. The file ends with an index of the rows of each rank.",
+        .offset         = offsetof(options_t, talp_collective_output),
+        .type           = OPT_BOOL_T,
+        .flags          = (option_flags_t)(OPT_OPTIONAL)
+    },
     {
         /* In the future, consider using an interval update timer instead of a boolean */
         .var_name       = "LB_NULL",
@@ -493,6 +565,106 @@ static const opts_dict_t options_dictionary[] = {
         .type           = OPT_BOOL_T,
         .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL)
     },
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--talp-lazy-regions",
+        .default_value  = "no",
+        .description    = OFFSET"Defer the update of nested open regions until they are stopped\n"
+                          OFFSET"or queried, so that starting and stopping a region does not\n"
+                          OFFSET"depend on the number of open regions. Ignored if\n"
+                          OFFSET"--talp-external-profiler is enabled.",
+        .offset         = offsetof(options_t, talp_lazy_regions),
+        .type           = OPT_BOOL_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL)
+    },
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--talp-mpi-breakdown",
+        .default_value  = "no",
+        .description    = OFFSET"Break down the MPI calls of each region by MPI function,\n"
+                          OFFSET"e.g., MPI_Allreduce, MPI_Waitall or MPI_Send, with the\n"
+                          OFFSET"number of calls, the time spent and the size of the message\n"
+                          OFFSET"buffers, i.e., the capacity for receives. The breakdown is\n"
+                          OFFSET"added to the POP metrics summary.",
+        .offset         = offsetof(options_t, talp_mpi_breakdown),
+        .type           = OPT_BOOL_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL)
+    },
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--talp-openmp-auto-regions",
+        .default_value  = "no",
+        .description    = OFFSET"Create a monitoring region for each outermost OpenMP parallel\n"
+                          OFFSET"construct, identified by its code address, so that each one\n"
+                          OFFSET"reports its own metrics without annotating the code. Regions\n"
+                          OFFSET"are named after the function of the construct, if it can be\n"
+                          OFFSET"resolved, or after its offset in the binary. Requires --ompt.",
+        .offset         = offsetof(options_t, talp_openmp_auto_regions),
+        .type           = OPT_BOOL_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL)
+    },
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--talp-mpi-auto-regions",
+        .default_value  = "no",
+        .description    = OFFSET"Create a monitoring region for each MPI call site, identified\n"
+                          OFFSET"by its return address, that measures the code between the\n"
+                          OFFSET"return of the call and the next MPI call. Regions are named\n"
+                          OFFSET"like the OpenMP automatic regions. Every MPI call stops and\n"
+                          OFFSET"starts a region, which adds an overhead to each call.",
+        .offset         = offsetof(options_t, talp_mpi_auto_regions),
+        .type           = OPT_BOOL_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL)
+    },
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--talp-auto-regions-max",
+        .default_value  = "1000",
+        .description    = OFFSET"Maximum number of automatic regions of each kind. Further\n"
+                          OFFSET"code addresses are aggregated into one overflow region,\n"
+                          OFFSET"whose addresses may differ across processes.",
+        .offset         = offsetof(options_t, talp_auto_regions_max),
+        .type           = OPT_INT_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL)
+    },
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--talp-sampling-period",
+        .default_value  = "0",
+        .description    = OFFSET"If greater than 0, sampling period in microseconds of the\n"
+                          OFFSET"TALP statistical sampling mode. MPI calls and OpenMP\n"
+                          OFFSET"synchronization and task events only switch the thread\n"
+                          OFFSET"state, and the time of each thread is split among\n"
+                          OFFSET"states according to the states observed by a per-thread\n"
+                          OFFSET"SIGPROF timer.",
+        .offset         = offsetof(options_t, talp_sampling_period),
+        .type           = OPT_INT_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL | OPT_ADVANCED)
+    },
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--talp-timeseries-period",
+        .default_value  = "0",
+        .description    = OFFSET"If greater than 0, period in milliseconds at which the\n"
+                          OFFSET"increment of every region is appended to the time-series\n"
+                          OFFSET"file. Periods are checked on MPI calls and region\n"
+                          OFFSET"starts and stops of the main thread.",
+        .offset         = offsetof(options_t, talp_timeseries_period),
+        .type           = OPT_INT_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL)
+    },
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--talp-timeseries-file",
+        .default_value  = "",
+        .description    = OFFSET"JSON-lines file of the TALP time series, one line per region\n"
+                          OFFSET"and period. The filename may contain the same replacement\n"
+                          OFFSET"tokens as --talp-output-file. If not set, the time series\n"
+                          OFFSET"is written to talp_timeseries_%h_%p.jsonl.",
+        .offset         = offsetof(options_t, talp_timeseries_file),
+        .type           = OPT_PTR_PATH_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL)
+    },
     {
         .var_name       = "LB_NULL",
         .arg_name       = "--talp-regions-per-proc",
@@ -555,6 +727,20 @@ static const opts_dict_t options_dictionary[] = {
         .type           = OPT_TLPMOD_T,
         .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL | OPT_ADVANCED)
     },
+    {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--talp-timer",
+        .default_value  = "clock",
+        .description    = OFFSET"Select the timer used by TALP to timestamp its samples.\n"
+                          OFFSET"'clock' uses clock_gettime with CLOCK_MONOTONIC. 'tsc' reads\n"
+                          OFFSET"the CPU time-stamp counter, or the generic timer on aarch64,\n"
+                          OFFSET"which is cheaper but requires an invariant counter. If the\n"
+                          OFFSET"counter is not reliable, TALP falls back to 'clock'. With\n"
+                          OFFSET"'tsc', TALP initialization sleeps 20 ms to calibrate it.",
+        .offset         = offsetof(options_t, talp_timer),
+        .type           = OPT_TLPTMR_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL | OPT_ADVANCED)
+    },
     // MNGO
     {
         .var_name       = "LB_NULL",
@@ -613,6 +799,17 @@ static const opts_dict_t options_dictionary[] = {
         .offset         = offsetof(options_t, barrier_id),
         .type           = OPT_INT_T,
         .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL | OPT_ADVANCED)
+    }, {
+        .var_name       = "LB_NULL",
+        .arg_name       = "--barrier-futex",
+        .default_value  = "no",
+        .description    = OFFSET"Use a hierarchical barrier implementation, where processes\n"
+                          OFFSET"spin briefly and then block on a futex, for the barriers\n"
+                          OFFSET"created by this process. Named barriers may also select it\n"
+                          OFFSET"with the flag DLB_BARRIER_FUTEX.",
+        .offset         = offsetof(options_t, barrier_futex),
+        .type           = OPT_BOOL_T,
+        .flags          = (option_flags_t)(OPT_READONLY | OPT_OPTIONAL | OPT_ADVANCED)
     },
     // misc
     {
@@ -741,6 +938,8 @@ static int set_value(option_type_t type, void *option, const char *str_value) {
             return parse_talp_summary(str_value, (talp_summary_t*)option);
         case OPT_TLPMOD_T:
             return parse_talp_model(str_value, (talp_model_t*)option);
+        case OPT_TLPTMR_T:
+            return parse_talp_timer(str_value, (talp_timer_t*)option);
         case OPT_TLPCOM_T:
             return parse_talp_component(str_value, (talp_component_t*)option);
         case OPT_MNGO_MODE_T:
@@ -787,6 +986,8 @@ static const char * get_value(option_type_t type, const void *option) {
             return talp_summary_tostr(*(talp_summary_t*)option);
         case OPT_TLPMOD_T:
             return talp_model_tostr(*(talp_model_t*)option);
+        case OPT_TLPTMR_T:
+            return talp_timer_tostr(*(talp_timer_t*)option);
         case OPT_TLPCOM_T:
             return talp_component_tostr(*(talp_component_t*)option);
         case OPT_MNGO_MODE_T:
@@ -832,6 +1033,8 @@ static bool values_are_equivalent(option_type_t type, const char *value1, const
             return equivalent_talp_summary(value1, value2);
         case OPT_TLPMOD_T:
             return equivalent_talp_model(value1, value2);
+        case OPT_TLPTMR_T:
+            return equivalent_talp_timer(value1, value2);
         case OPT_TLPCOM_T:
             return equivalent_talp_component(value1, value2);
         case OPT_MNGO_MODE_T:
@@ -892,6 +1095,9 @@ static void copy_value(option_type_t type, void *dest, const char *src) {
         case OPT_TLPMOD_T:
             memcpy(dest, src, sizeof(talp_model_t));
             break;
+        case OPT_TLPTMR_T:
+            memcpy(dest, src, sizeof(talp_timer_t));
+            break;
         case OPT_TLPCOM_T:
             memcpy(dest, src, sizeof(talp_component_t));
             break;
@@ -1149,6 +1355,10 @@ void options_finalize(options_t *options) {
         free(options->talp_output_file);
         options->talp_output_file = NULL;
     }
+    if (options->talp_timeseries_file) {
+        free(options->talp_timeseries_file);
+        options->talp_timeseries_file = NULL;
+    }
 }
 
 /* Obtain value of specific entry, either from DLB_ARGS or from thread_spd->options */
@@ -1369,6 +1579,9 @@ void options_print_variables(const options_t *options, bool print_extended) {
             case OPT_TLPMOD_T:
                 b += snprintf(b, max_entry_len, "[%s]", get_talp_model_choices());
                 break;
+            case OPT_TLPTMR_T:
+                b += snprintf(b, max_entry_len, "[%s]", get_talp_timer_choices());
+                break;
             case OPT_TLPCOM_T:
                 b += snprintf(b, max_entry_len, "{%s}", get_talp_component_choices());
                 break;
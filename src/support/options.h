@@ -56,6 +56,12 @@ typedef struct Options {
     omptool_opts_t      lewi_ompt;
     int                 lewi_max_parallelism;
     int                 lewi_color;
+    bool                lewi_record;
+    /* drom */
+    int                 drom_migration_budget;
+    int                 drom_migration_interval;
+    bool                drom_cgroup;
+    char                drom_cgroup_path[MAX_OPTION_LENGTH];
     /* misc */
     char                shm_key[MAX_OPTION_LENGTH];
     int                 shm_size_multiplier;
@@ -65,12 +71,22 @@ typedef struct Options {
     /* talp */
     talp_component_t    talp;
     bool                talp_external_profiler;
+    bool                talp_lazy_regions;
+    bool                talp_mpi_breakdown;
+    bool                talp_openmp_auto_regions;
+    bool                talp_mpi_auto_regions;
+    int                 talp_auto_regions_max;
+    int                 talp_sampling_period;
+    int                 talp_timeseries_period;
+    char                *talp_timeseries_file;
     bool                talp_partial_output;
+    bool                talp_collective_output;
     talp_summary_t      talp_summary;
     char                *talp_output_file;
     char                talp_region_select[MAX_OPTION_LENGTH];
     char                talp_gpu_backend[MAX_OPTION_LENGTH];
     talp_model_t        talp_model;
+    talp_timer_t        talp_timer;
     /* mngo */
     int                 mngo_interval_time;
     mngo_mode_t         mngo_mode;
@@ -78,6 +94,7 @@ typedef struct Options {
     int                 mngo_lb_out_threshold;
     /* barrier */
     int                 barrier_id;
+    bool                barrier_futex;
     /* deprecated, but still parsed, options */
     bool                deprecated_talp_openmp;
     bool                deprecated_talp_papi;
@@ -622,6 +622,46 @@ bool equivalent_talp_model(const char *str1, const char *str2) {
 }
 
 
+/* talp_timer_t */
+static const talp_timer_t talp_timer_values[] = {TALP_TIMER_CLOCK, TALP_TIMER_TSC};
+static const char* const talp_timer_choices[] = {"clock", "tsc"};
+static const char talp_timer_choices_str[] = "clock, tsc";
+enum { talp_timer_nelems = sizeof(talp_timer_values) / sizeof(talp_timer_values[0]) };
+
+int parse_talp_timer(const char *str, talp_timer_t *value) {
+    int i;
+    for (i=0; i<talp_timer_nelems; ++i) {
+        if (strcasecmp(str, talp_timer_choices[i]) == 0) {
+            *value = talp_timer_values[i];
+            return DLB_SUCCESS;
+        }
+    }
+    return DLB_ERR_NOENT;
+}
+
+const char* talp_timer_tostr(talp_timer_t value) {
+    int i;
+    for (i=0; i<talp_timer_nelems; ++i) {
+        if (talp_timer_values[i] == value) {
+            return talp_timer_choices[i];
+        }
+    }
+    return "unknown";
+}
+
+const char* get_talp_timer_choices(void) {
+    return talp_timer_choices_str;
+}
+
+bool equivalent_talp_timer(const char *str1, const char *str2) {
+    talp_timer_t value1 = TALP_TIMER_CLOCK;
+    talp_timer_t value2 = TALP_TIMER_TSC;
+    int err1 = parse_talp_timer(str1, &value1);
+    int err2 = parse_talp_timer(str2, &value2);
+    return err1 == DLB_SUCCESS && err2 == DLB_SUCCESS && value1 == value2;
+}
+
+
 /* talp_component_t */
 static const talp_component_t talp_component_values[] = {
     TALP_COMPONENT_NONE, TALP_COMPONENT_DEFAULT, TALP_COMPONENT_MPI, TALP_COMPONENT_OPENMP,
@@ -114,6 +114,11 @@ typedef enum TalpModel {
     TALP_MODEL_HYBRID_V2,
 } talp_model_t;
 
+typedef enum TalpTimer {
+    TALP_TIMER_CLOCK,
+    TALP_TIMER_TSC,
+} talp_timer_t;
+
 typedef enum TalpComponent {
     TALP_COMPONENT_NONE    = 0,
     TALP_COMPONENT_DEFAULT = 1 << 0,
@@ -162,12 +167,18 @@ typedef enum OMPTMVersion {
     OMPTM_ROLE_SHIFT
 } omptm_version_t;
 
+/* Number of distinct MPI calls in the TALP breakdown of MPI calls. Each MPI
+ * call is assigned a slot on first use, and slot 0 accumulates the calls that
+ * arrive once all slots are taken */
+enum { MPI_NUM_CALL_SLOTS = 64 };
+
 typedef struct sync_call_flags_t {
     bool is_mpi:1;
     bool is_blocking:1;
     bool is_collective:1;
     bool is_dlb_barrier:1;
     bool do_lewi:1;
+    unsigned int mpi_call_slot:6;   /* < MPI_NUM_CALL_SLOTS */
 } sync_call_flags_t;
 
 static inline int min_int(int a, int b) { return a < b ? a : b; }
@@ -247,6 +258,12 @@ const char* talp_model_tostr(talp_model_t value);
 const char* get_talp_model_choices(void);
 bool equivalent_talp_model(const char *str1, const char *str2);
 
+/* talp_timer_t */
+int parse_talp_timer(const char *str, talp_timer_t *value);
+const char* talp_timer_tostr(talp_timer_t value);
+const char* get_talp_timer_choices(void);
+bool equivalent_talp_timer(const char *str1, const char *str2);
+
 /* talp_component_t */
 int parse_talp_component(const char *str, talp_component_t *value);
 const char* talp_component_tostr(talp_component_t value);
@@ -0,0 +1,320 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "talp/auto_regions.h"
+
+#include "LB_core/spd.h"
+#include "apis/dlb_errors.h"
+#include "apis/dlb_talp.h"
+#include "support/atomic.h"
+#include "support/debug.h"
+#include "support/dlb_common.h"
+#include "support/hash_table.h"
+#include "talp/regions.h"
+#include "talp/talp_types.h"
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef struct auto_region_t {
+    const void          *codeptr;
+    auto_region_kind_t  kind;
+    bool                overflow;   /* monitor is the overflow region of this kind */
+    dlb_monitor_t       *monitor;
+} auto_region_t;
+
+enum { AUTO_REGION_NUM_KINDS = AUTO_REGION_MPI + 1 };
+
+static const char* const auto_region_prefix[AUTO_REGION_NUM_KINDS] = {
+    [AUTO_REGION_OPENMP] = "OpenMP parallel",
+    [AUTO_REGION_MPI]    = "After MPI call",
+};
+
+
+/*********************************************************************************/
+/*    Lookup of automatic regions by code address                                */
+/*********************************************************************************/
+
+/* Lookups do not lock, while insertions are serialized with the regions_mutex.
+ * The table is deallocated when TALP is finalized. */
+struct auto_region_table_t {
+    _Atomic(hash_table_t*)      lookup;
+    unsigned int                num_regions[AUTO_REGION_NUM_KINDS]; /* excluding overflow */
+    bool                        overflowed[AUTO_REGION_NUM_KINDS];
+    bool                        symbolized;
+};
+
+static unsigned int hash_auto_region(const void *auto_region) {
+    return hash_table_hash_pointer(((const auto_region_t*)auto_region)->codeptr);
+}
+
+static bool auto_region_equal(const void *auto_region, const void *key) {
+    const auto_region_t *a = auto_region;
+    const auto_region_t *b = key;
+    return a->codeptr == b->codeptr && a->kind == b->kind;
+}
+
+/* Return the table, allocating it if needed. The caller must hold the
+ * regions_mutex */
+static auto_region_table_t* table_get(talp_info_t *talp_info) {
+    auto_region_table_t *table = DLB_ATOMIC_LD_RLX(&talp_info->auto_regions);
+    if (table == NULL) {
+        table = calloc(1, sizeof(auto_region_table_t));
+        fatal_cond(!table, "Could not allocate TALP automatic regions table."
+                " Please report at "PACKAGE_BUGREPORT);
+        DLB_ATOMIC_ST_REL(&talp_info->auto_regions, table);
+    }
+    return table;
+}
+
+/* Find automatic region by code address, lock-free */
+static auto_region_t* table_lookup(talp_info_t *talp_info,
+        auto_region_kind_t kind, const void *codeptr) {
+    auto_region_table_t *table = DLB_ATOMIC_LD_ACQ(&talp_info->auto_regions);
+    if (table == NULL) return NULL;
+
+    const auto_region_t key = { .codeptr = codeptr, .kind = kind };
+    return hash_table_lookup(&table->lookup, hash_table_hash_pointer(codeptr),
+            auto_region_equal, &key);
+}
+
+
+/*********************************************************************************/
+/*    Per-thread cache                                                           */
+/*********************************************************************************/
+
+/* Direct-mapped cache of the last automatic regions seen by each thread. The
+ * global epoch is increased when TALP is finalized, since the cached monitors
+ * are no longer valid. */
+enum { AUTO_REGION_CACHE_SIZE = 16 };
+
+static atomic_uint auto_regions_epoch = 1;
+static __thread unsigned int cache_epoch = 0;
+static __thread auto_region_t cache[AUTO_REGION_CACHE_SIZE];
+
+
+/*********************************************************************************/
+/*    Naming of automatic regions                                                */
+/*********************************************************************************/
+
+/* Write the location of codeptr as <binary>+<offset> */
+static void get_location(const void *codeptr, char *location, size_t size) {
+
+    /* Shared objects and dynamically linked executables */
+    Dl_info info;
+    if (dladdr(codeptr, &info) && info.dli_fname != NULL && info.dli_fbase != NULL) {
+        const char *binary = strrchr(info.dli_fname, '/');
+        binary = binary != NULL ? binary + 1 : info.dli_fname;
+        snprintf(location, size, "%s+%#lx", binary,
+                (unsigned long)((uintptr_t)codeptr - (uintptr_t)info.dli_fbase));
+        return;
+    }
+
+    /* Otherwise, look for the file mapping that contains codeptr */
+    FILE *maps = fopen("/proc/self/maps", "r");
+    if (maps != NULL) {
+        uintptr_t address = (uintptr_t)codeptr;
+        char line[512];
+        while (fgets(line, sizeof(line), maps) != NULL) {
+            unsigned long start, end, offset;
+            int path_pos = 0;
+            if (sscanf(line, "%lx-%lx %*s %lx %*s %*s %n", &start, &end, &offset, &path_pos) >= 3
+                    && path_pos > 0 && line[path_pos] == '/'
+                    && address >= start && address < end) {
+                line[strcspn(line, "\n")] = '\0';
+                const char *binary = strrchr(&line[path_pos], '/') + 1;
+                snprintf(location, size, "%s+%#lx", binary, address - start + offset);
+                fclose(maps);
+                return;
+            }
+        }
+        fclose(maps);
+    }
+
+    snprintf(location, size, "%p", codeptr);
+}
+
+static auto_region_t* auto_region_register(const subprocess_descriptor_t *spd,
+        auto_region_kind_t kind, const void *codeptr) {
+
+    talp_info_t *talp_info = spd->talp_info;
+    auto_region_t *auto_region;
+    bool overflow = false;
+    bool first_overflow = false;
+
+    /* Count the new region of this kind, or use the overflow region if the
+     * maximum is reached. Which addresses overflow depends on the order in
+     * which this process encounters them, so it may differ among processes */
+    pthread_mutex_lock(&talp_info->regions_mutex);
+    {
+        auto_region = table_lookup(talp_info, kind, codeptr);
+        if (auto_region == NULL) {
+            auto_region_table_t *table = table_get(talp_info);
+            if (table->num_regions[kind] <
+                    (unsigned int)max_int(spd->options.talp_auto_regions_max, 0)) {
+                ++table->num_regions[kind];
+            } else {
+                overflow = true;
+                first_overflow = !table->overflowed[kind];
+                table->overflowed[kind] = true;
+            }
+        }
+    }
+    pthread_mutex_unlock(&talp_info->regions_mutex);
+
+    if (auto_region != NULL) return auto_region;
+
+    if (first_overflow) {
+        warning("Reached the maximum number of automatic regions (%d) of kind %s."
+                " Further code addresses are aggregated into an overflow region, which"
+                " may contain different addresses in each process, so the metrics of"
+                " automatic regions are not comparable across processes. Increase the"
+                " maximum with --talp-auto-regions-max.",
+                spd->options.talp_auto_regions_max, auto_region_prefix[kind]);
+    }
+
+    char name[DLB_MONITOR_NAME_MAX];
+    if (overflow) {
+        snprintf(name, sizeof(name), "%s overflow", auto_region_prefix[kind]);
+    } else {
+        int len = snprintf(name, sizeof(name), "%s ", auto_region_prefix[kind]);
+        get_location(codeptr, &name[len], sizeof(name) - len);
+    }
+
+    dlb_monitor_t *monitor = region_register(spd, name);
+    fatal_cond(!monitor, "Could not register the automatic region %s."
+            " Please report at "PACKAGE_BUGREPORT, name);
+
+    /* Finally, insert, unless another thread has registered the same address.
+     * Overflow addresses are also inserted so that their lookups do not lock. */
+    pthread_mutex_lock(&talp_info->regions_mutex);
+    {
+        auto_region_table_t *table = table_get(talp_info);
+        auto_region = table_lookup(talp_info, kind, codeptr);
+        if (auto_region == NULL) {
+            auto_region = malloc(sizeof(auto_region_t));
+            fatal_cond(!auto_region, "Could not register the automatic region %s."
+                    " Please report at "PACKAGE_BUGREPORT, name);
+            *auto_region = (const auto_region_t) {
+                .codeptr = codeptr,
+                .kind = kind,
+                .overflow = overflow,
+                .monitor = monitor,
+            };
+            hash_table_insert(&table->lookup, auto_region, hash_auto_region);
+            verbose(VB_TALP, "Registering automatic region %s", name);
+        } else if (!overflow) {
+            --table->num_regions[kind];
+        }
+    }
+    pthread_mutex_unlock(&talp_info->regions_mutex);
+
+    return auto_region;
+}
+
+
+/*********************************************************************************/
+/*    Automatic regions                                                          */
+/*********************************************************************************/
+
+dlb_monitor_t* auto_region_get(const subprocess_descriptor_t *spd,
+        auto_region_kind_t kind, const void *codeptr) {
+
+    unsigned int epoch = DLB_ATOMIC_LD_RLX(&auto_regions_epoch);
+    if (unlikely(cache_epoch != epoch)) {
+        memset(cache, 0, sizeof(cache));
+        cache_epoch = epoch;
+    }
+
+    auto_region_t *cached =
+        &cache[hash_table_hash_pointer(codeptr) & (AUTO_REGION_CACHE_SIZE-1)];
+    if (likely(cached->codeptr == codeptr && cached->kind == kind)) {
+        return cached->monitor;
+    }
+
+    auto_region_t *auto_region = table_lookup(spd->talp_info, kind, codeptr);
+    if (auto_region == NULL) {
+        auto_region = auto_region_register(spd, kind, codeptr);
+    }
+
+    *cached = *auto_region;
+    return auto_region->monitor;
+}
+
+static void symbolize_auto_region(void *entry, void *user_data) {
+
+    const auto_region_t *auto_region = entry;
+    const subprocess_descriptor_t *spd = user_data;
+    if (auto_region->overflow) return;
+
+    /* Executables need to export their symbols, e.g., with -rdynamic */
+    Dl_info info;
+    if (dladdr(auto_region->codeptr, &info)
+            && info.dli_sname != NULL && info.dli_saddr != NULL) {
+        char name[DLB_MONITOR_NAME_MAX];
+        snprintf(name, sizeof(name), "%s %s+%#lx",
+                auto_region_prefix[auto_region->kind], info.dli_sname,
+                (unsigned long)((uintptr_t)auto_region->codeptr
+                    - (uintptr_t)info.dli_saddr));
+        if (region_rename(spd, auto_region->monitor, name) == DLB_SUCCESS) {
+            verbose(VB_TALP, "Renaming automatic region to %s", name);
+        }
+    }
+}
+
+void auto_regions_symbolize(const subprocess_descriptor_t *spd) {
+
+    talp_info_t *talp_info = spd->talp_info;
+
+    /* Region names are already published in the shared memory */
+    if (talp_info->flags.have_shmem) return;
+
+    auto_region_table_t *table = DLB_ATOMIC_LD_ACQ(&talp_info->auto_regions);
+    if (table == NULL || table->symbolized) return;
+    table->symbolized = true;
+
+    hash_table_foreach(&table->lookup, symbolize_auto_region, (void*)spd);
+}
+
+static void free_auto_region(void *entry, void *user_data) {
+    free(entry);
+}
+
+void auto_regions_finalize(talp_info_t *talp_info) {
+
+    auto_region_table_t *table = DLB_ATOMIC_LD_RLX(&talp_info->auto_regions);
+    if (table == NULL) return;
+
+    hash_table_foreach(&table->lookup, free_auto_region, NULL);
+    hash_table_destroy(&table->lookup);
+    free(table);
+    DLB_ATOMIC_ST_RLX(&talp_info->auto_regions, NULL);
+
+    /* Invalidate the per-thread caches */
+    DLB_ATOMIC_ADD_RLX(&auto_regions_epoch, 1);
+}
@@ -0,0 +1,53 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifndef AUTO_REGIONS_H
+#define AUTO_REGIONS_H
+
+typedef struct dlb_monitor_t dlb_monitor_t;
+typedef struct SubProcessDescriptor subprocess_descriptor_t;
+typedef struct talp_info_t talp_info_t;
+
+/* Automatic regions: monitoring regions created by TALP for each distinct code
+ * address of some event, e.g., an OpenMP parallel construct */
+typedef enum AutoRegionKind {
+    AUTO_REGION_OPENMP,
+    AUTO_REGION_MPI,
+} auto_region_kind_t;
+
+/* Return the region of codeptr, registering it on first use. The region is
+ * named after the position-independent location of codeptr, i.e., the binary
+ * and the offset, so that it has the same name in all processes. Once the
+ * maximum number of regions of this kind is reached, further addresses share
+ * an overflow region. Since the overflowing addresses depend on the order in
+ * which each process encounters them, the maximum must not be reached for the
+ * regions to be comparable across processes. codeptr must not be NULL.
+ * Lookups do not lock. */
+dlb_monitor_t* auto_region_get(const subprocess_descriptor_t *spd,
+        auto_region_kind_t kind, const void *codeptr);
+
+/* Rename the automatic regions after the function of their code address, if
+ * it can be resolved. Only the main thread may call this function, once all
+ * automatic regions are stopped and before the regions are gathered. */
+void auto_regions_symbolize(const subprocess_descriptor_t *spd);
+
+/* Deallocate the lookup table, the caller must hold the regions_mutex */
+void auto_regions_finalize(talp_info_t *talp_info);
+
+#endif /* AUTO_REGIONS_H */
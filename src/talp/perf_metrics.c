@@ -29,8 +29,10 @@
 #include "mpi/mpi_core.h"
 #endif
 
+#include <math.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /*********************************************************************************/
@@ -268,6 +270,133 @@ static inline void perf_metrics__compute_hybrid_model_v2(
     };
 }
 
+/* 95% confidence intervals of the POP efficiencies out of the variances of the
+ * sampled MPI time. Each process is an independent estimate, and the useful
+ * time is the complement of the MPI time, so useful_time has the same
+ * variance. The load balance is a ratio of two dependent estimates, their
+ * positive covariance is ignored so its interval is conservative */
+static inline void perf_metrics__compute_hybrid_model_ci(
+        pop_metrics_ci_t *ci,
+        const pop_base_metrics_t *base_metrics,
+        talp_model_t model) {
+
+    const double z = 1.96;
+
+    int     num_cpus                = base_metrics->num_cpus;
+    int64_t elapsed_time            = base_metrics->elapsed_time;
+    int64_t useful_time             = base_metrics->useful_time;
+    int64_t mpi_time                = base_metrics->mpi_time;
+    int64_t mpi_worker_idle_time    = base_metrics->mpi_worker_idle_time;
+    double  min_mpi_normd_proc      = base_metrics->min_mpi_normd_proc;
+    double  mpi_time_variance       = base_metrics->mpi_time_variance;
+    double  mpi_cpu_time_variance   = base_metrics->mpi_cpu_time_variance;
+    double  min_mpi_normd_proc_variance = base_metrics->min_mpi_normd_proc_variance;
+
+    int64_t sum_active = useful_time + mpi_time + base_metrics->omp_load_imbalance_time
+        + base_metrics->omp_scheduling_time + base_metrics->omp_serialization_time
+        + base_metrics->gpu_runtime_time;
+
+    /* Non-MPI time normalized at application level, and its variance. The
+     * hybrid model v1 does not count the worker threads idle during MPI */
+    double mpi_normd_app, non_mpi_normd_app_variance;
+    if (model == TALP_MODEL_HYBRID_V1) {
+        mpi_normd_app = (double)mpi_time / num_cpus;
+        non_mpi_normd_app_variance = mpi_time_variance / ((double)num_cpus * num_cpus);
+    } else {
+        mpi_normd_app = (double)(mpi_time + mpi_worker_idle_time) / num_cpus;
+        non_mpi_normd_app_variance = mpi_cpu_time_variance / ((double)num_cpus * num_cpus);
+    }
+    double non_mpi_normd_app = elapsed_time - mpi_normd_app;
+    double max_non_mpi_normd_proc = elapsed_time - min_mpi_normd_proc;
+
+    double mpi_parallel_efficiency_sd = model == TALP_MODEL_HYBRID_V1
+        ? sqrt(mpi_time_variance) / (useful_time + mpi_time)
+        : sqrt(non_mpi_normd_app_variance) / elapsed_time;
+
+    double load_balance = non_mpi_normd_app / max_non_mpi_normd_proc;
+    double load_balance_variance =
+        (non_mpi_normd_app_variance
+         + load_balance * load_balance * min_mpi_normd_proc_variance)
+        / (max_non_mpi_normd_proc * max_non_mpi_normd_proc);
+
+    *ci = (const pop_metrics_ci_t) {
+        .parallel_efficiency = z * sqrt(mpi_time_variance) / sum_active,
+        .mpi_parallel_efficiency = z * mpi_parallel_efficiency_sd,
+        .mpi_communication_efficiency = z * sqrt(min_mpi_normd_proc_variance) / elapsed_time,
+        .mpi_load_balance = z * sqrt(load_balance_variance),
+    };
+}
+
+/* Combine the base metrics of two sets of processes */
+static void reduce_base_metrics(pop_base_metrics_t *inout, const pop_base_metrics_t *in) {
+    /* Resources */
+    inout->num_cpus                += in->num_cpus;
+    inout->num_available_cpus      += in->num_available_cpus;
+    inout->num_omp_threads         += in->num_omp_threads;
+    inout->num_mpi_ranks           += in->num_mpi_ranks;
+    inout->num_nodes               += in->num_nodes;
+    inout->avg_cpus                += in->avg_cpus;
+    inout->num_gpus                += in->num_gpus;
+    /* Hardware Counters */
+    inout->cycles                  += in->cycles;
+    inout->instructions            += in->instructions;
+    /* Statistics */
+    inout->num_measurements        += in->num_measurements;
+    inout->num_mpi_calls           += in->num_mpi_calls;
+    inout->num_omp_parallels       += in->num_omp_parallels;
+    inout->num_omp_tasks           += in->num_omp_tasks;
+    inout->num_gpu_runtime_calls   += in->num_gpu_runtime_calls;
+    /* Host Times */
+    inout->elapsed_time             = max_int64(inout->elapsed_time, in->elapsed_time);
+    inout->useful_time             += in->useful_time;
+    inout->mpi_time                += in->mpi_time;
+    inout->mpi_worker_idle_time    += in->mpi_worker_idle_time;
+    inout->omp_load_imbalance_time += in->omp_load_imbalance_time;
+    inout->omp_scheduling_time     += in->omp_scheduling_time;
+    inout->omp_serialization_time  += in->omp_serialization_time;
+    inout->gpu_runtime_time        += in->gpu_runtime_time;
+
+    /* Host Normalized Times, the variance is the one of the chosen process */
+    double min_mpi_normd_proc =
+        min_double_non_zero(inout->min_mpi_normd_proc, in->min_mpi_normd_proc);
+    if (min_mpi_normd_proc != inout->min_mpi_normd_proc) {
+        inout->min_mpi_normd_proc_variance = in->min_mpi_normd_proc_variance;
+    }
+    inout->min_mpi_normd_proc = min_mpi_normd_proc;
+    inout->min_mpi_normd_node =
+        min_double_non_zero(inout->min_mpi_normd_node, in->min_mpi_normd_node);
+
+    /* Host Variances, processes are independent */
+    inout->mpi_time_variance       += in->mpi_time_variance;
+    inout->mpi_cpu_time_variance   += in->mpi_cpu_time_variance;
+
+    /* Device Times */
+    inout->gpu_useful_time         += in->gpu_useful_time;
+    inout->gpu_communication_time  += in->gpu_communication_time;
+    inout->gpu_inactive_time       += in->gpu_inactive_time;
+
+    /* Device Max Times */
+    inout->max_gpu_useful_time =
+        max_int64(inout->max_gpu_useful_time, in->max_gpu_useful_time);
+    inout->max_gpu_active_time =
+        max_int64(inout->max_gpu_active_time, in->max_gpu_active_time);
+}
+
+/* Set the variances of a process out of the variance of its sampled MPI time.
+ * The time of the worker threads idle during MPI is proportional to it */
+static void set_mpi_time_variances(pop_base_metrics_t *base_metrics,
+        const dlb_monitor_t *monitor, double mpi_time_variance) {
+
+    double scale = monitor->mpi_time == 0 ? 1.0
+        : (double)(monitor->mpi_time + monitor->mpi_worker_idle_time) / monitor->mpi_time;
+    double mpi_cpu_time_variance = scale * scale * mpi_time_variance;
+
+    base_metrics->mpi_time_variance = mpi_time_variance;
+    base_metrics->mpi_cpu_time_variance = mpi_cpu_time_variance;
+    base_metrics->min_mpi_normd_proc_variance = monitor->num_cpus == 0 ? 0.0
+        : mpi_cpu_time_variance / ((double)monitor->num_cpus * monitor->num_cpus);
+}
+
 #ifdef MPI_LIB
 
 /* The following node and app reductions are needed to compute POP metrics: */
@@ -278,6 +407,7 @@ static inline void perf_metrics__compute_hybrid_model_v2(
 typedef struct node_reduction_t {
     bool node_used;
     int cpus_node;
+    int num_available_cpus;
     int64_t mpi_time;
     int64_t mpi_worker_idle_time;
     uint64_t gpu_ids[MAX_NODE_GPUS];
@@ -325,6 +455,8 @@ static void mpi_node_reduction_fn(void *invec, void *inoutvec, int *len,
         if (in[i].node_used) {
             inout[i].node_used = true;
             inout[i].cpus_node += in[i].cpus_node;
+            inout[i].num_available_cpus =
+                max_int(inout[i].num_available_cpus, in[i].num_available_cpus);
             inout[i].mpi_time += in[i].mpi_time;
             inout[i].mpi_worker_idle_time += in[i].mpi_worker_idle_time;
             merge_gpu_metrics(&inout[i], &in[i]);
@@ -332,57 +464,32 @@ static void mpi_node_reduction_fn(void *invec, void *inoutvec, int *len,
     }
 }
 
-/* Function to perform the reduction at node level */
-static void reduce_pop_metrics_node_reduction(node_reduction_t *node_reduction,
-        const dlb_monitor_t *monitor) {
+/* Cached MPI struct type and operation of node_reduction_t */
+static MPI_Datatype mpi_node_reduction_type = MPI_DATATYPE_NULL;
+static MPI_Op node_reduction_op = MPI_OP_NULL;
 
-    node_reduction_t node_reduction_send = {
-        .node_used = monitor->num_measurements > 0,
-        .cpus_node = monitor->num_cpus,
-        .mpi_time = monitor->mpi_time,
-        .mpi_worker_idle_time = monitor->mpi_worker_idle_time,
-    };
+static void init_node_reduction_type(void) {
 
-    /* Construct a contiguous output array of the GPUs times and their unique id */
-    int num_gpus = 0;
-    const monitor_data_t *monitor_data = monitor->_data;
-    uint64_t mask = monitor_data->gpu_mask;
-    while(mask) {
-        int gpu = gm_ctz(mask);
-        if (unlikely(gpu < 0)) {
-            warning("Unmatched gpu %d found in mask 0x%" PRIx64 "."
-                    " Please report bug", gpu, mask);
-            continue;
-        }
-
-        node_reduction_send.gpu_ids[num_gpus] = talp_gpu_local_to_unique_id((uint32_t)gpu);
-        node_reduction_send.gpu_useful[num_gpus] = monitor_data->gpu_timers[gpu].useful;
-        node_reduction_send.gpu_communication[num_gpus] =
-            monitor_data->gpu_timers[gpu].communication;
-
-        mask = gm_clear_lsb(mask);
-        ++num_gpus;
-    }
-    node_reduction_send.num_gpu_ids = num_gpus;
+    if (mpi_node_reduction_type != MPI_DATATYPE_NULL) return;
 
     /* MPI types: int64_t and uint64_t */
     MPI_Datatype mpi_int64_type = get_mpi_int64_type();
     MPI_Datatype mpi_uint64_type = get_mpi_uint64_type();
 
     /* MPI struct type: node_reduction_t */
-    MPI_Datatype mpi_node_reduction_type;
     {
-        int blocklengths[] = {1, 1, 1, 1, MAX_NODE_GPUS, MAX_NODE_GPUS, MAX_NODE_GPUS, 1};
+        int blocklengths[] = {1, 1, 1, 1, 1, MAX_NODE_GPUS, MAX_NODE_GPUS, MAX_NODE_GPUS, 1};
         MPI_Aint displacements[] = {
             offsetof(node_reduction_t, node_used),
             offsetof(node_reduction_t, cpus_node),
+            offsetof(node_reduction_t, num_available_cpus),
             offsetof(node_reduction_t, mpi_time),
             offsetof(node_reduction_t, mpi_worker_idle_time),
             offsetof(node_reduction_t, gpu_ids),
             offsetof(node_reduction_t, gpu_useful),
             offsetof(node_reduction_t, gpu_communication),
             offsetof(node_reduction_t, num_gpu_ids)};
-        MPI_Datatype types[] = {MPI_C_BOOL, MPI_INT, mpi_int64_type, mpi_int64_type,
+        MPI_Datatype types[] = {MPI_C_BOOL, MPI_INT, MPI_INT, mpi_int64_type, mpi_int64_type,
             mpi_uint64_type, mpi_int64_type, mpi_int64_type, MPI_INT};
 
         enum {count = sizeof(blocklengths) / sizeof(blocklengths[0])};
@@ -396,30 +503,81 @@ static void reduce_pop_metrics_node_reduction(node_reduction_t *node_reduction,
         PMPI_Type_create_resized(tmp_type, 0, sizeof(node_reduction_t),
                 &mpi_node_reduction_type);
         PMPI_Type_commit(&mpi_node_reduction_type);
-
+        PMPI_Type_free(&tmp_type);
     }
 
     /* Define MPI operation (the GPUs array merging makes this op a non-commutative) */
-    MPI_Op node_reduction_op;
     PMPI_Op_create(mpi_node_reduction_fn, false, &node_reduction_op);
+}
 
-    /* MPI reduction */
-    PMPI_Reduce(&node_reduction_send, node_reduction, 1,
-            mpi_node_reduction_type, node_reduction_op,
-            0, getNodeComm());
+/* Initialize the node reduction data of a monitor in this process */
+static void init_node_reduction_send(node_reduction_t *node_reduction_send,
+        const dlb_monitor_t *monitor) {
 
-    /* Check that we have not summed more CPUs that the node count */
-    int system_count = mu_get_system_count();
+    *node_reduction_send = (const node_reduction_t) {
+        .node_used = monitor->num_measurements > 0,
+        .cpus_node = monitor->num_cpus,
+        .num_available_cpus = mu_get_system_count(),
+        .mpi_time = monitor->mpi_time,
+        .mpi_worker_idle_time = monitor->mpi_worker_idle_time,
+    };
+
+    /* Construct a contiguous output array of the GPUs times and their unique id */
+    int num_gpus = 0;
+    const monitor_data_t *monitor_data = monitor->_data;
+    uint64_t mask = monitor_data->gpu_mask;
+    while(mask) {
+        int gpu = gm_ctz(mask);
+        if (unlikely(gpu < 0)) {
+            warning("Unmatched gpu %d found in mask 0x%" PRIx64 "."
+                    " Please report bug", gpu, mask);
+            continue;
+        }
+
+        node_reduction_send->gpu_ids[num_gpus] =
+            talp_gpu_local_to_unique_id((uint32_t)gpu);
+        node_reduction_send->gpu_useful[num_gpus] = monitor_data->gpu_timers[gpu].useful;
+        node_reduction_send->gpu_communication[num_gpus] =
+            monitor_data->gpu_timers[gpu].communication;
+
+        mask = gm_clear_lsb(mask);
+        ++num_gpus;
+    }
+    node_reduction_send->num_gpu_ids = num_gpus;
+}
+
+/* Check that we have not summed more CPUs that the node count */
+static void check_node_reduction_cpus(node_reduction_t *node_reduction) {
+    int system_count = node_reduction->num_available_cpus;
     if (node_reduction->cpus_node > system_count) {
         verbose(VB_TALP, "Warning: Number of CPUs after node reduction (%d) is greater"
                 " than the node CPU count (%d). Reverting value.",
                 node_reduction->cpus_node, system_count);
         node_reduction->cpus_node = system_count;
     }
+}
+
+/* Function to perform the reduction at node level of nmonitors monitors */
+static void reduce_pop_metrics_node_reduction(node_reduction_t *node_reductions,
+        const dlb_monitor_t *const *monitors, int nmonitors) {
+
+    node_reduction_t *node_reductions_send = calloc(nmonitors, sizeof(node_reduction_t));
+    fatal_cond(node_reductions_send == NULL, "Could not allocate TALP node reduction");
+
+    for (int m = 0; m < nmonitors; ++m) {
+        init_node_reduction_send(&node_reductions_send[m], monitors[m]);
+    }
 
-    /* Free MPI types */
-    PMPI_Type_free(&mpi_node_reduction_type);
-    PMPI_Op_free(&node_reduction_op);
+    /* MPI reduction of all monitors at once */
+    init_node_reduction_type();
+    PMPI_Reduce(node_reductions_send, node_reductions, nmonitors,
+            mpi_node_reduction_type, node_reduction_op,
+            0, getNodeComm());
+    free(node_reductions_send);
+
+    for (int m = 0; m < nmonitors; ++m) {
+        check_node_reduction_cpus(&node_reductions[m]);
+    }
 }
 
 /** App reduction ***/
@@ -433,87 +591,96 @@ static void mpi_reduction_fn(void *invec, void *inoutvec, int *len,
 
     int _len = *len;
     for (int i = 0; i < _len; ++i) {
-        /* Resources */
-        inout[i].num_cpus                += in[i].num_cpus;
-        inout[i].num_available_cpus      += in[i].num_available_cpus;
-        inout[i].num_omp_threads         += in[i].num_omp_threads;
-        inout[i].num_mpi_ranks           += in[i].num_mpi_ranks;
-        inout[i].num_nodes               += in[i].num_nodes;
-        inout[i].avg_cpus                += in[i].avg_cpus;
-        inout[i].num_gpus                += in[i].num_gpus;
-        /* Hardware Counters */
-        inout[i].cycles                  += in[i].cycles;
-        inout[i].instructions            += in[i].instructions;
-        /* Statistics */
-        inout[i].num_measurements        += in[i].num_measurements;
-        inout[i].num_mpi_calls           += in[i].num_mpi_calls;
-        inout[i].num_omp_parallels       += in[i].num_omp_parallels;
-        inout[i].num_omp_tasks           += in[i].num_omp_tasks;
-        inout[i].num_gpu_runtime_calls   += in[i].num_gpu_runtime_calls;
-        /* Host Times */
-        inout[i].elapsed_time             = max_int64(inout[i].elapsed_time, in[i].elapsed_time);
-        inout[i].useful_time             += in[i].useful_time;
-        inout[i].mpi_time                += in[i].mpi_time;
-        inout[i].mpi_worker_idle_time    += in[i].mpi_worker_idle_time;
-        inout[i].omp_load_imbalance_time += in[i].omp_load_imbalance_time;
-        inout[i].omp_scheduling_time     += in[i].omp_scheduling_time;
-        inout[i].omp_serialization_time  += in[i].omp_serialization_time;
-        inout[i].gpu_runtime_time        += in[i].gpu_runtime_time;
+        reduce_base_metrics(&inout[i], &in[i]);
+    }
+}
 
-        /* Host Normalized Times */
-        inout[i].min_mpi_normd_proc =
-            min_double_non_zero(inout[i].min_mpi_normd_proc, in[i].min_mpi_normd_proc);
-        inout[i].min_mpi_normd_node =
-            min_double_non_zero(inout[i].min_mpi_normd_node, in[i].min_mpi_normd_node);
+/* Cached MPI struct type and operation of pop_base_metrics_t */
+static MPI_Datatype mpi_app_reduction_type = MPI_DATATYPE_NULL;
+static MPI_Op app_reduction_op = MPI_OP_NULL;
 
-        /* Device Times */
-        inout[i].gpu_useful_time         += in[i].gpu_useful_time;
-        inout[i].gpu_communication_time  += in[i].gpu_communication_time;
-        inout[i].gpu_inactive_time       += in[i].gpu_inactive_time;
+static void init_app_reduction_type(void) {
 
-        /* Device Max Times */
-        inout[i].max_gpu_useful_time =
-            max_int64(inout[i].max_gpu_useful_time, in[i].max_gpu_useful_time);
-        inout[i].max_gpu_active_time =
-            max_int64(inout[i].max_gpu_active_time, in[i].max_gpu_active_time);
+    if (mpi_app_reduction_type != MPI_DATATYPE_NULL) return;
+
+    /* MPI type: int64_t */
+    MPI_Datatype mpi_int64_type = get_mpi_int64_type();
+
+    /* MPI struct type: app_reduction_t */
+    {
+
+        int blocklengths[] = {
+            #define FIELD_BLOCKLENGTH(name, c_type, mpi_type) 1,
+            FOR_POP_BASE_METRICS_FIELDS(FIELD_BLOCKLENGTH)
+            #undef FIELD_BLOCKLENGTH
+        };
+
+        MPI_Aint displacements[] = {
+            #define FIELD_DISPLACEMENT(name, c_type, mpi_type) offsetof(pop_base_metrics_t, name),
+            FOR_POP_BASE_METRICS_FIELDS(FIELD_DISPLACEMENT)
+            #undef FIELD_DISPLACEMENT
+        };
+
+        MPI_Datatype types[] = {
+            #define FIELD_MPI_TYPE(name, c_type, mpi_type) mpi_type,
+            FOR_POP_BASE_METRICS_FIELDS(FIELD_MPI_TYPE)
+            #undef FIELD_MPI_TYPE
+        };
+
+        enum {count = sizeof(blocklengths) / sizeof(blocklengths[0])};
+
+        MPI_Datatype tmp_type;
+        PMPI_Type_create_struct(count, blocklengths, displacements, types, &tmp_type);
+        PMPI_Type_create_resized(tmp_type, 0, sizeof(pop_base_metrics_t),
+                &mpi_app_reduction_type);
+        PMPI_Type_commit(&mpi_app_reduction_type);
+        PMPI_Type_free(&tmp_type);
     }
+
+    /* Define MPI operation */
+    PMPI_Op_create(mpi_reduction_fn, true, &app_reduction_op);
 }
 
-/* Function to perform the reduction at application level */
-static void reduce_pop_metrics_app_reduction(pop_base_metrics_t *base_metrics,
-        const node_reduction_t *node_reduction, const dlb_monitor_t *monitor,
-        bool all_to_all) {
+/* Add the metrics of a node, out of the result of its node reduction, to the
+ * base metrics. The number of GPUs and their times need to be aggregated by
+ * node, since devices can be shared among processes in the node. */
+static void add_node_reduction(pop_base_metrics_t *base_metrics,
+        const node_reduction_t *node_reduction) {
 
-    double min_mpi_normd_proc = monitor->num_cpus == 0 ? 0.0
-        : (double)(monitor->mpi_time + monitor->mpi_worker_idle_time) / monitor->num_cpus;
-    double min_mpi_normd_node = _process_id != 0 ? 0.0
-        : node_reduction->cpus_node == 0 ? 0.0
+    if (!node_reduction->node_used) return;
+
+    double mpi_normd_node = node_reduction->cpus_node == 0 ? 0.0
         : (double)(node_reduction->mpi_time + node_reduction->mpi_worker_idle_time)
                     / node_reduction->cpus_node;
-
-    /* The number of GPUs and their times need to be aggregated by node, since
-     * devices can be shared among processes in the node. */
-    int num_gpus = 0;
-    int64_t gpu_useful_time = 0;
-    int64_t gpu_communication_time = 0;
-    if (_process_id == 0 && node_reduction->node_used) {
-        num_gpus = node_reduction->num_gpu_ids;
-        for (int i = 0; i < num_gpus; ++i) {
-            gpu_useful_time += node_reduction->gpu_useful[i];
-            gpu_communication_time += node_reduction->gpu_communication[i];
-        }
+    base_metrics->min_mpi_normd_node =
+        min_double_non_zero(base_metrics->min_mpi_normd_node, mpi_normd_node);
+
+    base_metrics->num_available_cpus += node_reduction->num_available_cpus;
+    base_metrics->num_nodes += 1;
+    base_metrics->num_gpus += node_reduction->num_gpu_ids;
+    for (int i = 0; i < node_reduction->num_gpu_ids; ++i) {
+        base_metrics->gpu_useful_time += node_reduction->gpu_useful[i];
+        base_metrics->gpu_communication_time += node_reduction->gpu_communication[i];
     }
+}
 
-    const pop_base_metrics_t app_reduction_send = {
+/* Initialize the app reduction data of a monitor in this process, given the
+ * variance of its sampled MPI time and the result of its node reduction. The
+ * node metrics are only added by the node root, and not at all if
+ * node_reduction is NULL */
+static void init_app_reduction_send(pop_base_metrics_t *app_reduction_send,
+        const node_reduction_t *node_reduction, const dlb_monitor_t *monitor,
+        double mpi_time_variance) {
+
+    double min_mpi_normd_proc = monitor->num_cpus == 0 ? 0.0
+        : (double)(monitor->mpi_time + monitor->mpi_worker_idle_time) / monitor->num_cpus;
+
+    *app_reduction_send = (const pop_base_metrics_t) {
         /* Resources */
         .num_cpus                = monitor->num_cpus,
-        .num_available_cpus      = _process_id == 0 && node_reduction->node_used
-                                    ? mu_get_system_count() : 0,
         .num_omp_threads         = monitor->num_omp_threads,
         .num_mpi_ranks           = 1,
-        .num_nodes               = _process_id == 0 && node_reduction->node_used ? 1 : 0,
         .avg_cpus                = monitor->avg_cpus,
-        .num_gpus                = num_gpus,
         /* Hardware Counters */
         .cycles                  = (double)monitor->cycles,
         .instructions            = (double)monitor->instructions,
@@ -534,68 +701,58 @@ static void reduce_pop_metrics_app_reduction(pop_base_metrics_t *base_metrics,
         .gpu_runtime_time        = monitor->gpu_runtime_time,
         /* Host Normalized Times */
         .min_mpi_normd_proc      = min_mpi_normd_proc,
-        .min_mpi_normd_node      = min_mpi_normd_node,
         /* Device Times */
-        .gpu_useful_time         = gpu_useful_time,
-        .gpu_communication_time  = gpu_communication_time,
         .gpu_inactive_time       = monitor->gpu_inactive_time,
         /* Device Max Times */
         .max_gpu_useful_time     = monitor->gpu_useful_time,
         .max_gpu_active_time     = monitor->gpu_useful_time + monitor->gpu_communication_time,
     };
+    set_mpi_time_variances(app_reduction_send, monitor, mpi_time_variance);
 
-    /* MPI type: int64_t */
-    MPI_Datatype mpi_int64_type = get_mpi_int64_type();
-
-    /* MPI struct type: app_reduction_t */
-    MPI_Datatype mpi_app_reduction_type;
-    {
-
-        int blocklengths[] = {
-            #define FIELD_BLOCKLENGTH(name, c_type, mpi_type) 1,
-            FOR_POP_BASE_METRICS_FIELDS(FIELD_BLOCKLENGTH)
-            #undef FIELD_BLOCKLENGTH
-        };
-
-        MPI_Aint displacements[] = {
-            #define FIELD_DISPLACEMENT(name, c_type, mpi_type) offsetof(pop_base_metrics_t, name),
-            FOR_POP_BASE_METRICS_FIELDS(FIELD_DISPLACEMENT)
-            #undef FIELD_DISPLACEMENT
-        };
+    if (node_reduction != NULL && _process_id == 0) {
+        add_node_reduction(app_reduction_send, node_reduction);
+    }
+}
 
-        MPI_Datatype types[] = {
-            #define FIELD_MPI_TYPE(name, c_type, mpi_type) mpi_type,
-            FOR_POP_BASE_METRICS_FIELDS(FIELD_MPI_TYPE)
-            #undef FIELD_MPI_TYPE
-        };
+/* Function to perform the reduction at application level of nmonitors monitors */
+static void reduce_pop_metrics_app_reduction(pop_base_metrics_t *base_metrics,
+        const node_reduction_t *node_reductions, const dlb_monitor_t *const *monitors,
+        int nmonitors, bool all_to_all) {
 
-        enum {count = sizeof(blocklengths) / sizeof(blocklengths[0])};
+    pop_base_metrics_t *app_reductions_send = malloc(nmonitors * sizeof(pop_base_metrics_t));
+    fatal_cond(app_reductions_send == NULL, "Could not allocate TALP app reduction");
 
-        MPI_Datatype tmp_type;
-        PMPI_Type_create_struct(count, blocklengths, displacements, types, &tmp_type);
-        PMPI_Type_create_resized(tmp_type, 0, sizeof(pop_base_metrics_t),
-                &mpi_app_reduction_type);
-        PMPI_Type_commit(&mpi_app_reduction_type);
+    for (int m = 0; m < nmonitors; ++m) {
+        const monitor_data_t *monitor_data = monitors[m]->_data;
+        init_app_reduction_send(&app_reductions_send[m], &node_reductions[m], monitors[m],
+                monitor_data->sampling.mpi_time_variance);
     }
 
-    /* Define MPI operation */
-    MPI_Op app_reduction_op;
-    PMPI_Op_create(mpi_reduction_fn, true, &app_reduction_op);
-
-    /* MPI reduction */
+    /* MPI reduction of all monitors at once */
+    init_app_reduction_type();
     if (!all_to_all) {
-        PMPI_Reduce(&app_reduction_send, base_metrics, 1,
+        PMPI_Reduce(app_reductions_send, base_metrics, nmonitors,
                 mpi_app_reduction_type, app_reduction_op,
                 0, getWorldComm());
     } else {
-        PMPI_Allreduce(&app_reduction_send, base_metrics, 1,
+        PMPI_Allreduce(app_reductions_send, base_metrics, nmonitors,
                 mpi_app_reduction_type, app_reduction_op,
                 getWorldComm());
     }
+    free(app_reductions_send);
+}
 
-    /* Free MPI types */
-    PMPI_Type_free(&mpi_app_reduction_type);
-    PMPI_Op_free(&app_reduction_op);
+/* Free the cached MPI types and operations */
+void perf_metrics__finalize_mpi(void) {
+    perf_metrics__complete_requests();
+    if (mpi_node_reduction_type != MPI_DATATYPE_NULL) {
+        PMPI_Type_free(&mpi_node_reduction_type);
+        PMPI_Op_free(&node_reduction_op);
+    }
+    if (mpi_app_reduction_type != MPI_DATATYPE_NULL) {
+        PMPI_Type_free(&mpi_app_reduction_type);
+        PMPI_Op_free(&app_reduction_op);
+    }
 }
 
 #endif
@@ -607,15 +764,129 @@ static void reduce_pop_metrics_app_reduction(pop_base_metrics_t *base_metrics,
 void perf_metrics__reduce_monitor_into_base_metrics(pop_base_metrics_t *base_metrics,
         const dlb_monitor_t *monitor, bool all_to_all) {
 
+    perf_metrics__reduce_monitors_into_base_metrics(base_metrics, &monitor, 1, all_to_all);
+}
+
+/* Construct an array of base metrics out of an array of monitors reduced via
+ * MPI, with a single reduction for all of them */
+void perf_metrics__reduce_monitors_into_base_metrics(pop_base_metrics_t *base_metrics,
+        const dlb_monitor_t *const *monitors, int nmonitors, bool all_to_all) {
+
+    if (nmonitors <= 0) return;
+
     /* First, reduce some values among processes in the node,
      * needed to compute pop metrics */
-    node_reduction_t node_reduction = {0};
-    reduce_pop_metrics_node_reduction(&node_reduction, monitor);
+    node_reduction_t *node_reductions = calloc(nmonitors, sizeof(node_reduction_t));
+    fatal_cond(node_reductions == NULL, "Could not allocate TALP node reduction");
+    reduce_pop_metrics_node_reduction(node_reductions, monitors, nmonitors);
 
     /* With the node reduction, reduce again among all process */
-    *base_metrics = (pop_base_metrics_t){0};
-    reduce_pop_metrics_app_reduction(base_metrics, &node_reduction,
-            monitor, all_to_all);
+    memset(base_metrics, 0, nmonitors * sizeof(pop_base_metrics_t));
+    reduce_pop_metrics_app_reduction(base_metrics, node_reductions,
+            monitors, nmonitors, all_to_all);
+
+    free(node_reductions);
+}
+
+/* Non-blocking reduction of a monitor. The node reduction of a blocking
+ * reduction is needed to compute the app reduction, so here the node metrics
+ * are reduced among all processes instead, each node into its own slot, at the
+ * same time as the rest of the metrics. The node metrics are added to the base
+ * metrics when both reductions complete */
+struct perf_metrics_request_t {
+    MPI_Request mpi_requests[2];
+    bool completed;
+    pop_base_metrics_t app_reduction_send;
+    pop_base_metrics_t base_metrics;
+    struct perf_metrics_request_t *next;
+    node_reduction_t node_reductions[];     /* _num_nodes send and receive slots */
+};
+
+/* Requests not yet completed, to complete them at finalization */
+static perf_metrics_request_t *pending_requests = NULL;
+
+perf_metrics_request_t* perf_metrics__ireduce_monitor_into_base_metrics(
+        const dlb_monitor_t *monitor) {
+
+    perf_metrics_request_t *request = calloc(1, sizeof(perf_metrics_request_t)
+            + 2 * _num_nodes * sizeof(node_reduction_t));
+    fatal_cond(request == NULL, "Could not allocate TALP reduction request");
+
+    /* Only the local snapshot of the monitor is taken synchronously. The slots
+     * of the other nodes are not used */
+    node_reduction_t *node_reductions_send = request->node_reductions;
+    node_reduction_t *node_reductions_recv = &request->node_reductions[_num_nodes];
+    init_node_reduction_send(&node_reductions_send[_node_id], monitor);
+    const monitor_data_t *monitor_data = monitor->_data;
+    init_app_reduction_send(&request->app_reduction_send, NULL, monitor,
+            monitor_data->sampling.mpi_time_variance);
+
+    /* Both collectives are started here, so that completing the request never
+     * depends on other processes testing theirs */
+    init_node_reduction_type();
+    init_app_reduction_type();
+    PMPI_Iallreduce(node_reductions_send, node_reductions_recv, _num_nodes,
+            mpi_node_reduction_type, node_reduction_op,
+            getWorldComm(), &request->mpi_requests[0]);
+    PMPI_Iallreduce(&request->app_reduction_send, &request->base_metrics, 1,
+            mpi_app_reduction_type, app_reduction_op,
+            getWorldComm(), &request->mpi_requests[1]);
+
+    request->next = pending_requests;
+    pending_requests = request;
+
+    return request;
+}
+
+/* Add the node metrics of a request whose reductions have completed */
+static void finish_request(perf_metrics_request_t *request) {
+    node_reduction_t *node_reductions_recv = &request->node_reductions[_num_nodes];
+    for (int node = 0; node < _num_nodes; ++node) {
+        check_node_reduction_cpus(&node_reductions_recv[node]);
+        add_node_reduction(&request->base_metrics, &node_reductions_recv[node]);
+    }
+    request->completed = true;
+}
+
+static void remove_pending_request(const perf_metrics_request_t *request) {
+    for (perf_metrics_request_t **it = &pending_requests; *it != NULL; it = &(*it)->next) {
+        if (*it == request) {
+            *it = request->next;
+            return;
+        }
+    }
+}
+
+bool perf_metrics__test_reduce_monitor(perf_metrics_request_t *request,
+        pop_base_metrics_t *base_metrics, bool wait) {
+
+    if (!request->completed) {
+        int flag = 1;
+        if (wait) {
+            PMPI_Waitall(2, request->mpi_requests, MPI_STATUSES_IGNORE);
+        } else {
+            PMPI_Testall(2, request->mpi_requests, &flag, MPI_STATUSES_IGNORE);
+        }
+        if (!flag) return false;
+        finish_request(request);
+        remove_pending_request(request);
+    }
+
+    *base_metrics = request->base_metrics;
+    free(request);
+    return true;
+}
+
+/* Complete all pending requests. Completed requests are kept until they are
+ * tested, but they no longer need MPI */
+void perf_metrics__complete_requests(void) {
+
+    for (perf_metrics_request_t *request = pending_requests;
+            request != NULL; request = request->next) {
+        PMPI_Waitall(2, request->mpi_requests, MPI_STATUSES_IGNORE);
+        finish_request(request);
+    }
+    pending_requests = NULL;
 }
 #endif
 
@@ -667,6 +938,75 @@ void perf_metrics__local_monitor_into_base_metrics(pop_base_metrics_t *base_metr
         .max_gpu_useful_time     = monitor->gpu_useful_time,
         .max_gpu_active_time     = monitor->gpu_useful_time + monitor->gpu_communication_time,
     };
+    const monitor_data_t *monitor_data = monitor->_data;
+    set_mpi_time_variances(base_metrics, monitor, monitor_data->sampling.mpi_time_variance);
+}
+
+/* Construct the node base metrics out of the metrics published in the TALP
+ * shared memory by each process in the node, without any MPI communication */
+void perf_metrics__shmem_metrics_into_base_metrics(pop_base_metrics_t *base_metrics,
+        const shmem_talp_metrics_t *metrics_list, int nelems) {
+
+    *base_metrics = (const pop_base_metrics_t) {};
+
+    int64_t node_mpi_time = 0;
+    int cpus_node = 0;
+    for (int i = 0; i < nelems; ++i) {
+        const shmem_talp_metrics_t *metrics = &metrics_list[i];
+        if (metrics->num_measurements == 0) continue;
+
+        double mpi_normd_proc = metrics->num_cpus == 0 ? 0.0
+            : (double)(metrics->mpi_time + metrics->mpi_worker_idle_time) / metrics->num_cpus;
+
+        pop_base_metrics_t process_metrics = {
+            .num_cpus                = metrics->num_cpus,
+            .num_omp_threads         = metrics->num_omp_threads,
+            .num_mpi_ranks           = metrics->num_mpi_ranks,
+            .avg_cpus                = metrics->avg_cpus,
+            .num_gpus                = metrics->num_gpus,
+            .cycles                  = (double)metrics->cycles,
+            .instructions            = (double)metrics->instructions,
+            .num_measurements        = metrics->num_measurements,
+            .num_mpi_calls           = metrics->num_mpi_calls,
+            .num_omp_parallels       = metrics->num_omp_parallels,
+            .num_omp_tasks           = metrics->num_omp_tasks,
+            .num_gpu_runtime_calls   = metrics->num_gpu_runtime_calls,
+            .elapsed_time            = metrics->elapsed_time,
+            .useful_time             = metrics->useful_time,
+            .mpi_time                = metrics->mpi_time,
+            .mpi_worker_idle_time    = metrics->mpi_worker_idle_time,
+            .omp_load_imbalance_time = metrics->omp_load_imbalance_time,
+            .omp_scheduling_time     = metrics->omp_scheduling_time,
+            .omp_serialization_time  = metrics->omp_serialization_time,
+            .gpu_runtime_time        = metrics->gpu_runtime_time,
+            .min_mpi_normd_proc      = mpi_normd_proc,
+            .gpu_useful_time         = metrics->gpu_useful_time,
+            .gpu_communication_time  = metrics->gpu_communication_time,
+            .gpu_inactive_time       = metrics->gpu_inactive_time,
+            .max_gpu_useful_time     = metrics->gpu_useful_time,
+            .max_gpu_active_time     = metrics->gpu_useful_time
+                                        + metrics->gpu_communication_time,
+        };
+        reduce_base_metrics(base_metrics, &process_metrics);
+
+        node_mpi_time += metrics->mpi_time + metrics->mpi_worker_idle_time;
+        cpus_node += metrics->num_cpus;
+    }
+
+    if (base_metrics->num_measurements == 0) return;
+
+    /* Same node values as in the MPI node reduction */
+    int system_count = mu_get_system_count();
+    if (cpus_node > system_count) {
+        verbose(VB_TALP, "Warning: Number of CPUs in the node (%d) is greater"
+                " than the node CPU count (%d). Reverting value.",
+                cpus_node, system_count);
+        cpus_node = system_count;
+    }
+    base_metrics->num_nodes = 1;
+    base_metrics->num_available_cpus = system_count;
+    base_metrics->min_mpi_normd_node = cpus_node == 0 ? 0.0
+        : (double)node_mpi_time / cpus_node;
 }
 
 /* Compute POP metrics out of a base metrics struct */
@@ -736,3 +1076,17 @@ void perf_metrics__base_to_pop_metrics(const char *monitor_name,
     };
     snprintf(pop_metrics->name, DLB_MONITOR_NAME_MAX, "%s", monitor_name);
 }
+
+/* Compute the confidence intervals of the POP metrics out of a base metrics
+ * struct. They are 0 if the times have not been estimated by sampling */
+void perf_metrics__base_to_pop_metrics_ci(const pop_base_metrics_t *base_metrics,
+        pop_metrics_ci_t *ci) {
+
+    *ci = (const pop_metrics_ci_t) {};
+
+    if (base_metrics->useful_time > 0 && base_metrics->elapsed_time > 0
+            && base_metrics->mpi_time_variance > 0.0) {
+        perf_metrics__compute_hybrid_model_ci(ci, base_metrics,
+                thread_spd->options.talp_model);
+    }
+}
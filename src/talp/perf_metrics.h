@@ -20,6 +20,7 @@
 #ifndef PERF_METRICS_H
 #define PERF_METRICS_H
 
+#include "LB_comm/shmem_talp.h"
 #include "talp/talp_types.h"
 #include <stdbool.h>
 #include <stdint.h>
@@ -55,12 +56,43 @@ void perf_metrics__infer_mpi_model(
 #if MPI_LIB
 void perf_metrics__reduce_monitor_into_base_metrics(pop_base_metrics_t *base_metrics,
         const dlb_monitor_t *monitor, bool all_to_all);
+
+/* Same as above for nmonitors monitors with a single reduction. The MPI
+ * datatypes and operations are created once and cached until finalize */
+void perf_metrics__reduce_monitors_into_base_metrics(pop_base_metrics_t *base_metrics,
+        const dlb_monitor_t *const *monitors, int nmonitors, bool all_to_all);
+
+void perf_metrics__finalize_mpi(void);
+
+/* Start a non-blocking reduction of a monitor among all processes. Only the
+ * local snapshot of the monitor is taken, and all the collectives are started,
+ * in this call */
+typedef struct perf_metrics_request_t perf_metrics_request_t;
+perf_metrics_request_t* perf_metrics__ireduce_monitor_into_base_metrics(
+        const dlb_monitor_t *monitor);
+
+/* Test a non-blocking reduction, or wait for it if wait is true. Return true,
+ * fill base_metrics and free the request if the reduction is complete */
+bool perf_metrics__test_reduce_monitor(perf_metrics_request_t *request,
+        pop_base_metrics_t *base_metrics, bool wait);
+
+/* Complete all pending non-blocking reductions before MPI is finalized.
+ * Completed requests are still freed when tested */
+void perf_metrics__complete_requests(void);
 #endif
 
 void perf_metrics__local_monitor_into_base_metrics(pop_base_metrics_t *base_metrics,
         const dlb_monitor_t *monitor, talp_flags_t talp_flags);
 
+/* Node reduction of the metrics published in shmem by each process. Devices
+ * shared among processes are counted once per process */
+void perf_metrics__shmem_metrics_into_base_metrics(pop_base_metrics_t *base_metrics,
+        const shmem_talp_metrics_t *metrics_list, int nelems);
+
 void perf_metrics__base_to_pop_metrics(const char *monitor_name,
         const pop_base_metrics_t *base_metrics, dlb_pop_metrics_t *pop_metrics);
 
+void perf_metrics__base_to_pop_metrics_ci(const pop_base_metrics_t *base_metrics,
+        pop_metrics_ci_t *ci);
+
 #endif /* PERF_METRICS_H */
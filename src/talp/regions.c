@@ -28,15 +28,19 @@
 #include "LB_core/thread_ctx.h"
 #include "apis/dlb_errors.h"
 #include "apis/dlb_talp.h"
+#include "support/atomic.h"
 #include "support/debug.h"
 #include "support/gtree.h"
+#include "support/hash_table.h"
 #include "support/mask_utils.h"
 #include "support/tracing.h"
 #include "talp/sample.h"
 #include "talp/talp.h"
 #include "talp/talp_output.h"
+#include "talp/talp_timeseries.h"
 #include "talp/talp_types.h"
 
+#include <math.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -53,7 +57,27 @@ typedef struct {
     int             cpuid;      /* single CPU that participates in this region */
 } local_region_entry_t;
 
-__thread GSList *local_regions = NULL;
+/* Stack of open thread-local regions, the innermost one is on top. The buffer
+ * only grows, so that starting and stopping regions does not allocate memory */
+typedef struct {
+    local_region_entry_t    *entries;
+    int                     size;
+    int                     capacity;
+} local_region_stack_t;
+
+enum { LOCAL_REGIONS_INITIAL_CAPACITY = 8 };
+
+static __thread local_region_stack_t local_regions = {};
+
+static local_region_entry_t* local_regions_find(const dlb_monitor_t *monitor) {
+    /* Regions are usually stopped in reverse order, search from the top */
+    for (int i = local_regions.size - 1; i >= 0; --i) {
+        if (local_regions.entries[i].monitor == monitor) {
+            return &local_regions.entries[i];
+        }
+    }
+    return NULL;
+}
 
 static int region_start_thread(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor) {
 
@@ -72,19 +96,28 @@ static int region_start_thread(const subprocess_descriptor_t *spd, dlb_monitor_t
 
     const talp_sample_t *sample = talp_sample_get(spd->talp_info);
 
+    if (local_regions.size == local_regions.capacity) {
+        int capacity = local_regions.capacity > 0
+            ? local_regions.capacity * 2 : LOCAL_REGIONS_INITIAL_CAPACITY;
+        void *p = realloc(local_regions.entries, capacity * sizeof(local_region_entry_t));
+        if (p == NULL) return DLB_ERR_NOMEM;
+        local_regions.entries = p;
+        local_regions.capacity = capacity;
+    }
+
     /* For thread-local regions we can't modify the sample, we just keep a snapshot */
-    local_region_entry_t *entry = malloc(sizeof(local_region_entry_t));
+    local_region_entry_t *entry = &local_regions.entries[local_regions.size++];
     *entry = (local_region_entry_t) {
         .monitor  = monitor,
         .snapshot = {
             .timers   = sample->timers,
             .counters = sample->counters,
             .stats    = sample->stats,
+            .sampling = sample->sampling,
         },
         .cpuid = sched_getcpu(),
     };
-
-    local_regions = g_slist_prepend(local_regions, entry);
+    memcpy(entry->snapshot.mpi_calls, sample->mpi_calls, sizeof(sample->mpi_calls));
 
     return DLB_SUCCESS;
 }
@@ -93,25 +126,17 @@ static int region_stop_thread(const subprocess_descriptor_t *spd, dlb_monitor_t
 
     local_region_entry_t *entry = NULL;
 
-    /* Get region entry if monitor is a special value */
     if (monitor == DLB_LAST_OPEN_REGION) {
-        if (local_regions != NULL) {
-            entry = local_regions->data;
+        /* Get region entry if monitor is a special value */
+        if (local_regions.size > 0) {
+            entry = &local_regions.entries[local_regions.size - 1];
             monitor = entry->monitor;
         } else {
             return DLB_ERR_NOENT;
         }
-    }
-
-    /* Get region entry if monitor is an actual pointer */
-    for (GSList *node = local_regions;
-            node != NULL && entry == NULL;
-            node = node->next) {
-
-        local_region_entry_t *e = node->data;
-        if (e->monitor == monitor) {
-            entry = e;
-        }
+    } else {
+        /* Get region entry if monitor is an actual pointer */
+        entry = local_regions_find(monitor);
     }
 
     if (entry == NULL) return DLB_NOUPDT;
@@ -137,8 +162,12 @@ static int region_stop_thread(const subprocess_descriptor_t *spd, dlb_monitor_t
     /* Aggregate delta to region */
     talp_aggregate_sample_to_region(talp_info, monitor, &delta, elapsed);
 
-    local_regions = g_slist_remove(local_regions, entry);
-    free(entry);
+    /* Remove entry, keeping the order of the rest of the stack */
+    local_region_entry_t *top = &local_regions.entries[local_regions.size - 1];
+    if (entry != top) {
+        memmove(entry, entry + 1, (top - entry) * sizeof(local_region_entry_t));
+    }
+    --local_regions.size;
 
     return DLB_SUCCESS;
 }
@@ -163,6 +192,88 @@ static int get_new_anonymous_id(void) {
     return DLB_ATOMIC_ADD_FETCH_RLX(&id, 1);
 }
 
+
+/*********************************************************************************/
+/*    Lookup of regions by name                                                  */
+/*********************************************************************************/
+
+/* Lookups do not lock, while insertions and removals are serialized with the
+ * regions_mutex. Tables are deallocated when TALP is finalized. */
+
+static unsigned int hash_region_name(const char *name) {
+    /* Only the characters that are compared in region names */
+    return hash_table_hash_string(name, DLB_MONITOR_NAME_MAX-1);
+}
+
+static unsigned int hash_region(const void *monitor) {
+    return hash_region_name(((const dlb_monitor_t*)monitor)->name);
+}
+
+static bool region_has_name(const void *monitor, const void *name) {
+    return region_compare_by_name(((const dlb_monitor_t*)monitor)->name, name) == 0;
+}
+
+/* Insert region, the caller must hold the regions_mutex */
+static void region_insert(talp_info_t *talp_info, dlb_monitor_t *monitor) {
+
+    g_tree_insert(talp_info->regions, (gpointer)monitor->name, monitor);
+    hash_table_insert(&talp_info->regions_hash, monitor, hash_region);
+}
+
+/* Find region by name, lock-free */
+static dlb_monitor_t* region_lookup(talp_info_t *talp_info, const char *name) {
+    return hash_table_lookup(&talp_info->regions_hash, hash_region_name(name),
+            region_has_name, name);
+}
+
+void region_hash_destroy(talp_info_t *talp_info) {
+    hash_table_destroy(&talp_info->regions_hash);
+}
+
+
+/*********************************************************************************/
+/*    Stack of open regions                                                      */
+/*********************************************************************************/
+
+/* The caller must hold the regions_mutex */
+static void open_regions_push(talp_info_t *talp_info, dlb_monitor_t *monitor) {
+    region_stack_t *stack = &talp_info->open_regions;
+    if (stack->size == stack->capacity) {
+        int capacity = stack->capacity > 0 ? stack->capacity * 2 : 8;
+        dlb_monitor_t **monitors = realloc(stack->monitors, capacity * sizeof(dlb_monitor_t*));
+        fatal_cond(!monitors, "Could not allocate TALP open regions."
+                " Please report at "PACKAGE_BUGREPORT);
+        stack->monitors = monitors;
+        stack->capacity = capacity;
+    }
+    stack->monitors[stack->size++] = monitor;
+}
+
+/* The caller must hold the regions_mutex.
+ * If flush is false, deferred updates of this region are discarded */
+static void open_regions_remove(talp_info_t *talp_info, const dlb_monitor_t *monitor,
+        bool flush) {
+    region_stack_t *stack = &talp_info->open_regions;
+
+    /* Regions are usually stopped in reverse order, search from the top */
+    for (int i = stack->size - 1; i >= 0; --i) {
+        if (stack->monitors[i] == monitor) {
+            /* Flush deferred updates while the nesting is still known */
+            talp_lazy_region_stop(talp_info, i, flush);
+            memmove(&stack->monitors[i], &stack->monitors[i+1],
+                    (stack->size - i - 1) * sizeof(dlb_monitor_t*));
+            --stack->size;
+            return;
+        }
+    }
+}
+
+void region_free_open_regions(talp_info_t *talp_info) {
+    free(talp_info->open_regions.monitors);
+    talp_info->open_regions = (const region_stack_t) {};
+}
+
+
 /* Return true if the region is to be enabled.
  * region_select format:
  *  --talp-region-select=[(include|exclude):]<region-list>
@@ -281,8 +392,12 @@ void region_dealloc(void *data) {
 
     dlb_monitor_t *monitor = data;
 
-    /* Free private data */
+    /* Free private data, including the names before any rename */
     monitor_data_t *monitor_data = monitor->_data;
+    for (GSList *node = monitor_data->retired_names; node != NULL; node = node->next) {
+        free(node->data);
+    }
+    g_slist_free(monitor_data->retired_names);
     free(monitor_data);
     monitor_data = NULL;
 
@@ -321,12 +436,7 @@ dlb_monitor_t* region_register(const subprocess_descriptor_t *spd, const char* n
 
     /* Found monitor if already registered */
     if (!anonymous_region) {
-        pthread_mutex_lock(&talp_info->regions_mutex);
-        {
-            monitor = g_tree_lookup(talp_info->regions, name);
-        }
-        pthread_mutex_unlock(&talp_info->regions_mutex);
-
+        monitor = region_lookup(talp_info, name);
         if (monitor != NULL) {
             return monitor;
         }
@@ -354,13 +464,22 @@ dlb_monitor_t* region_register(const subprocess_descriptor_t *spd, const char* n
     region_initialize(monitor, get_new_monitor_id(), name,
             spd->id, avg_cpus, spd->options.talp_region_select, have_shmem);
 
-    /* Finally, insert */
+    /* Finally, insert, unless another thread has registered the same name */
+    dlb_monitor_t *existing_monitor = NULL;
     pthread_mutex_lock(&talp_info->regions_mutex);
     {
-        g_tree_insert(talp_info->regions, (gpointer)monitor->name, monitor);
+        existing_monitor = region_lookup(talp_info, monitor->name);
+        if (existing_monitor == NULL) {
+            region_insert(talp_info, monitor);
+        }
     }
     pthread_mutex_unlock(&talp_info->regions_mutex);
 
+    if (existing_monitor != NULL) {
+        region_dealloc(monitor);
+        return existing_monitor;
+    }
+
     return monitor;
 }
 
@@ -380,7 +499,7 @@ int region_reset(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor) {
         pthread_mutex_lock(&talp_info->regions_mutex);
         {
             monitor_data->flags.started = false;
-            talp_info->open_regions = g_slist_remove(talp_info->open_regions, monitor);
+            open_regions_remove(talp_info, monitor, false);
         }
         pthread_mutex_unlock(&talp_info->regions_mutex);
 
@@ -394,6 +513,8 @@ int region_reset(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor) {
         .num_resets = monitor->num_resets + 1,
         ._data = monitor->_data,
     };
+    monitor_data->sampling = (const sampling_stats_t){};
+    memset(monitor_data->mpi_calls, 0, sizeof(monitor_data->mpi_calls));
 
     return DLB_SUCCESS;
 }
@@ -427,8 +548,10 @@ int region_start(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor) {
         /* Update this sample first */
         talp_sample_update(talp_info);
 
-        /* Gather samples from all threads and update regions */
-        talp_aggregate_samples_to_regions(talp_info);
+        /* Gather samples from all threads and update regions, deferring the
+         * update of open regions if lazy. If lazy and the other threads are
+         * idle, only this sample is gathered */
+        talp_aggregate_samples_deferred(talp_info);
 
         verbose(VB_TALP, "Starting region %s", monitor->name);
         instrument_event(MONITOR_REGION, monitor_data->id, EVENT_BEGIN);
@@ -441,10 +564,16 @@ int region_start(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor) {
         pthread_mutex_lock(&talp_info->regions_mutex);
         {
             monitor_data->flags.started = true;
-            talp_info->open_regions = g_slist_prepend(talp_info->open_regions, monitor);
+            talp_lazy_region_start(talp_info, monitor);
+            open_regions_push(talp_info, monitor);
         }
         pthread_mutex_unlock(&talp_info->regions_mutex);
 
+        /* Append the time series if its period has finished */
+        if (talp_info->flags.timeseries && thread_is_main_sequential()) {
+            talp_timeseries_poll(spd);
+        }
+
         error = DLB_SUCCESS;
     } else {
         error = DLB_NOUPDT;
@@ -472,8 +601,9 @@ int region_stop(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor) {
     }
 
     if (monitor == DLB_LAST_OPEN_REGION) {
-        if (talp_info->open_regions != NULL) {
-            monitor = talp_info->open_regions->data;
+        region_stack_t *open_regions = &talp_info->open_regions;
+        if (open_regions->size > 0) {
+            monitor = open_regions->monitors[open_regions->size - 1];
         } else {
             return DLB_ERR_NOENT;
         }
@@ -487,8 +617,10 @@ int region_stop(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor) {
         /* Update this sample first */
         talp_sample_update(talp_info);
 
-        /* Gather samples from all threads and update regions */
-        talp_aggregate_samples_to_regions(talp_info);
+        /* Gather samples from all threads and update regions, deferring the
+         * update of open regions if lazy. If lazy and the other threads are
+         * idle, only this sample is gathered */
+        talp_aggregate_samples_deferred(talp_info);
 
         /* Stop timer */
         talp_sample_t *thread_sample = talp_sample_get(talp_info);
@@ -499,12 +631,23 @@ int region_stop(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor) {
         pthread_mutex_lock(&talp_info->regions_mutex);
         {
             monitor_data->flags.started = false;
-            talp_info->open_regions = g_slist_remove(talp_info->open_regions, monitor);
+            open_regions_remove(talp_info, monitor, true);
         }
         pthread_mutex_unlock(&talp_info->regions_mutex);
 
+        /* Publish the completed measurement */
+        if (talp_info->flags.external_profiler) {
+            talp_publish_region_metrics(talp_info, monitor);
+        }
+
         verbose(VB_TALP, "Stopping region %s", monitor->name);
         instrument_event(MONITOR_REGION, monitor_data->id, EVENT_END);
+
+        /* Append the time series if its period has finished */
+        if (talp_info->flags.timeseries && thread_is_main_sequential()) {
+            talp_timeseries_poll(spd);
+        }
+
         error = DLB_SUCCESS;
     } else {
         error = DLB_NOUPDT;
@@ -513,10 +656,59 @@ int region_stop(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor) {
     return error;
 }
 
+/* Rename a registered region. The name is only updated in this process, so
+ * it should be done before the regions are gathered or published.
+ * The new name is published with an atomic pointer swap, and the previous
+ * name is kept until the region is deallocated, since lock-free lookups or
+ * users of the region may still be reading it. */
+int region_rename(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor,
+        const char *name) {
+
+    talp_info_t *talp_info = spd->talp_info;
+    int error;
+
+    char *new_name = malloc(DLB_MONITOR_NAME_MAX*sizeof(char));
+    snprintf(new_name, DLB_MONITOR_NAME_MAX, "%s", name);
+
+    pthread_mutex_lock(&talp_info->regions_mutex);
+    {
+        if (monitor == talp_info->monitor
+                || region_lookup(talp_info, new_name) != NULL) {
+            error = DLB_NOUPDT;
+        } else {
+            /* The name is the key of the tree and of the lookup table */
+            char *old_name = (char*)monitor->name;
+            g_tree_steal(talp_info->regions, old_name);
+            hash_table_remove(&talp_info->regions_hash, monitor,
+                    hash_region_name(old_name));
+            DLB_ATOMIC_ST_REL((_Atomic(const char*)*)&monitor->name, new_name);
+            region_insert(talp_info, monitor);
+
+            monitor_data_t *monitor_data = monitor->_data;
+            monitor_data->retired_names =
+                g_slist_prepend(monitor_data->retired_names, old_name);
+            new_name = NULL;
+            error = DLB_SUCCESS;
+        }
+    }
+    pthread_mutex_unlock(&talp_info->regions_mutex);
+
+    free(new_name);
+
+    return error;
+}
+
 bool region_is_started(const dlb_monitor_t *monitor) {
     return ((monitor_data_t*)monitor->_data)->flags.started;
 }
 
+/* 95% confidence interval of the MPI time estimated by statistical sampling,
+ * or 0 if it was measured exactly */
+int64_t region_get_mpi_time_ci(const dlb_monitor_t *monitor) {
+    const monitor_data_t *monitor_data = monitor->_data;
+    return 1.96 * sqrt(monitor_data->sampling.mpi_time_variance);
+}
+
 void region_set_internal(struct dlb_monitor_t *monitor, bool internal) {
     ((monitor_data_t*)monitor->_data)->flags.internal = internal;
 }
@@ -530,6 +722,13 @@ int region_report(const subprocess_descriptor_t *spd, const dlb_monitor_t *monit
         return DLB_NOUPDT;
     }
 
+    /* Bring an open region up to date before printing it */
+    if (((monitor_data_t*)monitor->_data)->flags.started
+            && !thread_is_parallel()) {
+        talp_sample_update(talp_info);
+        talp_aggregate_samples_to_regions(talp_info);
+    }
+
     talp_output_print_monitoring_region(monitor, talp_info->flags);
 
     return DLB_SUCCESS;
@@ -21,9 +21,11 @@
 #define REGIONS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef struct dlb_monitor_t dlb_monitor_t;
 typedef struct SubProcessDescriptor subprocess_descriptor_t;
+typedef struct talp_info_t talp_info_t;
 
 /* Global region getters */
 struct dlb_monitor_t* region_get_global(const subprocess_descriptor_t *spd);
@@ -33,13 +35,20 @@ const char* region_get_global_name(void);
 int  region_compare_by_name(const void *a, const void *b);
 void region_dealloc(void *data);
 
+/* Deallocation of the lookup table and the stack of open regions */
+void region_hash_destroy(talp_info_t *talp_info);
+void region_free_open_regions(talp_info_t *talp_info);
+
 /* Region functions */
 dlb_monitor_t*
      region_register(const subprocess_descriptor_t *spd, const char* name);
 int  region_reset(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor);
 int  region_start(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor);
 int  region_stop(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor);
+int  region_rename(const subprocess_descriptor_t *spd, dlb_monitor_t *monitor,
+        const char *name);
 bool region_is_started(const dlb_monitor_t *monitor);
+int64_t region_get_mpi_time_ci(const dlb_monitor_t *monitor);
 void region_set_internal(struct dlb_monitor_t *monitor, bool internal);
 int  region_report(const subprocess_descriptor_t *spd, const dlb_monitor_t *monitor);
 
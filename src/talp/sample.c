@@ -20,6 +20,7 @@
 #include "talp/sample.h"
 
 #include "LB_core/thread_ctx.h"
+#include "apis/dlb_errors.h"
 #include "support/debug.h"
 #include "support/dlb_common.h"
 #include "support/mytime.h"
@@ -28,8 +29,11 @@
 #include "talp/talp_hwc.h"
 
 #include <pthread.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 
 static __thread talp_sample_t* _tls_sample = NULL;
@@ -39,6 +43,10 @@ static inline void record_cpuid(talp_sample_t *sample);
 static inline void set_state(const talp_info_t *talp_info,
         talp_sample_t *sample, talp_sample_state_t new_state);
 
+static int sampling_init(void);
+static void sampling_finalize(talp_info_t *talp_info);
+static void sampling_timer_start(const talp_info_t *talp_info, talp_sample_t *sample);
+
 
 /*********************************************************************************/
 /*    Init / Finalize                                                            */
@@ -46,9 +54,13 @@ static inline void set_state(const talp_info_t *talp_info,
 
 void talp_sample_init(talp_info_t *talp_info) {
 
-    talp_info->sample_registry = (sample_registry_t){
-        .mutex = PTHREAD_MUTEX_INITIALIZER,
-    };
+    talp_info->sample_registry = (const sample_registry_t){};
+
+    if (talp_info->flags.sampling && sampling_init() != DLB_SUCCESS) {
+        warning("TALP: could not install the sampling signal handler,"
+                " disabling the sampling mode");
+        talp_info->flags.sampling = false;
+    }
 }
 
 void talp_sample_finalize(talp_info_t *talp_info) {
@@ -63,19 +75,90 @@ void talp_sample_finalize(talp_info_t *talp_info) {
      * TLS variable would be broken if TALP is reinitialized again.
      * For now we will keep it like this and will revisit if needed. */
 
+    /* Stop sampling timers before deallocating any sample */
+    if (talp_info->flags.sampling) {
+        sampling_finalize(talp_info);
+    }
+
     /* Deallocate main thread sample */
     free(_tls_sample);
     _tls_sample = NULL;
 
-    /* Deallocate samples list */
+    /* Deallocate samples list
+     * (no other thread may access the registry at this point) */
     sample_registry_t *registry = &talp_info->sample_registry;
-    pthread_mutex_lock(&registry->mutex);
-    {
-        free(registry->samples);
-        registry->samples = NULL;
-        registry->num_samples = 0;
+    for (int c = 0; c < MAX_SAMPLE_CHUNKS; ++c) {
+        free((void*)registry->chunks[c]);
     }
-    pthread_mutex_unlock(&registry->mutex);
+    *registry = (const sample_registry_t){};
+}
+
+
+/*********************************************************************************/
+/*    Sample registry                                                            */
+/*********************************************************************************/
+
+/* Chunk and offset of a registry index: chunk c starts at index
+ * SAMPLE_CHUNK_SIZE * (2^c - 1) */
+static inline void registry_index_to_slot(int index, int *chunk, int *offset) {
+    unsigned int n = (unsigned int)index / SAMPLE_CHUNK_SIZE + 1;
+    int c = (int)(sizeof(unsigned int) * 8) - 1 - __builtin_clz(n);
+    *chunk = c;
+    *offset = index - SAMPLE_CHUNK_SIZE * ((1 << c) - 1);
+}
+
+/* Return the slots of a chunk, allocating them if needed */
+static _Atomic(talp_sample_t*)* registry_get_chunk(sample_registry_t *registry, int c) {
+
+    _Atomic(talp_sample_t*) *chunk = DLB_ATOMIC_LD_ACQ(&registry->chunks[c]);
+    if (chunk == NULL) {
+        /* Several threads may try to allocate the same chunk, only one wins */
+        _Atomic(talp_sample_t*) *new_chunk =
+            calloc((size_t)SAMPLE_CHUNK_SIZE << c, sizeof(talp_sample_t*));
+        fatal_cond(new_chunk == NULL, "TALP: could not allocate thread sample");
+        for (;;) {
+            _Atomic(talp_sample_t*) *expected = NULL;
+            if (DLB_ATOMIC_CMP_EXCH_WEAK(&registry->chunks[c], expected, new_chunk)) {
+                return new_chunk;
+            }
+            chunk = DLB_ATOMIC_LD_ACQ(&registry->chunks[c]);
+            if (chunk != NULL) {
+                free((void*)new_chunk);
+                return chunk;
+            }
+        }
+    }
+    return chunk;
+}
+
+/* Append a sample to the registry without locking */
+static void registry_add(sample_registry_t *registry, talp_sample_t *sample) {
+
+    int index = DLB_ATOMIC_ADD_RLX(&registry->num_reserved, 1);
+    int c, offset;
+    registry_index_to_slot(index, &c, &offset);
+    fatal_cond(c >= MAX_SAMPLE_CHUNKS, "TALP: too many thread samples");
+
+    _Atomic(talp_sample_t*) *chunk = registry_get_chunk(registry, c);
+    DLB_ATOMIC_ST_REL(&chunk[offset], sample);
+    DLB_ATOMIC_ADD(&registry->num_samples, 1);
+}
+
+/* Return the sample at index, or NULL if not (yet) published */
+static talp_sample_t* registry_get(sample_registry_t *registry, int index) {
+
+    int c, offset;
+    registry_index_to_slot(index, &c, &offset);
+    _Atomic(talp_sample_t*) *chunk = DLB_ATOMIC_LD_ACQ(&registry->chunks[c]);
+    return chunk != NULL ? DLB_ATOMIC_LD_ACQ(&chunk[offset]) : NULL;
+}
+
+talp_sample_t* talp_sample_registry_get(talp_info_t *talp_info, int index) {
+
+    sample_registry_t *registry = &talp_info->sample_registry;
+    if (index < 0 || index >= DLB_ATOMIC_LD_ACQ(&registry->num_reserved)) return NULL;
+
+    return registry_get(registry, index);
 }
 
 
@@ -93,43 +176,42 @@ talp_sample_t* talp_sample_get(talp_info_t *talp_info) {
     if (unlikely(!thread_is_profiled())) return NULL;
 
     /* Otherwise, allocate */
-    sample_registry_t *registry = &talp_info->sample_registry;
-    pthread_mutex_lock(&registry->mutex);
-    {
-        int num_samples = ++registry->num_samples;
-        void *samples = realloc(registry->samples, sizeof(talp_sample_t*)*num_samples);
-        if (samples) {
-            void *new_sample = NULL;
-            if (posix_memalign(&new_sample, DLB_CACHE_LINE, sizeof(talp_sample_t)) == 0) {
-                _tls_sample = new_sample;
-                *_tls_sample = (talp_sample_t){0};
-                registry->samples = samples;
-                registry->samples[num_samples-1] = new_sample;
-            } else {
-                // error
-                free(new_sample);
-                _tls_sample = NULL;
-            }
-        }
+    void *new_sample = NULL;
+    if (posix_memalign(&new_sample, DLB_CACHE_LINE, sizeof(talp_sample_t)) != 0) {
+        new_sample = NULL;
     }
-    pthread_mutex_unlock(&registry->mutex);
-
-    fatal_cond(_tls_sample == NULL, "TALP: could not allocate thread sample");
+    fatal_cond(new_sample == NULL, "TALP: could not allocate thread sample");
+    _tls_sample = new_sample;
+    *_tls_sample = (talp_sample_t){0};
 
     /* If a thread is created mid-region, its initial time is that of the
      * innermost open region, otherwise it is the current time */
-    int64_t last_updated_ts;
-    if (talp_info->open_regions) {
-        const dlb_monitor_t *innermost_monitor = talp_info->open_regions->data;
-        last_updated_ts = innermost_monitor->start_time;
-    } else {
-        last_updated_ts = get_time_in_ns();
+    int64_t last_updated_ts = 0;
+    pthread_mutex_lock(&talp_info->regions_mutex);
+    {
+        const region_stack_t *open_regions = &talp_info->open_regions;
+        if (open_regions->size > 0) {
+            const dlb_monitor_t *innermost_monitor =
+                open_regions->monitors[open_regions->size - 1];
+            last_updated_ts = innermost_monitor->start_time;
+        }
+    }
+    pthread_mutex_unlock(&talp_info->regions_mutex);
+    if (last_updated_ts == 0) {
+        last_updated_ts = get_fast_time_in_ns();
     }
 
     _tls_sample->last_updated_ts = last_updated_ts;
 
     set_state(talp_info, _tls_sample, TALP_STATE_DISABLED);
 
+    if (talp_info->flags.sampling) {
+        sampling_timer_start(talp_info, _tls_sample);
+    }
+
+    /* Publish the sample once initialized */
+    registry_add(&talp_info->sample_registry, _tls_sample);
+
 #ifdef INSTRUMENTATION_VERSION
     unsigned events[] = {MONITOR_CYCLES, MONITOR_INSTR};
     long long hwc_values[] = {0, 0};
@@ -144,10 +226,101 @@ static inline void reset_sample(talp_sample_t *sample) {
     memset(&sample->timers,   0, sizeof(sample->timers));
     memset(&sample->counters, 0, sizeof(sample->counters));
     memset(&sample->stats,    0, sizeof(sample->stats));
+    memset(&sample->sampling, 0, sizeof(sample->sampling));
+    memset(&sample->mpi_calls, 0, sizeof(sample->mpi_calls));
+    for (int state = 0; state < TALP_NUM_STATES; ++state) {
+        DLB_ATOMIC_ST_RLX(&sample->pending_ticks[state], 0);
+    }
     CPU_ZERO(&sample->cpu_mask);
     record_cpuid(sample);
 }
 
+/* Whether the calling thread's sample is estimated by statistical sampling,
+ * i.e., whether state changes can skip the sample update */
+bool talp_sample_is_sampled(talp_info_t *talp_info) {
+    talp_sample_t *sample = talp_sample_get(talp_info);
+    return sample != NULL && sample->sampled;
+}
+
+
+/*********************************************************************************/
+/*    Statistical sampling                                                       */
+/*********************************************************************************/
+
+/* Older glibc versions do not define this field name */
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+static struct sigaction old_sigprof_action;
+
+/* Count the state of the interrupted thread. It only increments a lock-free
+ * atomic of the thread's own sample, so it is async-signal-safe. */
+static void sampling_handler(int signum, siginfo_t *info, void *context) {
+    talp_sample_t *sample = _tls_sample;
+    if (sample != NULL) {
+        DLB_ATOMIC_ADD_RLX(&sample->pending_ticks[sample->state], 1);
+    }
+}
+
+static int sampling_init(void) {
+    struct sigaction action = {
+        .sa_sigaction = sampling_handler,
+        .sa_flags = SA_SIGINFO | SA_RESTART,
+    };
+    sigemptyset(&action.sa_mask);
+    return sigaction(SIGPROF, &action, &old_sigprof_action) == 0
+        ? DLB_SUCCESS : DLB_ERR_UNKNOWN;
+}
+
+static void sampling_finalize(talp_info_t *talp_info) {
+
+    /* Timers are per-process, delete the timer of each thread */
+    sample_registry_t *registry = &talp_info->sample_registry;
+    int num_reserved = DLB_ATOMIC_LD_ACQ(&registry->num_reserved);
+    for (int i = 0; i < num_reserved; ++i) {
+        talp_sample_t *sample = registry_get(registry, i);
+        if (sample != NULL && sample->sampled) {
+            timer_delete(sample->sampling_timer);
+            sample->sampled = false;
+        }
+    }
+
+    /* A signal may still be pending: ignoring it discards it, then the
+     * previous action is restored as it was */
+    struct sigaction ignore_action = { .sa_handler = SIG_IGN };
+    sigemptyset(&ignore_action.sa_mask);
+    sigaction(SIGPROF, &ignore_action, NULL);
+    sigaction(SIGPROF, &old_sigprof_action, NULL);
+}
+
+/* Arm a periodic timer that sends SIGPROF to the calling thread */
+static void sampling_timer_start(const talp_info_t *talp_info, talp_sample_t *sample) {
+
+    struct sigevent sev = {
+        .sigev_notify = SIGEV_THREAD_ID,
+        .sigev_signo = SIGPROF,
+    };
+    sev.sigev_notify_thread_id = syscall(SYS_gettid);
+    if (timer_create(CLOCK_MONOTONIC, &sev, &sample->sampling_timer) != 0) {
+        warning("TALP: could not create the sampling timer of thread %ld,"
+                " its state changes will be measured", (long)sev.sigev_notify_thread_id);
+        return;
+    }
+
+    struct timespec period = {
+        .tv_sec = talp_info->sampling_period / 1000000000LL,
+        .tv_nsec = talp_info->sampling_period % 1000000000LL,
+    };
+    struct itimerspec spec = { .it_interval = period, .it_value = period };
+    if (timer_settime(sample->sampling_timer, 0, &spec, NULL) != 0) {
+        timer_delete(sample->sampling_timer);
+        return;
+    }
+
+    sample->sampled = true;
+}
+
 
 /*********************************************************************************/
 /*    Sample update                                                              */
@@ -161,6 +334,73 @@ static inline void ensure_generation(talp_sample_t *sample, int64_t current_gene
     }
 }
 
+/* Add a duration to the timer of a state */
+static inline void add_state_time(const talp_info_t *restrict talp_info,
+        talp_sample_t *restrict sample, talp_sample_state_t state, int64_t duration) {
+
+    switch(state) {
+        case TALP_STATE_DISABLED:
+            break;
+        case TALP_STATE_USEFUL:
+            sample->timers.useful += duration;
+            break;
+        case TALP_STATE_NOT_USEFUL_MPI:
+            sample->timers.not_useful_mpi += duration;
+            if (thread_is_main_sequential()
+                    && talp_info->flags.have_openmp) {
+                // Add unused CPUs' time to special timer
+                int num_unused_cpus = talp_info->num_cpus - 1;
+                sample->timers.not_useful_omp_during_mpi
+                    += duration * num_unused_cpus;
+            }
+            break;
+        case TALP_STATE_NOT_USEFUL_OMP_IN:
+            sample->timers.not_useful_omp_in += duration;
+            break;
+        case TALP_STATE_NOT_USEFUL_OMP_OUT:
+            sample->timers.not_useful_omp_out += duration;
+            break;
+        case TALP_STATE_NOT_USEFUL_GPU:
+            sample->timers.not_useful_gpu += duration;
+            break;
+    }
+}
+
+/* Split a duration among the states observed by the sampling timer since the
+ * last update. The current state counts as one more observation, so that the
+ * split is exact if the state has not changed. The time of each state is a
+ * binomial estimate, keep the variance of the MPI time. */
+static inline void add_sampled_time(const talp_info_t *restrict talp_info,
+        talp_sample_t *restrict sample, int64_t duration) {
+
+    int64_t ticks[TALP_NUM_STATES];
+    int64_t num_ticks = 0;
+    for (int state = 0; state < TALP_NUM_STATES; ++state) {
+        ticks[state] = DLB_ATOMIC_EXCH_RLX(&sample->pending_ticks[state], 0);
+        num_ticks += ticks[state];
+    }
+    sample->sampling.num_ticks += num_ticks;
+
+    talp_sample_state_t current_state = sample->state;
+    ++ticks[current_state];
+    ++num_ticks;
+
+    /* The current state gets the rounding error */
+    int64_t remaining = duration;
+    for (int state = 0; state < TALP_NUM_STATES; ++state) {
+        if (state != (int)current_state && ticks[state] > 0) {
+            int64_t share = (int64_t)((double)duration * ticks[state] / num_ticks);
+            add_state_time(talp_info, sample, (talp_sample_state_t)state, share);
+            remaining -= share;
+        }
+    }
+    add_state_time(talp_info, sample, current_state, remaining);
+
+    double p = (double)ticks[TALP_STATE_NOT_USEFUL_MPI] / num_ticks;
+    sample->sampling.mpi_time_variance +=
+        (double)duration * duration * p * (1.0 - p) / num_ticks;
+}
+
 /* Compute new microsample (time since last update) and update sample values */
 void talp_sample_update(talp_info_t *talp_info) {
 
@@ -175,48 +415,33 @@ void talp_sample_update(talp_info_t *talp_info) {
     /* Generation helps us to identify whether this sample belongs to the
      * current generation (i.e., region has yet to be updated) or if we need to
      * reset it */
+    talp_sample_write_begin(sample);
     ensure_generation(sample, current_generation);
 
     /* Compute duration and set new last_updated_ts */
-    int64_t now = get_time_in_ns();
+    int64_t now = get_fast_time_in_ns();
     int64_t microsample_duration = now - sample->last_updated_ts;
     sample->last_updated_ts = now;
 
-    /* Update the appropriate sample timer */
-    switch(sample->state) {
-        case TALP_STATE_DISABLED:
-            break;
-        case TALP_STATE_USEFUL:
-            sample->timers.useful += microsample_duration;
-            break;
-        case TALP_STATE_NOT_USEFUL_MPI:
-            sample->timers.not_useful_mpi += microsample_duration;
-            if (thread_is_main_sequential()
-                    && talp_info->flags.have_openmp) {
-                // Add unused CPUs' time to special timer
-                int num_unused_cpus = talp_info->num_cpus - 1;
-                sample->timers.not_useful_omp_during_mpi
-                    += microsample_duration * num_unused_cpus;
-            }
-            break;
-        case TALP_STATE_NOT_USEFUL_OMP_IN:
-            sample->timers.not_useful_omp_in += microsample_duration;
-            break;
-        case TALP_STATE_NOT_USEFUL_OMP_OUT:
-            sample->timers.not_useful_omp_out += microsample_duration;
-            break;
-        case TALP_STATE_NOT_USEFUL_GPU:
-            sample->timers.not_useful_gpu += microsample_duration;
-            break;
+    /* Update the appropriate sample timers */
+    if (sample->sampled) {
+        add_sampled_time(talp_info, sample, microsample_duration);
+    } else {
+        add_state_time(talp_info, sample, sample->state, microsample_duration);
     }
 
-    if (talp_info->flags.have_hwc) {
-        hw_counters_t measurements = {0};
+    hw_counters_t measurements = {0};
+    bool have_hwc = talp_info->flags.have_hwc;
+    if (have_hwc) {
         if (talp_hwc_collect(&measurements)) {
             sample->counters.cycles       += measurements.cycles;
             sample->counters.instructions += measurements.instructions;
         }
+    }
+
+    talp_sample_write_end(sample);
 
+    if (have_hwc) {
 #ifdef INSTRUMENTATION_VERSION
         // We want to emit even if talp_hwc_collect returned false,
         // that's why measurements is init'd to 0 above.
@@ -234,7 +459,9 @@ static inline void record_cpuid(talp_sample_t *sample) {
 
 void talp_sample_record_cpuid(talp_info_t *talp_info) {
     talp_sample_t *sample = talp_sample_get(talp_info);
+    talp_sample_write_begin(sample);
     record_cpuid(sample);
+    talp_sample_write_end(sample);
 }
 
 static inline void set_state(const talp_info_t *restrict talp_info,
@@ -245,7 +472,9 @@ static inline void set_state(const talp_info_t *restrict talp_info,
         talp_hwc_on_state_change(old, new_state);
     }
 
+    talp_sample_write_begin(sample);
     sample->state = new_state;
+    talp_sample_write_end(sample);
 
     instrument_event(MONITOR_STATE,
             new_state == TALP_STATE_DISABLED ? MONITOR_STATE_DISABLED
@@ -270,7 +499,7 @@ void talp_sample_set_state(talp_info_t *talp_info, talp_sample_state_t new_state
 /*********************************************************************************/
 
 talp_sample_t talp_sample_delta(const talp_sample_t *end, const talp_sample_t *start) {
-    return (talp_sample_t) {
+    talp_sample_t delta = {
         .timers = {
             .useful                    = end->timers.useful
                                         - start->timers.useful,
@@ -299,7 +528,20 @@ talp_sample_t talp_sample_delta(const talp_sample_t *end, const talp_sample_t *s
             .num_omp_tasks          = end->stats.num_omp_tasks         - start->stats.num_omp_tasks,
             .num_gpu_runtime_calls  = end->stats.num_gpu_runtime_calls - start->stats.num_gpu_runtime_calls,
         },
+        .sampling = {
+            .num_ticks          = end->sampling.num_ticks - start->sampling.num_ticks,
+            .mpi_time_variance  = end->sampling.mpi_time_variance
+                                    - start->sampling.mpi_time_variance,
+        },
     };
+    for (int i = 0; i < MPI_NUM_CALL_SLOTS; ++i) {
+        delta.mpi_calls[i] = (const mpi_call_stats_t) {
+            .num_calls = end->mpi_calls[i].num_calls - start->mpi_calls[i].num_calls,
+            .time      = end->mpi_calls[i].time      - start->mpi_calls[i].time,
+            .bytes     = end->mpi_calls[i].bytes     - start->mpi_calls[i].bytes,
+        };
+    }
+    return delta;
 }
 
 
@@ -328,75 +570,122 @@ static inline void aggregate_sample_to_macrosample(const talp_sample_t *restrict
     macrosample->stats.num_omp_tasks              += sample->stats.num_omp_tasks;
     macrosample->stats.num_gpu_runtime_calls      += sample->stats.num_gpu_runtime_calls;
 
+    /* Sampling */
+    macrosample->sampling.num_ticks               += sample->sampling.num_ticks;
+    macrosample->sampling.mpi_time_variance       += sample->sampling.mpi_time_variance;
+
+    /* MPI calls */
+    for (int i = 0; i < MPI_NUM_CALL_SLOTS; ++i) {
+        macrosample->mpi_calls[i].num_calls       += sample->mpi_calls[i].num_calls;
+        macrosample->mpi_calls[i].time            += sample->mpi_calls[i].time;
+        macrosample->mpi_calls[i].bytes           += sample->mpi_calls[i].bytes;
+    }
+
     /* CPU mask */
     CPU_OR(&macrosample->cpu_mask, &macrosample->cpu_mask, &sample->cpu_mask);
 }
 
 
+/* Copy the fields of a sample needed for aggregation. If the owner thread is
+ * modifying it, retry until a consistent copy is obtained. */
+static inline void read_sample(const talp_sample_t *restrict sample,
+        talp_sample_t *restrict copy) {
+
+    unsigned int seq_begin;
+    do {
+        seq_begin = seqlock_read_begin(&sample->seq);
+        copy->timers        = sample->timers;
+        copy->counters      = sample->counters;
+        copy->stats         = sample->stats;
+        copy->sampling      = sample->sampling;
+        memcpy(copy->mpi_calls, sample->mpi_calls, sizeof(copy->mpi_calls));
+        copy->state         = sample->state;
+        copy->generation_ts = sample->generation_ts;
+        copy->cpu_mask      = sample->cpu_mask;
+    } while (seqlock_read_retry(&sample->seq, seq_begin));
+}
+
 /* Aggregate all samples. Don't update any. */
 void talp_sample_aggregate_all_to_macrosample(
         talp_info_t *restrict talp_info, talp_macrosample_t *restrict macrosample) {
 
     /* Warning: observer threads can call this function although is prone to
      * produce some race conditions while reading samples. Still, we cannot
-     * assume samples[0] is our sample */
+     * assume the first sample is ours */
     talp_sample_t *my_sample = talp_sample_get(talp_info);
 
     /* If this function is called by the main thread (expected),
      * re-use the timestamp that was just set updating the sample. */
     int64_t now = my_sample != NULL
         ? my_sample->last_updated_ts
-        : get_time_in_ns();
+        : get_fast_time_in_ns();
 
     sample_registry_t *registry = &talp_info->sample_registry;
     int64_t current_generation_ts = DLB_ATOMIC_LD_RLX(&registry->current_generation_ts);
     int64_t generation_duration = now - current_generation_ts;
 
-    /* Accumulate samples from all threads */
-    pthread_mutex_lock(&registry->mutex);
-    {
-        int num_samples = registry->num_samples;
-        macrosample->num_samples = num_samples;
-
-        /* Aggregate samples */
-        for (int i = 0; i < num_samples; ++i) {
-            const talp_sample_t *sample = registry->samples[i];
-
-            if (sample == my_sample) {
-                /* Our sample is just aggregated because we know it's updated */
-                aggregate_sample_to_macrosample(sample, macrosample);
-                continue;
-            }
-
-            /* Note: By contract, we only aggregate samples in sequential code.
-             * So at this point, we only look for threads that are probably
-             * stopped after a parallel region.
-             * Since implicit-task-end event is not reliable, we use the
-             * last_parallel_end_ts set by the primary to compute the missing
-             * not-useful-omp-out here */
-
-            if (likely(sample->state == TALP_STATE_NOT_USEFUL_OMP_IN
-                        || sample->state == TALP_STATE_NOT_USEFUL_OMP_OUT)) {
+    /* Accumulate samples from all threads. Samples that are being registered
+     * concurrently may be skipped, they will be aggregated the next time */
+    int num_reserved = DLB_ATOMIC_LD_ACQ(&registry->num_reserved);
+    int num_samples = 0;
+    bool quiescent = my_sample != NULL && thread_is_main_sequential();
+    int num_idle = 0;
+    cpu_set_t idle_cpu_mask;
+    CPU_ZERO(&idle_cpu_mask);
+    talp_sample_t copy;
+    for (int i = 0; i < num_reserved; ++i) {
+        const talp_sample_t *sample = registry_get(registry, i);
+        if (sample == NULL) {
+            quiescent = false;
+            continue;
+        }
+        ++num_samples;
 
-                int64_t last_parallel_end_ts = DLB_ATOMIC_LD_RLX(&sample->last_parallel_end_ts);
-                macrosample->timers.not_useful_omp_out += min_int64(
-                        generation_duration,
-                        now - last_parallel_end_ts);
-            }
+        if (sample == my_sample) {
+            /* Our sample is just aggregated because we know it's updated */
+            aggregate_sample_to_macrosample(sample, macrosample);
+            continue;
+        }
 
-            if (sample->generation_ts < current_generation_ts) {
-                /* Sample not updated in the current generation.
-                 * Skip aggregation of any other timer, but still account for the CPU.*/
+        /* Note: By contract, we only aggregate samples in sequential code.
+         * So at this point, we only look for threads that are probably
+         * stopped after a parallel region.
+         * Since implicit-task-end event is not reliable, we use the
+         * last_parallel_end_ts set by the primary to compute the missing
+         * not-useful-omp-out here */
+
+        read_sample(sample, &copy);
+
+        if (likely(copy.state == TALP_STATE_NOT_USEFUL_OMP_IN
+                    || copy.state == TALP_STATE_NOT_USEFUL_OMP_OUT)) {
+
+            int64_t last_parallel_end_ts = DLB_ATOMIC_LD_RLX(&sample->last_parallel_end_ts);
+            macrosample->timers.not_useful_omp_out += min_int64(
+                    generation_duration,
+                    now - last_parallel_end_ts);
+            ++num_idle;
+        } else if (copy.state != TALP_STATE_DISABLED) {
+            quiescent = false;
+        }
+        CPU_OR(&idle_cpu_mask, &idle_cpu_mask, &copy.cpu_mask);
 
-                CPU_OR(&macrosample->cpu_mask, &macrosample->cpu_mask, &sample->cpu_mask);
-                continue;
-            }
+        if (copy.generation_ts < current_generation_ts) {
+            /* Sample not updated in the current generation.
+             * Skip aggregation of any other timer, but still account for the CPU.*/
 
-            /* Aggregate the values computed by the thread */
-            aggregate_sample_to_macrosample(sample, macrosample);
+            CPU_OR(&macrosample->cpu_mask, &macrosample->cpu_mask, &copy.cpu_mask);
+            continue;
         }
+
+        /* Aggregate the values computed by the thread */
+        aggregate_sample_to_macrosample(&copy, macrosample);
     }
-    pthread_mutex_unlock(&registry->mutex);
+    macrosample->num_samples = num_samples;
+
+    registry->quiescent.valid = quiescent;
+    registry->quiescent.num_samples = num_samples;
+    registry->quiescent.num_idle = num_idle;
+    registry->quiescent.cpu_mask = idle_cpu_mask;
 
     /* Start generation for the next sample aggregation */
     DLB_ATOMIC_ST_RLX(&registry->current_generation_ts, now);
@@ -404,7 +693,51 @@ void talp_sample_aggregate_all_to_macrosample(
     /* If this function is called by the main thread (expected),
      * reset sample and set the new generation time-stamp. */
     if (my_sample != NULL) {
+        talp_sample_write_begin(my_sample);
         reset_sample(my_sample);
         my_sample->generation_ts = now;
+        talp_sample_write_end(my_sample);
+    }
+}
+
+/* Aggregate only the sample of the calling thread, if the other threads have
+ * not run since the last aggregation of all samples: no new thread, and no
+ * parallel region started by the calling thread. Their contribution is then
+ * the time they have been idle, and the resulting macrosample is the same as
+ * the one of talp_sample_aggregate_all_to_macrosample. Otherwise, return false
+ * and do nothing. Only the main thread in sequential code may call it, after
+ * updating its sample. */
+bool talp_sample_aggregate_own_to_macrosample(
+        talp_info_t *restrict talp_info, talp_macrosample_t *restrict macrosample) {
+
+    talp_sample_t *my_sample = talp_sample_get(talp_info);
+    sample_registry_t *registry = &talp_info->sample_registry;
+
+    if (my_sample == NULL
+            || !thread_is_main_sequential()
+            || !registry->quiescent.valid
+            || my_sample->stats.num_omp_parallels > 0
+            || DLB_ATOMIC_LD_RLX(&registry->num_reserved) != registry->quiescent.num_samples) {
+        registry->quiescent.valid = false;
+        return false;
     }
+
+    int64_t now = my_sample->last_updated_ts;
+    int64_t current_generation_ts = DLB_ATOMIC_LD_RLX(&registry->current_generation_ts);
+
+    aggregate_sample_to_macrosample(my_sample, macrosample);
+    macrosample->timers.not_useful_omp_out +=
+        (now - current_generation_ts) * registry->quiescent.num_idle;
+    CPU_OR(&macrosample->cpu_mask, &macrosample->cpu_mask, &registry->quiescent.cpu_mask);
+    macrosample->num_samples = registry->quiescent.num_samples;
+
+    /* The samples of the other threads are left in the previous generation */
+    DLB_ATOMIC_ST_RLX(&registry->current_generation_ts, now);
+
+    talp_sample_write_begin(my_sample);
+    reset_sample(my_sample);
+    my_sample->generation_ts = now;
+    talp_sample_write_end(my_sample);
+
+    return true;
 }
@@ -26,8 +26,21 @@ void talp_sample_init(talp_info_t *talp_info);
 void talp_sample_finalize(talp_info_t *talp_info);
 
 talp_sample_t* talp_sample_get(talp_info_t *talp_info);
+talp_sample_t* talp_sample_registry_get(talp_info_t *talp_info, int index);
+
+/* Only the owner thread modifies its sample, and it must do so between these
+ * two calls so that other threads can read a consistent copy of it. Writers
+ * never wait for readers. Calls cannot be nested. */
+static inline void talp_sample_write_begin(talp_sample_t *sample) {
+    seqlock_write_begin(&sample->seq);
+}
+
+static inline void talp_sample_write_end(talp_sample_t *sample) {
+    seqlock_write_end(&sample->seq);
+}
 
 void talp_sample_update(talp_info_t *talp_info);
+bool talp_sample_is_sampled(talp_info_t *talp_info);
 void talp_sample_record_cpuid(talp_info_t *talp_info);
 void talp_sample_set_state(talp_info_t *talp_info, talp_sample_state_t new_state);
 
@@ -35,5 +48,7 @@ talp_sample_t talp_sample_delta(const talp_sample_t *end, const talp_sample_t *s
 
 void talp_sample_aggregate_all_to_macrosample(
         talp_info_t *restrict talp_info, talp_macrosample_t *restrict macrosample);
+bool talp_sample_aggregate_own_to_macrosample(
+        talp_info_t *restrict talp_info, talp_macrosample_t *restrict macrosample);
 
 #endif /* SAMPLE_H */
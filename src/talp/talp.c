@@ -39,6 +39,7 @@
 #include "support/options.h"
 #include "support/mask_utils.h"
 #include "support/gpu_mask_utils.h"
+#include "talp/auto_regions.h"
 #include "talp/backend.h"
 #include "talp/perf_metrics.h"
 #include "talp/sample.h"
@@ -47,6 +48,7 @@
 #include "talp/talp_hwc.h"
 #include "talp/talp_output.h"
 #include "talp/talp_record.h"
+#include "talp/talp_timeseries.h"
 #include "talp/talp_types.h"
 #ifdef MPI_LIB
 #include "mpi/mpi_core.h"
@@ -109,6 +111,23 @@ void talp_init(subprocess_descriptor_t *spd) {
                 NULL, NULL, region_dealloc),
         .regions_mutex = PTHREAD_MUTEX_INITIALIZER,
     };
+
+    /* Lazy regions are not compatible with live updates to the shared memory */
+    talp_info->flags.lazy_regions = spd->options.talp_lazy_regions
+        && !talp_info->flags.external_profiler;
+
+    /* Breakdown of MPI calls by type */
+    talp_info->flags.mpi_breakdown = spd->options.talp_mpi_breakdown;
+
+    /* Automatic regions */
+    talp_info->flags.openmp_auto_regions = spd->options.talp_openmp_auto_regions;
+    talp_info->flags.mpi_auto_regions = spd->options.talp_mpi_auto_regions;
+
+    /* Statistical sampling mode */
+    if (spd->options.talp_sampling_period > 0) {
+        talp_info->flags.sampling = true;
+        talp_info->sampling_period = spd->options.talp_sampling_period * 1000LL;
+    }
     spd->talp_info = talp_info;
 
     /* Initialize shared memory */
@@ -161,8 +180,19 @@ void talp_init(subprocess_descriptor_t *spd) {
     }
 #endif
 
+    /* Initialize the timer used for sample timestamps */
+    if (spd->options.talp_timer == TALP_TIMER_TSC) {
+        if (fast_time_init() == DLB_SUCCESS) {
+            verbose(VB_TALP, "TALP timer: invariant hardware counter");
+        } else {
+            warning("TALP: the hardware counter is not reliable, falling back to"
+                    " clock_gettime");
+        }
+    }
+
     /* Initialize sample structure */
     talp_sample_init(talp_info);
+    talp_info->next_publish_ts = get_fast_time_in_ns() + TALP_PUBLISH_PERIOD_NS;
 
     /* Create the main thread's sample */
     (void)talp_sample_get(talp_info);
@@ -175,6 +205,11 @@ void talp_init(subprocess_descriptor_t *spd) {
 
     /* Start global region */
     region_start(spd, talp_info->monitor);
+
+    /* Initialize the time series of regions */
+    if (spd->options.talp_timeseries_period > 0) {
+        talp_timeseries_init(spd);
+    }
 }
 
 void talp_finalize(subprocess_descriptor_t *spd) {
@@ -187,11 +222,18 @@ void talp_finalize(subprocess_descriptor_t *spd) {
     /* Stop open regions
      * (Note that region_stop need to acquire the regions_mutex
      * lock, so we we need to iterate without it) */
-    while(talp_info->open_regions != NULL) {
-        dlb_monitor_t *monitor = talp_info->open_regions->data;
+    while(talp_info->open_regions.size > 0) {
+        dlb_monitor_t *monitor =
+            talp_info->open_regions.monitors[talp_info->open_regions.size - 1];
         region_stop(spd, monitor);
     }
 
+    /* Name automatic regions after their functions, if not done yet */
+    auto_regions_symbolize(spd);
+
+    /* Append the last period of the time series */
+    talp_timeseries_finalize(spd);
+
     /* Finalize TALP components */
     if (talp_info->flags.have_gpu) {
         talp_gpu_finalize();
@@ -222,6 +264,7 @@ void talp_finalize(subprocess_descriptor_t *spd) {
 
     /* Deallocate samples structure */
     talp_sample_finalize(talp_info);
+    fast_time_finalize();
 
     /* Finalize shared memory */
     if (talp_info->flags.have_shmem || talp_info->flags.have_minimal_shmem) {
@@ -236,9 +279,10 @@ void talp_finalize(subprocess_descriptor_t *spd) {
         talp_info->regions = NULL;
         talp_info->monitor = NULL;
 
-        /* Destroy list of open regions */
-        g_slist_free(talp_info->open_regions);
-        talp_info->open_regions = NULL;
+        /* Destroy lookup tables and stack of open regions */
+        region_hash_destroy(talp_info);
+        auto_regions_finalize(talp_info);
+        region_free_open_regions(talp_info);
     }
     pthread_mutex_unlock(&talp_info->regions_mutex);
     free(talp_info);
@@ -286,113 +330,292 @@ void talp_aggregate_sample_to_region(talp_info_t *talp_info,
         monitor->num_omp_tasks          += sample->stats.num_omp_tasks;
         monitor->num_gpu_runtime_calls  += sample->stats.num_gpu_runtime_calls;
 
+        /* Sampling */
+        monitor_data->sampling.num_ticks            += sample->sampling.num_ticks;
+        monitor_data->sampling.mpi_time_variance    += sample->sampling.mpi_time_variance;
+
+        /* MPI calls */
+        for (int i = 0; i < MPI_NUM_CALL_SLOTS; ++i) {
+            monitor_data->mpi_calls[i].num_calls    += sample->mpi_calls[i].num_calls;
+            monitor_data->mpi_calls[i].time         += sample->mpi_calls[i].time;
+            monitor_data->mpi_calls[i].bytes        += sample->mpi_calls[i].bytes;
+        }
+
         monitor->elapsed_time += elapsed;
         ++(monitor->num_measurements);
     }
     pthread_mutex_unlock(&talp_info->regions_mutex);
 }
 
+/* Resources observed in a macrosample */
+static void get_macrosample_resources(const talp_info_t *restrict talp_info,
+        const talp_macrosample_t *restrict macrosample,
+        talp_resources_t *restrict resources) {
+
+    resources->cpu_mask = macrosample->cpu_mask;
+
+    /* Number of CPUs:
+     * - the CPU mask in macrosample may have more CPUs than the actual
+     *   number of threads, e.g.: when OMP_PLACES=cores or when the initial
+     *   thread is bound only after the first parallel region.
+     * -  */
+    resources->num_cpus = min_int(
+            CPU_COUNT(&macrosample->cpu_mask), macrosample->num_samples);
+
+    /* Number of OpenMP threads */
+    resources->num_omp_threads = talp_info->flags.have_openmp
+        ? macrosample->num_samples : 0;
+
+    resources->gpu_mask = macrosample->gpu_mask;
+}
+
+/* Merge resources from src into dst */
+static void merge_resources(talp_resources_t *restrict dst,
+        const talp_resources_t *restrict src) {
+
+    CPU_OR(&dst->cpu_mask, &dst->cpu_mask, &src->cpu_mask);
+    dst->num_cpus = max_int(dst->num_cpus, src->num_cpus);
+    dst->num_omp_threads = max_int(dst->num_omp_threads, src->num_omp_threads);
+    dst->gpu_mask |= src->gpu_mask;
+}
+
+/* Add or subtract the additive values of a macrosample: timers, counters,
+ * stats and GPU timers */
+static void add_macrosample(talp_macrosample_t *restrict dst,
+        const talp_macrosample_t *restrict src, int sign) {
+
+    dst->timers.useful                      += sign * src->timers.useful;
+    dst->timers.not_useful_mpi              += sign * src->timers.not_useful_mpi;
+    dst->timers.not_useful_omp_during_mpi   += sign * src->timers.not_useful_omp_during_mpi;
+    dst->timers.not_useful_omp_in_lb        += sign * src->timers.not_useful_omp_in_lb;
+    dst->timers.not_useful_omp_in_sched     += sign * src->timers.not_useful_omp_in_sched;
+    dst->timers.not_useful_omp_out          += sign * src->timers.not_useful_omp_out;
+    dst->timers.not_useful_gpu              += sign * src->timers.not_useful_gpu;
+
+    dst->counters.cycles                    += sign * src->counters.cycles;
+    dst->counters.instructions              += sign * src->counters.instructions;
+
+    dst->stats.num_mpi_calls                += sign * src->stats.num_mpi_calls;
+    dst->stats.num_omp_parallels            += sign * src->stats.num_omp_parallels;
+    dst->stats.num_omp_tasks                += sign * src->stats.num_omp_tasks;
+    dst->stats.num_gpu_runtime_calls        += sign * src->stats.num_gpu_runtime_calls;
+
+    dst->sampling.num_ticks                 += sign * src->sampling.num_ticks;
+    dst->sampling.mpi_time_variance         += sign * src->sampling.mpi_time_variance;
+
+    for (int i = 0; i < MPI_NUM_CALL_SLOTS; ++i) {
+        dst->mpi_calls[i].num_calls         += sign * src->mpi_calls[i].num_calls;
+        dst->mpi_calls[i].time              += sign * src->mpi_calls[i].time;
+        dst->mpi_calls[i].bytes             += sign * src->mpi_calls[i].bytes;
+    }
+
+    uint64_t mask = src->gpu_mask;
+    while (mask) {
+        int gpu = gm_ctz(mask);
+        dst->gpu_timers[gpu].useful         += sign * src->gpu_timers[gpu].useful;
+        dst->gpu_timers[gpu].communication  += sign * src->gpu_timers[gpu].communication;
+        mask = gm_clear_lsb(mask);
+    }
+    dst->gpu_mask |= src->gpu_mask;
+}
+
+/* Update one region with the observed resources and the additive values of
+ * a macrosample. The caller must hold the regions_mutex */
+static void update_region(talp_info_t *restrict talp_info, dlb_monitor_t *monitor,
+        const talp_resources_t *restrict resources,
+        const talp_macrosample_t *restrict macrosample) {
+
+    monitor_data_t *monitor_data = monitor->_data;
+
+    /* CPU mask */
+    CPU_OR(&monitor_data->cpu_mask, &monitor_data->cpu_mask, &resources->cpu_mask);
+
+    /* Number of CPUs */
+    if (monitor->num_cpus < resources->num_cpus) {
+        monitor->num_cpus = resources->num_cpus;
+    }
+    ensure(monitor->num_cpus > 0, "Updating region with 0 CPUs. Please report.");
+
+    /* Number of OpenMP threads */
+    if (monitor->num_omp_threads < resources->num_omp_threads) {
+        monitor->num_omp_threads = resources->num_omp_threads;
+    }
+
+    /* GPU mask */
+    monitor_data->gpu_mask |= resources->gpu_mask;
+
+    /* Number of GPUs */
+    monitor->num_gpus = gm_count(monitor_data->gpu_mask);
+
+    /* Timers */
+    monitor->useful_time             += macrosample->timers.useful;
+    monitor->mpi_time                += macrosample->timers.not_useful_mpi;
+    monitor->mpi_worker_idle_time    += macrosample->timers.not_useful_omp_during_mpi;
+    monitor->omp_load_imbalance_time += macrosample->timers.not_useful_omp_in_lb;
+    monitor->omp_scheduling_time     += macrosample->timers.not_useful_omp_in_sched;
+    monitor->omp_serialization_time  += macrosample->timers.not_useful_omp_out;
+    monitor->gpu_runtime_time        += macrosample->timers.not_useful_gpu;
+
+    /* Counters */
+    monitor->cycles                  += macrosample->counters.cycles;
+    monitor->instructions            += macrosample->counters.instructions;
+
+    /* Stats */
+    monitor->num_mpi_calls           += macrosample->stats.num_mpi_calls;
+    monitor->num_omp_parallels       += macrosample->stats.num_omp_parallels;
+    monitor->num_omp_tasks           += macrosample->stats.num_omp_tasks;
+    monitor->num_gpu_runtime_calls   += macrosample->stats.num_gpu_runtime_calls;
+
+    /* Sampling */
+    monitor_data->sampling.num_ticks            += macrosample->sampling.num_ticks;
+    monitor_data->sampling.mpi_time_variance    += macrosample->sampling.mpi_time_variance;
+
+    /* MPI calls */
+    for (int i = 0; i < MPI_NUM_CALL_SLOTS; ++i) {
+        monitor_data->mpi_calls[i].num_calls    += macrosample->mpi_calls[i].num_calls;
+        monitor_data->mpi_calls[i].time         += macrosample->mpi_calls[i].time;
+        monitor_data->mpi_calls[i].bytes        += macrosample->mpi_calls[i].bytes;
+    }
+
+    /* GPU Timers */
+    uint64_t mask = macrosample->gpu_mask;
+    while (mask) {
+        int gpu = gm_ctz(mask);
+
+        /* Aggregated into monitor */
+        monitor->gpu_useful_time        += macrosample->gpu_timers[gpu].useful;
+        monitor->gpu_communication_time += macrosample->gpu_timers[gpu].communication;
+
+        /* Also store the data decomposed by device in the private monitor
+         * data for use during the later MPI node reduction. */
+        monitor_data->gpu_timers[gpu].useful        += macrosample->gpu_timers[gpu].useful;
+        monitor_data->gpu_timers[gpu].communication +=
+            macrosample->gpu_timers[gpu].communication;
+
+        mask = gm_clear_lsb(mask);
+    }
+
+    /* Update shared memory only if requested */
+    if (talp_info->flags.external_profiler) {
+        talp_publish_region_metrics(talp_info, monitor);
+    }
+}
+
+/* Lazy regions:
+ * With --talp-lazy-regions, macrosamples are not applied to every open region.
+ * Instead, their additive values are summed into talp_info->accumulated, and
+ * the observed resources are merged into the innermost open region only.
+ * A region at the stack index k is brought up to date by adding the difference
+ * between the accumulated macrosample and the one at its last update, and by
+ * merging the pending resources of the regions k to top, since every
+ * macrosample observed while any of those regions was the innermost one was
+ * also observed by region k. */
+
+/* Bring the open region at stack index k up to date.
+ * The caller must hold the regions_mutex */
+static void lazy_update_region(talp_info_t *talp_info, int k,
+        const talp_resources_t *resources) {
+
+    dlb_monitor_t *monitor = talp_info->open_regions.monitors[k];
+    monitor_data_t *monitor_data = monitor->_data;
+
+    talp_macrosample_t delta = talp_info->accumulated;
+    add_macrosample(&delta, &monitor_data->lazy.base, -1);
+
+    update_region(talp_info, monitor, resources, &delta);
+    monitor_data->lazy.base = talp_info->accumulated;
+}
+
 /* Update all open regions with the macrosample */
 static void update_regions_with_macrosample(talp_info_t *restrict talp_info,
-        const talp_macrosample_t *restrict macrosample) {
+        const talp_macrosample_t *restrict macrosample, bool sync_lazy_regions) {
 
-    bool have_openmp = talp_info->flags.have_openmp;
-    bool external_profiler = talp_info->flags.external_profiler;
+    talp_resources_t resources;
+    get_macrosample_resources(talp_info, macrosample, &resources);
 
-    /* Update all open regions */
     pthread_mutex_lock(&talp_info->regions_mutex);
     {
-        for (GSList *node = talp_info->open_regions;
-                node != NULL;
-                node = node->next) {
-            dlb_monitor_t *monitor = node->data;
-            monitor_data_t *monitor_data = monitor->_data;
-
-            /* CPU mask */
-            CPU_OR(&monitor_data->cpu_mask, &monitor_data->cpu_mask, &macrosample->cpu_mask);
-
-            /* Number of CPUs:
-             * - the CPU mask in macrosample may have more CPUs than the actual
-             *   number of threads, e.g.: when OMP_PLACES=cores or when the initial
-             *   thread is bound only after the first parallel region.
-             * -  */
-            int macrosample_num_cpus = min_int(
-                    CPU_COUNT(&macrosample->cpu_mask), macrosample->num_samples);
-            if (monitor->num_cpus < macrosample_num_cpus) {
-                monitor->num_cpus = macrosample_num_cpus;
-            }
-            ensure(monitor->num_cpus > 0, "Updating region with 0 CPUs. Please report.");
+        region_stack_t *open_regions = &talp_info->open_regions;
 
-            /* Number of OpenMP threads */
-            if (have_openmp) {
-                if (monitor->num_omp_threads < macrosample->num_samples) {
-                    monitor->num_omp_threads = macrosample->num_samples;
-                }
+        if (!talp_info->flags.lazy_regions) {
+            /* Update all open regions */
+            for (int i = 0; i < open_regions->size; ++i) {
+                update_region(talp_info, open_regions->monitors[i],
+                        &resources, macrosample);
             }
-
-            /* GPU mask */
-            monitor_data->gpu_mask |= macrosample->gpu_mask;
-
-            /* Number of GPUs */
-            monitor->num_gpus = gm_count(monitor_data->gpu_mask);
-
-            /* Timers */
-            monitor->useful_time             += macrosample->timers.useful;
-            monitor->mpi_time                += macrosample->timers.not_useful_mpi;
-            monitor->mpi_worker_idle_time    += macrosample->timers.not_useful_omp_during_mpi;
-            monitor->omp_load_imbalance_time += macrosample->timers.not_useful_omp_in_lb;
-            monitor->omp_scheduling_time     += macrosample->timers.not_useful_omp_in_sched;
-            monitor->omp_serialization_time  += macrosample->timers.not_useful_omp_out;
-            monitor->gpu_runtime_time        += macrosample->timers.not_useful_gpu;
-
-            /* Counters */
-            monitor->cycles                  += macrosample->counters.cycles;
-            monitor->instructions            += macrosample->counters.instructions;
-
-            /* Stats */
-            monitor->num_mpi_calls           += macrosample->stats.num_mpi_calls;
-            monitor->num_omp_parallels       += macrosample->stats.num_omp_parallels;
-            monitor->num_omp_tasks           += macrosample->stats.num_omp_tasks;
-            monitor->num_gpu_runtime_calls   += macrosample->stats.num_gpu_runtime_calls;
-
-            /* GPU Timers */
-            uint64_t mask = macrosample->gpu_mask;
-            while (mask) {
-                int gpu = gm_ctz(mask);
-
-                /* Aggregated into monitor */
-                monitor->gpu_useful_time        += macrosample->gpu_timers[gpu].useful;
-                monitor->gpu_communication_time += macrosample->gpu_timers[gpu].communication;
-
-                /* Also store the data decomposed by device in the private monitor
-                 * data for use during the later MPI node reduction. */
-                monitor_data->gpu_timers[gpu].useful        += macrosample->gpu_timers[gpu].useful;
-                monitor_data->gpu_timers[gpu].communication +=
-                    macrosample->gpu_timers[gpu].communication;
-
-                mask = gm_clear_lsb(mask);
+        } else {
+            /* Accumulate macrosample and keep the resources in the innermost
+             * region, if any */
+            add_macrosample(&talp_info->accumulated, macrosample, 1);
+            if (open_regions->size > 0) {
+                monitor_data_t *top_data =
+                    open_regions->monitors[open_regions->size - 1]->_data;
+                merge_resources(&top_data->lazy.resources, &resources);
             }
 
-            /* Update shared memory only if requested */
-            if (external_profiler) {
-                shmem_talp__set_times(monitor_data->node_shared_id,
-                        monitor->mpi_time,
-                        monitor->useful_time);
+            /* Bring all open regions up to date, from the innermost */
+            if (sync_lazy_regions) {
+                talp_resources_t pending = {0};
+                for (int i = open_regions->size - 1; i >= 0; --i) {
+                    monitor_data_t *monitor_data = open_regions->monitors[i]->_data;
+                    merge_resources(&pending, &monitor_data->lazy.resources);
+                    lazy_update_region(talp_info, i, &pending);
+                }
             }
         }
     }
     pthread_mutex_unlock(&talp_info->regions_mutex);
 }
 
+void talp_lazy_region_start(talp_info_t *talp_info, dlb_monitor_t *monitor) {
+
+    if (!talp_info->flags.lazy_regions) return;
+
+    monitor_data_t *monitor_data = monitor->_data;
+    monitor_data->lazy.base = talp_info->accumulated;
+    monitor_data->lazy.resources = (const talp_resources_t) {0};
+}
+
+void talp_lazy_region_stop(talp_info_t *talp_info, int k, bool update) {
+
+    if (!talp_info->flags.lazy_regions) return;
+
+    region_stack_t *open_regions = &talp_info->open_regions;
+
+    if (update) {
+        /* Merge pending resources of this and all inner regions */
+        talp_resources_t pending = {0};
+        for (int i = open_regions->size - 1; i >= k; --i) {
+            monitor_data_t *monitor_data = open_regions->monitors[i]->_data;
+            merge_resources(&pending, &monitor_data->lazy.resources);
+        }
+        lazy_update_region(talp_info, k, &pending);
+    }
+
+    /* The enclosing region inherits the pending resources of this region. The
+     * inner regions keep their own, which will reach it once they stop. */
+    if (k > 0) {
+        monitor_data_t *monitor_data = open_regions->monitors[k]->_data;
+        monitor_data_t *enclosing_data = open_regions->monitors[k-1]->_data;
+        merge_resources(&enclosing_data->lazy.resources, &monitor_data->lazy.resources);
+    }
+}
+
 /* Accumulate values from samples of all threads and update regions */
-int talp_aggregate_samples_to_regions(talp_info_t *talp_info) {
+static int aggregate_samples_to_regions(talp_info_t *talp_info, bool sync_lazy_regions) {
 
     /* Observer and unknown threads can't aggregate samples */
     if (unlikely(!thread_is_profiled())) return DLB_ERR_PERM;
 
-    /* Accumulate samples from all threads */
+    /* Accumulate samples from all threads. Deferred lazy updates only need
+     * the sample of this thread while the others stay idle; they are
+     * aggregated again on the next query, parallel region, or finalize. */
     talp_macrosample_t macrosample = {0};
-    talp_sample_aggregate_all_to_macrosample(talp_info, &macrosample);
+    if (sync_lazy_regions
+            || !talp_info->flags.lazy_regions
+            || !talp_sample_aggregate_own_to_macrosample(talp_info, &macrosample)) {
+        talp_sample_aggregate_all_to_macrosample(talp_info, &macrosample);
+    }
 
     if (talp_info->flags.have_gpu) {
         /* Collect GPU measuremnts up to this point and update macrosample */
@@ -400,11 +623,84 @@ int talp_aggregate_samples_to_regions(talp_info_t *talp_info) {
     }
 
     /* Update all started regions */
-    update_regions_with_macrosample(talp_info, &macrosample);
+    update_regions_with_macrosample(talp_info, &macrosample, sync_lazy_regions);
 
     return DLB_SUCCESS;
 }
 
+int talp_aggregate_samples_to_regions(talp_info_t *talp_info) {
+    return aggregate_samples_to_regions(talp_info, true);
+}
+
+int talp_aggregate_samples_deferred(talp_info_t *talp_info) {
+    return aggregate_samples_to_regions(talp_info, false);
+}
+
+
+/*********************************************************************************/
+/*    TALP shared memory                                                         */
+/*********************************************************************************/
+
+/* Publish the metrics of the global region if they have not been updated for
+ * a publication period, so that they do not depend on regions being started or
+ * stopped, or on MPI. Only the main thread in sequential code may call it. */
+void talp_publish_poll(talp_info_t *talp_info) {
+
+    const monitor_data_t *monitor_data = talp_info->monitor->_data;
+    if (monitor_data->node_shared_id < 0) return;
+
+    int64_t now = get_fast_time_in_ns();
+    if (now < talp_info->next_publish_ts) return;
+    talp_info->next_publish_ts = now + TALP_PUBLISH_PERIOD_NS;
+
+    talp_sample_update(talp_info);
+    talp_aggregate_samples_to_regions(talp_info);
+    talp_publish_region_metrics(talp_info, talp_info->monitor);
+}
+
+/* Publish the base metrics of a region so that node POP metrics can be
+ * computed by any process attached to the shared memory */
+void talp_publish_region_metrics(const talp_info_t *talp_info,
+        const dlb_monitor_t *monitor) {
+
+    const monitor_data_t *monitor_data = monitor->_data;
+
+    /* Account for the measurement in progress, if any */
+    int64_t elapsed_time = monitor->elapsed_time;
+    int64_t num_measurements = monitor->num_measurements;
+    if (monitor_data->flags.started) {
+        elapsed_time += get_fast_time_in_ns() - monitor->start_time;
+        ++num_measurements;
+    }
+
+    shmem_talp__set_metrics(monitor_data->node_shared_id,
+            &(const shmem_talp_metrics_t) {
+                .num_cpus                = monitor->num_cpus,
+                .num_omp_threads         = monitor->num_omp_threads,
+                .num_mpi_ranks           = talp_info->flags.have_mpi ? 1 : 0,
+                .num_gpus                = monitor->num_gpus,
+                .avg_cpus                = monitor->avg_cpus,
+                .cycles                  = monitor->cycles,
+                .instructions            = monitor->instructions,
+                .num_measurements        = num_measurements,
+                .num_mpi_calls           = monitor->num_mpi_calls,
+                .num_omp_parallels       = monitor->num_omp_parallels,
+                .num_omp_tasks           = monitor->num_omp_tasks,
+                .num_gpu_runtime_calls   = monitor->num_gpu_runtime_calls,
+                .elapsed_time            = elapsed_time,
+                .useful_time             = monitor->useful_time,
+                .mpi_time                = monitor->mpi_time,
+                .mpi_worker_idle_time    = monitor->mpi_worker_idle_time,
+                .omp_load_imbalance_time = monitor->omp_load_imbalance_time,
+                .omp_scheduling_time     = monitor->omp_scheduling_time,
+                .omp_serialization_time  = monitor->omp_serialization_time,
+                .gpu_runtime_time        = monitor->gpu_runtime_time,
+                .gpu_useful_time         = monitor->gpu_useful_time,
+                .gpu_communication_time  = monitor->gpu_communication_time,
+                .gpu_inactive_time       = monitor->gpu_inactive_time,
+            });
+}
+
 
 /*********************************************************************************/
 /*    TALP collect functions for 3rd party programs:                             */
@@ -489,6 +785,36 @@ int talp_query_pop_node_metrics(const char *name, dlb_node_metrics_t *node_metri
 }
 
 
+/* Function that may be called from a third-party process to compute the POP
+ * metrics of the processes in the node for a given region. Only the metrics
+ * published in the shared memory are used, no MPI is involved. */
+int talp_query_pop_metrics(const char *name, dlb_pop_metrics_t *pop_metrics) {
+
+    if (name == NULL) {
+        name = region_get_global_name();
+    }
+
+    /* Obtain the published metrics of every process in the node */
+    int max_procs = mu_get_system_size();
+    shmem_talp_metrics_t *metrics_list = malloc(max_procs * sizeof(shmem_talp_metrics_t));
+    int nelems;
+    shmem_talp__get_metricslist(metrics_list, &nelems, max_procs, name);
+
+    /* Node reduction */
+    pop_base_metrics_t base_metrics;
+    perf_metrics__shmem_metrics_into_base_metrics(&base_metrics, metrics_list, nelems);
+    free(metrics_list);
+
+    if (base_metrics.num_measurements == 0) {
+        return DLB_ERR_NOENT;
+    }
+
+    perf_metrics__base_to_pop_metrics(name, &base_metrics, pop_metrics);
+
+    return DLB_SUCCESS;
+}
+
+
 /*********************************************************************************/
 /*    TALP collect functions for 1st party programs                              */
 /*      - Requires synchronization (MPI or node barrier) among all processes     */
@@ -530,6 +856,85 @@ int talp_collect_pop_metrics(const subprocess_descriptor_t *spd,
     return DLB_SUCCESS;
 }
 
+/* Non-blocking version of talp_collect_pop_metrics */
+struct dlb_talp_request_t {
+#ifdef MPI_LIB
+    perf_metrics_request_t *reduction;
+#endif
+    pop_base_metrics_t base_metrics;
+    dlb_pop_metrics_t *pop_metrics;
+    char name[DLB_MONITOR_NAME_MAX];
+};
+
+/* Start the computation of the current POP metrics for the specified monitor.
+ * The monitor is updated synchronously, and pop_metrics is filled when the
+ * request completes. */
+int talp_icollect_pop_metrics(const subprocess_descriptor_t *spd,
+        dlb_monitor_t *monitor, dlb_pop_metrics_t *pop_metrics,
+        dlb_talp_request_t **request) {
+    talp_info_t *talp_info = spd->talp_info;
+    if (monitor == NULL) {
+        monitor = talp_info->monitor;
+    }
+
+    dlb_talp_request_t *new_request = malloc(sizeof(dlb_talp_request_t));
+    if (new_request == NULL) return DLB_ERR_NOMEM;
+    new_request->pop_metrics = pop_metrics;
+    snprintf(new_request->name, DLB_MONITOR_NAME_MAX, "%s", monitor->name);
+
+    /* Stop monitor so that metrics are updated */
+    bool resume_region = region_stop(spd, monitor) == DLB_SUCCESS;
+
+#ifdef MPI_LIB
+    /* Start the reduction of the monitor among all MPI ranks (all-to-all) */
+    new_request->reduction = perf_metrics__ireduce_monitor_into_base_metrics(monitor);
+#else
+    /* Construct base metrics using only the monitor from this process */
+    perf_metrics__local_monitor_into_base_metrics(&new_request->base_metrics,
+            monitor, talp_info->flags);
+#endif
+
+    /* Resume monitor */
+    if (resume_region) {
+        region_start(spd, monitor);
+    }
+
+    *request = new_request;
+
+    return DLB_SUCCESS;
+}
+
+/* Test or wait for the completion of a request. On completion, the POP
+ * metrics are computed and the request is freed and set to NULL */
+int talp_test_request(dlb_talp_request_t **request, bool *completed, bool wait) {
+
+    dlb_talp_request_t *talp_request = *request;
+
+    /* Like MPI, testing a null request completes immediately */
+    if (talp_request == NULL) {
+        *completed = true;
+        return DLB_SUCCESS;
+    }
+
+#ifdef MPI_LIB
+    if (!perf_metrics__test_reduce_monitor(talp_request->reduction,
+                &talp_request->base_metrics, wait)) {
+        *completed = false;
+        return DLB_SUCCESS;
+    }
+#endif
+
+    /* Construct output pop_metrics out of base metrics */
+    perf_metrics__base_to_pop_metrics(talp_request->name, &talp_request->base_metrics,
+            talp_request->pop_metrics);
+
+    free(talp_request);
+    *request = NULL;
+    *completed = true;
+
+    return DLB_SUCCESS;
+}
+
 /* Node-collective function to compute node_metrics for a given region */
 int talp_collect_pop_node_metrics(const subprocess_descriptor_t *spd,
         dlb_monitor_t *monitor, dlb_node_metrics_t *node_metrics) {
@@ -549,9 +954,7 @@ int talp_collect_pop_node_metrics(const subprocess_descriptor_t *spd,
     }
 
     /* Update the shared memory with this process' metrics */
-    shmem_talp__set_times(monitor_data->node_shared_id,
-            monitor->mpi_time,
-            monitor->useful_time);
+    talp_publish_region_metrics(talp_info, monitor);
 
     /* Perform a node barrier to ensure everyone has updated their metrics */
     node_barrier(spd, NULL);
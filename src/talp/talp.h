@@ -41,10 +41,25 @@ void talp_finalize(subprocess_descriptor_t *spd);
 void talp_aggregate_sample_to_region(talp_info_t *talp_info,
         dlb_monitor_t *monitor, const talp_sample_t *sample, int64_t elapsed);
 int talp_aggregate_samples_to_regions(talp_info_t *talp_info);
+int talp_aggregate_samples_deferred(talp_info_t *talp_info);
+
+
+/* Lazy regions, the caller must hold the regions_mutex */
+void talp_lazy_region_start(talp_info_t *talp_info, dlb_monitor_t *monitor);
+void talp_lazy_region_stop(talp_info_t *talp_info, int index, bool update);
+
+
+/* Publish the metrics of a region into the TALP shared memory. The global
+ * region is also published every TALP_PUBLISH_PERIOD_NS when polled */
+enum { TALP_PUBLISH_PERIOD_NS = 100000000 };
+void talp_publish_poll(talp_info_t *talp_info);
+void talp_publish_region_metrics(const talp_info_t *talp_info,
+        const struct dlb_monitor_t *monitor);
 
 
 /* TALP collect functions for 3rd party programs */
 int talp_query_pop_node_metrics(const char *name, struct dlb_node_metrics_t *node_metrics);
+int talp_query_pop_metrics(const char *name, struct dlb_pop_metrics_t *pop_metrics);
 
 
 /* TALP collect functions for 1st party programs */
@@ -52,6 +67,10 @@ int talp_collect_pop_metrics(const subprocess_descriptor_t *spd,
         struct dlb_monitor_t *monitor, struct dlb_pop_metrics_t *pop_metrics);
 int talp_collect_pop_node_metrics(const subprocess_descriptor_t *spd,
         struct dlb_monitor_t *monitor, struct dlb_node_metrics_t *node_metrics);
+int talp_icollect_pop_metrics(const subprocess_descriptor_t *spd,
+        struct dlb_monitor_t *monitor, struct dlb_pop_metrics_t *pop_metrics,
+        struct dlb_talp_request_t **request);
+int talp_test_request(struct dlb_talp_request_t **request, bool *completed, bool wait);
 
 
 #endif /* TALP_H */
@@ -0,0 +1,339 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#include "talp/talp_binary.h"
+
+#include "support/debug.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { ALIGNMENT = 8 };
+
+static inline size_t align_up(size_t size) {
+    return (size + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+}
+
+size_t talp_binary_type_size(talp_binary_type_t type) {
+    switch(type) {
+        case TALP_BINARY_INT32:
+        case TALP_BINARY_FLOAT32:
+        case TALP_BINARY_STRING:
+            return 4;
+        case TALP_BINARY_INT64:
+        case TALP_BINARY_FLOAT64:
+            return 8;
+    }
+    return 0;
+}
+
+
+/*********************************************************************************/
+/*    Writer                                                                     */
+/*********************************************************************************/
+
+static gint key_compare_func(gconstpointer a, gconstpointer b, gpointer user_data) {
+    return strcmp(a, b);
+}
+
+void talp_binary_writer_init(talp_binary_writer_t *writer) {
+    *writer = (const talp_binary_writer_t) {
+        .string_index = g_tree_new_full(
+                (GCompareDataFunc)key_compare_func,
+                NULL, free, NULL),
+    };
+
+    /* The header is completed when the file is written */
+    writer->size = align_up(sizeof(talp_binary_header_t));
+    writer->capacity = 4096;
+    writer->data = calloc(1, writer->capacity);
+    fatal_cond(writer->data == NULL, "Could not allocate the TALP binary output");
+}
+
+void talp_binary_writer_finalize(talp_binary_writer_t *writer) {
+    free(writer->data);
+    free(writer->strings);
+    g_tree_destroy(writer->string_index);
+    *writer = (const talp_binary_writer_t) {};
+}
+
+/* Reserve an aligned, zeroed, block at the end of the data buffer */
+static void* reserve(talp_binary_writer_t *writer, size_t size) {
+    size_t offset = writer->size;
+    size_t new_size = offset + align_up(size);
+    if (new_size > writer->capacity) {
+        size_t new_capacity = writer->capacity;
+        while (new_capacity < new_size) new_capacity *= 2;
+        writer->data = realloc(writer->data, new_capacity);
+        fatal_cond(writer->data == NULL, "Could not allocate the TALP binary output");
+        writer->capacity = new_capacity;
+    }
+    memset(writer->data + offset, 0, new_size - offset);
+    writer->size = new_size;
+    return writer->data + offset;
+}
+
+uint32_t talp_binary_writer_add_string(talp_binary_writer_t *writer, const char *string) {
+
+    /* The index stores offset + 1 so that NULL means not found */
+    gpointer value = g_tree_lookup(writer->string_index, string);
+    if (value != NULL) {
+        return (uint32_t)((uintptr_t)value - 1);
+    }
+
+    size_t len = strlen(string) + 1;
+    if (writer->strings_size + len > writer->strings_capacity) {
+        size_t new_capacity = writer->strings_capacity > 0 ? writer->strings_capacity : 1024;
+        while (new_capacity < writer->strings_size + len) new_capacity *= 2;
+        writer->strings = realloc(writer->strings, new_capacity);
+        fatal_cond(writer->strings == NULL, "Could not allocate the TALP binary output");
+        writer->strings_capacity = new_capacity;
+    }
+
+    uint32_t offset = writer->strings_size;
+    memcpy(writer->strings + offset, string, len);
+    writer->strings_size += len;
+    g_tree_insert(writer->string_index, strdup(string), (gpointer)((uintptr_t)offset + 1));
+
+    return offset;
+}
+
+void talp_binary_writer_add_table(talp_binary_writer_t *writer, const char *name,
+        uint32_t num_columns, uint64_t num_rows) {
+
+    ensure(writer->column_index == writer->num_columns,
+            "TALP binary table with missing columns");
+
+    uint32_t name_offset = talp_binary_writer_add_string(writer, name);
+    talp_binary_table_t *table = reserve(writer, sizeof(talp_binary_table_t));
+    *table = (const talp_binary_table_t) {
+        .name = name_offset,
+        .num_columns = num_columns,
+        .num_rows = num_rows,
+    };
+    writer->table_offset = (char*)table - writer->data;
+
+    /* Column descriptors are filled as the columns are added */
+    reserve(writer, sizeof(talp_binary_column_t) * num_columns);
+
+    writer->num_columns = num_columns;
+    writer->column_index = 0;
+    writer->num_rows = num_rows;
+    ++writer->num_tables;
+}
+
+void* talp_binary_writer_add_column(talp_binary_writer_t *writer, const char *name,
+        talp_binary_type_t type) {
+
+    ensure(writer->column_index < writer->num_columns,
+            "TALP binary table with too many columns");
+
+    uint32_t name_offset = talp_binary_writer_add_string(writer, name);
+    void *column_data = reserve(writer, talp_binary_type_size(type) * writer->num_rows);
+
+    talp_binary_column_t *columns = (talp_binary_column_t*)(writer->data
+            + writer->table_offset + sizeof(talp_binary_table_t));
+    columns[writer->column_index++] = (const talp_binary_column_t) {
+        .name = name_offset,
+        .type = type,
+    };
+
+    return column_data;
+}
+
+int talp_binary_writer_write(talp_binary_writer_t *writer,
+        const talp_binary_header_t *header, FILE *out_file) {
+
+    ensure(writer->column_index == writer->num_columns,
+            "TALP binary table with missing columns");
+
+    /* Append the string table */
+    size_t string_table_offset = writer->size;
+    if (writer->strings_size > 0) {
+        void *strings = reserve(writer, writer->strings_size);
+        memcpy(strings, writer->strings, writer->strings_size);
+    }
+
+    talp_binary_header_t *file_header = (talp_binary_header_t*)writer->data;
+    *file_header = *header;
+    memcpy(file_header->magic, TALP_BINARY_MAGIC, sizeof(TALP_BINARY_MAGIC));
+    file_header->version = TALP_BINARY_VERSION;
+    file_header->byte_order = TALP_BINARY_BYTE_ORDER;
+    file_header->num_tables = writer->num_tables;
+    file_header->string_table_offset = string_table_offset;
+    file_header->string_table_size = writer->strings_size;
+
+    if (fwrite(writer->data, 1, writer->size, out_file) != writer->size) {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*********************************************************************************/
+/*    Reader                                                                     */
+/*********************************************************************************/
+
+/* Return whether the strings section contains a string at offset */
+static bool valid_string(const talp_binary_file_t *file, uint32_t offset) {
+    return offset < file->header->string_table_size;
+}
+
+static int parse_tables(talp_binary_file_t *file) {
+
+    const talp_binary_header_t *header = file->header;
+    const char *data = file->data;
+    size_t end = header->string_table_offset;
+    size_t offset = align_up(sizeof(talp_binary_header_t));
+
+    file->tables = calloc(header->num_tables, sizeof(talp_binary_table_view_t));
+    if (file->tables == NULL) return -1;
+
+    for (uint32_t i = 0; i < header->num_tables; ++i) {
+
+        if (offset + sizeof(talp_binary_table_t) > end) return -1;
+        const talp_binary_table_t *table = (const talp_binary_table_t*)(data + offset);
+        offset += sizeof(talp_binary_table_t);
+
+        size_t columns_size = sizeof(talp_binary_column_t) * table->num_columns;
+        if (offset + columns_size > end) return -1;
+        if (!valid_string(file, table->name)) return -1;
+
+        talp_binary_table_view_t *view = &file->tables[i];
+        *view = (const talp_binary_table_view_t) {
+            .name = file->strings + table->name,
+            .num_columns = table->num_columns,
+            .num_rows = table->num_rows,
+            .columns = (const talp_binary_column_t*)(data + offset),
+            .strings = file->strings,
+            .column_data = malloc(sizeof(void*) * table->num_columns),
+        };
+        if (view->column_data == NULL) return -1;
+        offset += align_up(columns_size);
+
+        for (uint32_t j = 0; j < table->num_columns; ++j) {
+            const talp_binary_column_t *column = &view->columns[j];
+            size_t type_size = talp_binary_type_size(column->type);
+            if (type_size == 0 || !valid_string(file, column->name)) return -1;
+            if (table->num_rows > (end - offset) / type_size) return -1;
+            view->column_data[j] = data + offset;
+            offset += align_up(type_size * table->num_rows);
+            if (offset > end) return -1;
+
+            /* String values must point inside the string table */
+            if (column->type == TALP_BINARY_STRING) {
+                const uint32_t *values = view->column_data[j];
+                for (uint64_t row = 0; row < table->num_rows; ++row) {
+                    if (!valid_string(file, values[row])) return -1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+talp_binary_file_t* talp_binary_read(const char *filename) {
+
+    FILE *in_file = fopen(filename, "r");
+    if (in_file == NULL) {
+        warning("Cannot open TALP binary file %s", filename);
+        return NULL;
+    }
+
+    talp_binary_file_t *file = calloc(1, sizeof(talp_binary_file_t));
+    bool ok = file != NULL
+        && fseek(in_file, 0, SEEK_END) == 0
+        && (long)(file->size = ftell(in_file)) > 0
+        && fseek(in_file, 0, SEEK_SET) == 0
+        && (file->data = malloc(file->size)) != NULL
+        && fread(file->data, 1, file->size, in_file) == file->size;
+    fclose(in_file);
+
+    if (ok) {
+        const talp_binary_header_t *header = file->data;
+        file->header = header;
+        ok = file->size >= sizeof(talp_binary_header_t)
+            && memcmp(header->magic, TALP_BINARY_MAGIC, sizeof(TALP_BINARY_MAGIC)) == 0
+            && header->byte_order == TALP_BINARY_BYTE_ORDER
+            && header->version == TALP_BINARY_VERSION
+            && header->string_table_offset <= file->size
+            && header->string_table_size <= file->size - header->string_table_offset
+            && (header->string_table_size == 0
+                    || ((const char*)file->data)[header->string_table_offset
+                        + header->string_table_size - 1] == '\0');
+    }
+
+    if (ok) {
+        file->strings = (const char*)file->data + file->header->string_table_offset;
+        ok = valid_string(file, file->header->dlb_version)
+            && valid_string(file, file->header->timestamp)
+            && valid_string(file, file->header->hostname)
+            && parse_tables(file) == 0;
+    }
+
+    if (!ok) {
+        warning("%s is not a valid TALP binary file", filename);
+        talp_binary_free(file);
+        return NULL;
+    }
+
+    return file;
+}
+
+void talp_binary_free(talp_binary_file_t *file) {
+    if (file == NULL) return;
+    if (file->tables != NULL) {
+        for (uint32_t i = 0; i < file->header->num_tables; ++i) {
+            free(file->tables[i].column_data);
+        }
+        free(file->tables);
+    }
+    free(file->data);
+    free(file);
+}
+
+const char* talp_binary_get_string(const talp_binary_file_t *file, uint32_t offset) {
+    return valid_string(file, offset) ? file->strings + offset : NULL;
+}
+
+const talp_binary_table_view_t* talp_binary_get_table(const talp_binary_file_t *file,
+        const char *name) {
+
+    for (uint32_t i = 0; i < file->header->num_tables; ++i) {
+        if (strcmp(file->tables[i].name, name) == 0) {
+            return &file->tables[i];
+        }
+    }
+    return NULL;
+}
+
+const void* talp_binary_get_column(const talp_binary_table_view_t *table,
+        const char *name, talp_binary_type_t type) {
+
+    for (uint32_t i = 0; i < table->num_columns; ++i) {
+        if (table->columns[i].type == type
+                && strcmp(table->strings + table->columns[i].name, name) == 0) {
+            return table->column_data[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,173 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifndef TALP_BINARY_H
+#define TALP_BINARY_H
+
+#include "support/gtree.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* TALP binary columnar format
+ *
+ * A file is a sequence of 8-byte aligned sections, all of them in the byte
+ * order of the writer, which can be detected with the byte_order field:
+ *
+ *   talp_binary_header_t
+ *   For each table:
+ *     talp_binary_table_t
+ *     talp_binary_column_t[num_columns]
+ *     For each column: num_rows values of the column type, padded to 8 bytes
+ *   String table: string_table_size bytes of NUL-terminated strings
+ *
+ * Strings, including table and column names, are stored as 32-bit offsets
+ * into the string table, and each distinct string is stored only once.
+ */
+
+#define TALP_BINARY_MAGIC "DLBTALP"
+enum { TALP_BINARY_VERSION = 1 };
+enum { TALP_BINARY_BYTE_ORDER = 0x01020304 };
+
+typedef enum talp_binary_type_t {
+    TALP_BINARY_INT32   = 1,
+    TALP_BINARY_INT64   = 2,
+    TALP_BINARY_FLOAT32 = 3,
+    TALP_BINARY_FLOAT64 = 4,
+    TALP_BINARY_STRING  = 5,    /* uint32_t offset into the string table */
+} talp_binary_type_t;
+
+/* Binary type of an arithmetic C type */
+#define TALP_BINARY_TYPE_OF(c_type)                                     \
+    ((c_type)0.5 != 0                                                   \
+     ? (sizeof(c_type) == 4 ? TALP_BINARY_FLOAT32 : TALP_BINARY_FLOAT64)  \
+     : (sizeof(c_type) == 4 ? TALP_BINARY_INT32 : TALP_BINARY_INT64))
+
+typedef struct talp_binary_header_t {
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t dlb_version;               /* string */
+    uint32_t timestamp;                 /* string */
+    uint32_t num_cpus;
+    uint32_t num_available_cpus;
+    uint32_t num_nodes;
+    uint32_t num_mpi_ranks;
+    uint32_t num_gpus;
+    uint32_t hostname;                  /* string, processInfo */
+    int32_t  pid;                       /* processInfo, 0 if not recorded */
+    uint32_t num_tables;
+    uint64_t string_table_offset;
+    uint64_t string_table_size;
+} talp_binary_header_t;
+
+typedef struct talp_binary_table_t {
+    uint32_t name;                      /* string */
+    uint32_t num_columns;
+    uint64_t num_rows;
+} talp_binary_table_t;
+
+typedef struct talp_binary_column_t {
+    uint32_t name;                      /* string */
+    uint32_t type;                      /* talp_binary_type_t */
+} talp_binary_column_t;
+
+size_t talp_binary_type_size(talp_binary_type_t type);
+
+
+/*********************************************************************************/
+/*    Writer                                                                     */
+/*********************************************************************************/
+
+/* The whole file is built in memory and written with a single fwrite */
+typedef struct talp_binary_writer_t {
+    char *data;
+    size_t size;
+    size_t capacity;
+    char *strings;
+    size_t strings_size;
+    size_t strings_capacity;
+    GTree *string_index;
+    uint32_t num_tables;
+    size_t table_offset;                /* current table */
+    uint32_t num_columns;
+    uint32_t column_index;
+    uint64_t num_rows;
+} talp_binary_writer_t;
+
+void talp_binary_writer_init(talp_binary_writer_t *writer);
+void talp_binary_writer_finalize(talp_binary_writer_t *writer);
+
+/* Return the offset of the string in the string table, adding it if needed */
+uint32_t talp_binary_writer_add_string(talp_binary_writer_t *writer, const char *string);
+
+/* Start a table, which must be followed by exactly num_columns columns */
+void talp_binary_writer_add_table(talp_binary_writer_t *writer, const char *name,
+        uint32_t num_columns, uint64_t num_rows);
+
+/* Append a column to the current table and return the array of num_rows
+ * values to fill. The array is only valid until the next table or column is
+ * added, but strings may be added meanwhile */
+void* talp_binary_writer_add_column(talp_binary_writer_t *writer, const char *name,
+        talp_binary_type_t type);
+
+/* Complete the header fields that describe the layout and write the file.
+ * Return 0 on success, or -1 on error */
+int talp_binary_writer_write(talp_binary_writer_t *writer,
+        const talp_binary_header_t *header, FILE *out_file);
+
+
+/*********************************************************************************/
+/*    Reader                                                                     */
+/*********************************************************************************/
+
+typedef struct talp_binary_table_view_t {
+    const char *name;
+    uint32_t num_columns;
+    uint64_t num_rows;
+    const talp_binary_column_t *columns;
+    const void **column_data;
+    const char *strings;
+} talp_binary_table_view_t;
+
+typedef struct talp_binary_file_t {
+    void *data;
+    size_t size;
+    const talp_binary_header_t *header;
+    const char *strings;
+    talp_binary_table_view_t *tables;
+} talp_binary_file_t;
+
+/* Read and validate a whole file. Return NULL on error */
+talp_binary_file_t* talp_binary_read(const char *filename);
+void talp_binary_free(talp_binary_file_t *file);
+
+/* Return the string at the given offset */
+const char* talp_binary_get_string(const talp_binary_file_t *file, uint32_t offset);
+
+/* Return the table with the given name, or NULL if not found */
+const talp_binary_table_view_t* talp_binary_get_table(const talp_binary_file_t *file,
+        const char *name);
+
+/* Return the values of the column with the given name, or NULL if not found
+ * or the type does not match */
+const void* talp_binary_get_column(const talp_binary_table_view_t *table,
+        const char *name, talp_binary_type_t type);
+
+#endif /* TALP_BINARY_H */
@@ -164,7 +164,9 @@ void talp_gpu_exit_runtime(void) {
 
         /* Add statistic */
         talp_sample_t *sample = talp_sample_get(talp_info);
+        talp_sample_write_begin(sample);
         ++sample->stats.num_gpu_runtime_calls;
+        talp_sample_write_end(sample);
 
         /* Out of Sync call -> useful */
         talp_sample_set_state(talp_info, TALP_STATE_USEFUL);
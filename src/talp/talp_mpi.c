@@ -19,22 +19,27 @@
 
 #include "talp/talp_mpi.h"
 
-#include "LB_comm/shmem_talp.h"
 #include "LB_core/node_barrier.h"
 #include "LB_core/spd.h"
 #include "LB_core/thread_ctx.h"
+#include "apis/dlb_errors.h"
 #include "apis/dlb_talp.h"
 #include "support/debug.h"
+#include "support/mytime.h"
+#include "talp/auto_regions.h"
+#include "talp/perf_metrics.h"
 #include "talp/regions.h"
 #include "talp/sample.h"
 #include "talp/talp.h"
 #include "talp/talp_record.h"
+#include "talp/talp_timeseries.h"
 #include "talp/talp_types.h"
 #ifdef MPI_LIB
 #include "mpi/mpi_core.h"
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 
@@ -51,10 +56,8 @@ static void talp_register_common_mpi_regions(const subprocess_descriptor_t *spd)
     talp_info_t *talp_info = spd->talp_info;
 
     /* Warn about open regions */
-    for (GSList *node = talp_info->open_regions;
-            node != NULL;
-            node = node->next) {
-        const dlb_monitor_t *monitor = node->data;
+    for (int i = 0; i < talp_info->open_regions.size; ++i) {
+        const dlb_monitor_t *monitor = talp_info->open_regions.monitors[i];
         warning("Region %s is still open during MPI_Finalize."
                 " Collected data may be incomplete.",
                 monitor->name);
@@ -136,7 +139,9 @@ void talp_mpi_init(const subprocess_descriptor_t *spd) {
 
         /* Add MPI_Init statistic and set useful state */
         talp_sample_t *sample = talp_sample_get(talp_info);
+        talp_sample_write_begin(sample);
         ++sample->stats.num_mpi_calls;
+        talp_sample_write_end(sample);
         talp_sample_set_state(talp_info, TALP_STATE_USEFUL);
     }
 }
@@ -150,6 +155,9 @@ void talp_mpi_finalize(const subprocess_descriptor_t *spd) {
 
     if (talp_info == NULL || !talp_info->flags.have_mpi) return;
 
+    /* The code interval after the last MPI call site ends here */
+    talp_mpi_auto_region_stop(spd);
+
 #ifdef MPI_LIB
     /* We also need to measure the waiting time of an MPI_Finalize.
         * For this, we call an MPI_Barrier and the appropriate TALP functions.
@@ -163,22 +171,28 @@ void talp_mpi_finalize(const subprocess_descriptor_t *spd) {
         * Even though talp_mpi_finalize should never be called if no MPI_LIB,
         * we keep this case for testing purposes. */
     talp_sample_t *sample = talp_sample_get(talp_info);
+    talp_sample_write_begin(sample);
     ++sample->stats.num_mpi_calls;
+    talp_sample_write_end(sample);
 #endif
 
     /* Stop global region */
     region_stop(spd, talp_info->monitor);
 
-    monitor_data_t *monitor_data = talp_info->monitor->_data;
-
     /* Update shared memory values */
     if (talp_info->flags.have_shmem || talp_info->flags.have_minimal_shmem) {
         // TODO: is it needed? isn't it updated when stopped?
-        shmem_talp__set_times(monitor_data->node_shared_id,
-                talp_info->monitor->mpi_time,
-                talp_info->monitor->useful_time);
+        talp_publish_region_metrics(talp_info, talp_info->monitor);
     }
 
+    /* Name automatic regions after their functions before gathering them */
+    auto_regions_symbolize(spd);
+
+#ifdef MPI_LIB
+    /* Complete the pending non-blocking reductions before MPI is finalized */
+    perf_metrics__complete_requests();
+#endif
+
     /* If TALP partial output is enabled, metrics are not merged here.
      * Output is written per process in talp_finalize() */
     if (spd->options.talp_partial_output) return;
@@ -201,20 +215,35 @@ void talp_mpi_finalize(const subprocess_descriptor_t *spd) {
             /* Ensure everyone has the same monitoring regions */
             talp_register_common_mpi_regions(spd);
 
+            /* Write process data in parallel if requested, or gather it below */
+            bool process_collective = spd->options.talp_summary & SUMMARY_PROCESS
+                && spd->options.talp_collective_output
+                && talp_record_process_collective(spd) == DLB_SUCCESS;
+
             /* Finally, reduce data */
+            int nregions = g_tree_nnodes(talp_info->regions);
+            const dlb_monitor_t **monitors = malloc(nregions * sizeof(dlb_monitor_t*));
+            int i = 0;
             for (GTreeNode *node = g_tree_node_first(talp_info->regions);
                     node != NULL;
                     node = g_tree_node_next(node)) {
-                const dlb_monitor_t *monitor = g_tree_node_value(node);
-                if (spd->options.talp_summary & SUMMARY_POP_METRICS) {
-                    talp_record_pop_summary(spd, monitor);
-                }
-                if (spd->options.talp_summary & SUMMARY_PROCESS) {
-                    talp_record_process_summary(spd, monitor);
+                monitors[i++] = g_tree_node_value(node);
+            }
+            if (spd->options.talp_summary & SUMMARY_POP_METRICS) {
+                talp_record_pop_summary(spd, monitors, nregions);
+            }
+            if (spd->options.talp_summary & SUMMARY_PROCESS
+                    && !process_collective) {
+                for (i = 0; i < nregions; ++i) {
+                    talp_record_process_summary(spd, monitors[i]);
                 }
             }
+            free(monitors);
         }
     }
+
+    /* Free MPI datatypes cached by the reductions */
+    perf_metrics__finalize_mpi();
 #endif
 }
 
@@ -227,11 +256,72 @@ void talp_into_sync_call(const subprocess_descriptor_t *spd, sync_call_flags_t f
 
     if (talp_info == NULL || !talp_info->flags.have_mpi) return;
 
-    /* Update sample */
-    talp_sample_update(talp_info);
+    /* Update sample, unless it is estimated by statistical sampling */
+    if (!talp_sample_is_sampled(talp_info)) {
+        talp_sample_update(talp_info);
+    }
 
     /* Into Sync call -> not_useful_mpi */
     talp_sample_set_state(talp_info, TALP_STATE_NOT_USEFUL_MPI);
+
+    /* Start of the MPI call for the breakdown, the sample timestamp is reused
+     * if it has just been updated */
+    if (talp_info->flags.mpi_breakdown && flags.is_mpi) {
+        talp_sample_t *sample = talp_sample_get(talp_info);
+        sample->mpi_call_start_ts = sample->sampled
+            ? get_fast_time_in_ns()
+            : sample->last_updated_ts;
+    }
+}
+
+void talp_mpi_add_bytes(const subprocess_descriptor_t *spd, int slot,
+        int64_t bytes) {
+
+    /* Observer and unknown threads may call MPI functions, but TALP must ignore them */
+    if (unlikely(!thread_is_profiled())) return;
+
+    talp_info_t *talp_info = spd->talp_info;
+
+    if (talp_info == NULL
+            || !talp_info->flags.have_mpi
+            || !talp_info->flags.mpi_breakdown) return;
+
+    talp_sample_t *sample = talp_sample_get(talp_info);
+    talp_sample_write_begin(sample);
+    sample->mpi_calls[slot].bytes += bytes;
+    talp_sample_write_end(sample);
+}
+
+/* Only the main thread in sequential code manages the automatic regions of
+ * MPI call sites, since TALP regions are shared by the whole process.
+ * Starting and stopping a region aggregates the samples of all threads, so
+ * this is the main cost of MPI calls with automatic regions, see talp_09 */
+void talp_mpi_auto_region_start(const subprocess_descriptor_t *spd, const void *call_site) {
+
+    talp_info_t *talp_info = spd->talp_info;
+
+    if (talp_info == NULL
+            || !talp_info->flags.have_mpi
+            || !talp_info->flags.mpi_auto_regions
+            || call_site == NULL
+            || !thread_is_main_sequential()) return;
+
+    dlb_monitor_t *monitor = auto_region_get(spd, AUTO_REGION_MPI, call_site);
+    if (region_start(spd, monitor) == DLB_SUCCESS) {
+        talp_info->mpi_auto_region = monitor;
+    }
+}
+
+void talp_mpi_auto_region_stop(const subprocess_descriptor_t *spd) {
+
+    talp_info_t *talp_info = spd->talp_info;
+
+    if (talp_info == NULL
+            || talp_info->mpi_auto_region == NULL
+            || !thread_is_main_sequential()) return;
+
+    region_stop(spd, talp_info->mpi_auto_region);
+    talp_info->mpi_auto_region = NULL;
 }
 
 void talp_out_of_sync_call(const subprocess_descriptor_t *spd, sync_call_flags_t flags) {
@@ -243,13 +333,25 @@ void talp_out_of_sync_call(const subprocess_descriptor_t *spd, sync_call_flags_t
 
     if (talp_info == NULL || !talp_info->flags.have_mpi) return;
 
-    /* Update sample */
-    talp_sample_update(talp_info);
+    /* Update sample, unless it is estimated by statistical sampling */
+    if (!talp_sample_is_sampled(talp_info)) {
+        talp_sample_update(talp_info);
+    }
 
     /* Add statistic only if this is a real MPI call and not a DLB_Barrier */
     if (flags.is_mpi) {
         talp_sample_t *sample = talp_sample_get(talp_info);
+        talp_sample_write_begin(sample);
         ++sample->stats.num_mpi_calls;
+        if (talp_info->flags.mpi_breakdown) {
+            int64_t now = sample->sampled
+                ? get_fast_time_in_ns()
+                : sample->last_updated_ts;
+            mpi_call_stats_t *stats = &sample->mpi_calls[flags.mpi_call_slot];
+            ++stats->num_calls;
+            stats->time += now - sample->mpi_call_start_ts;
+        }
+        talp_sample_write_end(sample);
     }
 
     /* Out of Sync call -> useful */
@@ -262,4 +364,14 @@ void talp_out_of_sync_call(const subprocess_descriptor_t *spd, sync_call_flags_t
             && flags.is_collective) {
         talp_aggregate_samples_to_regions(talp_info);
     }
+
+    /* Append the time series if its period has finished */
+    if (talp_info->flags.timeseries && thread_is_main_sequential()) {
+        talp_timeseries_poll(spd);
+    }
+
+    /* Publish the global region if its period has finished */
+    if (thread_is_main_sequential()) {
+        talp_publish_poll(talp_info);
+    }
 }
@@ -30,4 +30,14 @@ void talp_mpi_finalize(const subprocess_descriptor_t *spd);
 void talp_into_sync_call(const subprocess_descriptor_t *spd, sync_call_flags_t flags);
 void talp_out_of_sync_call(const subprocess_descriptor_t *spd, sync_call_flags_t flags);
 
+/* Add the bytes of the message buffer of an MPI call to the slot of the call in
+ * the breakdown of MPI calls */
+void talp_mpi_add_bytes(const subprocess_descriptor_t *spd, int slot,
+        int64_t bytes);
+
+/* Automatic regions of MPI call sites: the region of a call site is started
+ * when the call returns and stopped when the next MPI call begins */
+void talp_mpi_auto_region_start(const subprocess_descriptor_t *spd, const void *call_site);
+void talp_mpi_auto_region_stop(const subprocess_descriptor_t *spd);
+
 #endif /* TALP_MPI_H */
@@ -23,14 +23,17 @@
 #include "LB_comm/shmem_talp.h"
 #include "LB_core/DLB_kernel.h"
 #include "LB_core/thread_ctx.h"
+#include "apis/dlb_errors.h"
 #include "apis/dlb_talp.h"
 #include "support/atomic.h"
 #include "support/debug.h"
 #include "support/small_array.h"
+#include "talp/auto_regions.h"
 #include "talp/regions.h"
 #include "talp/sample.h"
 #include "talp/talp.h"
 #include "talp/talp_hwc.h"
+#include "talp/talp_timeseries.h"
 #include "talp/talp_types.h"
 
 #include <unistd.h>
@@ -47,15 +50,9 @@ static void update_serialization_in_nested_regions(const subprocess_descriptor_t
     /* Update all open nested regions */
     pthread_mutex_lock(&talp_info->regions_mutex);
     {
-        GSList *nested_open_regions = talp_info->open_regions
-            ? talp_info->open_regions->next
-            : NULL;
-
-        for (GSList *node = nested_open_regions;
-                node != NULL;
-                node = node->next) {
-
-            dlb_monitor_t *monitor = node->data;
+        /* All open regions but the innermost one */
+        for (int i = 0; i < talp_info->open_regions.size - 1; ++i) {
+            dlb_monitor_t *monitor = talp_info->open_regions.monitors[i];
             monitor->omp_serialization_time +=
                 sample->last_updated_ts - monitor->start_time;
         }
@@ -109,6 +106,7 @@ static void compute_parallel_not_useful(
 typedef struct talp_parallel_data_t {
     talp_sample_t**  parallel_samples;
     int64_t          previous_not_useful_omp_in;
+    dlb_monitor_t*   auto_region;       /* automatic region of this parallel, if any */
 } talp_parallel_data_t;
 
 static talp_parallel_data_t talp_parallel_data_l1 = {0};
@@ -225,6 +223,14 @@ void talp_openmp_parallel_begin(omptool_parallel_data_t *parallel_data) {
         /* Assign local data */
         parallel_data->talp_parallel_data = &talp_parallel_data_l1;
 
+        /* Start the automatic region of this construct while still sequential */
+        if (talp_info->flags.openmp_auto_regions && parallel_data->codeptr_ra != NULL) {
+            dlb_monitor_t *monitor = auto_region_get(spd, AUTO_REGION_OPENMP,
+                    parallel_data->codeptr_ra);
+            talp_parallel_data_l1.auto_region =
+                region_start(spd, monitor) == DLB_SUCCESS ? monitor : NULL;
+        }
+
     } else if (parallel_level > 1) {
         /* Allocate parallel samples array */
         unsigned int requested_parallelism = parallel_data->requested_parallelism;
@@ -241,7 +247,9 @@ void talp_openmp_parallel_begin(omptool_parallel_data_t *parallel_data) {
 
     /* Update stats */
     talp_sample_t *sample = talp_sample_get(talp_info);
+    talp_sample_write_begin(sample);
     ++sample->stats.num_omp_parallels;
+    talp_sample_write_end(sample);
 
     /* Update main thread sequential mode if this is the outermost parallel region */
     if (parallel_level == 1) {
@@ -273,8 +281,10 @@ void talp_openmp_parallel_end(omptool_parallel_data_t *parallel_data) {
     compute_parallel_not_useful(parallel_samples, num_samples, now,
             &not_useful_omp_in_lb, &not_useful_omp_in_sched);
 
+    talp_sample_write_begin(sample);
     sample->timers.not_useful_omp_in_lb += not_useful_omp_in_lb;
     sample->timers.not_useful_omp_in_sched += not_useful_omp_in_sched;
+    talp_sample_write_end(sample);
 
     /* Iterate all participants' samples and record the timestamp of the parallel-end event.
      * Note that this is needed because we don't know if the OpenMP implementation
@@ -290,9 +300,25 @@ void talp_openmp_parallel_end(omptool_parallel_data_t *parallel_data) {
     if (parallel_data->level == 1) {
         /* Update main thread sequential mode if this was the outermost parallel region */
         thread_ctx_set_main(THREAD_MAIN_SEQUENTIAL);
+
+        /* Stop the automatic region of this construct */
+        if (talp_parallel_data->auto_region != NULL) {
+            region_stop(spd, talp_parallel_data->auto_region);
+            talp_parallel_data->auto_region = NULL;
+        }
+
+        /* Append the time series if its period has finished */
+        if (talp_info->flags.timeseries) {
+            talp_timeseries_poll(spd);
+        }
+
+        /* Publish the global region if its period has finished */
+        talp_publish_poll(talp_info);
     } else {
         /* Restore previously pushed not-useful-omp-in */
+        talp_sample_write_begin(sample);
         sample->timers.not_useful_omp_in = talp_parallel_data->previous_not_useful_omp_in;
+        talp_sample_write_end(sample);
 
         /* free local data */
         free(talp_parallel_data);
@@ -319,6 +345,7 @@ void talp_openmp_into_parallel_function(
         parallel_samples[index] = sample;
     }
 
+    talp_sample_write_begin(sample);
     if (index > 0) {
         /* For non-primary threads, the next sample update will add time to
          * not-useful-omp-out, but we need to fix the initial timestamp to not
@@ -336,8 +363,10 @@ void talp_openmp_into_parallel_function(
 
     /* We always start parallel regions with this timer reset to 0. */
     sample->timers.not_useful_omp_in = 0;
+    talp_sample_write_end(sample);
 
-    /* Update thread sample */
+    /* Update thread sample, also in statistical sampling mode, so that the
+     * time before this parallel region is not split among its states */
     talp_sample_update(talp_info);
 
     /* Each thread records its CPU when beginning the parallel region */
@@ -379,7 +408,9 @@ void talp_openmp_into_parallel_implicit_barrier(omptool_parallel_data_t *paralle
 
     if (talp_info == NULL || !talp_info->flags.have_openmp) return;
 
-    /* Update thread sample */
+    /* Update thread sample, also in statistical sampling mode: the primary
+     * thread computes the load balance and scheduling times of the parallel
+     * region from the samples of all participants at parallel-end */
     talp_sample_update(talp_info);
 
     /* Update state */
@@ -394,8 +425,10 @@ void talp_openmp_into_parallel_sync(omptool_parallel_data_t *parallel_data) {
 
     if (talp_info == NULL || !talp_info->flags.have_openmp) return;
 
-    /* Update thread sample */
-    talp_sample_update(talp_info);
+    /* Update thread sample, unless it is estimated by statistical sampling */
+    if (!talp_sample_is_sampled(talp_info)) {
+        talp_sample_update(talp_info);
+    }
 
     /* Update state */
     talp_sample_set_state(talp_info, TALP_STATE_NOT_USEFUL_OMP_IN);
@@ -409,8 +442,10 @@ void talp_openmp_outof_parallel_sync(omptool_parallel_data_t *parallel_data) {
 
     if (talp_info == NULL || !talp_info->flags.have_openmp) return;
 
-    /* Update thread sample */
-    talp_sample_update(talp_info);
+    /* Update thread sample, unless it is estimated by statistical sampling */
+    if (!talp_sample_is_sampled(talp_info)) {
+        talp_sample_update(talp_info);
+    }
 
     /* Update state */
     talp_sample_set_state(talp_info, TALP_STATE_USEFUL);
@@ -426,7 +461,9 @@ void talp_openmp_task_create(void) {
 
     /* Just update stats */
     talp_sample_t *sample = talp_sample_get(talp_info);
+    talp_sample_write_begin(sample);
     ++sample->stats.num_omp_tasks;
+    talp_sample_write_end(sample);
 }
 
 // task-schedule event: task complete
@@ -437,8 +474,10 @@ void talp_openmp_task_complete(void) {
 
     if (talp_info == NULL || !talp_info->flags.have_openmp) return;
 
-    /* Update thread sample */
-    talp_sample_update(talp_info);
+    /* Update thread sample, unless it is estimated by statistical sampling */
+    if (!talp_sample_is_sampled(talp_info)) {
+        talp_sample_update(talp_info);
+    }
 
     /* Update state (FIXME: tasks outside of parallels?) */
     talp_sample_set_state(talp_info, TALP_STATE_NOT_USEFUL_OMP_IN);
@@ -452,8 +491,10 @@ void talp_openmp_task_switch(void) {
 
     if (talp_info == NULL || !talp_info->flags.have_openmp) return;
 
-    /* Update thread sample */
-    talp_sample_update(talp_info);
+    /* Update thread sample, unless it is estimated by statistical sampling */
+    if (!talp_sample_is_sampled(talp_info)) {
+        talp_sample_update(talp_info);
+    }
 
     /* Update state */
     talp_sample_set_state(talp_info, TALP_STATE_USEFUL);
@@ -27,11 +27,15 @@
 #include "apis/dlb_talp.h"
 #include "support/debug.h"
 #include "support/gslist.h"
+#include "support/hash_table.h"
 #include "support/mask_utils.h"
 #include "support/mytime.h"
 #include "support/options.h"
+#include "talp/regions.h"
 #include "talp/talp.h"
+#include "talp/talp_binary.h"
 #include "talp/talp_types.h"
+#include "talp/talp_writer.h"
 #include "talp/perf_metrics.h"
 
 #include <errno.h>
@@ -39,6 +43,7 @@
 #include <libgen.h>
 #include <limits.h>
 #include <locale.h>
+#include <math.h>
 #include <pthread.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -117,6 +122,12 @@ void talp_output_print_monitoring_region(
     if (talp_flags.have_mpi) {
         info("### Not useful MPI:                           %"PRId64" ns",
                 monitor->mpi_time);
+        if (talp_flags.sampling) {
+            int64_t mpi_time_ci = region_get_mpi_time_ci(monitor);
+            info("### Not useful MPI 95%% CI:                    +/- %"PRId64" ns"
+                    " (%"PRId64" samples)",
+                    mpi_time_ci, monitor_data->sampling.num_ticks);
+        }
         if (talp_flags.have_openmp) {
             info("### Not useful MPI in worker threads:         %"PRId64" ns",
                     monitor->mpi_worker_idle_time);
@@ -164,25 +175,50 @@ void talp_output_print_monitoring_region(
 /*    POP Metrics                                                                */
 /*********************************************************************************/
 
+typedef struct pop_metrics_record_t {
+    dlb_pop_metrics_t metrics;
+    pop_metrics_ci_t ci;        /* all 0 if not sampled */
+    bool sampled;
+} pop_metrics_record_t;
+
 static GSList *pop_metrics_records = NULL;
 
-void talp_output_record_pop_metrics(const dlb_pop_metrics_t *metrics) {
+void talp_output_record_pop_metrics(const dlb_pop_metrics_t *metrics,
+        const pop_metrics_ci_t *ci) {
 
     /* Copy structure */
-    dlb_pop_metrics_t *new_record = malloc(sizeof(dlb_pop_metrics_t));
-    *new_record = *metrics;
+    pop_metrics_record_t *new_record = malloc(sizeof(pop_metrics_record_t));
+    *new_record = (const pop_metrics_record_t) {
+        .metrics = *metrics,
+        .ci = ci != NULL ? *ci : (const pop_metrics_ci_t) {},
+        .sampled = ci != NULL,
+    };
 
     /* Add record to list */
     pop_metrics_records = g_slist_prepend(pop_metrics_records, new_record);
 }
 
+/* Format an efficiency, followed by its confidence interval if sampled */
+static const char* efficiency_to_str(float value, float ci, bool sampled) {
+    static char buf[32];
+    if (sampled) {
+        snprintf(buf, sizeof(buf), "%1.2f +/- %1.3f", value, ci);
+    } else {
+        snprintf(buf, sizeof(buf), "%1.2f", value);
+    }
+    return buf;
+}
+
 static void pop_metrics_print(void) {
 
     for (GSList *node = pop_metrics_records;
             node != NULL;
             node = node->next) {
 
-        dlb_pop_metrics_t *record = node->data;
+        const pop_metrics_record_t *pop_record = node->data;
+        const dlb_pop_metrics_t *record = &pop_record->metrics;
+        const pop_metrics_ci_t *ci = &pop_record->ci;
+        bool sampled = pop_record->sampled;
 
         if (record->elapsed_time > 0) {
 
@@ -202,16 +238,20 @@ static void pop_metrics_print(void) {
             }
             if (record->mpi_parallel_efficiency > 0.0f &&
                     record->omp_parallel_efficiency > 0.0f) {
-                info("### Parallel efficiency:                      %1.2f",
-                        record->parallel_efficiency);
+                info("### Parallel efficiency:                      %s",
+                        efficiency_to_str(record->parallel_efficiency,
+                            ci->parallel_efficiency, sampled));
             }
             if (record->num_mpi_calls > 0) {
-                info("###  - MPI Parallel efficiency:               %1.2f",
-                        record->mpi_parallel_efficiency);
-                info("###     - Communication efficiency:           %1.2f",
-                        record->mpi_communication_efficiency);
-                info("###     - Load Balance:                       %1.2f",
-                        record->mpi_load_balance);
+                info("###  - MPI Parallel efficiency:               %s",
+                        efficiency_to_str(record->mpi_parallel_efficiency,
+                            ci->mpi_parallel_efficiency, sampled));
+                info("###     - Communication efficiency:           %s",
+                        efficiency_to_str(record->mpi_communication_efficiency,
+                            ci->mpi_communication_efficiency, sampled));
+                info("###     - Load Balance:                       %s",
+                        efficiency_to_str(record->mpi_load_balance,
+                            ci->mpi_load_balance, sampled));
                 info("###        - In:                              %1.2f",
                         record->mpi_load_balance_in);
                 info("###        - Out:                             %1.2f",
@@ -275,7 +315,8 @@ static void pop_metrics_to_json(FILE *out_file) {
                 node != NULL;
                 node = node->next) {
 
-            dlb_pop_metrics_t *record = node->data;
+            const pop_metrics_record_t *pop_record = node->data;
+            const dlb_pop_metrics_t *record = &pop_record->metrics;
 
             fprintf(out_file,
                     "    \"%s\": {\n"
@@ -283,7 +324,8 @@ static void pop_metrics_to_json(FILE *out_file) {
                     "      \"" #json_name "\": " fmt ",\n"
 #define PRINT_FMT_LAST(var_name, c_type, json_name, fmt) \
                     "      \"" #json_name "\": " fmt "\n"
-                    FOR_DLB_POP_METRICS_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
+                    FOR_DLB_POP_METRICS_FIELDS(PRINT_FMT, PRINT_FMT)
+                    FOR_POP_METRICS_CI_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
 #undef PRINT_FMT
 #undef PRINT_FMT_LAST
                     "    }%s\n",
@@ -291,6 +333,10 @@ static void pop_metrics_to_json(FILE *out_file) {
 #define PRINT_ARG(var_name, c_type, json_name, fmt) \
                     , record->var_name
                     FOR_DLB_POP_METRICS_FIELDS(PRINT_ARG, PRINT_ARG)
+#undef PRINT_ARG
+#define PRINT_ARG(var_name, c_type, json_name, fmt) \
+                    , pop_record->ci.var_name
+                    FOR_POP_METRICS_CI_FIELDS(PRINT_ARG, PRINT_ARG)
 #undef PRINT_ARG
                     , node->next != NULL ? "," : "");
         }
@@ -305,7 +351,8 @@ static void pop_metrics_to_txt(FILE *out_file) {
             node != NULL;
             node = node->next) {
 
-        dlb_pop_metrics_t *record = node->data;
+        const pop_metrics_record_t *pop_record = node->data;
+        const dlb_pop_metrics_t *record = &pop_record->metrics;
 
         if (record->elapsed_time > 0) {
             fprintf(out_file,
@@ -398,6 +445,18 @@ static void pop_metrics_to_txt(FILE *out_file) {
                     record->gpu_communication_efficiency,
                     record->gpu_orchestration_efficiency
                 );
+            if (pop_record->sampled) {
+                fprintf(out_file,
+                        "### --- 95%% confidence intervals (sampling) ---\n"
+                        "### Parallel efficiency:                       +/- %.3f\n"
+                        "### MPI Parallel efficiency:                   +/- %.3f\n"
+                        "###   - MPI Communication efficiency:          +/- %.3f\n"
+                        "###   - MPI Load Balance:                      +/- %.3f\n",
+                        pop_record->ci.parallel_efficiency,
+                        pop_record->ci.mpi_parallel_efficiency,
+                        pop_record->ci.mpi_communication_efficiency,
+                        pop_record->ci.mpi_load_balance);
+            }
         } else {
             fprintf(out_file,
                     "%s\n"
@@ -421,7 +480,8 @@ static void pop_metrics_to_csv(FILE *out_file, bool append) {
                 #json_name ","
 #define PRINT_FMT_LAST(var_name, c_type, json_name, fmt) \
                 #json_name "\n"
-                FOR_DLB_POP_METRICS_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
+                FOR_DLB_POP_METRICS_FIELDS(PRINT_FMT, PRINT_FMT)
+                FOR_POP_METRICS_CI_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
 #undef PRINT_FMT
 #undef PRINT_FMT_LAST
             );
@@ -431,7 +491,8 @@ static void pop_metrics_to_csv(FILE *out_file, bool append) {
             node != NULL;
             node = node->next) {
 
-        dlb_pop_metrics_t *record = node->data;
+        const pop_metrics_record_t *pop_record = node->data;
+        const dlb_pop_metrics_t *record = &pop_record->metrics;
 
         fprintf(out_file,
                 "\"%s\","
@@ -439,13 +500,18 @@ static void pop_metrics_to_csv(FILE *out_file, bool append) {
                 fmt ","
 #define PRINT_FMT_LAST(var_name, c_type, json_name, fmt) \
                 fmt "\n"
-                FOR_DLB_POP_METRICS_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
+                FOR_DLB_POP_METRICS_FIELDS(PRINT_FMT, PRINT_FMT)
+                FOR_POP_METRICS_CI_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
 #undef PRINT_FMT
 #undef PRINT_FMT_LAST
                 , record->name
 #define PRINT_ARG(var_name, c_type, json_name, fmt) \
                 , record->var_name
                 FOR_DLB_POP_METRICS_FIELDS(PRINT_ARG, PRINT_ARG)
+#undef PRINT_ARG
+#define PRINT_ARG(var_name, c_type, json_name, fmt) \
+                , pop_record->ci.var_name
+                FOR_POP_METRICS_CI_FIELDS(PRINT_ARG, PRINT_ARG)
 #undef PRINT_ARG
             );
     }
@@ -458,7 +524,7 @@ static void pop_metrics_finalize(void) {
             node != NULL;
             node = node->next) {
 
-        dlb_pop_metrics_t *record = node->data;
+        pop_metrics_record_t *record = node->data;
         free(record);
     }
 
@@ -694,59 +760,157 @@ static void node_finalize(void) {
 /*    Process                                                                    */
 /*********************************************************************************/
 
+/* The process records of a region are stored in arrival order, only for the
+ * ranks that actually recorded it, and sorted by rank before the output if
+ * they did not arrive in order. A repeated rank overwrites its previous
+ * record, either when it is recorded or when sorting. */
 typedef struct region_record_t {
     char name[DLB_MONITOR_NAME_MAX];
     int num_mpi_ranks;
-    process_record_t process_records[];
+    int num_records;
+    int capacity;
+    bool sorted;
+    process_record_t *process_records;
 } region_record_t;
 
 static GSList *region_records = NULL;
+static bool process_records_external = false;
+
+/* Lookup of region records by name */
+static _Atomic(hash_table_t*) region_table = NULL;
+
+enum { PROCESS_RECORDS_INITIAL_CAPACITY = 16 };
+
+static unsigned int hash_region_name(const char *name) {
+    return hash_table_hash_string(name, DLB_MONITOR_NAME_MAX-1);
+}
+
+static unsigned int hash_region_record(const void *region_record) {
+    return hash_region_name(((const region_record_t*)region_record)->name);
+}
+
+static bool region_record_has_name(const void *region_record, const void *name) {
+    return strncmp(((const region_record_t*)region_record)->name, name,
+            DLB_MONITOR_NAME_MAX-1) == 0;
+}
 
 void talp_output_record_process(const char *region_name,
         const process_record_t *process_record, int num_mpi_ranks) {
 
-    int rank = process_record->rank;
     if (num_mpi_ranks < 1) {
         /* special value to dissociate record->rank if the argument has a
          * proper value but still we're only recording one element.
          * (usually the case if --talp-partial-output) */
         num_mpi_ranks = 1;
-        rank = 0;
+    } else {
+        ensure(process_record->rank < num_mpi_ranks, "Wrong rank number in %s", __func__);
     }
 
-    region_record_t *region_record = NULL;
-
     /* Find region or allocate new one */
-    for (GSList *node = region_records;
-            node != NULL;
-            node = node->next) {
-
-        region_record_t *record = node->data;
-        if (strcmp(record->name, region_name) == 0) {
-            region_record = record;
-            break;
-        }
-    }
-
-    /* Allocate if not found */
+    region_record_t *region_record = hash_table_lookup(&region_table,
+            hash_region_name(region_name), region_record_has_name, region_name);
     if (region_record == NULL) {
         /* Allocate and initialize new region */
-        size_t region_record_size = sizeof(region_record_t) +
-            sizeof(process_record_t) * num_mpi_ranks;
-        region_record = malloc(region_record_size);
+        region_record = malloc(sizeof(region_record_t));
+        fatal_cond(region_record == NULL, "Could not allocate TALP output region");
         *region_record = (const region_record_t) {
             .num_mpi_ranks = num_mpi_ranks,
+            .sorted = true,
         };
         snprintf(region_record->name, DLB_MONITOR_NAME_MAX, "%s",
                 region_name);
 
-        /* Insert to list */
+        /* Insert to table and list */
+        hash_table_insert(&region_table, region_record, hash_region_record);
         region_records = g_slist_prepend(region_records, region_record);
     }
 
-    /* Copy process_record */
-    ensure(rank < num_mpi_ranks, "Wrong rank number in %s", __func__);
-    memcpy(&region_record->process_records[rank], process_record, sizeof(process_record_t));
+    /* A repeated rank overwrites its previous record if it is the last one,
+     * other repetitions are removed when sorting */
+    if (region_record->num_records > 0) {
+        process_record_t *last =
+            &region_record->process_records[region_record->num_records-1];
+        if (region_record->num_mpi_ranks == 1
+                || last->rank == process_record->rank) {
+            *last = *process_record;
+            return;
+        }
+        if (last->rank > process_record->rank) {
+            region_record->sorted = false;
+        }
+    }
+
+    /* Grow the array of records, usually up to the number of ranks */
+    if (region_record->num_records == region_record->capacity) {
+        int capacity = region_record->capacity > 0
+            ? region_record->capacity * 2 : PROCESS_RECORDS_INITIAL_CAPACITY;
+        if (capacity > region_record->num_mpi_ranks
+                && region_record->num_mpi_ranks > region_record->num_records) {
+            capacity = region_record->num_mpi_ranks;
+        }
+        process_record_t *process_records = realloc(region_record->process_records,
+                sizeof(process_record_t) * capacity);
+        fatal_cond(process_records == NULL, "Could not allocate TALP output process records");
+        region_record->process_records = process_records;
+        region_record->capacity = capacity;
+    }
+
+    region_record->process_records[region_record->num_records++] = *process_record;
+}
+
+/* Records being sorted, qsort has no argument for the comparison function */
+static const process_record_t *sorting_records = NULL;
+
+/* Compare indices of records by rank, and by arrival order for the same rank */
+static int compare_process_records(const void *a, const void *b) {
+    int index_a = *(const int*)a;
+    int index_b = *(const int*)b;
+    int rank_a = sorting_records[index_a].rank;
+    int rank_b = sorting_records[index_b].rank;
+    if (rank_a != rank_b) return (rank_a > rank_b) - (rank_a < rank_b);
+    return (index_a > index_b) - (index_a < index_b);
+}
+
+/* Sort the process records of each region by rank, keeping only the last
+ * record of each rank */
+static void process_sort(void) {
+    for (GSList *node = region_records;
+            node != NULL;
+            node = node->next) {
+
+        region_record_t *region_record = node->data;
+        if (region_record->sorted) continue;
+
+        int num_records = region_record->num_records;
+        int *order = malloc(sizeof(int) * num_records);
+        process_record_t *process_records = malloc(sizeof(process_record_t) * num_records);
+        fatal_cond(order == NULL || process_records == NULL,
+                "Could not allocate TALP output process records");
+
+        for (int i = 0; i < num_records; ++i) {
+            order[i] = i;
+        }
+        sorting_records = region_record->process_records;
+        qsort(order, num_records, sizeof(int), compare_process_records);
+        sorting_records = NULL;
+
+        int num_sorted = 0;
+        for (int i = 0; i < num_records; ++i) {
+            const process_record_t *record = &region_record->process_records[order[i]];
+            if (num_sorted > 0 && process_records[num_sorted-1].rank == record->rank) {
+                process_records[num_sorted-1] = *record;
+            } else {
+                process_records[num_sorted++] = *record;
+            }
+        }
+
+        free(order);
+        free(region_record->process_records);
+        region_record->process_records = process_records;
+        region_record->num_records = num_sorted;
+        region_record->capacity = num_records;
+        region_record->sorted = true;
+    }
 }
 
 static void process_print(void) {
@@ -757,7 +921,7 @@ static void process_print(void) {
 
         region_record_t *region_record = node->data;
 
-        for (int i = 0; i < region_record->num_mpi_ranks; ++i) {
+        for (int i = 0; i < region_record->num_records; ++i) {
 
             process_record_t *process_record = &region_record->process_records[i];
 
@@ -833,7 +997,7 @@ static void process_to_json(FILE *out_file) {
                 "    \"%s\": [\n",
                 region_record->name);
 
-        for (int i = 0; i < region_record->num_mpi_ranks; ++i) {
+        for (int i = 0; i < region_record->num_records; ++i) {
 
             process_record_t *process_record = &region_record->process_records[i];
 
@@ -844,6 +1008,7 @@ static void process_to_json(FILE *out_file) {
                 "        \"nodeId\": %d,\n"
                 "        \"hostname\": \"%s\",\n"
                 "        \"cpuset\": %s,\n"
+                "        \"mpiTimeCI\": %"PRId64",\n"
 #define PRINT_FMT(var_name, c_type, json_name, fmt) \
                 "        \"" #json_name "\": " fmt ",\n"
 #define PRINT_FMT_LAST(var_name, c_type, json_name, fmt) \
@@ -857,11 +1022,12 @@ static void process_to_json(FILE *out_file) {
                 process_record->node_id,
                 process_record->hostname,
                 process_record->cpuset_quoted,
+                process_record->mpi_time_ci,
 #define PRINT_ARG(var_name, c_type, json_name, fmt) \
                 process_record->monitor.var_name,
                 FOR_DLB_MONITOR_PRINTABLE_FIELDS(PRINT_ARG, PRINT_ARG)
 #undef PRINT_ARG
-                i + 1 < region_record->num_mpi_ranks ? "," : "");
+                i + 1 < region_record->num_records ? "," : "");
         }
         fprintf(out_file,
                 "    ]%s\n",
@@ -871,27 +1037,66 @@ static void process_to_json(FILE *out_file) {
                 "  }");         /* no eol */
 }
 
-static void process_to_csv(FILE *out_file, bool append) {
+void talp_output_record_process_external(void) {
+    process_records_external = true;
+}
 
-    if (region_records == NULL) return;
+void talp_output_process_csv_header(FILE *out_file) {
+    fprintf(out_file,
+            "Region,"
+            "Rank,"
+            "PID,"
+            "NodeId,"
+            "Hostname,"
+            "CpuSet,"
+            "MpiTimeCI,"
+#define PRINT_FMT(var_name, c_type, json_name, fmt) \
+            #json_name ","
+#define PRINT_FMT_LAST(var_name, c_type, json_name, fmt) \
+            #json_name "\n"
+            FOR_DLB_MONITOR_PRINTABLE_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
+#undef PRINT_FMT
+#undef PRINT_FMT_LAST
+           );
+}
 
-    if (!append) {
-        /* Print header */
-        fprintf(out_file,
-                "Region,"
-                "Rank,"
-                "PID,"
-                "NodeId,"
-                "Hostname,"
-                "CpuSet,"
+void talp_output_process_csv_row(FILE *out_file, const char *region_name,
+        const process_record_t *process_record) {
+    fprintf(out_file,
+            "%s,"           /* Region */
+            "%d,"           /* Rank */
+            "%d,"           /* PID */
+            "%d,"           /* NodeId */
+            "%s,"           /* Hostname */
+            "%s,"           /* CpuSet */
+            "%"PRId64","    /* MpiTimeCI */
 #define PRINT_FMT(var_name, c_type, json_name, fmt) \
-                #json_name ","
+            fmt ","
 #define PRINT_FMT_LAST(var_name, c_type, json_name, fmt) \
-                #json_name "\n"
-                FOR_DLB_MONITOR_PRINTABLE_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
+            fmt "\n"
+            FOR_DLB_MONITOR_PRINTABLE_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
 #undef PRINT_FMT
 #undef PRINT_FMT_LAST
-               );
+            , region_name
+            , process_record->rank
+            , process_record->pid
+            , process_record->node_id
+            , process_record->hostname
+            , process_record->cpuset_quoted
+            , process_record->mpi_time_ci
+#define PRINT_ARG(var_name, c_type, json_name, fmt) \
+            , process_record->monitor.var_name
+            FOR_DLB_MONITOR_PRINTABLE_FIELDS(PRINT_ARG, PRINT_ARG)
+#undef PRINT_ARG
+            );
+}
+
+static void process_to_csv(FILE *out_file, bool append) {
+
+    if (region_records == NULL) return;
+
+    if (!append) {
+        talp_output_process_csv_header(out_file);
     }
 
     for (GSList *node = region_records;
@@ -900,35 +1105,9 @@ static void process_to_csv(FILE *out_file, bool append) {
 
         region_record_t *region_record = node->data;
 
-        for (int i = 0; i < region_record->num_mpi_ranks; ++i) {
-
-            process_record_t *process_record = &region_record->process_records[i];
-
-            fprintf(out_file,
-                    "%s,"           /* Region */
-                    "%d,"           /* Rank */
-                    "%d,"           /* PID */
-                    "%d,"           /* NodeId */
-                    "%s,"           /* Hostname */
-                    "%s,"           /* CpuSet */
-#define PRINT_FMT(var_name, c_type, json_name, fmt) \
-                    fmt ","
-#define PRINT_FMT_LAST(var_name, c_type, json_name, fmt) \
-                    fmt "\n"
-                    FOR_DLB_MONITOR_PRINTABLE_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
-#undef PRINT_FMT
-#undef PRINT_FMT_LAST
-                    , region_record->name
-                    , process_record->rank
-                    , process_record->pid
-                    , process_record->node_id
-                    , process_record->hostname
-                    , process_record->cpuset_quoted
-#define PRINT_ARG(var_name, c_type, json_name, fmt) \
-                    , process_record->monitor.var_name
-                    FOR_DLB_MONITOR_PRINTABLE_FIELDS(PRINT_ARG, PRINT_ARG)
-#undef PRINT_ARG
-                    );
+        for (int i = 0; i < region_record->num_records; ++i) {
+            talp_output_process_csv_row(out_file, region_record->name,
+                    &region_record->process_records[i]);
         }
     }
 }
@@ -941,7 +1120,7 @@ static void process_to_txt(FILE *out_file) {
 
         region_record_t *region_record = node->data;
 
-        for (int i = 0; i < region_record->num_mpi_ranks; ++i) {
+        for (int i = 0; i < region_record->num_records; ++i) {
 
             process_record_t *process_record = &region_record->process_records[i];
 
@@ -989,18 +1168,216 @@ static void process_to_txt(FILE *out_file) {
 
 static void process_finalize(void) {
 
+    process_records_external = false;
+
     /* Free every record data */
     for (GSList *node = region_records;
             node != NULL;
             node = node->next) {
 
         region_record_t *record = node->data;
+        free(record->process_records);
         free(record);
     }
 
-    /* Free list */
+    /* Free list and table */
     g_slist_free(region_records);
     region_records = NULL;
+    hash_table_destroy(&region_table);
+}
+
+
+/*********************************************************************************/
+/*    MPI calls                                                                  */
+/*********************************************************************************/
+
+enum { MPI_CALL_NAME_MAX = 64 };
+
+typedef struct mpi_call_record_t {
+    char name[MPI_CALL_NAME_MAX];
+    mpi_call_stats_t stats;
+} mpi_call_record_t;
+
+typedef struct mpi_calls_record_t {
+    char name[DLB_MONITOR_NAME_MAX];
+    int num_calls;                  /* MPI calls that have been called */
+    mpi_call_record_t calls[];
+} mpi_calls_record_t;
+
+static GSList *mpi_calls_records = NULL;
+
+void talp_output_record_mpi_calls(const char *region_name, int num_calls,
+        const char *const *call_names, const mpi_call_stats_t *mpi_calls) {
+
+    int num_called = 0;
+    for (int i = 0; i < num_calls; ++i) {
+        if (mpi_calls[i].num_calls > 0) {
+            ++num_called;
+        }
+    }
+
+    if (num_called == 0) return;
+
+    /* Keep only the MPI calls that have been called */
+    mpi_calls_record_t *record = malloc(sizeof(mpi_calls_record_t)
+            + sizeof(mpi_call_record_t) * num_called);
+    snprintf(record->name, DLB_MONITOR_NAME_MAX, "%s", region_name);
+    record->num_calls = 0;
+    for (int i = 0; i < num_calls; ++i) {
+        if (mpi_calls[i].num_calls > 0) {
+            mpi_call_record_t *call = &record->calls[record->num_calls++];
+            snprintf(call->name, MPI_CALL_NAME_MAX, "%s", call_names[i]);
+            call->stats = mpi_calls[i];
+        }
+    }
+
+    /* Add record to list */
+    mpi_calls_records = g_slist_prepend(mpi_calls_records, record);
+}
+
+static void mpi_calls_print(void) {
+
+    for (GSList *node = mpi_calls_records;
+            node != NULL;
+            node = node->next) {
+
+        mpi_calls_record_t *record = node->data;
+
+        info("%s", make_header("Monitoring Region MPI Calls"));
+        info("### Name:                                     %s", record->name);
+        info("### %-24s %16s %20s %20s", "MPI call", "Calls", "Time (ns)", "Buffer bytes");
+        for (int i = 0; i < record->num_calls; ++i) {
+            info("### %-24s %16"PRId64" %20"PRId64" %20"PRId64,
+                    record->calls[i].name,
+                    record->calls[i].stats.num_calls,
+                    record->calls[i].stats.time,
+                    record->calls[i].stats.bytes);
+        }
+    }
+}
+
+static void mpi_calls_to_json(FILE *out_file) {
+
+    if (mpi_calls_records == NULL) return;
+
+    /* If there are other records, append to the existing dictionary */
+    if (pop_metrics_records != NULL
+            || node_records != NULL
+            || region_records != NULL) {
+        fprintf(out_file,",\n");
+    }
+
+    fprintf(out_file,
+                "  \"MpiCalls\": {\n");
+
+    for (GSList *node = mpi_calls_records;
+            node != NULL;
+            node = node->next) {
+
+        mpi_calls_record_t *record = node->data;
+
+        fprintf(out_file,
+                "    \"%s\": {\n",
+                record->name);
+
+        for (int i = 0; i < record->num_calls; ++i) {
+            fprintf(out_file,
+                "      \"%s\": {\n"
+                "        \"numCalls\": %"PRId64",\n"
+                "        \"time\": %"PRId64",\n"
+                "        \"bufferBytes\": %"PRId64"\n"
+                "      }%s\n",
+                record->calls[i].name,
+                record->calls[i].stats.num_calls,
+                record->calls[i].stats.time,
+                record->calls[i].stats.bytes,
+                i + 1 < record->num_calls ? "," : "");
+        }
+        fprintf(out_file,
+                "    }%s\n",
+                node->next != NULL ? "," : "");
+    }
+    fprintf(out_file,
+                "  }");         /* no eol */
+}
+
+static void mpi_calls_to_csv(FILE *out_file, bool append) {
+
+    if (mpi_calls_records == NULL) return;
+
+    if (!append) {
+        /* Print header */
+        fprintf(out_file,
+                "Region,"
+                "CallType,"
+                "NumCalls,"
+                "Time,"
+                "BufferBytes\n");
+    }
+
+    for (GSList *node = mpi_calls_records;
+            node != NULL;
+            node = node->next) {
+
+        mpi_calls_record_t *record = node->data;
+
+        for (int i = 0; i < record->num_calls; ++i) {
+            fprintf(out_file,
+                    "\"%s\","       /* Region */
+                    "%s,"           /* CallType */
+                    "%"PRId64","    /* NumCalls */
+                    "%"PRId64","    /* Time */
+                    "%"PRId64"\n",  /* BufferBytes */
+                    record->name,
+                    record->calls[i].name,
+                    record->calls[i].stats.num_calls,
+                    record->calls[i].stats.time,
+                    record->calls[i].stats.bytes);
+        }
+    }
+}
+
+static void mpi_calls_to_txt(FILE *out_file) {
+
+    for (GSList *node = mpi_calls_records;
+            node != NULL;
+            node = node->next) {
+
+        mpi_calls_record_t *record = node->data;
+
+        fprintf(out_file,
+                "%s\n"
+                "### Name:                                     %s\n"
+                "### %-24s %16s %20s %20s\n",
+                make_header("Monitoring Region MPI Calls"),
+                record->name,
+                "MPI call", "Calls", "Time (ns)", "Buffer bytes");
+
+        for (int i = 0; i < record->num_calls; ++i) {
+            fprintf(out_file,
+                    "### %-24s %16"PRId64" %20"PRId64" %20"PRId64"\n",
+                    record->calls[i].name,
+                    record->calls[i].stats.num_calls,
+                    record->calls[i].stats.time,
+                    record->calls[i].stats.bytes);
+        }
+    }
+}
+
+static void mpi_calls_finalize(void) {
+
+    /* Free every record data */
+    for (GSList *node = mpi_calls_records;
+            node != NULL;
+            node = node->next) {
+
+        mpi_calls_record_t *record = node->data;
+        free(record);
+    }
+
+    /* Free list */
+    g_slist_free(mpi_calls_records);
+    mpi_calls_records = NULL;
 }
 
 
@@ -1136,6 +1513,216 @@ static void process_info_to_json(FILE *out_file) {
     }
 }
 
+/*********************************************************************************/
+/*    Binary                                                                     */
+/*********************************************************************************/
+
+#define COUNT_FIELD(var_name, c_type, json_name, fmt) + 1
+
+/* Add a column and fill it with the value expression of each row */
+#define WRITE_COLUMN_VALUES(writer, num_rows, c_type, json_name, value)             \
+    {                                                                               \
+        c_type *column = talp_binary_writer_add_column(writer, #json_name,          \
+                TALP_BINARY_TYPE_OF(c_type));                                       \
+        for (row = 0; row < num_rows; ++row) {                                      \
+            column[row] = value;                                                    \
+        }                                                                           \
+    }
+
+/* Same, for a column of strings */
+#define WRITE_STRING_COLUMN(writer, num_rows, json_name, string)                    \
+    {                                                                               \
+        uint32_t *column = talp_binary_writer_add_column(writer, #json_name,        \
+                TALP_BINARY_STRING);                                                \
+        for (row = 0; row < num_rows; ++row) {                                      \
+            column[row] = talp_binary_writer_add_string(writer, string);            \
+        }                                                                           \
+    }
+
+static void pop_metrics_to_binary(talp_binary_writer_t *writer) {
+
+    if (pop_metrics_records == NULL) return;
+
+    size_t num_rows = g_slist_length(pop_metrics_records);
+    const pop_metrics_record_t **records = malloc(sizeof(pop_metrics_record_t*) * num_rows);
+    size_t row = 0;
+    for (GSList *node = pop_metrics_records; node != NULL; node = node->next) {
+        records[row++] = node->data;
+    }
+
+    uint32_t num_columns = 1 FOR_DLB_POP_METRICS_FIELDS(COUNT_FIELD, COUNT_FIELD)
+        FOR_POP_METRICS_CI_FIELDS(COUNT_FIELD, COUNT_FIELD);
+    talp_binary_writer_add_table(writer, "Application", num_columns, num_rows);
+
+    WRITE_STRING_COLUMN(writer, num_rows, regionName, records[row]->metrics.name);
+
+#define WRITE_COLUMN(var_name, c_type, json_name, fmt) \
+    WRITE_COLUMN_VALUES(writer, num_rows, c_type, json_name, records[row]->metrics.var_name)
+    FOR_DLB_POP_METRICS_FIELDS(WRITE_COLUMN, WRITE_COLUMN)
+#undef WRITE_COLUMN
+#define WRITE_COLUMN(var_name, c_type, json_name, fmt) \
+    WRITE_COLUMN_VALUES(writer, num_rows, c_type, json_name, records[row]->ci.var_name)
+    FOR_POP_METRICS_CI_FIELDS(WRITE_COLUMN, WRITE_COLUMN)
+#undef WRITE_COLUMN
+
+    free(records);
+}
+
+static void node_to_binary(talp_binary_writer_t *writer) {
+
+    if (node_records == NULL) return;
+
+    /* One row per process in node, as in the CSV format */
+    size_t num_rows = 0;
+    for (GSList *node = node_records; node != NULL; node = node->next) {
+        const node_record_t *node_record = node->data;
+        num_rows += node_record->nelems;
+    }
+
+    talp_binary_writer_add_table(writer, "Node", 8, num_rows);
+
+    size_t row;
+#define WRITE_NODE_COLUMN(c_type, json_name, value)                                 \
+    {                                                                               \
+        c_type *column = talp_binary_writer_add_column(writer, #json_name,          \
+                TALP_BINARY_TYPE_OF(c_type));                                       \
+        row = 0;                                                                    \
+        for (GSList *node = node_records; node != NULL; node = node->next) {        \
+            const node_record_t *node_record = node->data;                          \
+            for (int i = 0; i < node_record->nelems; ++i) {                         \
+                column[row++] = value;                                              \
+            }                                                                       \
+        }                                                                           \
+    }
+    WRITE_NODE_COLUMN(int,     nodeId,            node_record->node_id);
+    WRITE_NODE_COLUMN(pid_t,   processId,         node_record->processes[i].pid);
+    WRITE_NODE_COLUMN(int64_t, processUsefulTime, node_record->processes[i].useful_time);
+    WRITE_NODE_COLUMN(int64_t, processMpiTime,    node_record->processes[i].mpi_time);
+    WRITE_NODE_COLUMN(int64_t, nodeAvgUsefulTime, node_record->avg_useful_time);
+    WRITE_NODE_COLUMN(int64_t, nodeAvgMpiTime,    node_record->avg_mpi_time);
+    WRITE_NODE_COLUMN(int64_t, nodeMaxUsefulTime, node_record->max_useful_time);
+    WRITE_NODE_COLUMN(int64_t, nodeMaxMpiTime,    node_record->max_mpi_time);
+#undef WRITE_NODE_COLUMN
+}
+
+static void process_to_binary(talp_binary_writer_t *writer) {
+
+    if (region_records == NULL) return;
+
+    /* Flatten the records of all regions */
+    size_t num_rows = 0;
+    for (GSList *node = region_records; node != NULL; node = node->next) {
+        const region_record_t *region_record = node->data;
+        num_rows += region_record->num_records;
+    }
+    const process_record_t **records = malloc(sizeof(process_record_t*) * num_rows);
+    const char **region_names = malloc(sizeof(char*) * num_rows);
+    size_t row = 0;
+    for (GSList *node = region_records; node != NULL; node = node->next) {
+        const region_record_t *region_record = node->data;
+        for (int i = 0; i < region_record->num_records; ++i) {
+            region_names[row] = region_record->name;
+            records[row] = &region_record->process_records[i];
+            ++row;
+        }
+    }
+
+    uint32_t num_columns = 7 FOR_DLB_MONITOR_PRINTABLE_FIELDS(COUNT_FIELD, COUNT_FIELD);
+    talp_binary_writer_add_table(writer, "Process", num_columns, num_rows);
+
+    WRITE_STRING_COLUMN(writer, num_rows, regionName, region_names[row]);
+    WRITE_COLUMN_VALUES(writer, num_rows, int, rank, records[row]->rank);
+    WRITE_COLUMN_VALUES(writer, num_rows, pid_t, pid, records[row]->pid);
+    WRITE_COLUMN_VALUES(writer, num_rows, int, nodeId, records[row]->node_id);
+    WRITE_STRING_COLUMN(writer, num_rows, hostname, records[row]->hostname);
+    WRITE_STRING_COLUMN(writer, num_rows, cpuset, records[row]->cpuset);
+    WRITE_COLUMN_VALUES(writer, num_rows, int64_t, mpiTimeCI, records[row]->mpi_time_ci);
+
+#define WRITE_COLUMN(var_name, c_type, json_name, fmt) \
+    WRITE_COLUMN_VALUES(writer, num_rows, c_type, json_name, records[row]->monitor.var_name)
+    FOR_DLB_MONITOR_PRINTABLE_FIELDS(WRITE_COLUMN, WRITE_COLUMN)
+#undef WRITE_COLUMN
+
+    free(records);
+    free(region_names);
+}
+
+static void mpi_calls_to_binary(talp_binary_writer_t *writer) {
+
+    if (mpi_calls_records == NULL) return;
+
+    /* One row per region and MPI call, as in the CSV format */
+    size_t num_rows = 0;
+    for (GSList *node = mpi_calls_records; node != NULL; node = node->next) {
+        const mpi_calls_record_t *record = node->data;
+        num_rows += record->num_calls;
+    }
+    const mpi_calls_record_t **records = malloc(sizeof(mpi_calls_record_t*) * num_rows);
+    int *indices = malloc(sizeof(int) * num_rows);
+    size_t row = 0;
+    for (GSList *node = mpi_calls_records; node != NULL; node = node->next) {
+        const mpi_calls_record_t *record = node->data;
+        for (int i = 0; i < record->num_calls; ++i) {
+            records[row] = record;
+            indices[row] = i;
+            ++row;
+        }
+    }
+
+    talp_binary_writer_add_table(writer, "MpiCalls", 5, num_rows);
+
+    WRITE_STRING_COLUMN(writer, num_rows, regionName, records[row]->name);
+    WRITE_STRING_COLUMN(writer, num_rows, callType,
+            records[row]->calls[indices[row]].name);
+    WRITE_COLUMN_VALUES(writer, num_rows, int64_t, numCalls,
+            records[row]->calls[indices[row]].stats.num_calls);
+    WRITE_COLUMN_VALUES(writer, num_rows, int64_t, time,
+            records[row]->calls[indices[row]].stats.time);
+    WRITE_COLUMN_VALUES(writer, num_rows, int64_t, bufferBytes,
+            records[row]->calls[indices[row]].stats.bytes);
+
+    free(records);
+    free(indices);
+}
+
+#undef WRITE_STRING_COLUMN
+#undef WRITE_COLUMN_VALUES
+#undef COUNT_FIELD
+
+/* Build the whole file in memory and write it at once */
+static void records_to_binary(FILE *out_file) {
+
+    talp_binary_writer_t writer;
+    talp_binary_writer_init(&writer);
+
+    talp_binary_header_t header = {
+        .dlb_version        = talp_binary_writer_add_string(&writer,
+                                    common_record.dlb_version),
+        .timestamp          = talp_binary_writer_add_string(&writer,
+                                    common_record.time_of_creation),
+        .num_cpus           = resources_record.num_cpus,
+        .num_available_cpus = resources_record.num_available_cpus,
+        .num_nodes          = resources_record.num_nodes,
+        .num_mpi_ranks      = resources_record.num_mpi_ranks,
+        .num_gpus           = resources_record.num_gpus,
+        .hostname           = talp_binary_writer_add_string(&writer,
+                                    process_info_record.hostname),
+        .pid                = process_info_record.pid,
+    };
+
+    pop_metrics_to_binary(&writer);
+    node_to_binary(&writer);
+    process_to_binary(&writer);
+    mpi_calls_to_binary(&writer);
+
+    if (talp_binary_writer_write(&writer, &header, out_file) != 0) {
+        warning("Could not write TALP binary output: %s", strerror(errno));
+    }
+
+    talp_binary_writer_finalize(&writer);
+}
+
+
 /*********************************************************************************/
 /*    Helper functions                                                           */
 /*********************************************************************************/
@@ -1183,7 +1770,7 @@ static int mkdir_p(const char *path, mode_t mode) {
 }
 
 // open file for appending or writing, creating dirs as needed
-static FILE *open_file_with_dirs(const char *filename, bool *append) {
+FILE *talp_output_open_file(const char *filename, bool *append) {
     if (access(filename, F_OK) == 0) {
         FILE *f;
         if (append) {
@@ -1299,7 +1886,8 @@ static void sanitize_records(void) {
             node != NULL;
             node = node->next) {
 
-        dlb_pop_metrics_t *record = node->data;
+        pop_metrics_record_t *pop_record = node->data;
+        dlb_pop_metrics_t *record = &pop_record->metrics;
 
         for (size_t i = 0; i < COUNTERS_FIELDS_SIZE; ++i) {
             double *value = (double *)((char *)record + counters_fields[i].offset);
@@ -1329,22 +1917,33 @@ static void sanitize_records(void) {
 
         region_record_t *region_record = node->data;
 
-        for (int i = 0; i < region_record->num_mpi_ranks; ++i) {
+        for (int i = 0; i < region_record->num_records; ++i) {
 
             dlb_monitor_t *monitor = &region_record->process_records[i].monitor;
 
             for (size_t j = 0; j < MONITOR_COUNTERS_FIELDS_SIZE; ++j) {
                 double *value = (double *)((char *)monitor + monitor_counters_fields[j].offset);
-                sanitize_counter(counters_fields[i].name, value, monitor->name);
+                sanitize_counter(monitor_counters_fields[j].name, value, monitor->name);
             }
         }
     }
 }
 
+/* Return the extension of filename, ignoring the compression suffix, e.g.,
+ * ".json" for "talp.json.gz", or NULL if there is none */
+static const char* find_extension(const char *filename) {
+    const char *compression_suffix = talp_writer_compression_suffix(filename);
+    for (const char *c = compression_suffix; c > filename; --c) {
+        if (c[-1] == '.') return c - 1;
+        if (c[-1] == '/') break;
+    }
+    return NULL;
+}
+
 /* Return an allocated string: base + "_%h_%p.partial" + extension */
 static char *build_partial_template(const char *filename) {
 
-    const char *dot = strrchr(filename, '.');
+    const char *dot = find_extension(filename);
     size_t base_len = dot - filename;
     const char *ext = dot;
 
@@ -1389,8 +1988,40 @@ static const char *get_job_id(void) {
     return NULL;
 }
 
+void talp_output_json_string(FILE *out_file, const char *string) {
+    fputc('"', out_file);
+    for (const unsigned char *c = (const unsigned char*)string; *c != '\0'; ++c) {
+        switch (*c) {
+            case '"':  fputs("\\\"", out_file); break;
+            case '\\': fputs("\\\\", out_file); break;
+            case '\n': fputs("\\n", out_file); break;
+            case '\r': fputs("\\r", out_file); break;
+            case '\t': fputs("\\t", out_file); break;
+            default:
+                if (*c < 0x20) {
+                    fprintf(out_file, "\\u%04x", *c);
+                } else {
+                    fputc(*c, out_file);
+                }
+        }
+    }
+    fputc('"', out_file);
+}
+
+char* talp_output_csv_section_filename(const char *filename, const char *section) {
+    /* Length without extension, the compression suffix is kept */
+    const char *suffix = talp_writer_compression_suffix(filename);
+    int filename_useful_len = suffix - filename - strlen(".csv");
+    size_t len = filename_useful_len + strlen(section) + strlen(suffix)
+        + strlen("-.csv") + 1;
+    char *section_filename = malloc(sizeof(char)*len);
+    sprintf(section_filename, "%.*s-%s.csv%s", filename_useful_len, filename,
+            section, suffix);
+    return section_filename;
+}
+
 /* Expands output file, e.g.: talp_%p.json -> talp_123.json */
-static char *expand_output_filename(const char *template)
+char *talp_output_expand_filename(const char *template)
 {
     if (strchr(template, '%') == NULL) return NULL;
 
@@ -1481,6 +2112,14 @@ static char *expand_output_filename(const char *template)
     return output_filename;
 }
 
+/* Hand off the content written so far, so that the writer thread can write it
+ * while the next section is being formatted. Return the FILE to continue with */
+static FILE* flush_section(talp_writer_stream_t *stream, FILE *file) {
+    if (stream == NULL) return file;
+    talp_writer_flush(stream);
+    return talp_writer_file(stream);
+}
+
 void talp_output_finalize(const char *output_file, bool partial_output) {
 
     /* For efficiency when adding records, they are prepended to their respective lists.
@@ -1488,6 +2127,8 @@ void talp_output_finalize(const char *output_file, bool partial_output) {
     pop_metrics_records = g_slist_reverse(pop_metrics_records);
     node_records        = g_slist_reverse(node_records);
     region_records      = g_slist_reverse(region_records);
+    mpi_calls_records   = g_slist_reverse(mpi_calls_records);
+    process_sort();
 
     /* Sanitize erroneous values */
     sanitize_records();
@@ -1507,6 +2148,7 @@ void talp_output_finalize(const char *output_file, bool partial_output) {
         pop_metrics_print();
         node_print();
         process_print();
+        mpi_calls_print();
     } else {
         /* Do not open file if process has no data */
         if (pop_metrics_records == NULL
@@ -1519,16 +2161,20 @@ void talp_output_finalize(const char *output_file, bool partial_output) {
             EXT_XML,
             EXT_CSV,
             EXT_TXT,
+            EXT_BINARY,
         } extension_t;
         extension_t extension = EXT_TXT;
-        const char *ext = strrchr(output_file, '.');
+        const char *ext = find_extension(output_file);
         if (ext != NULL) {
-            if (strcmp(ext+1, "json") == 0) {
+            size_t ext_len = talp_writer_compression_suffix(output_file) - ext;
+            if (strncmp(ext, ".json", ext_len) == 0) {
                 extension = EXT_JSON;
-            } else if (strcmp(ext+1, "xml") == 0) {
+            } else if (strncmp(ext, ".xml", ext_len) == 0) {
                 extension = EXT_XML;
-            } else if (strcmp(ext+1, "csv") == 0) {
+            } else if (strncmp(ext, ".csv", ext_len) == 0) {
                 extension = EXT_CSV;
+            } else if (strncmp(ext, ".talp", ext_len) == 0) {
+                extension = EXT_BINARY;
             }
         }
 
@@ -1555,7 +2201,7 @@ void talp_output_finalize(const char *output_file, bool partial_output) {
             template = strdup(output_file);
         }
 
-        filename = expand_output_filename(template);
+        filename = talp_output_expand_filename(template);
 
         if (filename != NULL) {
             output_file = filename;
@@ -1563,77 +2209,98 @@ void talp_output_finalize(const char *output_file, bool partial_output) {
 
         free(template);
 
-        /* Specific case where output file needs to be split */
+        /* Specific case where output file needs to be split. The process
+         * records may have been written to their file by all ranks */
         if (extension == EXT_CSV
                 && !!(pop_metrics_records != NULL)
                     + !!(node_records != NULL)
-                    + !!(region_records != NULL) > 1) {
-
-            /* Length without extension */
-            int filename_useful_len = ext - output_file;
+                    + !!(region_records != NULL || process_records_external)
+                    + !!(mpi_calls_records != NULL) > 1) {
 
             /* POP */
             if (pop_metrics_records != NULL) {
-                const char *pop_ext = "-pop.csv";
-                size_t pop_file_len = filename_useful_len + strlen(pop_ext) + 1;
-                char *pop_filename = malloc(sizeof(char)*pop_file_len);
-                sprintf(pop_filename, "%.*s%s", filename_useful_len, output_file, pop_ext);
+                char *pop_filename = talp_output_csv_section_filename(output_file, "pop");
                 bool append_to_csv;
-                FILE *pop_file = open_file_with_dirs(pop_filename, &append_to_csv);
-                if (pop_file) {
-                    pop_metrics_to_csv(pop_file, append_to_csv);
-                    fclose(pop_file);
+                talp_writer_stream_t *pop_stream =
+                    talp_writer_open(pop_filename, &append_to_csv);
+                if (pop_stream) {
+                    pop_metrics_to_csv(talp_writer_file(pop_stream), append_to_csv);
+                    talp_writer_close(pop_stream);
                 } else {
                     warning("Writing metrics to stdout instead:");
                     pop_metrics_to_csv(stdout, /* append: */ false);
                 }
+                free(pop_filename);
             }
 
             /* Node */
             if (node_records != NULL) {
-                const char *node_ext = "-node.csv";
-                size_t node_file_len = filename_useful_len + strlen(node_ext) + 1;
-                char *node_filename = malloc(sizeof(char)*node_file_len);
-                sprintf(node_filename, "%.*s%s", filename_useful_len, output_file, node_ext);
+                char *node_filename = talp_output_csv_section_filename(output_file, "node");
                 bool append_to_csv;
-                FILE *node_file = open_file_with_dirs(node_filename, &append_to_csv);
-                if (node_file) {
-                    node_to_csv(node_file, append_to_csv);
-                    fclose(node_file);
+                talp_writer_stream_t *node_stream =
+                    talp_writer_open(node_filename, &append_to_csv);
+                if (node_stream) {
+                    node_to_csv(talp_writer_file(node_stream), append_to_csv);
+                    talp_writer_close(node_stream);
                 } else {
                     warning("Writing metrics to stdout instead:");
                     node_to_csv(stdout, /* append: */ false);
                 }
+                free(node_filename);
             }
 
             /* Process */
             if (region_records != NULL) {
-                const char *process_ext = "-process.csv";
-                size_t process_file_len = filename_useful_len + strlen(process_ext) + 1;
-                char *process_filename = malloc(sizeof(char)*process_file_len);
-                sprintf(process_filename, "%.*s%s", filename_useful_len, output_file, process_ext);
+                char *process_filename = talp_output_csv_section_filename(output_file,
+                        "process");
                 bool append_to_csv;
-                FILE *process_file = open_file_with_dirs(process_filename, &append_to_csv);
-                if (process_file) {
-                    process_to_csv(process_file, append_to_csv);
-                    fclose(process_file);
+                talp_writer_stream_t *process_stream =
+                    talp_writer_open(process_filename, &append_to_csv);
+                if (process_stream) {
+                    process_to_csv(talp_writer_file(process_stream), append_to_csv);
+                    talp_writer_close(process_stream);
                 } else {
                     warning("Writing metrics to stdout instead:");
                     process_to_csv(stdout, /* append: */ false);
                 }
+                free(process_filename);
+            }
+
+            /* MPI calls */
+            if (mpi_calls_records != NULL) {
+                char *mpi_filename = talp_output_csv_section_filename(output_file, "mpi");
+                bool append_to_csv;
+                talp_writer_stream_t *mpi_stream =
+                    talp_writer_open(mpi_filename, &append_to_csv);
+                if (mpi_stream) {
+                    mpi_calls_to_csv(talp_writer_file(mpi_stream), append_to_csv);
+                    talp_writer_close(mpi_stream);
+                } else {
+                    warning("Writing metrics to stdout instead:");
+                    mpi_calls_to_csv(stdout, /* append: */ false);
+                }
+                free(mpi_filename);
             }
         }
 
         /* Write to file */
         else {
-            /* Open file */
+            /* Open file. The content is formatted in memory and written,
+             * possibly compressed, by the TALP writer thread */
             bool append_to_csv;
-            FILE *out_file = open_file_with_dirs(output_file,
+            talp_writer_stream_t *out_stream = talp_writer_open(output_file,
                     extension == EXT_CSV ? &append_to_csv : NULL);
-            if (!out_file) {
+            FILE *out_file;
+            if (out_stream) {
+                out_file = talp_writer_file(out_stream);
+            } else {
                 warning("Writing metrics to stdout instead:");
                 out_file = stdout;
                 append_to_csv = false;
+                /* Do not write binary data to stdout */
+                if (extension == EXT_BINARY) {
+                    extension = EXT_TXT;
+                }
             }
 
             /* Write records to file */
@@ -1644,28 +2311,38 @@ void talp_output_finalize(const char *output_file, bool partial_output) {
                     resources_to_json(out_file);
                     process_info_to_json(out_file);
                     pop_metrics_to_json(out_file);
+                    out_file = flush_section(out_stream, out_file);
                     node_to_json(out_file);
+                    out_file = flush_section(out_stream, out_file);
                     process_to_json(out_file);
+                    mpi_calls_to_json(out_file);
                     json_footer(out_file);
                     break;
                 case EXT_CSV:
                     pop_metrics_to_csv(out_file, append_to_csv);
                     node_to_csv(out_file, append_to_csv);
                     process_to_csv(out_file, append_to_csv);
+                    mpi_calls_to_csv(out_file, append_to_csv);
+                    break;
+                case EXT_BINARY:
+                    records_to_binary(out_file);
                     break;
                 case EXT_XML:
                 case EXT_TXT:
                     common_to_txt(out_file);
                     resources_to_txt(out_file);
                     pop_metrics_to_txt(out_file);
+                    out_file = flush_section(out_stream, out_file);
                     node_to_txt(out_file);
+                    out_file = flush_section(out_stream, out_file);
                     process_to_txt(out_file);
+                    mpi_calls_to_txt(out_file);
                     break;
             }
 
             /* Close file */
-            if (out_file != stdout) {
-                fclose(out_file);
+            if (out_stream) {
+                talp_writer_close(out_stream);
             }
         }
 
@@ -1683,4 +2360,5 @@ void talp_output_finalize(const char *output_file, bool partial_output) {
     pop_metrics_finalize();
     node_finalize();
     process_finalize();
+    mpi_calls_finalize();
 }
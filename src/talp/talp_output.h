@@ -25,8 +25,11 @@
 #include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 typedef struct talp_flags_t talp_flags_t;
+typedef struct mpi_call_stats_t mpi_call_stats_t;
+typedef struct pop_metrics_ci_t pop_metrics_ci_t;
 
 typedef enum gpu_vendor {
     GPU_VENDOR_NONE,
@@ -58,6 +61,7 @@ typedef struct process_record_t {
     char hostname[HOST_NAME_MAX];
     char cpuset[TALP_OUTPUT_CPUSET_MAX];
     char cpuset_quoted[TALP_OUTPUT_CPUSET_MAX];
+    int64_t mpi_time_ci;    /* see region_get_mpi_time_ci */
     dlb_monitor_t monitor;
 } process_record_t;
 
@@ -66,18 +70,51 @@ void talp_output_record_gpu_vendor(gpu_vendor_t vendor);
 
 void talp_output_print_monitoring_region(const dlb_monitor_t *monitor, talp_flags_t talp_flags);
 
-void talp_output_record_pop_metrics(const dlb_pop_metrics_t *metrics);
+/* Record the POP metrics of a region, and their confidence intervals if they
+ * are estimated by statistical sampling, or NULL otherwise */
+void talp_output_record_pop_metrics(const dlb_pop_metrics_t *metrics,
+        const pop_metrics_ci_t *ci);
 
 void talp_output_record_node(const node_record_t *node_record);
 
+/* Record the breakdown of MPI calls of a region, the statistics of num_calls
+ * MPI calls named after call_names. Calls that have not been called and
+ * regions without MPI calls are not recorded */
+void talp_output_record_mpi_calls(const char *region_name, int num_calls,
+        const char *const *call_names, const mpi_call_stats_t *mpi_calls);
+
 void talp_output_record_process(const char *monitor_name,
         const process_record_t *process_record, int num_mpi_ranks);
 
+/* The per-process records have been written to their CSV file by other means,
+ * see talp_record_process_collective. The CSV output is split accordingly */
+void talp_output_record_process_external(void);
+
+/* Print the CSV header and one CSV row of the per-process records */
+void talp_output_process_csv_header(FILE *out_file);
+void talp_output_process_csv_row(FILE *out_file, const char *region_name,
+        const process_record_t *process_record);
+
 void talp_output_record_resources(int num_cpus, int num_available_cpus, int num_nodes,
         int num_mpi_ranks, int num_gpus);
 
 void talp_output_record_process_info(void);
 
+/* Print string as a quoted JSON string, escaping the characters that need it */
+void talp_output_json_string(FILE *out_file, const char *string);
+
+/* Return the allocated filename of a section of the CSV output when it is
+ * split in several files, e.g., talp.csv -> talp-pop.csv */
+char *talp_output_csv_section_filename(const char *filename, const char *section);
+
+/* Return the allocated filename with the replacement tokens expanded, or NULL
+ * if the template has no tokens */
+char *talp_output_expand_filename(const char *template);
+
+/* Open file for writing, or for appending if append is not NULL and the file
+ * exists, creating the parent directories if needed */
+FILE *talp_output_open_file(const char *filename, bool *append);
+
 void talp_output_finalize(const char *output_file, bool partial_output);
 
 #endif /* TALP_OUTPUT_H */
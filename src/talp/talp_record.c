@@ -22,8 +22,10 @@
 #include "LB_comm/shmem_talp.h"
 #include "LB_core/node_barrier.h"
 #include "LB_core/spd.h"
+#include "apis/dlb_errors.h"
 #include "apis/dlb_talp.h"
 #include "support/debug.h"
+#include "support/gtree.h"
 #include "support/mask_utils.h"
 #include "support/options.h"
 #include "talp/perf_metrics.h"
@@ -34,8 +36,14 @@
 #include "mpi/mpi_core.h"
 #endif
 
+#include <inttypes.h>
+#include <limits.h>
+#include <locale.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 
@@ -70,6 +78,7 @@ void talp_record_monitor(const subprocess_descriptor_t *spd,
         process_record_t process_record = {
             .rank = rank,
             .pid = spd->id,
+            .mpi_time_ci = region_get_mpi_time_ci(monitor),
             .monitor = *monitor,
         };
 
@@ -95,18 +104,36 @@ void talp_record_monitor(const subprocess_descriptor_t *spd,
 
             dlb_pop_metrics_t pop_metrics;
             perf_metrics__base_to_pop_metrics(monitor->name, &base_metrics, &pop_metrics);
-            talp_output_record_pop_metrics(&pop_metrics);
+            pop_metrics_ci_t ci;
+            perf_metrics__base_to_pop_metrics_ci(&base_metrics, &ci);
+            talp_output_record_pop_metrics(&pop_metrics,
+                    talp_info->flags.sampling ? &ci : NULL);
 
             if (monitor == talp_info->monitor) {
                 talp_output_record_resources(monitor->num_cpus, mu_get_system_count(),
                         num_nodes, num_ranks, base_metrics.num_gpus);
             }
 
+            if (talp_info->flags.mpi_breakdown) {
+                const monitor_data_t *monitor_data = monitor->_data;
+                const char *call_names[MPI_NUM_CALL_SLOTS];
+                for (int slot = 0; slot < MPI_NUM_CALL_SLOTS; ++slot) {
+#ifdef MPI_LIB
+                    call_names[slot] = get_mpi_call_name(get_mpi_call_slot_id(slot));
+#else
+                    /* MPI calls are only intercepted by the MPI library */
+                    call_names[slot] = "Other";
+#endif
+                }
+                talp_output_record_mpi_calls(monitor->name, MPI_NUM_CALL_SLOTS,
+                        call_names, monitor_data->mpi_calls);
+            }
+
         } else {
             verbose(VB_TALP, "TALP summary: recording empty region %s", monitor->name);
             dlb_pop_metrics_t pop_metrics = {0};
             snprintf(pop_metrics.name, DLB_MONITOR_NAME_MAX, "%s", monitor->name);
-            talp_output_record_pop_metrics(&pop_metrics);
+            talp_output_record_pop_metrics(&pop_metrics, NULL);
         }
     }
 }
@@ -247,7 +274,101 @@ void talp_record_node_summary(const subprocess_descriptor_t *spd) {
     }
 }
 
-/* Gather PROCESS data of a monitor among all ranks and record it in rank 0 */
+/* Compact version of process_record_t used in the process summary gather.
+ * Strings are offsets into the string table of the node, where the first
+ * string is always the hostname */
+typedef struct process_summary_record_t {
+    int rank;
+    pid_t pid;
+    int cpuset;
+    int cpuset_quoted;
+    int64_t mpi_time_ci;
+    dlb_monitor_t monitor;
+} process_summary_record_t;
+
+/* Deduplicated table of NUL-terminated strings */
+typedef struct string_table_t {
+    char *data;
+    int size;
+    int capacity;
+    GTree *index;   /* string -> offset + 1 */
+} string_table_t;
+
+static gint key_compare_func(gconstpointer a, gconstpointer b, gpointer user_data) {
+    return strcmp(a, b);
+}
+
+static void string_table_init(string_table_t *table) {
+    *table = (const string_table_t) {
+        .index = g_tree_new_full((GCompareDataFunc)key_compare_func, NULL, free, NULL),
+    };
+}
+
+static void string_table_finalize(string_table_t *table) {
+    g_tree_destroy(table->index);
+    free(table->data);
+    *table = (const string_table_t) {};
+}
+
+/* Return the offset of the string in the table, adding it if needed */
+static int string_table_add(string_table_t *table, const char *string) {
+
+    gpointer value = g_tree_lookup(table->index, string);
+    if (value != NULL) {
+        return (int)((uintptr_t)value - 1);
+    }
+
+    int len = strlen(string) + 1;
+    if (table->size + len > table->capacity) {
+        int new_capacity = table->capacity > 0 ? table->capacity : 1024;
+        while (new_capacity < table->size + len) new_capacity *= 2;
+        table->data = realloc(table->data, new_capacity);
+        fatal_cond(table->data == NULL, "Could not allocate TALP process summary");
+        table->capacity = new_capacity;
+    }
+
+    int offset = table->size;
+    memcpy(table->data + offset, string, len);
+    table->size += len;
+
+    g_tree_insert(table->index, strdup(string), (gpointer)((uintptr_t)offset + 1));
+
+    return offset;
+}
+
+/* Expand the compacted records of a node and add them to the output */
+static void record_node_summary(const char *region_name, int node_id,
+        const process_summary_record_t *records, int num_records,
+        const char *node_table) {
+
+    process_record_t process_record;
+    for (int i = 0; i < num_records; ++i) {
+        const process_summary_record_t *record = &records[i];
+        verbose(VB_TALP, "Process summary: recording region %s on rank %d",
+                region_name, record->rank);
+        process_record.rank = record->rank;
+        process_record.pid = record->pid;
+        process_record.node_id = node_id;
+        process_record.mpi_time_ci = record->mpi_time_ci;
+        process_record.monitor = record->monitor;
+        snprintf(process_record.hostname, HOST_NAME_MAX, "%s",
+                node_table);
+        snprintf(process_record.cpuset, TALP_OUTPUT_CPUSET_MAX, "%s",
+                node_table + record->cpuset);
+        snprintf(process_record.cpuset_quoted, TALP_OUTPUT_CPUSET_MAX, "%s",
+                node_table + record->cpuset_quoted);
+        talp_output_record_process(region_name, &process_record, _mpi_size);
+    }
+}
+
+/* Gather PROCESS data of a monitor among all ranks and record it in rank 0.
+ *
+ * The gather is performed in two levels so that rank 0 only receives one
+ * message per node: each node leader first gathers the records of its node
+ * and builds a deduplicated string table with the hostname and the CPU sets,
+ * then rank 0 receives the compacted data of one node leader at a time. The
+ * output still keeps one record per rank in rank 0, which is avoided with
+ * talp_record_process_collective. */
 void talp_record_process_summary(const subprocess_descriptor_t *spd,
         const dlb_monitor_t *monitor) {
 
@@ -262,23 +383,27 @@ void talp_record_process_summary(const subprocess_descriptor_t *spd,
         verbose(VB_TALP, "Process summary: gathering region %s", monitor->name);
     }
 
-    process_record_t process_record_send = {
+    /* Local strings, sent as "cpuset\0cpuset_quoted\0" */
+    char strings[TALP_OUTPUT_CPUSET_MAX * 2];
+    int cpuset_len = snprintf(strings, TALP_OUTPUT_CPUSET_MAX, "%s",
+            mu_to_str(&monitor_data->cpu_mask));
+    cpuset_len = min_int(cpuset_len, TALP_OUTPUT_CPUSET_MAX - 1) + 1;
+    mu_get_quoted_mask(&monitor_data->cpu_mask,
+            strings + cpuset_len, TALP_OUTPUT_CPUSET_MAX);
+    int strings_len = cpuset_len + strlen(strings + cpuset_len) + 1;
+
+    process_summary_record_t record_send = {
         .rank = _mpi_rank,
         .pid = spd->id,
-        .node_id = _node_id,
+        .cpuset = 0,
+        .cpuset_quoted = cpuset_len,
+        .mpi_time_ci = region_get_mpi_time_ci(monitor),
         .monitor = *monitor,
     };
 
     /* Invalidate pointers of the copied monitor */
-    process_record_send.monitor.name = NULL;
-    process_record_send.monitor._data = NULL;
-
-    /* Fill hostname and CPU mask strings in process_record_send */
-    gethostname(process_record_send.hostname, HOST_NAME_MAX);
-    snprintf(process_record_send.cpuset, TALP_OUTPUT_CPUSET_MAX, "%s",
-            mu_to_str(&monitor_data->cpu_mask));
-    mu_get_quoted_mask(&monitor_data->cpu_mask,
-            process_record_send.cpuset_quoted, TALP_OUTPUT_CPUSET_MAX);
+    record_send.monitor.name = NULL;
+    record_send.monitor._data = NULL;
 
     /* MPI type: int64_t */
     MPI_Datatype mpi_int64_type = get_mpi_int64_type();
@@ -324,46 +449,124 @@ void talp_record_process_summary(const subprocess_descriptor_t *spd,
         PMPI_Type_commit(&mpi_dlb_monitor_type);
     }
 
-    /* MPI struct type: process_record_t */
+    /* MPI struct type: process_summary_record_t */
     MPI_Datatype mpi_process_record_type;
     {
-        int count = 7;
-        int blocklengths[] = {1, 1, 1, HOST_NAME_MAX,
-            TALP_OUTPUT_CPUSET_MAX, TALP_OUTPUT_CPUSET_MAX, 1};
+        int count = 6;
+        int blocklengths[] = {1, 1, 1, 1, 1, 1};
         MPI_Aint displacements[] = {
-            offsetof(process_record_t, rank),
-            offsetof(process_record_t, pid),
-            offsetof(process_record_t, node_id),
-            offsetof(process_record_t, hostname),
-            offsetof(process_record_t, cpuset),
-            offsetof(process_record_t, cpuset_quoted),
-            offsetof(process_record_t, monitor)};
-        MPI_Datatype types[] = {MPI_INT, mpi_pid_type, MPI_INT, MPI_CHAR, MPI_CHAR,
-            MPI_CHAR, mpi_dlb_monitor_type};
+            offsetof(process_summary_record_t, rank),
+            offsetof(process_summary_record_t, pid),
+            offsetof(process_summary_record_t, cpuset),
+            offsetof(process_summary_record_t, cpuset_quoted),
+            offsetof(process_summary_record_t, mpi_time_ci),
+            offsetof(process_summary_record_t, monitor)};
+        MPI_Datatype types[] = {MPI_INT, mpi_pid_type, MPI_INT, MPI_INT,
+            mpi_int64_type, mpi_dlb_monitor_type};
         MPI_Datatype tmp_type;
         PMPI_Type_create_struct(count, blocklengths, displacements, types, &tmp_type);
-        PMPI_Type_create_resized(tmp_type, 0, sizeof(process_record_t),
+        PMPI_Type_create_resized(tmp_type, 0, sizeof(process_summary_record_t),
                 &mpi_process_record_type);
         PMPI_Type_commit(&mpi_process_record_type);
     }
 
-    /* Gather data */
-    process_record_t *recvbuf = NULL;
-    if (_mpi_rank == 0) {
-        recvbuf = malloc(_mpi_size * sizeof(process_record_t));
+    /* First level: the node leader gathers the records and strings of its node */
+    MPI_Comm node_comm = getNodeComm();
+    int node_size;
+    PMPI_Comm_size(node_comm, &node_size);
+
+    process_summary_record_t *node_records = NULL;
+    int *strings_lens = NULL;
+    int *strings_displs = NULL;
+    char *node_strings = NULL;
+    if (_process_id == 0) {
+        node_records = malloc(node_size * sizeof(process_summary_record_t));
+        strings_lens = malloc(node_size * sizeof(int));
+        strings_displs = malloc(node_size * sizeof(int));
+    }
+    PMPI_Gather(&record_send, 1, mpi_process_record_type,
+            node_records, 1, mpi_process_record_type,
+            0, node_comm);
+    PMPI_Gather(&strings_len, 1, MPI_INT,
+            strings_lens, 1, MPI_INT,
+            0, node_comm);
+    if (_process_id == 0) {
+        int total_len = 0;
+        for (int i = 0; i < node_size; ++i) {
+            strings_displs[i] = total_len;
+            total_len += strings_lens[i];
+        }
+        node_strings = malloc(total_len);
     }
-    PMPI_Gather(&process_record_send, 1, mpi_process_record_type,
-            recvbuf, 1, mpi_process_record_type,
-            0, getWorldComm());
+    PMPI_Gatherv(strings, strings_len, MPI_CHAR,
+            node_strings, strings_lens, strings_displs, MPI_CHAR,
+            0, node_comm);
 
-    /* Add records */
-    if (_mpi_rank == 0) {
-        for (int rank = 0; rank < _mpi_size; ++rank) {
-            verbose(VB_TALP, "Process summary: recording region %s on rank %d",
-                    monitor->name, rank);
-            talp_output_record_process(monitor->name, &recvbuf[rank], _mpi_size);
+    /* Second level: rank 0 receives the compacted data of every node leader */
+    if (_process_id == 0) {
+
+        /* Build the string table of the node and translate the record offsets */
+        string_table_t string_table;
+        string_table_init(&string_table);
+        char hostname[HOST_NAME_MAX] = "";
+        gethostname(hostname, HOST_NAME_MAX);
+        string_table_add(&string_table, hostname);
+        for (int i = 0; i < node_size; ++i) {
+            const char *base = node_strings + strings_displs[i];
+            node_records[i].cpuset = string_table_add(&string_table,
+                    base + node_records[i].cpuset);
+            node_records[i].cpuset_quoted = string_table_add(&string_table,
+                    base + node_records[i].cpuset_quoted);
         }
-        free(recvbuf);
+        free(node_strings);
+        free(strings_lens);
+        free(strings_displs);
+
+        MPI_Comm internode_comm = getInterNodeComm();
+        if (_mpi_rank == 0) {
+            /* Own node first, then one node at a time, so that the receive
+             * buffers only hold the records of the largest node */
+            record_node_summary(monitor->name, 0, node_records, node_size,
+                    string_table.data);
+            process_summary_record_t *records = NULL;
+            char *table = NULL;
+            int records_capacity = 0;
+            int table_capacity = 0;
+            for (int node_id = 1; node_id < _num_nodes; ++node_id) {
+                int node_sizes[2];
+                PMPI_Recv(node_sizes, 2, MPI_INT, node_id, 0, internode_comm,
+                        MPI_STATUS_IGNORE);
+                if (node_sizes[0] > records_capacity) {
+                    records_capacity = node_sizes[0];
+                    free(records);
+                    records = malloc(records_capacity * sizeof(process_summary_record_t));
+                }
+                if (node_sizes[1] > table_capacity) {
+                    table_capacity = node_sizes[1];
+                    free(table);
+                    table = malloc(table_capacity);
+                }
+                fatal_cond(records == NULL || table == NULL,
+                        "Could not allocate TALP process summary");
+                PMPI_Recv(records, node_sizes[0], mpi_process_record_type, node_id, 0,
+                        internode_comm, MPI_STATUS_IGNORE);
+                PMPI_Recv(table, node_sizes[1], MPI_CHAR, node_id, 0,
+                        internode_comm, MPI_STATUS_IGNORE);
+                record_node_summary(monitor->name, node_id, records, node_sizes[0],
+                        table);
+            }
+            free(records);
+            free(table);
+        } else {
+            int node_sizes[2] = {node_size, string_table.size};
+            PMPI_Send(node_sizes, 2, MPI_INT, 0, 0, internode_comm);
+            PMPI_Send(node_records, node_size, mpi_process_record_type, 0, 0,
+                    internode_comm);
+            PMPI_Send(string_table.data, string_table.size, MPI_CHAR, 0, 0,
+                    internode_comm);
+        }
+        free(node_records);
+        string_table_finalize(&string_table);
     }
 
     /* Free MPI types */
@@ -371,52 +574,327 @@ void talp_record_process_summary(const subprocess_descriptor_t *spd,
     PMPI_Type_free(&mpi_process_record_type);
 }
 
-/* Gather POP METRICS data of a monitor among all ranks and record it in rank 0 */
-void talp_record_pop_summary(const subprocess_descriptor_t *spd,
-        const dlb_monitor_t *monitor) {
+/* Collective output of PROCESS data
+ *
+ * The CSV rows of each rank are written with MPI-IO at the offset given by
+ * the prefix sum of the sizes of the preceding ranks, followed by an index
+ * of fixed-width lines, one per rank, and a fixed-width trailer:
+ *
+ *   "# <rank> <offset> <size>\n"               (TALP_COLLECTIVE_INDEX_ENTRY_LEN)
+ *   "#TALP_INDEX <index_offset> <num_ranks>\n" (TALP_COLLECTIVE_INDEX_TRAILER_LEN)
+ *
+ * The rows of rank r can then be read after reading the trailer and the
+ * entry at index_offset + r * TALP_COLLECTIVE_INDEX_ENTRY_LEN. */
+enum { TALP_COLLECTIVE_INDEX_ENTRY_LEN = 55 };
+enum { TALP_COLLECTIVE_INDEX_TRAILER_LEN = 44 };
+
+/* Return the allocated name of the collective output file. Only valid in rank 0 */
+static char* get_collective_filename(const subprocess_descriptor_t *spd) {
+
+    const char *output_file = spd->options.talp_output_file;
+    char *filename = talp_output_expand_filename(output_file);
+    if (filename == NULL) {
+        filename = strdup(output_file);
+    }
 
-    /* Internal monitors will not be recorded */
-    if (((monitor_data_t*)monitor->_data)->flags.internal) {
-        return;
+    /* Same naming as the CSV output when it is split in several files */
+    if (spd->options.talp_summary & (SUMMARY_POP_METRICS | SUMMARY_NODE)) {
+        char *process_filename = talp_output_csv_section_filename(filename, "process");
+        free(filename);
+        filename = process_filename;
     }
 
+    return filename;
+}
+
+/* Write PROCESS data of all monitors from every rank to a single file, using
+ * MPI-IO collective writes. Return DLB_SUCCESS, or an error code if the
+ * output file could not be written and the process summary must be gathered */
+int talp_record_process_collective(const subprocess_descriptor_t *spd) {
+
+    const char *output_file = spd->options.talp_output_file;
+    const char *ext = output_file != NULL ? strrchr(output_file, '.') : NULL;
+    if (ext == NULL || strcmp(ext, ".csv") != 0) {
+        if (_mpi_rank == 0) {
+            warning("Option --talp-collective-output is only supported for CSV format."
+                    " Disabling option");
+        }
+        return DLB_ERR_NOCOMP;
+    }
+
+    MPI_Comm comm = getWorldComm();
+
+    /* Rank 0 creates the file, or appends to it as the CSV output does, and
+     * broadcasts its name and the offset where the new data starts */
+    char filename[PATH_MAX] = "";
+    uint64_t base_offset = 0;
     if (_mpi_rank == 0) {
-        verbose(VB_TALP, "TALP summary: gathering region %s", monitor->name);
+        char *collective_filename = get_collective_filename(spd);
+        bool append;
+        FILE *file = talp_output_open_file(collective_filename, &append);
+        if (file != NULL) {
+            fseek(file, 0, SEEK_END);
+            base_offset = ftell(file);
+            fclose(file);
+            snprintf(filename, PATH_MAX, "%s", collective_filename);
+        }
+        free(collective_filename);
+    }
+    PMPI_Bcast(filename, PATH_MAX, MPI_CHAR, 0, comm);
+    PMPI_Bcast(&base_offset, 1, MPI_UINT64_T, 0, comm);
+    if (filename[0] == '\0') {
+        return DLB_ERR_PERM;
+    }
+
+    MPI_File fh;
+    int error = PMPI_File_open(comm, filename, MPI_MODE_WRONLY,
+            MPI_INFO_NULL, &fh);
+    if (error != MPI_SUCCESS) {
+        if (_mpi_rank == 0) {
+            warning("Cannot open file %s with MPI-IO", filename);
+        }
+        return DLB_ERR_PERM;
+    }
+
+    verbose(VB_TALP, "Process summary: writing records to %s", filename);
+
+    /* Print floats with the expected notation, see talp_output_finalize */
+    locale_t new_locale = newlocale(LC_ALL, "C", 0);
+    locale_t prev_locale = uselocale(new_locale);
+
+    /* Format the local records */
+    char *buffer = NULL;
+    size_t buffer_size = 0;
+    FILE *stream = open_memstream(&buffer, &buffer_size);
+    if (_mpi_rank == 0 && base_offset == 0) {
+        talp_output_process_csv_header(stream);
     }
 
     talp_info_t *talp_info = spd->talp_info;
+    for (GTreeNode *node = g_tree_node_first(talp_info->regions);
+            node != NULL;
+            node = g_tree_node_next(node)) {
+        const dlb_monitor_t *monitor = g_tree_node_value(node);
+        monitor_data_t *monitor_data = monitor->_data;
+
+        /* Internal monitors will not be recorded */
+        if (monitor_data->flags.internal) continue;
+
+        process_record_t process_record = {
+            .rank = _mpi_rank,
+            .pid = spd->id,
+            .node_id = _node_id,
+            .mpi_time_ci = region_get_mpi_time_ci(monitor),
+            .monitor = *monitor,
+        };
+        gethostname(process_record.hostname, HOST_NAME_MAX);
+        snprintf(process_record.cpuset, TALP_OUTPUT_CPUSET_MAX, "%s",
+                mu_to_str(&monitor_data->cpu_mask));
+        mu_get_quoted_mask(&monitor_data->cpu_mask,
+                process_record.cpuset_quoted, TALP_OUTPUT_CPUSET_MAX);
+
+        talp_output_process_csv_row(stream, monitor->name, &process_record);
+    }
+    fclose(stream);
+
+    /* Compute the offset of the local rows and the offset of the index */
+    uint64_t size = buffer_size;
+    uint64_t offset = 0;
+    uint64_t index_offset = 0;
+    PMPI_Exscan(&size, &offset, 1, MPI_UINT64_T, MPI_SUM, comm);
+    if (_mpi_rank == 0) offset = 0;
+    PMPI_Allreduce(&size, &index_offset, 1, MPI_UINT64_T, MPI_SUM, comm);
+    offset += base_offset;
+    index_offset += base_offset;
+
+    /* Write rows */
+    ensure( buffer_size <= INT_MAX, "TALP collective output too large in %s", __func__ );
+    PMPI_File_write_at_all(fh, offset, buffer, (int)buffer_size, MPI_CHAR,
+            MPI_STATUS_IGNORE);
+    free(buffer);
+
+    /* Write index entry */
+    char entry[TALP_COLLECTIVE_INDEX_ENTRY_LEN + 1];
+    snprintf(entry, sizeof(entry), "# %10d %20"PRIu64" %20"PRIu64"\n",
+            _mpi_rank, offset, size);
+    PMPI_File_write_at_all(fh,
+            index_offset + (uint64_t)_mpi_rank * TALP_COLLECTIVE_INDEX_ENTRY_LEN,
+            entry, TALP_COLLECTIVE_INDEX_ENTRY_LEN, MPI_CHAR, MPI_STATUS_IGNORE);
+
+    /* Write trailer */
+    if (_mpi_rank == 0) {
+        char trailer[TALP_COLLECTIVE_INDEX_TRAILER_LEN + 1];
+        snprintf(trailer, sizeof(trailer), "#TALP_INDEX %20"PRIu64" %10d\n",
+                index_offset, _mpi_size);
+        PMPI_File_write_at(fh,
+                index_offset + (uint64_t)_mpi_size * TALP_COLLECTIVE_INDEX_ENTRY_LEN,
+                trailer, TALP_COLLECTIVE_INDEX_TRAILER_LEN, MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+
+    PMPI_File_close(&fh);
+
+    uselocale(prev_locale);
+    freelocale(new_locale);
+
+    /* Rank 0 splits the rest of the CSV output as if it had the records */
+    if (_mpi_rank == 0) {
+        talp_output_record_process_external();
+    }
+
+    return DLB_SUCCESS;
+}
 
-    /* Reduce monitor among all MPI ranks into MPI rank 0 */
-    pop_base_metrics_t base_metrics;
-    perf_metrics__reduce_monitor_into_base_metrics(&base_metrics, monitor, false);
+/* Gather POP METRICS data of all monitors among all ranks and record it in
+ * rank 0. All monitors are reduced at once with a single reduction */
+/* The slots of the breakdown of MPI calls are assigned in order of first use
+ * in each process, so the breakdown is reduced by MPI call. The calls used by
+ * any process are agreed first, and only those are reduced. Rank 0 obtains
+ * the list of MPI calls and an array of nmonitors x num_call_ids statistics */
+static void reduce_mpi_calls(const dlb_monitor_t **monitors, int nmonitors,
+        int *num_call_ids, mpi_call_id_t **call_ids, mpi_call_stats_t **mpi_calls) {
+
+    /* Bitmap of the MPI calls used by any process */
+    enum { CALL_IDS_MASK_LEN = (MPI_NUM_CALL_IDS + 63) / 64 };
+    uint64_t local_mask[CALL_IDS_MASK_LEN] = {0};
+    uint64_t global_mask[CALL_IDS_MASK_LEN];
+    mpi_call_id_t slot_ids[MPI_NUM_CALL_SLOTS];
+    for (int slot = 0; slot < MPI_NUM_CALL_SLOTS; ++slot) {
+        slot_ids[slot] = get_mpi_call_slot_id(slot);
+        for (int i = 0; i < nmonitors; ++i) {
+            const monitor_data_t *monitor_data = monitors[i]->_data;
+            if (monitor_data->mpi_calls[slot].num_calls > 0) {
+                local_mask[slot_ids[slot] / 64] |= UINT64_C(1) << (slot_ids[slot] % 64);
+                break;
+            }
+        }
+    }
+    PMPI_Allreduce(local_mask, global_mask, CALL_IDS_MASK_LEN,
+            get_mpi_uint64_type(), MPI_BOR, getWorldComm());
+
+    /* Same list of MPI calls in all processes, in call id order */
+    int num_ids = 0;
+    int *id_index = malloc(sizeof(int) * MPI_NUM_CALL_IDS);
+    mpi_call_id_t *ids = malloc(sizeof(mpi_call_id_t) * MPI_NUM_CALL_IDS);
+    for (int id = 0; id < MPI_NUM_CALL_IDS; ++id) {
+        if (global_mask[id / 64] & (UINT64_C(1) << (id % 64))) {
+            id_index[id] = num_ids;
+            ids[num_ids++] = id;
+        }
+    }
 
+    size_t mpi_calls_size = max_int(nmonitors * num_ids, 1);
+    mpi_call_stats_t *local_mpi_calls = calloc(mpi_calls_size, sizeof(mpi_call_stats_t));
+    for (int i = 0; i < nmonitors; ++i) {
+        const monitor_data_t *monitor_data = monitors[i]->_data;
+        for (int slot = 0; slot < MPI_NUM_CALL_SLOTS; ++slot) {
+            const mpi_call_stats_t *stats = &monitor_data->mpi_calls[slot];
+            if (stats->num_calls > 0) {
+                mpi_call_stats_t *dst =
+                    &local_mpi_calls[i * num_ids + id_index[slot_ids[slot]]];
+                dst->num_calls  += stats->num_calls;
+                dst->time       += stats->time;
+                dst->bytes      += stats->bytes;
+            }
+        }
+    }
+
+    mpi_call_stats_t *global_mpi_calls = NULL;
     if (_mpi_rank == 0) {
-        if (base_metrics.elapsed_time > 0) {
+        global_mpi_calls = malloc(mpi_calls_size * sizeof(mpi_call_stats_t));
+    }
+    /* mpi_call_stats_t only contains int64_t fields */
+    enum { NUM_STATS = sizeof(mpi_call_stats_t) / sizeof(int64_t) };
+    PMPI_Reduce(local_mpi_calls, global_mpi_calls, nmonitors * num_ids * NUM_STATS,
+            get_mpi_int64_type(), MPI_SUM, 0, getWorldComm());
+
+    free(local_mpi_calls);
+    free(id_index);
+
+    *num_call_ids = num_ids;
+    *call_ids = ids;
+    *mpi_calls = global_mpi_calls;
+}
+
+void talp_record_pop_summary(const subprocess_descriptor_t *spd,
+        const dlb_monitor_t *const *monitors, int nmonitors) {
+
+    talp_info_t *talp_info = spd->talp_info;
+
+    /* Internal monitors will not be recorded */
+    const dlb_monitor_t **recorded_monitors = calloc(nmonitors, sizeof(dlb_monitor_t*));
+    int nrecorded = 0;
+    for (int i = 0; i < nmonitors; ++i) {
+        if (!((monitor_data_t*)monitors[i]->_data)->flags.internal) {
+            recorded_monitors[nrecorded++] = monitors[i];
+            if (_mpi_rank == 0) {
+                verbose(VB_TALP, "TALP summary: gathering region %s", monitors[i]->name);
+            }
+        }
+    }
+
+    /* Reduce monitors among all MPI ranks into MPI rank 0 */
+    pop_base_metrics_t *base_metrics_array = malloc(
+            max_int(nrecorded, 1) * sizeof(pop_base_metrics_t));
+    perf_metrics__reduce_monitors_into_base_metrics(base_metrics_array,
+            recorded_monitors, nrecorded, false);
+
+    /* Reduce the breakdown of MPI calls of all monitors at once */
+    int num_call_ids = 0;
+    mpi_call_id_t *call_ids = NULL;
+    mpi_call_stats_t *mpi_calls_array = NULL;
+    if (talp_info->flags.mpi_breakdown) {
+        reduce_mpi_calls(recorded_monitors, nrecorded, &num_call_ids, &call_ids,
+                &mpi_calls_array);
+    }
+
+    for (int i = 0; _mpi_rank == 0 && i < nrecorded; ++i) {
+        const dlb_monitor_t *monitor = recorded_monitors[i];
+        const pop_base_metrics_t *base_metrics = &base_metrics_array[i];
+
+        if (base_metrics->elapsed_time > 0) {
 
             /* Only the global region records the resources */
             if (monitor == talp_info->monitor) {
-                talp_output_record_resources(base_metrics.num_cpus,
-                        base_metrics.num_available_cpus,
-                        base_metrics.num_nodes, base_metrics.num_mpi_ranks,
-                        base_metrics.num_gpus);
+                talp_output_record_resources(base_metrics->num_cpus,
+                        base_metrics->num_available_cpus,
+                        base_metrics->num_nodes, base_metrics->num_mpi_ranks,
+                        base_metrics->num_gpus);
             }
 
             /* Construct pop_metrics out of base metrics */
             dlb_pop_metrics_t pop_metrics;
-            perf_metrics__base_to_pop_metrics(monitor->name, &base_metrics, &pop_metrics);
+            perf_metrics__base_to_pop_metrics(monitor->name, base_metrics, &pop_metrics);
+            pop_metrics_ci_t ci;
+            perf_metrics__base_to_pop_metrics_ci(base_metrics, &ci);
 
             /* Record */
             verbose(VB_TALP, "TALP summary: recording region %s", monitor->name);
-            talp_output_record_pop_metrics(&pop_metrics);
+            talp_output_record_pop_metrics(&pop_metrics,
+                    talp_info->flags.sampling ? &ci : NULL);
+
+            if (mpi_calls_array != NULL) {
+                const char **call_names = malloc(sizeof(char*) * max_int(num_call_ids, 1));
+                for (int j = 0; j < num_call_ids; ++j) {
+                    call_names[j] = get_mpi_call_name(call_ids[j]);
+                }
+                talp_output_record_mpi_calls(monitor->name, num_call_ids, call_names,
+                        &mpi_calls_array[i * num_call_ids]);
+                free(call_names);
+            }
 
         } else {
             /* Record empty */
             verbose(VB_TALP, "TALP summary: recording empty region %s", monitor->name);
             dlb_pop_metrics_t pop_metrics = {0};
             snprintf(pop_metrics.name, DLB_MONITOR_NAME_MAX, "%s", monitor->name);
-            talp_output_record_pop_metrics(&pop_metrics);
+            talp_output_record_pop_metrics(&pop_metrics, NULL);
         }
     }
+
+    free(call_ids);
+    free(mpi_calls_array);
+    free(base_metrics_array);
+    free(recorded_monitors);
 }
 
 #endif /* MPI_LIB */
@@ -33,8 +33,13 @@ void talp_record_node_summary(const subprocess_descriptor_t *spd);
 void talp_record_process_summary(const subprocess_descriptor_t *spd,
         const dlb_monitor_t *monitor);
 
+/* Write PROCESS data of all monitors from every rank to a single CSV file with
+ * MPI-IO, see --talp-collective-output. Return DLB_SUCCESS, or an error code
+ * if the data must be gathered with talp_record_process_summary instead */
+int talp_record_process_collective(const subprocess_descriptor_t *spd);
+
 void talp_record_pop_summary(const subprocess_descriptor_t *spd,
-        const dlb_monitor_t *monitor);
+        const dlb_monitor_t *const *monitors, int nmonitors);
 
 #endif
 
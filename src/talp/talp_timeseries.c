@@ -0,0 +1,234 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#include "talp/talp_timeseries.h"
+
+#include "LB_core/spd.h"
+#include "apis/dlb_talp.h"
+#include "support/debug.h"
+#include "support/gtree.h"
+#include "support/mytime.h"
+#include "support/options.h"
+#include "talp/sample.h"
+#include "talp/talp.h"
+#include "talp/talp_output.h"
+#include "talp/talp_types.h"
+#include "talp/talp_writer.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+enum { TIMESERIES_RING_CAPACITY = 1024 };
+static const char *default_filename = "talp_timeseries_%h_%p.jsonl";
+
+typedef struct timeseries_record_t {
+    int64_t timestamp;              /* end of the period */
+    const dlb_monitor_t *monitor;   /* only used for the name */
+    dlb_monitor_t delta;            /* increment of the region during the period */
+} timeseries_record_t;
+
+typedef struct timeseries_t {
+    int64_t period;                 /* in ns */
+    int64_t next_ts;                /* end of the current period */
+    talp_writer_stream_t *stream;
+    timeseries_record_t *ring;
+    int head;                       /* index of the oldest record */
+    int size;
+    int64_t num_dropped;
+} timeseries_t;
+
+static timeseries_t timeseries = {};
+
+
+/*********************************************************************************/
+/*    Ring                                                                       */
+/*********************************************************************************/
+
+/* Push a record, overwriting the oldest one if the ring is full. The ring only
+ * holds the records while the writer thread is busy */
+static void ring_push(const timeseries_record_t *record) {
+    if (timeseries.size == TIMESERIES_RING_CAPACITY) {
+        timeseries.head = (timeseries.head + 1) % TIMESERIES_RING_CAPACITY;
+        --timeseries.size;
+        ++timeseries.num_dropped;
+    }
+    int tail = (timeseries.head + timeseries.size) % TIMESERIES_RING_CAPACITY;
+    timeseries.ring[tail] = *record;
+    ++timeseries.size;
+}
+
+/* Append all records to the file and empty the ring. The records are formatted
+ * here and written by the TALP writer thread */
+static void ring_flush(void) {
+    FILE *file = talp_writer_file(timeseries.stream);
+    for (int i = 0; i < timeseries.size; ++i) {
+        const timeseries_record_t *record =
+            &timeseries.ring[(timeseries.head + i) % TIMESERIES_RING_CAPACITY];
+        fprintf(file, "{\"timestamp\": %"PRId64", \"region\": ", record->timestamp);
+        talp_output_json_string(file, record->monitor->name);
+        fprintf(file,
+                ", "
+#define PRINT_FMT(var_name, c_type, json_name, fmt) \
+                "\"" #json_name "\": " fmt ", "
+#define PRINT_FMT_LAST(var_name, c_type, json_name, fmt) \
+                "\"" #json_name "\": " fmt "}\n"
+                FOR_DLB_MONITOR_PRINTABLE_FIELDS(PRINT_FMT, PRINT_FMT_LAST)
+#undef PRINT_FMT
+#undef PRINT_FMT_LAST
+#define PRINT_ARG(var_name, c_type, json_name, fmt) \
+                , record->delta.var_name
+                FOR_DLB_MONITOR_PRINTABLE_FIELDS(PRINT_ARG, PRINT_ARG)
+#undef PRINT_ARG
+               );
+    }
+    talp_writer_flush(timeseries.stream);
+    timeseries.head = 0;
+    timeseries.size = 0;
+}
+
+
+/*********************************************************************************/
+/*    Time series                                                                */
+/*********************************************************************************/
+
+/* Push the increment of every region since the last period */
+static void record_regions(talp_info_t *talp_info, int64_t now) {
+
+    pthread_mutex_lock(&talp_info->regions_mutex);
+    {
+        for (GTreeNode *node = g_tree_node_first(talp_info->regions);
+                node != NULL;
+                node = g_tree_node_next(node)) {
+            const dlb_monitor_t *monitor = g_tree_node_value(node);
+            monitor_data_t *monitor_data = monitor->_data;
+            if (monitor_data->flags.internal) continue;
+
+            /* Open regions only account for their elapsed time when stopped */
+            dlb_monitor_t current = *monitor;
+            if (monitor_data->flags.started) {
+                current.elapsed_time += now - monitor->start_time;
+            }
+
+            /* A reset region starts again from zero */
+            dlb_monitor_t *last = &monitor_data->timeseries_last;
+            if (last->num_resets != current.num_resets) {
+                *last = (const dlb_monitor_t) {};
+            }
+
+            timeseries_record_t record = {
+                .timestamp = now,
+                .monitor = monitor,
+            };
+#define DELTA(var_name, c_type, json_name, fmt) \
+            record.delta.var_name = current.var_name - last->var_name;
+            FOR_DLB_MONITOR_PRINTABLE_FIELDS(DELTA, DELTA)
+#undef DELTA
+
+            /* Resources are not additive */
+            record.delta.num_cpus        = current.num_cpus;
+            record.delta.num_omp_threads = current.num_omp_threads;
+            record.delta.num_gpus        = current.num_gpus;
+            record.delta.num_resets      = current.num_resets;
+
+            *last = current;
+
+            /* Skip regions without activity in this period */
+            if (record.delta.elapsed_time == 0
+                    && record.delta.num_measurements == 0) continue;
+
+            ring_push(&record);
+        }
+    }
+    pthread_mutex_unlock(&talp_info->regions_mutex);
+}
+
+/* Update all regions up to now, and return the timestamp */
+static int64_t update_regions(talp_info_t *talp_info) {
+    talp_sample_update(talp_info);
+    talp_aggregate_samples_to_regions(talp_info);
+    const talp_sample_t *sample = talp_sample_get(talp_info);
+    return sample->last_updated_ts;
+}
+
+void talp_timeseries_init(const subprocess_descriptor_t *spd) {
+
+    talp_info_t *talp_info = spd->talp_info;
+    const char *template = spd->options.talp_timeseries_file != NULL
+        ? spd->options.talp_timeseries_file : default_filename;
+
+    char *filename = talp_output_expand_filename(template);
+    talp_writer_stream_t *stream =
+        talp_writer_open(filename != NULL ? filename : template, NULL);
+    free(filename);
+    if (stream == NULL) {
+        warning("TALP: disabling the time series");
+        return;
+    }
+
+    timeseries = (const timeseries_t) {
+        .period = spd->options.talp_timeseries_period * 1000000LL,
+        .next_ts = get_fast_time_in_ns() + spd->options.talp_timeseries_period * 1000000LL,
+        .stream = stream,
+        .ring = malloc(sizeof(timeseries_record_t) * TIMESERIES_RING_CAPACITY),
+    };
+    fatal_cond(timeseries.ring == NULL, "TALP: could not allocate the time-series ring");
+
+    talp_info->flags.timeseries = true;
+}
+
+void talp_timeseries_finalize(const subprocess_descriptor_t *spd) {
+
+    talp_info_t *talp_info = spd->talp_info;
+    if (!talp_info->flags.timeseries) return;
+
+    /* Record the last, possibly incomplete, period */
+    int64_t now = update_regions(talp_info);
+    record_regions(talp_info, now);
+    ring_flush();
+
+    if (timeseries.num_dropped > 0) {
+        warning("TALP: %"PRId64" time-series records were dropped", timeseries.num_dropped);
+    }
+
+    talp_writer_close(timeseries.stream);
+    free(timeseries.ring);
+    timeseries = (const timeseries_t) {};
+    talp_info->flags.timeseries = false;
+}
+
+void talp_timeseries_poll(const subprocess_descriptor_t *spd) {
+
+    talp_info_t *talp_info = spd->talp_info;
+    if (get_fast_time_in_ns() < timeseries.next_ts) return;
+
+    int64_t now = update_regions(talp_info);
+    record_regions(talp_info, now);
+
+    /* Hand off the records of this period, unless it would block until the
+     * writer thread finishes the previous ones */
+    if (timeseries.size > 0 && talp_writer_is_idle(timeseries.stream)) {
+        ring_flush();
+    }
+
+    /* Skip the periods that have been missed, if any */
+    do {
+        timeseries.next_ts += timeseries.period;
+    } while (timeseries.next_ts <= now);
+}
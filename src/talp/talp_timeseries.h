@@ -0,0 +1,36 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifndef TALP_TIMESERIES_H
+#define TALP_TIMESERIES_H
+
+typedef struct SubProcessDescriptor subprocess_descriptor_t;
+
+/* Time series of TALP regions: every period, the increment of each region is
+ * handed off to the TALP writer thread, which appends it to a JSON-lines file.
+ * While the writer thread is busy, the records are kept in a bounded ring,
+ * dropping the oldest ones if it is full */
+void talp_timeseries_init(const subprocess_descriptor_t *spd);
+void talp_timeseries_finalize(const subprocess_descriptor_t *spd);
+
+/* Only the main thread in sequential code may call this function. It does
+ * nothing if the current period has not finished yet. */
+void talp_timeseries_poll(const subprocess_descriptor_t *spd);
+
+#endif /* TALP_TIMESERIES_H */
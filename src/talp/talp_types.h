@@ -25,9 +25,12 @@
 #include "support/atomic.h"
 #include "support/gtree.h"
 #include "support/gslist.h"
+#include "support/hash_table.h"
+#include "support/types.h"
 #include "talp/backend.h"
 
 #include <pthread.h>
+#include <time.h>
 
 // Convenience compiler-time constant to avoid dynamic allocation.
 // We may revisit in the future.
@@ -47,6 +50,8 @@ typedef enum {
     TALP_STATE_NOT_USEFUL_GPU,
 } talp_sample_state_t;
 
+enum { TALP_NUM_STATES = TALP_STATE_NOT_USEFUL_GPU + 1 };
+
 typedef struct {
     int64_t useful;
     int64_t not_useful_mpi;
@@ -76,6 +81,20 @@ typedef struct {
     int64_t num_gpu_runtime_calls;
 } event_stats_t;
 
+/* Breakdown of the calls to one MPI function */
+typedef struct mpi_call_stats_t {
+    int64_t num_calls;
+    int64_t time;                   // in ns
+    int64_t bytes;
+} mpi_call_stats_t;
+
+/* Statistical sampling: number of observed timer signals and variance of the
+ * estimated MPI time */
+typedef struct {
+    int64_t num_ticks;
+    double  mpi_time_variance;      // in ns^2
+} sampling_stats_t;
+
 
 /* The sample contains the temporary per-thread accumulated values of all the
  * measured metrics. Main thread, during sequential code by contract, aggregates
@@ -94,11 +113,23 @@ typedef struct DLB_ALIGN_CACHE talp_sample_t {
     sample_timers_t     timers;
     hw_counters_t       counters;
     event_stats_t       stats;
+    sampling_stats_t    sampling;
+    mpi_call_stats_t    mpi_calls[MPI_NUM_CALL_SLOTS]; // only with --talp-mpi-breakdown
     talp_sample_state_t state;
+    atomic_uint         seq;                // sequence lock, odd while the owner thread
+                                            // is modifying the sample
     int64_t             last_updated_ts;    // timestamp of the last sample update
     int64_t             generation_ts;      // timestamp of the start of the generation since the
                                             // last update
     cpu_set_t           cpu_mask;           // CPUs this sample has been observed on
+    int64_t             mpi_call_start_ts;  // timestamp of the start of the current
+                                            // MPI call, for the MPI breakdown
+
+    // Statistical sampling: only modified by the owner thread and its signal handler
+    atomic_int_least64_t pending_ticks[TALP_NUM_STATES]; // timer signals since the last
+                                                         // update, per state
+    bool                sampled;            // whether a sampling timer is armed
+    timer_t             sampling_timer;
 
     // Cold fields: atomic variables read/written at parallel-end
     struct DLB_ALIGN_CACHE {
@@ -113,12 +144,24 @@ typedef struct talp_macrosample_t {
     macro_timers_t timers;
     hw_counters_t  counters;
     event_stats_t  stats;
+    sampling_stats_t sampling;
+    mpi_call_stats_t mpi_calls[MPI_NUM_CALL_SLOTS];
     cpu_set_t      cpu_mask;
     int            num_samples;
     uint64_t       gpu_mask;
     gpu_timers_t   gpu_timers[MAX_LOCAL_GPUS];
 } talp_macrosample_t;
 
+/* Non-additive values of one or more macrosamples, i.e., the resources that
+ * have been observed. Unlike timers or counters, these cannot be computed as a
+ * difference of two accumulated macrosamples. */
+typedef struct talp_resources_t {
+    cpu_set_t      cpu_mask;
+    int            num_cpus;
+    int            num_omp_threads;
+    uint64_t       gpu_mask;
+} talp_resources_t;
+
 
 /*********************************************************************************/
 /*    General TALP data                                                          */
@@ -133,24 +176,61 @@ typedef struct talp_flags_t {
     bool have_openmp:1;         /* whether TALP regions have OpenMP events */
     bool have_gpu:1;            /* whether TALP regions have GPU events */
     bool have_hwc:1;            /* whether TALP regions have HWC events */
+    bool lazy_regions:1;        /* whether to defer the update of open regions */
+    bool sampling:1;            /* whether thread states are sampled by a timer */
+    bool timeseries:1;          /* whether to record the time series of regions */
+    bool mpi_breakdown:1;       /* whether to break down MPI calls by type */
+    bool openmp_auto_regions:1; /* whether to create a region per OpenMP parallel */
+    bool mpi_auto_regions:1;    /* whether to create a region per MPI call site */
 } talp_flags_t;
 
+/* The sample registry is an append-only array of per-thread samples split in
+ * chunks that are never moved, so that it can be iterated without locking.
+ * The chunk c holds SAMPLE_CHUNK_SIZE << c samples. */
+enum { SAMPLE_CHUNK_SIZE = 64 };
+enum { MAX_SAMPLE_CHUNKS = 24 };
+
 /* Collection of samples and metadada needed for aggregation */
 typedef struct sample_registry_t {
-    talp_sample_t         **samples;             /* Array of per-thread samples */
-    int                   num_samples;           /* Number of samples */
-    pthread_mutex_t       mutex;                 /* Protects samples */
+    _Atomic(_Atomic(talp_sample_t*)*) chunks[MAX_SAMPLE_CHUNKS]; /* Per-thread samples */
+    atomic_int            num_reserved;          /* Number of slots handed out */
+    atomic_int            num_samples;           /* Number of published samples */
     atomic_int_least64_t  current_generation_ts; /* Global aggregation generation timestamp */
+    /* Other threads at the last aggregation of all samples, only accessed by
+     * the aggregating thread. While they stay idle, aggregating the calling
+     * thread's sample alone gives the same macrosample. */
+    struct {
+        bool            valid;      /* other threads were idle or disabled */
+        int             num_samples;
+        int             num_idle;   /* in an OpenMP idle state */
+        cpu_set_t       cpu_mask;
+    } quiescent;
 } sample_registry_t;
 
+/* Stack of open regions, the innermost region is on top */
+typedef struct region_stack_t {
+    dlb_monitor_t   **monitors;     /* monitors[size-1] is the innermost region */
+    int             size;
+    int             capacity;
+} region_stack_t;
+
+/* Hash table of automatic regions by code address, defined in auto_regions.c */
+typedef struct auto_region_table_t auto_region_table_t;
+
 /* TALP info per spd */
 typedef struct talp_info_t {
     talp_flags_t      flags;
     int               num_cpus;        /* Number of CPUs in the initial process mask */
     dlb_monitor_t     *monitor;        /* Convenience pointer to the global region */
-    GTree             *regions;        /* Tree of monitoring regions */
-    GSList            *open_regions;   /* List of open regions */
+    GTree             *regions;        /* Tree of monitoring regions, sorted by name */
+    _Atomic(hash_table_t*) regions_hash; /* Lock-free lookup of regions by name */
+    region_stack_t    open_regions;    /* Stack of open regions */
+    _Atomic(auto_region_table_t*) auto_regions; /* Automatic regions by code address */
+    dlb_monitor_t     *mpi_auto_region; /* Open automatic region of the last MPI call site */
+    int64_t           sampling_period; /* Period of the sampling timer, in ns */
+    int64_t           next_publish_ts; /* Next time to publish the global region */
     pthread_mutex_t   regions_mutex;   /* Mutex to protect regions allocation/iteration */
+    talp_macrosample_t accumulated;    /* Sum of all macrosamples, for lazy regions */
     sample_registry_t sample_registry; /* List of per-thread samples */
 } talp_info_t;
 
@@ -166,6 +246,15 @@ typedef struct monitor_data_t {
     cpu_set_t    cpu_mask;                  /* CPUs this region has been observed on */
     uint64_t     gpu_mask;                  /* GPUs this region has been observed on */
     gpu_timers_t gpu_timers[MAX_LOCAL_GPUS];
+    sampling_stats_t sampling;              /* sampling statistics of this region */
+    mpi_call_stats_t mpi_calls[MPI_NUM_CALL_SLOTS]; /* MPI calls by slot of this region */
+    dlb_monitor_t timeseries_last;          /* region values at the last time-series period */
+    GSList       *retired_names;            /* names before any rename, see region_rename */
+    struct {
+        talp_macrosample_t base;            /* accumulated macrosample at last update */
+        talp_resources_t   resources;       /* resources not yet applied to this region
+                                               or to any enclosing one */
+    } lazy;
 } monitor_data_t;
 
 
@@ -206,6 +295,10 @@ typedef struct monitor_data_t {
     /* Normalized Host times by the number of assigned CPUs */  \
     DO(min_mpi_normd_proc,          double,     MPI_DOUBLE)     \
     DO(min_mpi_normd_node,          double,     MPI_DOUBLE)     \
+    /* Variances of the Host times estimated by sampling */     \
+    DO(mpi_time_variance,           double,     MPI_DOUBLE)     \
+    DO(mpi_cpu_time_variance,       double,     MPI_DOUBLE)     \
+    DO(min_mpi_normd_proc_variance, double,     MPI_DOUBLE)     \
     /* Sum of Device times among all processes */               \
     DO(gpu_useful_time,             int64_t,    mpi_int64_type) \
     DO(gpu_communication_time,      int64_t,    mpi_int64_type) \
@@ -220,6 +313,21 @@ typedef struct pop_base_metrics_t {
     #undef DEFINE_C_TYPES
 } pop_base_metrics_t;
 
+/* pop_metrics_ci_t: 95% confidence intervals, as half-widths, of the POP
+ * efficiencies that depend on the MPI time estimated by statistical sampling.
+ * Not part of dlb_pop_metrics_t, but printed next to it */
+#define FOR_POP_METRICS_CI_FIELDS(DO, DO_LAST)                                              \
+    DO(parallel_efficiency,             float,  parallelEfficiencyCI,           "%.3f")     \
+    DO(mpi_parallel_efficiency,         float,  mpiParallelEfficiencyCI,        "%.3f")     \
+    DO(mpi_communication_efficiency,    float,  mpiCommunicationEfficiencyCI,   "%.3f")     \
+    DO_LAST(mpi_load_balance,           float,  mpiLoadBalanceCI,               "%.3f")
+
+typedef struct pop_metrics_ci_t {
+    #define DEFINE_C_TYPES(var_name, c_type, json_name, fmt) c_type var_name;
+    FOR_POP_METRICS_CI_FIELDS(DEFINE_C_TYPES, DEFINE_C_TYPES)
+    #undef DEFINE_C_TYPES
+} pop_metrics_ci_t;
+
 
 /*********************************************************************************/
 /*    Public TALP structs                                                        */
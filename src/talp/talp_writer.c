@@ -0,0 +1,429 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#include "talp/talp_writer.h"
+
+#include "support/debug.h"
+#include "talp/talp_output.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+enum { ZSTD_LEVEL = 3 };
+
+typedef enum compression_t {
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_ZSTD,
+} compression_t;
+
+struct talp_writer_stream_t {
+    char *filename;
+    compression_t compression;
+    FILE *file;                 /* output file, unless gzip */
+    void *gz_file;              /* gzFile */
+    bool error;
+    int pending;                /* chunks handed off and not yet written */
+    /* Chunk being formatted by the caller */
+    FILE *memstream;
+    char *buffer;
+    size_t size;
+};
+
+typedef struct chunk_t {
+    talp_writer_stream_t *stream;
+    char *data;
+    size_t size;
+    bool last;
+    struct chunk_t *next;
+} chunk_t;
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t queued_cond;     /* a chunk has been queued, or stop */
+    pthread_cond_t written_cond;    /* a chunk has been written */
+    chunk_t *head;
+    chunk_t *tail;
+    bool running;
+    bool stop;
+} writer = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .queued_cond = PTHREAD_COND_INITIALIZER,
+    .written_cond = PTHREAD_COND_INITIALIZER,
+};
+
+
+/*********************************************************************************/
+/*    Compression libraries                                                      */
+/*********************************************************************************/
+
+/* Only the few symbols needed are loaded, their ABI is stable */
+typedef void* (*gzdopen_func_t)(int fd, const char *mode);
+typedef int (*gzwrite_func_t)(void *file, const void *buf, unsigned len);
+typedef int (*gzclose_func_t)(void *file);
+typedef size_t (*zstd_compress_bound_func_t)(size_t src_size);
+typedef size_t (*zstd_compress_func_t)(void *dst, size_t dst_capacity,
+        const void *src, size_t src_size, int level);
+typedef unsigned (*zstd_is_error_func_t)(size_t code);
+
+static struct {
+    bool tried;
+    void *handle;
+    gzdopen_func_t gzdopen;
+    gzwrite_func_t gzwrite;
+    gzclose_func_t gzclose;
+} zlib = {};
+
+static struct {
+    bool tried;
+    void *handle;
+    zstd_compress_bound_func_t compress_bound;
+    zstd_compress_func_t compress;
+    zstd_is_error_func_t is_error;
+} zstd = {};
+
+/* The caller must hold the writer mutex */
+static bool load_zlib(void) {
+    if (!zlib.tried) {
+        zlib.tried = true;
+        zlib.handle = dlopen("libz.so.1", RTLD_LAZY | RTLD_LOCAL);
+        if (zlib.handle != NULL) {
+            zlib.gzdopen = (gzdopen_func_t)dlsym(zlib.handle, "gzdopen");
+            zlib.gzwrite = (gzwrite_func_t)dlsym(zlib.handle, "gzwrite");
+            zlib.gzclose = (gzclose_func_t)dlsym(zlib.handle, "gzclose");
+            if (zlib.gzdopen == NULL || zlib.gzwrite == NULL || zlib.gzclose == NULL) {
+                dlclose(zlib.handle);
+                zlib.handle = NULL;
+            }
+        }
+    }
+    return zlib.handle != NULL;
+}
+
+/* The caller must hold the writer mutex */
+static bool load_zstd(void) {
+    if (!zstd.tried) {
+        zstd.tried = true;
+        zstd.handle = dlopen("libzstd.so.1", RTLD_LAZY | RTLD_LOCAL);
+        if (zstd.handle != NULL) {
+            zstd.compress_bound =
+                (zstd_compress_bound_func_t)dlsym(zstd.handle, "ZSTD_compressBound");
+            zstd.compress = (zstd_compress_func_t)dlsym(zstd.handle, "ZSTD_compress");
+            zstd.is_error = (zstd_is_error_func_t)dlsym(zstd.handle, "ZSTD_isError");
+            if (zstd.compress_bound == NULL || zstd.compress == NULL
+                    || zstd.is_error == NULL) {
+                dlclose(zstd.handle);
+                zstd.handle = NULL;
+            }
+        }
+    }
+    return zstd.handle != NULL;
+}
+
+static bool gzip_write(talp_writer_stream_t *stream, const char *data, size_t size) {
+    /* gzwrite takes an unsigned length */
+    enum { MAX_GZ_WRITE = 1 << 30 };
+    while (size > 0) {
+        unsigned len = size > MAX_GZ_WRITE ? MAX_GZ_WRITE : (unsigned)size;
+        if (zlib.gzwrite(stream->gz_file, data, len) != (int)len) return false;
+        data += len;
+        size -= len;
+    }
+    return true;
+}
+
+/* Each chunk is a complete zstd frame, concatenated frames are a valid stream */
+static bool zstd_write(talp_writer_stream_t *stream, const char *data, size_t size) {
+    size_t capacity = zstd.compress_bound(size);
+    void *frame = malloc(capacity);
+    if (frame == NULL) return false;
+    size_t frame_size = zstd.compress(frame, capacity, data, size, ZSTD_LEVEL);
+    bool ok = !zstd.is_error(frame_size)
+        && fwrite(frame, 1, frame_size, stream->file) == frame_size;
+    free(frame);
+    return ok;
+}
+
+
+/*********************************************************************************/
+/*    Writer thread                                                              */
+/*********************************************************************************/
+
+static void write_chunk(chunk_t *chunk) {
+
+    talp_writer_stream_t *stream = chunk->stream;
+
+    if (chunk->size > 0 && !stream->error) {
+        bool ok = false;
+        switch(stream->compression) {
+            case COMPRESSION_NONE:
+                /* Flushed, so that readers of the file see every chunk */
+                ok = fwrite(chunk->data, 1, chunk->size, stream->file) == chunk->size
+                    && fflush(stream->file) == 0;
+                break;
+            case COMPRESSION_GZIP:
+                ok = gzip_write(stream, chunk->data, chunk->size);
+                break;
+            case COMPRESSION_ZSTD:
+                ok = zstd_write(stream, chunk->data, chunk->size);
+                break;
+        }
+        if (!ok) {
+            warning("Could not write TALP output file %s: %s",
+                    stream->filename, strerror(errno));
+            stream->error = true;
+        }
+    }
+    free(chunk->data);
+
+    if (chunk->last) {
+        if (stream->gz_file != NULL) {
+            zlib.gzclose(stream->gz_file);
+        } else {
+            fclose(stream->file);
+        }
+        free(stream->filename);
+        free(stream);
+    }
+}
+
+static void* writer_thread_func(void *arg) {
+
+    /* Signals are handled by the application threads */
+    sigset_t sigset;
+    sigfillset(&sigset);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+    pthread_mutex_lock(&writer.mutex);
+    while (true) {
+        while (writer.head == NULL && !writer.stop) {
+            pthread_cond_wait(&writer.queued_cond, &writer.mutex);
+        }
+
+        /* The queue is drained before stopping */
+        chunk_t *chunk = writer.head;
+        if (chunk == NULL) break;
+        writer.head = chunk->next;
+        if (writer.head == NULL) writer.tail = NULL;
+
+        /* The stream may be freed when writing its last chunk */
+        talp_writer_stream_t *stream = chunk->stream;
+        bool last = chunk->last;
+
+        pthread_mutex_unlock(&writer.mutex);
+        write_chunk(chunk);
+        free(chunk);
+        pthread_mutex_lock(&writer.mutex);
+
+        if (!last) {
+            --stream->pending;
+            pthread_cond_broadcast(&writer.written_cond);
+        }
+    }
+    pthread_mutex_unlock(&writer.mutex);
+
+    return NULL;
+}
+
+/* The writer thread does not exist in a forked child */
+static void writer_atfork_child(void) {
+    writer.running = false;
+    writer.stop = false;
+    writer.head = NULL;
+    writer.tail = NULL;
+    pthread_mutex_init(&writer.mutex, NULL);
+}
+
+/* Close the memory stream and queue its content */
+static void hand_off(talp_writer_stream_t *stream, bool last) {
+
+    fclose(stream->memstream);
+
+    chunk_t *chunk = malloc(sizeof(chunk_t));
+    fatal_cond(chunk == NULL, "Could not allocate TALP output chunk");
+    *chunk = (const chunk_t) {
+        .stream = stream,
+        .data = stream->buffer,
+        .size = stream->size,
+        .last = last,
+    };
+
+    pthread_mutex_lock(&writer.mutex);
+    {
+        if (!writer.running) {
+            static bool atfork_registered = false;
+            if (!atfork_registered) {
+                pthread_atfork(NULL, NULL, writer_atfork_child);
+                atfork_registered = true;
+            }
+            writer.stop = false;
+            writer.running =
+                pthread_create(&writer.thread, NULL, writer_thread_func, NULL) == 0;
+        }
+
+        if (!writer.running) {
+            /* Could not create the thread, write synchronously */
+            write_chunk(chunk);
+            free(chunk);
+        } else {
+            if (writer.tail == NULL) {
+                writer.head = chunk;
+            } else {
+                writer.tail->next = chunk;
+            }
+            writer.tail = chunk;
+            if (!last) {
+                ++stream->pending;
+            }
+            pthread_cond_signal(&writer.queued_cond);
+
+            /* Double buffering: wait for the previous chunk */
+            while (!last && stream->pending > 1) {
+                pthread_cond_wait(&writer.written_cond, &writer.mutex);
+            }
+        }
+    }
+    pthread_mutex_unlock(&writer.mutex);
+}
+
+static void open_memstream_or_die(talp_writer_stream_t *stream) {
+    stream->memstream = open_memstream(&stream->buffer, &stream->size);
+    fatal_cond(stream->memstream == NULL, "Could not allocate TALP output buffer");
+}
+
+
+/*********************************************************************************/
+/*    Streams                                                                    */
+/*********************************************************************************/
+
+const char* talp_writer_compression_suffix(const char *filename) {
+    static const char *suffixes[] = {".gz", ".zst"};
+    size_t len = strlen(filename);
+    for (size_t i = 0; i < sizeof(suffixes)/sizeof(suffixes[0]); ++i) {
+        size_t suffix_len = strlen(suffixes[i]);
+        if (len > suffix_len
+                && strcmp(filename + len - suffix_len, suffixes[i]) == 0) {
+            return filename + len - suffix_len;
+        }
+    }
+    return filename + len;
+}
+
+talp_writer_stream_t* talp_writer_open(const char *filename, bool *append) {
+
+    const char *suffix = talp_writer_compression_suffix(filename);
+    compression_t compression =
+        strcmp(suffix, ".gz") == 0 ? COMPRESSION_GZIP
+        : strcmp(suffix, ".zst") == 0 ? COMPRESSION_ZSTD
+        : COMPRESSION_NONE;
+
+    bool available;
+    pthread_mutex_lock(&writer.mutex);
+    {
+        available = compression == COMPRESSION_NONE
+            || (compression == COMPRESSION_GZIP && load_zlib())
+            || (compression == COMPRESSION_ZSTD && load_zstd());
+    }
+    pthread_mutex_unlock(&writer.mutex);
+
+    char *real_filename = strdup(filename);
+    if (!available) {
+        real_filename[suffix - filename] = '\0';
+        warning("TALP: %s is not available, writing uncompressed output to %s",
+                compression == COMPRESSION_GZIP ? "zlib" : "zstd", real_filename);
+        compression = COMPRESSION_NONE;
+    }
+
+    FILE *file = talp_output_open_file(real_filename, append);
+    if (file == NULL) {
+        free(real_filename);
+        return NULL;
+    }
+
+    talp_writer_stream_t *stream = malloc(sizeof(talp_writer_stream_t));
+    fatal_cond(stream == NULL, "Could not allocate TALP output stream");
+    *stream = (const talp_writer_stream_t) {
+        .filename = real_filename,
+        .compression = compression,
+        .file = file,
+    };
+
+    /* A gzip stream is written through its own descriptor, which is already
+     * positioned at the end of the file if appending */
+    if (compression == COMPRESSION_GZIP) {
+        int fd = dup(fileno(file));
+        stream->gz_file = fd >= 0 ? zlib.gzdopen(fd, "wb") : NULL;
+        fclose(file);
+        stream->file = NULL;
+        if (stream->gz_file == NULL) {
+            warning("Cannot open file %s for compression", real_filename);
+            if (fd >= 0) close(fd);
+            free(real_filename);
+            free(stream);
+            return NULL;
+        }
+    }
+
+    open_memstream_or_die(stream);
+
+    return stream;
+}
+
+FILE* talp_writer_file(talp_writer_stream_t *stream) {
+    return stream->memstream;
+}
+
+bool talp_writer_is_idle(talp_writer_stream_t *stream) {
+    pthread_mutex_lock(&writer.mutex);
+    bool idle = stream->pending == 0;
+    pthread_mutex_unlock(&writer.mutex);
+    return idle;
+}
+
+void talp_writer_flush(talp_writer_stream_t *stream) {
+    hand_off(stream, false);
+    open_memstream_or_die(stream);
+}
+
+void talp_writer_close(talp_writer_stream_t *stream) {
+    hand_off(stream, true);
+}
+
+void talp_writer_finalize(void) {
+
+    pthread_mutex_lock(&writer.mutex);
+    bool running = writer.running;
+    if (running) {
+        writer.stop = true;
+        pthread_cond_signal(&writer.queued_cond);
+    }
+    pthread_mutex_unlock(&writer.mutex);
+
+    if (running) {
+        pthread_join(writer.thread, NULL);
+        writer.running = false;
+        writer.stop = false;
+    }
+}
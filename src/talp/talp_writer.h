@@ -0,0 +1,65 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifndef TALP_WRITER_H
+#define TALP_WRITER_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Asynchronous writer of TALP output files
+ *
+ * The caller formats the content of a stream into a memory FILE and hands it
+ * off in chunks. A background thread writes the chunks in order, compressing
+ * them if the filename ends with .gz (zlib) or .zst (zstd). Compression
+ * libraries are loaded at run time; if not available, the output is written
+ * uncompressed to the filename without the suffix.
+ *
+ * Chunks are double-buffered: the next chunk of a stream can be formatted
+ * while the previous one is being written, but not further.
+ */
+
+typedef struct talp_writer_stream_t talp_writer_stream_t;
+
+/* Return a pointer to the compression suffix of filename, or to its
+ * terminating NUL if there is none */
+const char* talp_writer_compression_suffix(const char *filename);
+
+/* Open a stream with the same semantics as talp_output_open_file.
+ * Return NULL if the file cannot be opened */
+talp_writer_stream_t* talp_writer_open(const char *filename, bool *append);
+
+/* Memory FILE where the current chunk is formatted */
+FILE* talp_writer_file(talp_writer_stream_t *stream);
+
+/* Return whether all the chunks handed off have been written, so that
+ * talp_writer_flush does not block */
+bool talp_writer_is_idle(talp_writer_stream_t *stream);
+
+/* Hand off the current chunk and start a new one. It may block until the
+ * writer thread has written the previous chunks */
+void talp_writer_flush(talp_writer_stream_t *stream);
+
+/* Hand off the last chunk. The stream is closed and freed by the writer thread */
+void talp_writer_close(talp_writer_stream_t *stream);
+
+/* Wait until all the streams are written and stop the writer thread */
+void talp_writer_finalize(void);
+
+#endif /* TALP_WRITER_H */
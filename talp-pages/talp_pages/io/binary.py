@@ -0,0 +1,202 @@
+"""
+Loader of the binary columnar output format of TALP (files with the .talp extension).
+
+The layout is described in src/talp/talp_binary.h of DLB: a header, the tables
+with their column descriptors and values, and a string table at the end.
+"""
+
+import struct
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Union
+
+TALP_BINARY_MAGIC = b"DLBTALP\0"
+TALP_BINARY_VERSION = 1
+TALP_BINARY_BYTE_ORDER = 0x01020304
+
+# type code: (struct format, size)
+_COLUMN_TYPES = {
+    1: ("i", 4),  # int32
+    2: ("q", 8),  # int64
+    3: ("f", 4),  # float32
+    4: ("d", 8),  # float64
+    5: ("I", 4),  # string, offset into the string table
+}
+_STRING_TYPE = 5
+
+# magic, version, byte_order, 7 uint32 fields and hostname, pid, num_tables,
+# string_table_offset, string_table_size
+_HEADER_FORMAT = "8sIIIIIIIIIIiIQQ"
+_TABLE_FORMAT = "IIQ"
+_COLUMN_FORMAT = "II"
+
+
+def _align(offset: int) -> int:
+    return (offset + 7) & ~7
+
+
+@dataclass
+class TalpBinary:
+    dlb_version: str
+    timestamp: str
+    resources: Dict[str, int]
+    process_info: Dict[str, Union[str, int]]
+    # table name -> column name -> values
+    tables: Dict[str, Dict[str, list]] = field(default_factory=dict)
+
+
+def read_talp_binary(path: Union[str, Path]) -> TalpBinary:
+    """Read a TALP binary file. Raises ValueError if the file is not valid"""
+    with open(path, "rb") as file:
+        data = file.read()
+
+    if len(data) < struct.calcsize("<" + _HEADER_FORMAT) or not data.startswith(
+        TALP_BINARY_MAGIC
+    ):
+        raise ValueError(f"{path} is not a TALP binary file")
+
+    # Detect the byte order of the writer
+    (byte_order,) = struct.unpack_from("<I", data, 12)
+    endian = "<" if byte_order == TALP_BINARY_BYTE_ORDER else ">"
+
+    (
+        _,
+        version,
+        _,
+        dlb_version,
+        timestamp,
+        num_cpus,
+        num_available_cpus,
+        num_nodes,
+        num_mpi_ranks,
+        num_gpus,
+        hostname,
+        pid,
+        num_tables,
+        string_table_offset,
+        string_table_size,
+    ) = struct.unpack_from(endian + _HEADER_FORMAT, data, 0)
+
+    if version != TALP_BINARY_VERSION:
+        raise ValueError(f"Unsupported TALP binary version {version} in {path}")
+    if string_table_offset + string_table_size > len(data):
+        raise ValueError(f"{path} is truncated")
+
+    strings = data[string_table_offset : string_table_offset + string_table_size]
+
+    def get_string(offset: int) -> str:
+        end = strings.index(b"\0", offset)
+        return strings[offset:end].decode()
+
+    talp_binary = TalpBinary(
+        dlb_version=get_string(dlb_version),
+        timestamp=get_string(timestamp),
+        resources={
+            "numCpus": num_cpus,
+            "numAvailableCpus": num_available_cpus,
+            "numNodes": num_nodes,
+            "numMpiRanks": num_mpi_ranks,
+            "numGpus": num_gpus,
+        },
+        process_info={"hostname": get_string(hostname), "pid": pid} if pid else {},
+    )
+
+    offset = _align(struct.calcsize(endian + _HEADER_FORMAT))
+    for _ in range(num_tables):
+        name, num_columns, num_rows = struct.unpack_from(
+            endian + _TABLE_FORMAT, data, offset
+        )
+        offset += struct.calcsize(endian + _TABLE_FORMAT)
+        descriptors = [
+            struct.unpack_from(endian + _COLUMN_FORMAT, data, offset + 8 * i)
+            for i in range(num_columns)
+        ]
+        offset = _align(offset + 8 * num_columns)
+
+        columns = {}
+        for column_name, column_type in descriptors:
+            fmt, size = _COLUMN_TYPES[column_type]
+            if offset + size * num_rows > string_table_offset:
+                raise ValueError(f"{path} is truncated")
+            values = list(struct.unpack_from(f"{endian}{num_rows}{fmt}", data, offset))
+            if column_type == _STRING_TYPE:
+                values = [get_string(value) for value in values]
+            columns[get_string(column_name)] = values
+            offset = _align(offset + size * num_rows)
+
+        talp_binary.tables[get_string(name)] = columns
+
+    return talp_binary
+
+
+def talp_binary_to_json_dict(talp_binary: TalpBinary) -> dict:
+    """Return the same structure as the JSON output of TALP"""
+    run_json = {
+        "dlbVersion": talp_binary.dlb_version,
+        "timestamp": talp_binary.timestamp,
+        "resources": dict(talp_binary.resources),
+    }
+    if talp_binary.process_info:
+        run_json["processInfo"] = dict(talp_binary.process_info)
+
+    def rows(table):
+        columns = list(table.keys())
+        num_rows = len(table[columns[0]]) if columns else 0
+        return [
+            {column: table[column][i] for column in columns} for i in range(num_rows)
+        ]
+
+    if "Application" in talp_binary.tables:
+        run_json["Application"] = {}
+        for row in rows(talp_binary.tables["Application"]):
+            region_name = row.pop("regionName")
+            run_json["Application"][region_name] = row
+
+    if "Node" in talp_binary.tables:
+        nodes: Dict[int, dict] = {}
+        for row in rows(talp_binary.tables["Node"]):
+            node = nodes.setdefault(
+                row["nodeId"],
+                {
+                    "id": str(row["nodeId"]),
+                    "process": [],
+                    "nodeAvg": {
+                        "usefulTime": row["nodeAvgUsefulTime"],
+                        "mpiTime": row["nodeAvgMpiTime"],
+                    },
+                    "nodeMax": {
+                        "usefulTime": row["nodeMaxUsefulTime"],
+                        "mpiTime": row["nodeMaxMpiTime"],
+                    },
+                },
+            )
+            node["process"].append(
+                {
+                    "id": row["processId"],
+                    "usefulTime": row["processUsefulTime"],
+                    "mpiTime": row["processMpiTime"],
+                }
+            )
+        run_json["node"] = list(nodes.values())
+
+    if "Process" in talp_binary.tables:
+        processes: Dict[str, List[dict]] = {}
+        for row in rows(talp_binary.tables["Process"]):
+            region_name = row.pop("regionName")
+            processes.setdefault(region_name, []).append(row)
+        run_json["Process"] = processes
+
+    if "MpiCalls" in talp_binary.tables:
+        mpi_calls: Dict[str, dict] = {}
+        for row in rows(talp_binary.tables["MpiCalls"]):
+            region_name = row.pop("regionName")
+            call_type = row.pop("callType")
+            mpi_calls.setdefault(region_name, {})[call_type] = row
+        run_json["MpiCalls"] = mpi_calls
+
+    return run_json
+
+
+def load_talp_binary(path: Union[str, Path]) -> dict:
+    """Read a TALP binary file into the same structure as the JSON output"""
+    return talp_binary_to_json_dict(read_talp_binary(path))
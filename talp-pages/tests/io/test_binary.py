@@ -0,0 +1,85 @@
+import json
+import pytest
+from talp_pages.io.binary import (
+    TalpBinary,
+    load_talp_binary,
+    read_talp_binary,
+    talp_binary_to_json_dict,
+)
+from tests.helpers import get_json_path
+
+
+def test_binary_matches_json():
+    # Both files were written by DLB from the same records
+    run_binary = load_talp_binary(get_json_path("jsons/unit-tests/binary_2mpi.talp"))
+    with open(get_json_path("jsons/unit-tests/binary_2mpi.json")) as file:
+        run_json = json.load(file)
+
+    assert run_binary["dlbVersion"] == run_json["dlbVersion"]
+    assert run_binary["timestamp"] == run_json["timestamp"]
+    assert run_binary["resources"] == run_json["resources"]
+    assert run_binary["node"] == run_json["node"]
+
+    assert run_binary["Application"].keys() == run_json["Application"].keys()
+    for region, metrics in run_json["Application"].items():
+        for key, value in metrics.items():
+            # JSON floats are rounded to 2 decimals or to integers
+            assert run_binary["Application"][region][key] == pytest.approx(
+                value, abs=0.5
+            )
+
+    assert run_binary["Process"].keys() == run_json["Process"].keys()
+    for region, processes in run_json["Process"].items():
+        assert len(run_binary["Process"][region]) == len(processes)
+        for process_binary, process_json in zip(
+            run_binary["Process"][region], processes
+        ):
+            process_json.pop("cpuset")
+            process_binary.pop("cpuset")
+            assert process_binary == process_json
+
+
+def test_binary_columns():
+    talp_binary = read_talp_binary(get_json_path("jsons/unit-tests/binary_2mpi.talp"))
+    process = talp_binary.tables["Process"]
+    assert process["regionName"] == ["Region 0", "Region 0", "Region 1", "Region 1"]
+    assert process["rank"] == [0, 1, 0, 1]
+    assert process["hostname"] == ["node0", "node0", "node0", "node0"]
+
+
+def test_binary_mpi_calls():
+    talp_binary = TalpBinary(
+        dlb_version="3.6",
+        timestamp="2026-01-01T00:00:00",
+        resources={},
+        process_info={},
+        tables={
+            "MpiCalls": {
+                "regionName": ["Global", "Global", "Region 0"],
+                "callType": ["MPI_Send", "MPI_Allreduce", "MPI_Send"],
+                "numCalls": [4, 2, 1],
+                "time": [400, 200, 100],
+                "bufferBytes": [4096, 16, 1024],
+            }
+        },
+    )
+    run_json = talp_binary_to_json_dict(talp_binary)
+    assert run_json["MpiCalls"] == {
+        "Global": {
+            "MPI_Send": {"numCalls": 4, "time": 400, "bufferBytes": 4096},
+            "MPI_Allreduce": {"numCalls": 2, "time": 200, "bufferBytes": 16},
+        },
+        "Region 0": {"MPI_Send": {"numCalls": 1, "time": 100, "bufferBytes": 1024}},
+    }
+
+
+def test_binary_wrong_file(tmp_path):
+    with pytest.raises(ValueError):
+        read_talp_binary(get_json_path("jsons/unit-tests/binary_2mpi.json"))
+
+    with open(get_json_path("jsons/unit-tests/binary_2mpi.talp"), "rb") as file:
+        data = file.read()
+    truncated = tmp_path / "truncated.talp"
+    truncated.write_bytes(data[: len(data) // 2])
+    with pytest.raises(ValueError):
+        read_talp_binary(truncated)
@@ -0,0 +1,51 @@
+#include <dlb_talp.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Benchmark of the TALP reductions with many monitoring regions:
+ * - each DLB_TALP_CollectPOPMetrics call reduces one region
+ * - MPI_Finalize reduces all regions for the POP metrics summary */
+
+int main(int argc, char *argv[]) {
+
+    int num_regions = argc > 1 ? atoi(argv[1]) : 200;
+
+    MPI_Init(&argc, &argv);
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    dlb_monitor_t **regions = malloc(num_regions * sizeof(dlb_monitor_t*));
+    for (int i = 0; i < num_regions; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "Region %d", i);
+        regions[i] = DLB_MonitoringRegionRegister(name);
+        DLB_MonitoringRegionStart(regions[i]);
+        MPI_Barrier(MPI_COMM_WORLD);
+        DLB_MonitoringRegionStop(regions[i]);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+    for (int i = 0; i < num_regions; ++i) {
+        dlb_pop_metrics_t pop_metrics;
+        DLB_TALP_CollectPOPMetrics(regions[i], &pop_metrics);
+    }
+    double collect_time = MPI_Wtime() - start;
+    free(regions);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    MPI_Finalize();
+    double finalize_time = MPI_Wtime() - start;
+
+    if (rank == 0) {
+        printf("%-32s %12s\n", "Benchmark", "Time (ms)");
+        printf("%-32s %12.3f\n", "CollectPOPMetrics (per region)",
+                collect_time * 1e3 / num_regions);
+        printf("%-32s %12.3f\n", "MPI_Finalize (all regions)", finalize_time * 1e3);
+    }
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+from pathlib import Path
+import sys
+sys.path.insert(0, str(Path(__file__).parents[1]))
+from conftest import run_binary
+import pytest
+
+BINARY = Path(__file__).parent / "bench_regions"
+
+@pytest.mark.parametrize("num_regions", [200])
+def test_bench_regions(tmp_path, num_regions):
+    output = run_binary(BINARY, tmp_path / "result.json", n_proc=2, args=[str(num_regions)])
+    app = output["Application"]
+
+    # --- All regions are reduced, plus the global region ---
+    assert len(app) == num_regions + 1
+    for i in range(num_regions):
+        region = app[f"Region {i}"]
+        assert region["numMpiRanks"] == 2
+        assert region["numMpiCalls"] == 2
@@ -0,0 +1,80 @@
+#include <dlb_errors.h>
+#include <dlb_talp.h>
+#include <mpi.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static void busy_wait(double seconds) {
+    double start = MPI_Wtime();
+    volatile uint64_t x = 0;
+    while (MPI_Wtime() - start < seconds)
+        x++;
+}
+
+int main(int argc, char *argv[]) {
+
+    MPI_Init(&argc, &argv);
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    /* Region with an imbalanced useful time */
+    dlb_monitor_t *region = DLB_MonitoringRegionRegister("Region");
+    DLB_MonitoringRegionStart(region);
+    busy_wait(0.1 * (rank + 1));
+    MPI_Barrier(MPI_COMM_WORLD);
+    DLB_MonitoringRegionStop(region);
+
+    /* Non-blocking collect, overlapped with computation */
+    dlb_pop_metrics_t ipop_metrics;
+    dlb_talp_request_t *request;
+    if (DLB_TALP_ICollectPOPMetrics(region, &ipop_metrics, &request) != DLB_SUCCESS) {
+        return 1;
+    }
+    int flag = 0;
+    int num_tests = 0;
+    while (!flag) {
+        busy_wait(0.001);
+        DLB_TALP_Test(&request, &flag);
+        ++num_tests;
+    }
+    if (request != NULL) return 1;
+
+    /* Wait on the same request after another non-blocking collect */
+    dlb_pop_metrics_t wpop_metrics;
+    DLB_TALP_ICollectPOPMetrics(region, &wpop_metrics, &request);
+    DLB_TALP_Wait(&request);
+
+    /* Completing a request does not depend on the other processes testing
+     * theirs: rank 0 waits before a barrier that rank 1 enters before waiting */
+    dlb_pop_metrics_t bpop_metrics;
+    DLB_TALP_ICollectPOPMetrics(region, &bpop_metrics, &request);
+    if (rank == 0) {
+        DLB_TALP_Wait(&request);
+        MPI_Barrier(MPI_COMM_WORLD);
+    } else {
+        MPI_Barrier(MPI_COMM_WORLD);
+        DLB_TALP_Wait(&request);
+    }
+
+    /* The blocking collect must return the same metrics */
+    dlb_pop_metrics_t pop_metrics;
+    DLB_TALP_CollectPOPMetrics(region, &pop_metrics);
+
+    int error = ipop_metrics.useful_time != pop_metrics.useful_time
+        || ipop_metrics.mpi_time != pop_metrics.mpi_time
+        || ipop_metrics.num_mpi_ranks != pop_metrics.num_mpi_ranks
+        || ipop_metrics.mpi_load_balance != pop_metrics.mpi_load_balance
+        || wpop_metrics.useful_time != pop_metrics.useful_time
+        || wpop_metrics.parallel_efficiency != pop_metrics.parallel_efficiency
+        || bpop_metrics.mpi_load_balance != pop_metrics.mpi_load_balance;
+
+    if (rank == 0) {
+        printf("numMpiRanks: %d, usefulTime: %lld, mpiLoadBalance: %.2f, tests: %d\n",
+                pop_metrics.num_mpi_ranks, (long long)pop_metrics.useful_time,
+                pop_metrics.mpi_load_balance, num_tests);
+    }
+
+    MPI_Finalize();
+    return error;
+}
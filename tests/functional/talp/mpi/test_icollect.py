@@ -0,0 +1,15 @@
+from pathlib import Path
+import sys
+sys.path.insert(0, str(Path(__file__).parents[1]))
+from conftest import run_binary
+import pytest
+
+BINARY = Path(__file__).parent / "test_icollect"
+
+def test_icollect_pop_metrics(tmp_path):
+    # The binary fails if the non-blocking and blocking metrics differ
+    output = run_binary(BINARY, tmp_path / "result.json", n_proc=2)
+    region = output["Application"]["Region"]
+
+    assert region["numMpiRanks"] == 2
+    assert region["numMpiCalls"] == 2
@@ -1,7 +1,8 @@
 from pathlib import Path
 import sys
 sys.path.insert(0, str(Path(__file__).parents[1]))
-from conftest import run_binary, assert_approx, NS, TIME_TOLERANCE, METRIC_TOLERANCE
+from conftest import run_binary, assert_approx, DLB_HOME, NS, TIME_TOLERANCE, METRIC_TOLERANCE
+import subprocess
 import pytest
 
 BINARY = Path(__file__).parent / "test_mpi"
@@ -39,3 +40,53 @@ def test_mpi_sendrecv_profile(tmp_path, repetitions):
                   absolute_tol=METRIC_TOLERANCE)
     assert_approx(g["mpiLoadBalance"], expected=0.83, label="mpiLoadBalance",
                   absolute_tol=METRIC_TOLERANCE)
+
+
+def test_mpi_collective_output(tmp_path):
+    output_csv = tmp_path / "result.csv"
+    env_pairs = [
+        f"LD_PRELOAD={DLB_HOME}/lib/libdlb_mpi.so",
+        "DLB_ARGS=--talp --talp-summary=process --talp-collective-output"
+        f" --talp-output-file={output_csv}",
+    ]
+    subprocess.run(["mpirun", "-n", "2", "env", *env_pairs, str(BINARY)], check=True)
+    data = output_csv.read_bytes()
+
+    # --- Index footer: trailer and one fixed-width entry per rank ---
+    index_offset, num_ranks = data[-44:].decode().split()[1:]
+    index_offset, num_ranks = int(index_offset), int(num_ranks)
+    assert num_ranks == 2
+    for rank in range(num_ranks):
+        entry = data[index_offset + 55 * rank : index_offset + 55 * (rank + 1)]
+        entry_rank, offset, size = map(int, entry.decode().split()[1:])
+        assert entry_rank == rank
+        rows = data[offset : offset + size].decode().splitlines()
+        if rank == 0:
+            assert rows.pop(0).startswith("Region,Rank,")
+        assert [row.split(",")[:2] for row in rows] == [["Global", str(rank)]]
+
+    # --- The file is still a valid CSV if comments are skipped ---
+    lines = [line for line in data.decode().splitlines() if not line.startswith("#")]
+    assert len(lines) == 1 + num_ranks
+
+
+def test_mpi_collective_output_split(tmp_path):
+    output_csv = tmp_path / "result.csv"
+    env_pairs = [
+        f"LD_PRELOAD={DLB_HOME}/lib/libdlb_mpi.so",
+        "DLB_ARGS=--talp --talp-summary=pop-metrics:process --talp-collective-output"
+        f" --talp-output-file={output_csv}",
+    ]
+    for _ in range(2):
+        subprocess.run(["mpirun", "-n", "2", "env", *env_pairs, str(BINARY)], check=True)
+
+    # --- Same file names as the CSV output without the collective mode ---
+    assert not output_csv.exists()
+    pop_lines = (tmp_path / "result-pop.csv").read_text().splitlines()
+    process_data = (tmp_path / "result-process.csv").read_text()
+
+    # --- Both executions are appended, with only one header ---
+    assert len(pop_lines) == 1 + 2
+    lines = [line for line in process_data.splitlines() if not line.startswith("#")]
+    assert lines[0].startswith("Region,Rank,")
+    assert len(lines) == 1 + 2 * 2
@@ -0,0 +1,95 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "support/hash_table.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+enum { NUM_ENTRIES = 1000 };
+enum { NAME_MAX_LEN = 16 };
+
+typedef struct entry_t {
+    char name[NAME_MAX_LEN];
+} entry_t;
+
+static unsigned int hash_entry(const void *entry) {
+    return hash_table_hash_string(((const entry_t*)entry)->name, NAME_MAX_LEN);
+}
+
+static bool entry_has_name(const void *entry, const void *name) {
+    return strncmp(((const entry_t*)entry)->name, name, NAME_MAX_LEN) == 0;
+}
+
+static entry_t* lookup(_Atomic(hash_table_t*) *table, const char *name) {
+    return hash_table_lookup(table, hash_table_hash_string(name, NAME_MAX_LEN),
+            entry_has_name, name);
+}
+
+static void count_entry(void *entry, void *user_data) {
+    ++*(int*)user_data;
+}
+
+int main(int argc, char *argv[]) {
+
+    _Atomic(hash_table_t*) table = NULL;
+    static entry_t entries[NUM_ENTRIES];
+
+    /* Empty table */
+    assert( lookup(&table, "entry 0") == NULL );
+    hash_table_remove(&table, &entries[0], 0);
+
+    /* Insert enough entries to grow the table several times */
+    for (int i = 0; i < NUM_ENTRIES; ++i) {
+        snprintf(entries[i].name, NAME_MAX_LEN, "entry %d", i);
+        hash_table_insert(&table, &entries[i], hash_entry);
+    }
+    for (int i = 0; i < NUM_ENTRIES; ++i) {
+        assert( lookup(&table, entries[i].name) == &entries[i] );
+    }
+    assert( lookup(&table, "unknown") == NULL );
+
+    /* Removed entries are no longer found, but the others are */
+    for (int i = 0; i < NUM_ENTRIES; i += 2) {
+        hash_table_remove(&table, &entries[i], hash_entry(&entries[i]));
+    }
+    for (int i = 0; i < NUM_ENTRIES; ++i) {
+        assert( lookup(&table, entries[i].name) == (i % 2 ? &entries[i] : NULL) );
+    }
+    int count = 0;
+    hash_table_foreach(&table, count_entry, &count);
+    assert( count == NUM_ENTRIES / 2 );
+
+    /* Entries can be inserted again */
+    hash_table_insert(&table, &entries[0], hash_entry);
+    assert( lookup(&table, entries[0].name) == &entries[0] );
+
+    /* Pointers with the same low bits do not collide in the same hash */
+    assert( hash_table_hash_pointer(&entries[0]) != hash_table_hash_pointer(&entries[1]) );
+
+    hash_table_destroy(&table);
+    assert( table == NULL );
+
+    return 0;
+}
@@ -134,6 +134,12 @@ int main(int argc, char *argv[]) {
         assert( mu_get_core_id(0) == 0 );
         assert( mu_get_core_id(31) == 15 );
         assert( mu_get_core_id(32) == -1 );
+        assert( mu_get_node_id(-1) == -1 );
+        assert( mu_get_node_id(0) == 0 );
+        assert( mu_get_node_id(7) == 0 );
+        assert( mu_get_node_id(8) == 1 );
+        assert( mu_get_node_id(31) == 3 );
+        assert( mu_get_node_id(32) == -1 );
         assert( mu_get_core_mask(0) != NULL);
         assert( mu_get_core_mask(32) == NULL);
 
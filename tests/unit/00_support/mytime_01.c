@@ -0,0 +1,95 @@
+/*********************************************************************************/
+/*  Copyright 2009-2021 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "extra_tests.h"
+
+#include "support/mytime.h"
+#include "apis/dlb_errors.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <assert.h>
+
+/* Test the fast timer calibration, and compare the cost of reading each timer */
+
+enum { NUM_READS = 1000000 };
+
+typedef int64_t (*timer_fn_t)(void);
+
+/* Return the average time, in nanoseconds, of reading a timer */
+static double time_reads(timer_fn_t timer_fn) {
+    volatile int64_t sink = 0;
+    int64_t start = get_time_in_ns();
+    for (int i = 0; i < NUM_READS; ++i) {
+        sink += timer_fn();
+    }
+    int64_t elapsed = get_time_in_ns() - start;
+    (void)sink;
+    return (double)elapsed / NUM_READS;
+}
+
+int main(int argc, char **argv) {
+
+    /* Without initialization, the fast timer is CLOCK_MONOTONIC */
+    {
+        int64_t t0 = get_time_in_ns();
+        int64_t t1 = get_fast_time_in_ns();
+        int64_t t2 = get_time_in_ns();
+        assert( t0 <= t1 && t1 <= t2 );
+    }
+
+    /* The hardware counter may not be available or reliable */
+    int error = fast_time_init();
+    assert( error == DLB_SUCCESS || error == DLB_ERR_NOCOMP );
+    printf("Fast timer: %s\n", error == DLB_SUCCESS ? "hardware counter" : "clock");
+
+    /* Fast timer is monotonic and in the same time base as CLOCK_MONOTONIC */
+    {
+        enum { MAX_DRIFT_NS = 1000000 };
+        int64_t prev = get_fast_time_in_ns();
+        for (int i = 0; i < 1000; ++i) {
+            int64_t now = get_fast_time_in_ns();
+            assert( now >= prev );
+            prev = now;
+        }
+        for (int i = 0; i < 5; ++i) {
+            usleep(20000);
+            int64_t fast_ns = get_fast_time_in_ns();
+            int64_t clock_ns = get_time_in_ns();
+            int64_t drift = clock_ns - fast_ns;
+            assert( drift > -MAX_DRIFT_NS && drift < MAX_DRIFT_NS );
+        }
+    }
+
+    /* Cost of reading each timer */
+    if (DLB_EXTRA_TESTS)
+    {
+        printf("%16s %16s\n", "Timer", "Read (ns)");
+        printf("%16s %16.2f\n", "clock_gettime", time_reads(get_time_in_ns));
+        printf("%16s %16.2f\n", "fast timer", time_reads(get_fast_time_in_ns));
+    }
+
+    fast_time_finalize();
+
+    return 0;
+}
@@ -228,6 +228,7 @@ int main( int argc, char **argv ) {
     interaction_mode_t mode;
     talp_summary_t talp_sum;
     talp_model_t talp_model;
+    talp_timer_t talp_timer;
     // 1) without thread_spd->options
     setenv("DLB_ARGS", "--lewi --lewi-mpi --barrier-id=3 --shm-key=custom_key"
             " --verbose=talp --lewi-ompt=borrow", 1);
@@ -245,6 +246,7 @@ int main( int argc, char **argv ) {
     options_parse_entry("--mode", &mode);               assert(mode == MODE_POLLING);
     options_parse_entry("--talp-summary", &talp_sum);   assert(talp_sum == SUMMARY_POP_METRICS);
     options_parse_entry("--talp-model", &talp_model);   assert(talp_model == TALP_MODEL_HYBRID_V2);
+    options_parse_entry("--talp-timer", &talp_timer);   assert(talp_timer == TALP_TIMER_CLOCK);
     // 2) with existing thread_spd
     spd_enter_dlb(NULL);
     options_init(&thread_spd->options, NULL);
@@ -264,6 +266,7 @@ int main( int argc, char **argv ) {
     options_parse_entry("--mode", &mode);               assert(mode == MODE_POLLING);
     options_parse_entry("--talp-summary", &talp_sum);   assert(talp_sum == SUMMARY_POP_METRICS);
     options_parse_entry("--talp-model", &talp_model);   assert(talp_model == TALP_MODEL_HYBRID_V2);
+    options_parse_entry("--talp-timer", &talp_timer);   assert(talp_timer == TALP_TIMER_CLOCK);
     free(shm_key);
     free(talp_file);
 
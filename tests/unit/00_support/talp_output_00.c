@@ -25,10 +25,12 @@
 #include "support/mask_utils.h"
 #include "talp/talp_output.h"
 #include "talp/talp_types.h"
+#include "talp/talp_writer.h"
 
 #include <ftw.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <limits.h>
 #include <assert.h>
@@ -94,6 +96,34 @@ static void cat_file(const char *filename) {
     fclose(f);
 }
 
+/* Output files are written in the background, wait for them */
+static void output_finalize(const char *output_file, bool partial_output) {
+    talp_output_finalize(output_file, partial_output);
+    talp_writer_finalize();
+}
+
+static bool file_starts_with(const char *filename, const unsigned char *magic,
+        size_t magic_len) {
+    unsigned char buffer[8] = {};
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) return false;
+    size_t n = fread(buffer, 1, magic_len, file);
+    fclose(file);
+    return n == magic_len && memcmp(buffer, magic, magic_len) == 0;
+}
+
+static bool file_contains(const char *filename, const char *string) {
+    char line[256];
+    bool found = false;
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) return false;
+    while (!found && fgets(line, sizeof(line), file) != NULL) {
+        found = strstr(line, string) != NULL;
+    }
+    fclose(file);
+    return found;
+}
+
 static void record_metrics(void) {
 
     /* Initialize structure */
@@ -126,7 +156,17 @@ static void record_metrics(void) {
         .omp_serialization_efficiency = 0.95f,
     };
 
-    talp_output_record_pop_metrics(&metrics);
+    talp_output_record_pop_metrics(&metrics, NULL);
+
+    /* Same metrics, estimated by statistical sampling */
+    snprintf(metrics.name, DLB_MONITOR_NAME_MAX, "Sampled region");
+    const pop_metrics_ci_t ci = {
+        .parallel_efficiency          = 0.01f,
+        .mpi_parallel_efficiency      = 0.01f,
+        .mpi_communication_efficiency = 0.02f,
+        .mpi_load_balance             = 0.03f,
+    };
+    talp_output_record_pop_metrics(&metrics, &ci);
 
     /* node_record_t contains a flexible array member and it needs to be
      * dynamically allocated */
@@ -164,6 +204,14 @@ static void record_metrics(void) {
     };
 
     talp_output_record_process("Region 1", &process_record, 1);
+
+    const char *call_names[] = { "MPI_Send", "MPI_Allreduce", "MPI_Waitall" };
+    mpi_call_stats_t mpi_calls[] = {
+        { .num_calls = 4, .time = 400, .bytes = 4096 },
+        { .num_calls = 2, .time = 200, .bytes = 16 },
+        { .num_calls = 0 },
+    };
+    talp_output_record_mpi_calls("Region 1", 3, call_names, mpi_calls);
 }
 
 static void record_wrong_metrics(void) {
@@ -189,7 +237,7 @@ static void record_wrong_metrics(void) {
         .omp_serialization_efficiency = 1.95f,
     };
 
-    talp_output_record_pop_metrics(&metrics);
+    talp_output_record_pop_metrics(&metrics, NULL);
 
     const process_record_t process_record = {
         .rank = 0,
@@ -224,9 +272,14 @@ int main(int argc, char *argv[]) {
     char *json_filename;
     asprintf(&json_filename, "%s/talp.json", tmpdir);
     record_metrics();
-    talp_output_finalize(json_filename, no_partial_output);
+    output_finalize(json_filename, no_partial_output);
     error += access(json_filename, F_OK);
     if (!error) cat_file(json_filename);
+    assert( file_contains(json_filename, "\"MpiCalls\"") );
+    assert( file_contains(json_filename, "\"MPI_Allreduce\"") );
+    assert( file_contains(json_filename, "\"bufferBytes\"") );
+    assert( !file_contains(json_filename, "\"MPI_Waitall\"") );
+    assert( !file_contains(json_filename, "\"Other\"") );
     int num_lines_in_json = count_lines(json_filename);
     free(json_filename);
 
@@ -234,7 +287,7 @@ int main(int argc, char *argv[]) {
     asprintf(&json_filename, "%s/talp.json", tmpdir);
     record_metrics();
     talp_output_record_process_info();
-    talp_output_finalize(json_filename, no_partial_output);
+    output_finalize(json_filename, no_partial_output);
     error += access(json_filename, F_OK);
     if (!error) cat_file(json_filename);
     int num_lines_in_json_w_process_info = count_lines(json_filename);
@@ -245,7 +298,7 @@ int main(int argc, char *argv[]) {
     char *json_template;
     asprintf(&json_template, "%s/talp_%%h_%%p.json", tmpdir);
     record_metrics();
-    talp_output_finalize(json_template, no_partial_output);
+    output_finalize(json_template, no_partial_output);
     char *real_filename;
     asprintf(&real_filename, "%s/talp_%s_%d.json", tmpdir, hostname, pid);
     error += access(real_filename, F_OK);
@@ -257,66 +310,101 @@ int main(int argc, char *argv[]) {
     bool partial_output = true;
     asprintf(&json_filename, "%s/talp.json", tmpdir);
     record_metrics();
-    talp_output_finalize(json_filename, partial_output);
+    output_finalize(json_filename, partial_output);
     asprintf(&real_filename, "%s/talp_%s_%d.partial.json", tmpdir, hostname, pid);
     error += access(real_filename, F_OK);
     if (!error) cat_file(real_filename);
     free(json_filename);
     free(real_filename);
 
+    /* JSON compressed with gzip */
+    const unsigned char gzip_magic[] = {0x1f, 0x8b};
+    asprintf(&json_filename, "%s/talp.json.gz", tmpdir);
+    record_metrics();
+    output_finalize(json_filename, no_partial_output);
+    assert( file_starts_with(json_filename, gzip_magic, sizeof(gzip_magic)) );
+    free(json_filename);
+
+    /* JSON compressed with gzip and partial output */
+    asprintf(&json_filename, "%s/talp.json.gz", tmpdir);
+    record_metrics();
+    output_finalize(json_filename, partial_output);
+    asprintf(&real_filename, "%s/talp_%s_%d.partial.json.gz", tmpdir, hostname, pid);
+    assert( file_starts_with(real_filename, gzip_magic, sizeof(gzip_magic)) );
+    free(json_filename);
+    free(real_filename);
+
+    /* JSON compressed with zstd, or uncompressed if zstd is not available */
+    const unsigned char zstd_magic[] = {0x28, 0xb5, 0x2f, 0xfd};
+    asprintf(&json_filename, "%s/talp.json.zst", tmpdir);
+    asprintf(&real_filename, "%s/talp.json", tmpdir);
+    remove(real_filename);
+    record_metrics();
+    output_finalize(json_filename, no_partial_output);
+    assert( file_starts_with(json_filename, zstd_magic, sizeof(zstd_magic))
+            || access(real_filename, F_OK) == 0 );
+    free(json_filename);
+    free(real_filename);
+
     /* CSV */
-    char *csv_filename, *csv1, *csv2, *csv3;
+    char *csv_filename, *csv1, *csv2, *csv3, *csv4;
     // single file
     asprintf(&csv_filename, "%s/talp.csv", tmpdir);
     dlb_pop_metrics_t metrics_1 = { .name = "Region 1" };
-    talp_output_record_pop_metrics(&metrics_1);
-    talp_output_finalize(csv_filename, no_partial_output);
+    talp_output_record_pop_metrics(&metrics_1, NULL);
+    output_finalize(csv_filename, no_partial_output);
     error += access(csv_filename, F_OK);
     if (!error) cat_file(csv_filename);
     // test append: 2 - > 3 lines
     dlb_pop_metrics_t metrics_2 = { .name = "Region 2" };
-    talp_output_record_pop_metrics(&metrics_2);
-    talp_output_finalize(csv_filename, no_partial_output);
+    talp_output_record_pop_metrics(&metrics_2, NULL);
+    output_finalize(csv_filename, no_partial_output);
     error += count_lines(csv_filename) - 3;  // test append, count_lines should return 3
     if (!error) cat_file(csv_filename);
     // multiple files
     asprintf(&csv1, "%s/talp-pop.csv", tmpdir);
     asprintf(&csv2, "%s/talp-node.csv", tmpdir);
     asprintf(&csv3, "%s/talp-process.csv", tmpdir);
+    asprintf(&csv4, "%s/talp-mpi.csv", tmpdir);
     record_metrics();
-    talp_output_finalize(csv_filename, no_partial_output);
+    output_finalize(csv_filename, no_partial_output);
     error += access(csv1, F_OK);
     error += access(csv2, F_OK);
     error += access(csv3, F_OK);
+    error += access(csv4, F_OK);
     if (!error) cat_file(csv1);
     if (!error) cat_file(csv2);
     if (!error) cat_file(csv3);
+    if (!error) cat_file(csv4);
+    error += count_lines(csv4) - 3;  // header and one line per type of call
     free(csv_filename);
     free(csv1);
     free(csv2);
     free(csv3);
+    free(csv4);
 
     /* TXT */
     char *txt_filename;
     asprintf(&txt_filename, "%s/talp.txt", tmpdir);
     record_metrics();
-    talp_output_finalize(txt_filename, no_partial_output);
+    output_finalize(txt_filename, no_partial_output);
     error += access(txt_filename, F_OK);
+    assert( file_contains(txt_filename, "MPI Calls") );
     free(txt_filename);
 
     /* No file */
     record_metrics();
-    talp_output_finalize(NULL, no_partial_output);
+    output_finalize(NULL, no_partial_output);
 
     /* Output to /dev/null */
     record_metrics();
-    talp_output_finalize("/dev/null", no_partial_output);
+    output_finalize("/dev/null", no_partial_output);
 
     /* Output to a directory that it does not exist */
     char *subdir_filename;
     asprintf(&subdir_filename, "%s/subdir/talp.json", tmpdir);
     record_metrics();
-    talp_output_finalize(subdir_filename, no_partial_output);
+    output_finalize(subdir_filename, no_partial_output);
     error += access(subdir_filename, F_OK);
     if (!error) cat_file(subdir_filename);
     free(subdir_filename);
@@ -325,7 +413,7 @@ int main(int argc, char *argv[]) {
      * (e.g., a directory or a file without writing permissions) */
     record_metrics();
     fprintf(stdout, "--- Fallback metrics in txt format:\n");
-    talp_output_finalize(tmpdir, no_partial_output);
+    output_finalize(tmpdir, no_partial_output);
     fflush(stdout);
 
     /* Output to a directory that cannot be created */
@@ -333,7 +421,7 @@ int main(int argc, char *argv[]) {
     asprintf(&wrong_subdir, "/subdir/talp.json");
     record_metrics();
     fprintf(stdout, "--- Fallback metrics in json format:\n");
-    talp_output_finalize(wrong_subdir, no_partial_output);
+    output_finalize(wrong_subdir, no_partial_output);
     fflush(stdout);
     free(wrong_subdir);
 
@@ -376,7 +464,7 @@ int main(int argc, char *argv[]) {
     /* Sanity checks */
     fprintf(stdout, "--- Wrong metrics:\n");
     record_wrong_metrics();
-    talp_output_finalize(NULL, no_partial_output);
+    output_finalize(NULL, no_partial_output);
     fflush(stdout);
 
     return error;
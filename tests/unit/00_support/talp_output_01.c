@@ -0,0 +1,394 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "extra_tests.h"
+
+#include "apis/dlb_talp.h"
+#include "support/mytime.h"
+#include "talp/talp_binary.h"
+#include "talp/talp_output.h"
+#include "talp/talp_types.h"
+#include "talp/talp_writer.h"
+
+#include <ftw.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <assert.h>
+
+/* Test the binary columnar output format of TALP, and compare its size and
+ * writing time with JSON */
+
+static char *tmpdir_template = NULL;
+static char *tmpdir = NULL;
+
+static int remove_callback(const char *fpath, const struct stat *sb,
+        int typeflag, struct FTW *ftwbuf) {
+    return remove(fpath);
+}
+
+__attribute__((destructor))
+static void delete_test_directory(void) {
+    if (tmpdir != NULL) {
+        nftw (tmpdir, remove_callback, 1, FTW_DEPTH | FTW_MOUNT | FTW_PHYS);
+    }
+
+    tmpdir = NULL;
+    free(tmpdir_template);
+    tmpdir_template = NULL;
+}
+
+static off_t file_size(const char *filename) {
+    struct stat st;
+    return stat(filename, &st) == 0 ? st.st_size : -1;
+}
+
+static void region_name(char *name, int region) {
+    snprintf(name, DLB_MONITOR_NAME_MAX, "Region %d", region);
+}
+
+static dlb_pop_metrics_t get_pop_metrics(int region) {
+    dlb_pop_metrics_t metrics = {
+        .num_cpus                     = 4 + region,
+        .num_mpi_ranks                = 4,
+        .num_nodes                    = 2,
+        .avg_cpus                     = 3.5f,
+        .cycles                       = 1e9 + region,
+        .instructions                 = 2e9,
+        .num_mpi_calls                = 100 * region,
+        .elapsed_time                 = 1000000000 + region,
+        .useful_time                  = 500000000,
+        .mpi_time                     = 300000000,
+        .min_mpi_normd_proc           = 1000.5,
+        .parallel_efficiency          = 0.24f,
+        .mpi_load_balance             = 0.25f,
+        .omp_serialization_efficiency = 0.95f,
+    };
+    region_name(metrics.name, region);
+    return metrics;
+}
+
+static process_record_t get_process_record(int region, int rank) {
+    process_record_t process_record = {
+        .rank = rank,
+        .pid = 1000 + rank,
+        .node_id = rank / 2,
+        .cpuset = "[0-3]",
+        .cpuset_quoted = "\"0-3\"",
+        .monitor = {
+            .num_cpus = 4,
+            .num_measurements = region + 1,
+            .num_mpi_calls = rank * 10 + region,
+            .elapsed_time = 1000000000LL * (region + 1),
+            .useful_time = 100 + rank,
+            .mpi_time = 200 + rank,
+        },
+    };
+    snprintf(process_record.hostname, HOST_NAME_MAX, "node%d", rank / 2);
+    return process_record;
+}
+
+static void record_metrics(int num_regions, int num_ranks) {
+
+    for (int region = 0; region < num_regions; ++region) {
+        dlb_pop_metrics_t metrics = get_pop_metrics(region);
+        talp_output_record_pop_metrics(&metrics, NULL);
+
+        char name[DLB_MONITOR_NAME_MAX];
+        region_name(name, region);
+        for (int rank = 0; rank < num_ranks; ++rank) {
+            process_record_t process_record = get_process_record(region, rank);
+            talp_output_record_process(name, &process_record, num_ranks);
+        }
+    }
+
+    node_record_t *node_record = malloc(sizeof(node_record_t)
+            + sizeof(process_in_node_record_t) * 2);
+    *node_record = (const node_record_t) {
+        .node_id = 1,
+        .nelems = 2,
+        .avg_useful_time = 150,
+        .avg_mpi_time = 250,
+        .max_useful_time = 200,
+        .max_mpi_time = 300,
+    };
+    node_record->processes[0] = (const process_in_node_record_t) {
+        .pid = 111, .mpi_time = 300, .useful_time = 100,
+    };
+    node_record->processes[1] = (const process_in_node_record_t) {
+        .pid = 222, .mpi_time = 200, .useful_time = 200,
+    };
+    talp_output_record_node(node_record);
+    free(node_record);
+
+    talp_output_record_resources(8, 8, 2, num_ranks, 0);
+}
+
+static int64_t time_output(const char *filename, int num_regions, int num_ranks) {
+    record_metrics(num_regions, num_ranks);
+    int64_t start = get_time_in_ns();
+    talp_output_finalize(filename, false);
+    talp_writer_finalize();
+    return get_time_in_ns() - start;
+}
+
+int main(int argc, char *argv[]) {
+
+    enum { NUM_REGIONS = 3 };
+    enum { NUM_RANKS = 4 };
+
+    /* Create temporary directory for TALP output files */
+    const char *tmpdir_env = getenv("TMPDIR");
+    asprintf(&tmpdir_template, "%s/dlb_test.XXXXXX", tmpdir_env ? tmpdir_env : "/tmp");
+    tmpdir = mkdtemp(tmpdir_template);
+
+    char *filename;
+    asprintf(&filename, "%s/talp.talp", tmpdir);
+
+    /* Round trip */
+    {
+        record_metrics(NUM_REGIONS, NUM_RANKS);
+        talp_output_record_process_info();
+        talp_output_finalize(filename, false);
+        talp_writer_finalize();
+
+        talp_binary_file_t *file = talp_binary_read(filename);
+        assert( file != NULL );
+        assert( strcmp(talp_binary_get_string(file, file->header->dlb_version),
+                    PACKAGE_VERSION) == 0 );
+        assert( file->header->num_cpus == 8 );
+        assert( file->header->num_mpi_ranks == NUM_RANKS );
+        assert( file->header->pid == getpid() );
+        assert( file->header->num_tables == 3 );
+
+        /* Application */
+        const talp_binary_table_view_t *table = talp_binary_get_table(file, "Application");
+        assert( table != NULL );
+        assert( table->num_rows == NUM_REGIONS );
+        const uint32_t *names = talp_binary_get_column(table, "regionName",
+                TALP_BINARY_STRING);
+        assert( names != NULL );
+        assert( talp_binary_get_column(table, "regionName", TALP_BINARY_INT32) == NULL );
+        assert( talp_binary_get_column(table, "unknown", TALP_BINARY_INT32) == NULL );
+        for (int region = 0; region < NUM_REGIONS; ++region) {
+            dlb_pop_metrics_t metrics = get_pop_metrics(region);
+            assert( strcmp(talp_binary_get_string(file, names[region]), metrics.name) == 0 );
+#define CHECK_COLUMN(var_name, c_type, json_name, fmt)                                  \
+            {                                                                           \
+                const c_type *column = talp_binary_get_column(table, #json_name,        \
+                        TALP_BINARY_TYPE_OF(c_type));                                   \
+                assert( column != NULL );                                               \
+                assert( column[region] == metrics.var_name );                           \
+            }
+            FOR_DLB_POP_METRICS_FIELDS(CHECK_COLUMN, CHECK_COLUMN)
+#undef CHECK_COLUMN
+        }
+
+        /* Process: region names and hostnames are stored once */
+        table = talp_binary_get_table(file, "Process");
+        assert( table != NULL );
+        assert( table->num_rows == NUM_REGIONS * NUM_RANKS );
+        names = talp_binary_get_column(table, "regionName", TALP_BINARY_STRING);
+        const uint32_t *hostnames = talp_binary_get_column(table, "hostname",
+                TALP_BINARY_STRING);
+        const int32_t *ranks = talp_binary_get_column(table, "rank", TALP_BINARY_INT32);
+        assert( names != NULL && hostnames != NULL && ranks != NULL );
+        assert( names[0] == names[NUM_RANKS - 1] );
+        assert( hostnames[0] == hostnames[NUM_RANKS] );
+        for (int region = 0; region < NUM_REGIONS; ++region) {
+            for (int rank = 0; rank < NUM_RANKS; ++rank) {
+                int row = region * NUM_RANKS + rank;
+                process_record_t record = get_process_record(region, rank);
+                char name[DLB_MONITOR_NAME_MAX];
+                region_name(name, region);
+                assert( strcmp(talp_binary_get_string(file, names[row]), name) == 0 );
+                assert( strcmp(talp_binary_get_string(file, hostnames[row]),
+                            record.hostname) == 0 );
+                assert( ranks[row] == rank );
+#define CHECK_COLUMN(var_name, c_type, json_name, fmt)                                  \
+                {                                                                       \
+                    const c_type *column = talp_binary_get_column(table, #json_name,    \
+                            TALP_BINARY_TYPE_OF(c_type));                               \
+                    assert( column != NULL );                                           \
+                    assert( column[row] == record.monitor.var_name );                   \
+                }
+                FOR_DLB_MONITOR_PRINTABLE_FIELDS(CHECK_COLUMN, CHECK_COLUMN)
+#undef CHECK_COLUMN
+            }
+        }
+
+        /* Node */
+        table = talp_binary_get_table(file, "Node");
+        assert( table != NULL );
+        assert( table->num_rows == 2 );
+        const int32_t *pids = talp_binary_get_column(table, "processId", TALP_BINARY_INT32);
+        const int64_t *mpi_times = talp_binary_get_column(table, "processMpiTime",
+                TALP_BINARY_INT64);
+        const int64_t *max_useful = talp_binary_get_column(table, "nodeMaxUsefulTime",
+                TALP_BINARY_INT64);
+        assert( pids[0] == 111 && pids[1] == 222 );
+        assert( mpi_times[0] == 300 && mpi_times[1] == 200 );
+        assert( max_useful[0] == 200 && max_useful[1] == 200 );
+
+        talp_binary_free(file);
+    }
+
+    /* MPI calls: one row per region and MPI call */
+    {
+        const char *call_names[] = { "MPI_Waitall", "MPI_Bcast" };
+        mpi_call_stats_t mpi_calls[] = {
+            { .num_calls = 10, .time = 1000 },
+            { .num_calls = 1, .time = 50, .bytes = 64 },
+        };
+        record_metrics(NUM_REGIONS, NUM_RANKS);
+        talp_output_record_mpi_calls("Region 0", 2, call_names, mpi_calls);
+        talp_output_record_mpi_calls("Region 1", 2, call_names,
+                (mpi_call_stats_t[2]){});
+        talp_output_finalize(filename, false);
+        talp_writer_finalize();
+
+        talp_binary_file_t *file = talp_binary_read(filename);
+        assert( file != NULL );
+        assert( file->header->num_tables == 4 );
+        const talp_binary_table_view_t *table = talp_binary_get_table(file, "MpiCalls");
+        assert( table != NULL );
+        assert( table->num_rows == 2 );
+        const uint32_t *types = talp_binary_get_column(table, "callType",
+                TALP_BINARY_STRING);
+        const int64_t *num_calls = talp_binary_get_column(table, "numCalls",
+                TALP_BINARY_INT64);
+        const int64_t *bytes = talp_binary_get_column(table, "bufferBytes",
+                TALP_BINARY_INT64);
+        assert( types != NULL && num_calls != NULL && bytes != NULL );
+        assert( strcmp(talp_binary_get_string(file, types[0]), "MPI_Waitall") == 0 );
+        assert( strcmp(talp_binary_get_string(file, types[1]), "MPI_Bcast") == 0 );
+        assert( num_calls[0] == 10 && num_calls[1] == 1 );
+        assert( bytes[0] == 0 && bytes[1] == 64 );
+        talp_binary_free(file);
+    }
+
+    /* Truncated and corrupted files are rejected */
+    {
+        off_t size = file_size(filename);
+        assert( size > 0 );
+        assert( truncate(filename, size / 2) == 0 );
+        assert( talp_binary_read(filename) == NULL );
+
+        FILE *file = fopen(filename, "w");
+        fprintf(file, "{ \"not\": \"binary\" }\n");
+        fclose(file);
+        assert( talp_binary_read(filename) == NULL );
+
+        assert( talp_binary_read("/non/existent/file.talp") == NULL );
+    }
+
+    /* Only records, without regions, still produce a valid file */
+    {
+        dlb_pop_metrics_t metrics = get_pop_metrics(0);
+        talp_output_record_pop_metrics(&metrics, NULL);
+        talp_output_finalize(filename, false);
+        talp_writer_finalize();
+        talp_binary_file_t *file = talp_binary_read(filename);
+        assert( file != NULL );
+        assert( file->header->num_tables == 1 );
+        assert( talp_binary_get_table(file, "Process") == NULL );
+        talp_binary_free(file);
+    }
+
+    /* Regions entered by a few ranks, recorded out of order and interleaved,
+     * only contain those ranks, sorted. A rank recorded again out of order
+     * keeps only its last record. */
+    {
+        enum { MANY_RANKS = 100000 };
+        enum { REPEATED_PID = 1 };
+        const int ranks_0[] = {70000, 2, 500, 2};
+        const int ranks_1[] = {9, 3};
+        char name_0[DLB_MONITOR_NAME_MAX], name_1[DLB_MONITOR_NAME_MAX];
+        region_name(name_0, 0);
+        region_name(name_1, 1);
+        for (int i = 0; i < 4; ++i) {
+            process_record_t process_record = get_process_record(0, ranks_0[i]);
+            if (i == 3) process_record.pid = REPEATED_PID;
+            talp_output_record_process(name_0, &process_record, MANY_RANKS);
+            if (i < 2) {
+                process_record = get_process_record(1, ranks_1[i]);
+                talp_output_record_process(name_1, &process_record, MANY_RANKS);
+            }
+        }
+        talp_output_finalize(filename, false);
+        talp_writer_finalize();
+
+        talp_binary_file_t *file = talp_binary_read(filename);
+        assert( file != NULL );
+        const talp_binary_table_view_t *table = talp_binary_get_table(file, "Process");
+        assert( table != NULL );
+        assert( table->num_rows == 5 );
+        const uint32_t *names = talp_binary_get_column(table, "regionName",
+                TALP_BINARY_STRING);
+        const int32_t *ranks = talp_binary_get_column(table, "rank", TALP_BINARY_INT32);
+        const int32_t *pids = talp_binary_get_column(table, "pid", TALP_BINARY_INT32);
+        assert( pids[0] == REPEATED_PID );
+        const int32_t expected_ranks[] = {2, 500, 70000, 3, 9};
+        for (int row = 0; row < 5; ++row) {
+            assert( ranks[row] == expected_ranks[row] );
+            assert( strcmp(talp_binary_get_string(file, names[row]),
+                        row < 3 ? name_0 : name_1) == 0 );
+        }
+        talp_binary_free(file);
+    }
+
+    /* Size and writing time compared to JSON */
+    if (DLB_EXTRA_TESTS)
+    {
+        enum { BENCH_REGIONS = 20 };
+        enum { BENCH_RANKS = 2000 };
+        char *json_filename;
+        asprintf(&json_filename, "%s/talp.json", tmpdir);
+
+        int64_t json_time = time_output(json_filename, BENCH_REGIONS, BENCH_RANKS);
+        int64_t binary_time = time_output(filename, BENCH_REGIONS, BENCH_RANKS);
+
+        int64_t start = get_time_in_ns();
+        talp_binary_file_t *file = talp_binary_read(filename);
+        int64_t read_time = get_time_in_ns() - start;
+        assert( file != NULL );
+        talp_binary_free(file);
+
+        printf("%d regions x %d processes\n", BENCH_REGIONS, BENCH_RANKS);
+        printf("%8s %14s %14s %14s\n", "Format", "Size (bytes)", "Write (ms)", "Read (ms)");
+        printf("%8s %14jd %14.2f %14s\n", "JSON", (intmax_t)file_size(json_filename),
+                json_time / 1e6, "-");
+        printf("%8s %14jd %14.2f %14.2f\n", "binary", (intmax_t)file_size(filename),
+                binary_time / 1e6, read_time / 1e6);
+        assert( file_size(filename) < file_size(json_filename) );
+
+        free(json_filename);
+    }
+
+    free(filename);
+
+    return 0;
+}
@@ -167,6 +167,17 @@ int main(int argc, char *argv[]) {
     assert(  equivalent_talp_model("hybrid-v1", "hybrid-v1") );
     assert( !equivalent_talp_model("hybrid-v1", "hybrid-v2") );
 
+    talp_timer_t talp_timer;
+    err = parse_talp_timer("", &talp_timer);
+    assert( err );
+    err = parse_talp_timer("clock", &talp_timer);
+    assert( !err && talp_timer == TALP_TIMER_CLOCK );
+    err = parse_talp_timer("TSC", &talp_timer);
+    assert( !err && talp_timer == TALP_TIMER_TSC );
+    assert( strcmp(talp_timer_tostr(TALP_TIMER_TSC), "tsc") == 0 );
+    assert(  equivalent_talp_timer("tsc", "TSC") );
+    assert( !equivalent_talp_timer("clock", "tsc") );
+
     mngo_mode_t mngo_mode;
     err = parse_mngo_mode("", &mngo_mode);          assert(err == DLB_ERR_NOENT);
     err = parse_mngo_mode("regions", &mngo_mode);   assert(!err && mngo_mode == MNGO_REGIONS);
@@ -70,9 +70,9 @@ int main(int argc, char **argv) {
 
         printf("Testing barrier with one process\n");
         shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
-        assert( shmem_barrier__register(NULL, lewi) == NULL );
+        assert( shmem_barrier__register(NULL, lewi, false) == NULL );
         assert( shmem_barrier__find(NULL) == NULL );
-        barrier_t *barrier = shmem_barrier__register(barrier_name, lewi);
+        barrier_t *barrier = shmem_barrier__register(barrier_name, lewi, false);
         assert( barrier != NULL );
         shmem_barrier__barrier(barrier);
         shmem_barrier__print_info(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
@@ -104,7 +104,7 @@ int main(int argc, char **argv) {
 
         printf("Testing multiple init/finalize\n");
         shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
-        barrier_t *barrier = shmem_barrier__register(barrier_name, lewi);
+        barrier_t *barrier = shmem_barrier__register(barrier_name, lewi, false);
         assert( barrier != NULL );
         barrier_t *barrier_copy = shmem_barrier__find(barrier_name);
         assert( barrier == barrier_copy);
@@ -118,7 +118,7 @@ int main(int argc, char **argv) {
         assert( shmem_barrier__detach(barrier) == DLB_ERR_NOSHMEM );
         shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
         shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
-        barrier = shmem_barrier__register(barrier_name, lewi);
+        barrier = shmem_barrier__register(barrier_name, lewi, false);
         assert( barrier != NULL );
         assert( shmem_barrier__exists() );
         assert( shmem_barrier__detach(barrier) == 0 );
@@ -169,7 +169,7 @@ int main(int argc, char **argv) {
                 spd_enter_dlb(NULL);
                 thread_spd->id = getpid();
                 shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
-                barrier_t *barrier = shmem_barrier__register(barrier_name, lewi);
+                barrier_t *barrier = shmem_barrier__register(barrier_name, lewi, false);
                 assert( barrier != NULL );
 
                 // Attach to the "test" shared memory and synchronize
@@ -256,7 +256,7 @@ int main(int argc, char **argv) {
                 spd_enter_dlb(NULL);
                 thread_spd->id = getpid();
                 shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
-                barrier_t *barrier = shmem_barrier__register(barrier_name, lewi);
+                barrier_t *barrier = shmem_barrier__register(barrier_name, lewi, false);
                 assert( barrier != NULL );
 
                 // Child 1 does DLB_BarrierDetach
@@ -61,14 +61,14 @@ int main(int argc, char **argv) {
 
         shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
         int max_barriers = shmem_barrier__get_max_barriers();
-        barrier_t *barrier0 = shmem_barrier__register("Barrier 0", DLB_BARRIER_LEWI_OFF);
+        barrier_t *barrier0 = shmem_barrier__register("Barrier 0", DLB_BARRIER_LEWI_OFF, false);
         assert( barrier0 != NULL );
         if (max_barriers > 2) {
-            barrier_t *barrier1 = shmem_barrier__register("Barrier 1", DLB_BARRIER_LEWI_OFF);
+            barrier_t *barrier1 = shmem_barrier__register("Barrier 1", DLB_BARRIER_LEWI_OFF, false);
             assert( barrier1 != NULL );
-            barrier_t *barrier2 = shmem_barrier__register("Barrier 2", DLB_BARRIER_LEWI_ON);
+            barrier_t *barrier2 = shmem_barrier__register("Barrier 2", DLB_BARRIER_LEWI_ON, false);
             assert( barrier2 != NULL );
-            barrier_t *barrier3 = shmem_barrier__register("Barrier 2", DLB_BARRIER_LEWI_ON);
+            barrier_t *barrier3 = shmem_barrier__register("Barrier 2", DLB_BARRIER_LEWI_ON, false);
             assert( barrier2 == barrier3 );
             assert( shmem_barrier__detach(barrier3) == 1 );
 
@@ -105,11 +105,11 @@ int main(int argc, char **argv) {
         for (j=0; j<2; ++j) {
             for (i=0; i<max_barriers; ++i) {
                 snprintf(barrier_name, 16, "Barrier %6d", i);
-                barrier_list[i] = shmem_barrier__register(barrier_name, lewi);
+                barrier_list[i] = shmem_barrier__register(barrier_name, lewi, false);
                 assert( barrier_list[i] != NULL );
             }
             snprintf(barrier_name, 16, "Doesn't fit");
-            barrier_list[i] = shmem_barrier__register(barrier_name, lewi);
+            barrier_list[i] = shmem_barrier__register(barrier_name, lewi, false);
             assert( barrier_list[i] == NULL );
             for (i=0; i<max_barriers; ++i) {
                 assert( shmem_barrier__detach(barrier_list[i]) == 0 );
@@ -0,0 +1,260 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "extra_tests.h"
+#include "unique_shmem.h"
+#include "test_process.h"
+
+#include "LB_comm/shmem_barrier.h"
+#include "LB_comm/shmem.h"
+#include "LB_core/spd.h"
+#include "support/atomic.h"
+#include "support/mask_utils.h"
+#include "support/mytime.h"
+#include "support/options.h"
+#include "support/debug.h"
+#include "apis/dlb_errors.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Test futex node barrier, and compare its latency with the pthread barrier */
+
+enum { SHMEM_SIZE_MULTIPLIER = 1 };
+enum { SYS_NUM_CPUS = 16 };
+enum { SYS_NUM_NODES = 4 };
+
+struct data {
+    pthread_barrier_t barrier;
+    atomic_uint arrivals;
+    int64_t elapsed_ns;
+};
+
+void* barrier_fn(void *arg) {
+    barrier_t *barrier = arg;
+    shmem_barrier__barrier(barrier);
+    return NULL;
+}
+
+/* Fork nprocs processes, each one pinned to a different CPU and thus spread
+ * among NUMA domains, that perform niters barriers. If check is set, verify
+ * that no process leaves a barrier before all processes have arrived.
+ * Return the average latency of a barrier, in nanoseconds. */
+static int64_t run_processes(int nprocs, int niters, bool futex, bool check) {
+
+    const char *barrier_name = futex ? "futex" : "pthread";
+
+    struct data *shdata;
+    shmem_handler_t *handler = shmem_init((void**)&shdata,
+            &(const shmem_props_t) {
+                .size = sizeof(struct data),
+                .name = "test",
+                .key = SHMEM_KEY,
+            });
+    pthread_barrierattr_t attr;
+    assert( pthread_barrierattr_init(&attr) == 0 );
+    assert( pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) == 0 );
+    assert( pthread_barrier_init(&shdata->barrier, &attr, nprocs) == 0 );
+    assert( pthread_barrierattr_destroy(&attr) == 0 );
+    shdata->arrivals = 0;
+    shdata->elapsed_ns = 0;
+
+    for (int child = 0; child < nprocs; ++child) {
+        pid_t pid = fork();
+        assert( pid >= 0 );
+        if (pid == 0) {
+            options_t options;
+            options_init(&options, NULL);
+            debug_init(&options);
+            spd_enter_dlb(NULL);
+            thread_spd->id = getpid();
+            CPU_ZERO(&thread_spd->process_mask);
+            CPU_SET(child % SYS_NUM_CPUS, &thread_spd->process_mask);
+
+            shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            barrier_t *barrier = shmem_barrier__register(barrier_name, false, futex);
+            assert( barrier != NULL );
+
+            // Wait until all processes have registered the barrier
+            int error = pthread_barrier_wait(&shdata->barrier);
+            assert(error == 0 || error == PTHREAD_BARRIER_SERIAL_THREAD);
+
+            int64_t start = get_time_in_ns();
+            for (int i = 0; i < niters; ++i) {
+                if (check) {
+                    DLB_ATOMIC_ADD(&shdata->arrivals, 1);
+                }
+                shmem_barrier__barrier(barrier);
+                if (check) {
+                    assert( DLB_ATOMIC_LD(&shdata->arrivals)
+                            >= (unsigned int)(nprocs * (i+1)) );
+                }
+            }
+            if (child == 0) {
+                shdata->elapsed_ns = get_time_in_ns() - start;
+            }
+
+            // Processes cannot detach until all of them are done
+            error = pthread_barrier_wait(&shdata->barrier);
+            assert(error == 0 || error == PTHREAD_BARRIER_SERIAL_THREAD);
+
+            assert( shmem_barrier__detach(barrier) >= 0 );
+            shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            shmem_finalize(handler, NULL);
+            dlb_test__exit(EXIT_SUCCESS);
+        }
+    }
+
+    int wstatus;
+    while(wait(&wstatus) > 0) {
+        if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) {
+            printf("Child return status: %d\n", WEXITSTATUS(wstatus));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int64_t latency = shdata->elapsed_ns / niters;
+    assert( pthread_barrier_destroy(&shdata->barrier) == 0 );
+    shmem_finalize(handler, NULL);
+
+    return latency;
+}
+
+int main(int argc, char **argv) {
+
+    /* Emulate a system with several NUMA nodes, all processes must agree */
+    mu_testing_set_sys(SYS_NUM_CPUS, SYS_NUM_CPUS, SYS_NUM_NODES);
+
+    /* Futex barrier with one process */
+    {
+        options_t options;
+        options_init(&options, NULL);
+        debug_init(&options);
+        spd_enter_dlb(NULL);
+        thread_spd->id = getpid();
+
+        shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+        barrier_t *barrier = shmem_barrier__register("futex", false, true);
+        assert( barrier != NULL );
+        shmem_barrier__barrier(barrier);
+        shmem_barrier__barrier(barrier);
+        assert( shmem_barrier__attach(barrier) == 2 );
+        assert( shmem_barrier__detach(barrier) == 1 );
+
+        /* The implementation is decided by the first process */
+        assert( shmem_barrier__register("futex", false, false) == barrier );
+        assert( shmem_barrier__detach(barrier) == 1 );
+
+        /* Perform several barriers with two threads of the same process */
+        assert( shmem_barrier__attach(barrier) == 2 );
+        for (int i = 0; i < 100; ++i) {
+            pthread_t thread1, thread2;
+            pthread_create(&thread1, NULL, barrier_fn, barrier);
+            pthread_create(&thread2, NULL, barrier_fn, barrier);
+            pthread_join(thread1, NULL);
+            pthread_join(thread2, NULL);
+        }
+        shmem_barrier__print_info(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+        assert( shmem_barrier__detach(barrier) == 1 );
+        assert( shmem_barrier__detach(barrier) == 0 );
+        assert( shmem_barrier__detach(barrier) == DLB_ERR_PERM );
+
+        shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+    }
+
+    /* A crashed process is removed from its own domain */
+    {
+        options_t options;
+        options_init(&options, NULL);
+        debug_init(&options);
+        spd_enter_dlb(NULL);
+        thread_spd->id = getpid();
+
+        /* This process in the last domain */
+        CPU_ZERO(&thread_spd->process_mask);
+        CPU_SET(SYS_NUM_CPUS-1, &thread_spd->process_mask);
+        shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+        barrier_t *barrier = shmem_barrier__register("futex", false, true);
+        assert( barrier != NULL );
+
+        /* Another process in the first domain attaches and dies */
+        pid_t pid = fork();
+        assert( pid >= 0 );
+        if (pid == 0) {
+            CPU_ZERO(&thread_spd->process_mask);
+            CPU_SET(0, &thread_spd->process_mask);
+            shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            assert( shmem_barrier__register("futex", false, true) != NULL );
+            dlb_test__exit(EXIT_SUCCESS);
+        }
+        int wstatus;
+        assert( waitpid(pid, &wstatus, 0) == pid );
+        assert( WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == EXIT_SUCCESS );
+
+        /* The next process attaching to the shmem cleans up the dead one */
+        pid = fork();
+        assert( pid >= 0 );
+        if (pid == 0) {
+            shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            dlb_test__exit(EXIT_SUCCESS);
+        }
+        assert( waitpid(pid, &wstatus, 0) == pid );
+        assert( WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == EXIT_SUCCESS );
+
+        /* This process is the only participant of its domain */
+        shmem_barrier__barrier(barrier);
+        assert( shmem_barrier__attach(barrier) == 2 );
+        assert( shmem_barrier__detach(barrier) == 1 );
+        assert( shmem_barrier__detach(barrier) == 0 );
+        shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+    }
+
+    /* Futex barrier with several processes in different NUMA domains */
+    {
+        run_processes(SYS_NUM_NODES + 1, 100, true, true);
+        run_processes(SYS_NUM_NODES + 1, 100, false, true);
+    }
+
+    /* Latency of both barrier implementations */
+    if (DLB_EXTRA_TESTS)
+    {
+        enum { NUM_ITERS = 200 };
+        printf("%12s %16s %16s\n", "Participants", "pthread (us)", "futex (us)");
+        for (int nprocs = 2; nprocs <= 256; nprocs *= 2) {
+            int64_t pthread_latency = run_processes(nprocs, NUM_ITERS, false, false);
+            int64_t futex_latency = run_processes(nprocs, NUM_ITERS, true, false);
+            printf("%12d %16.2f %16.2f\n", nprocs,
+                    pthread_latency / 1000.0, futex_latency / 1000.0);
+        }
+    }
+
+    return 0;
+}
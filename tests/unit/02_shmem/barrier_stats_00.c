@@ -0,0 +1,286 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "unique_shmem.h"
+#include "test_process.h"
+
+#include "LB_comm/shmem_barrier.h"
+#include "LB_comm/shmem.h"
+#include "LB_core/spd.h"
+#include "support/mask_utils.h"
+#include "support/options.h"
+#include "support/debug.h"
+#include "apis/dlb_errors.h"
+#include "apis/dlb_types.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Test the arrival skew statistics of the node barrier */
+
+enum { SHMEM_SIZE_MULTIPLIER = 1 };
+enum { NUM_PROCS = 3 };
+enum { NUM_ITERS = 20 };
+enum { DELAY_US = 2000 };
+
+struct data {
+    pthread_barrier_t barrier;
+};
+
+/* Fork NUM_PROCS processes that perform NUM_ITERS barriers. The last process
+ * sleeps DELAY_US before each barrier so it always arrives the last. */
+static void run_processes(bool futex, bool split_phase) {
+
+    const char *barrier_name = futex ? "futex" : "pthread";
+
+    struct data *shdata;
+    shmem_handler_t *handler = shmem_init((void**)&shdata,
+            &(const shmem_props_t) {
+                .size = sizeof(struct data),
+                .name = "test",
+                .key = SHMEM_KEY,
+            });
+    pthread_barrierattr_t attr;
+    assert( pthread_barrierattr_init(&attr) == 0 );
+    assert( pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) == 0 );
+    assert( pthread_barrier_init(&shdata->barrier, &attr, NUM_PROCS) == 0 );
+    assert( pthread_barrierattr_destroy(&attr) == 0 );
+
+    for (int child = 0; child < NUM_PROCS; ++child) {
+        pid_t pid = fork();
+        assert( pid >= 0 );
+        if (pid == 0) {
+            options_t options;
+            options_init(&options, NULL);
+            debug_init(&options);
+            spd_enter_dlb(NULL);
+            thread_spd->id = getpid();
+
+            shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            barrier_t *barrier = shmem_barrier__register(barrier_name, false, futex);
+            assert( barrier != NULL );
+
+            // Wait until all processes have registered the barrier
+            int error = pthread_barrier_wait(&shdata->barrier);
+            assert(error == 0 || error == PTHREAD_BARRIER_SERIAL_THREAD);
+
+            bool late = child == NUM_PROCS - 1;
+            for (int i = 0; i < NUM_ITERS; ++i) {
+                if (late) {
+                    usleep(DELAY_US);
+                }
+                if (split_phase) {
+                    assert( shmem_barrier__arrive(barrier) == DLB_SUCCESS );
+                    assert( shmem_barrier__wait(barrier) == DLB_SUCCESS );
+                } else {
+                    shmem_barrier__barrier(barrier);
+                }
+            }
+
+            // Processes cannot detach until all of them are done
+            error = pthread_barrier_wait(&shdata->barrier);
+            assert(error == 0 || error == PTHREAD_BARRIER_SERIAL_THREAD);
+
+            // Statistics are shared by all participants
+            dlb_barrier_stats_t stats;
+            assert( shmem_barrier__get_stats(barrier, &stats) == DLB_SUCCESS );
+            assert( stats.num_episodes == NUM_ITERS );
+            assert( stats.skew_min <= stats.skew_avg );
+            assert( stats.skew_avg <= stats.skew_max );
+            assert( stats.skew_min >= DELAY_US * 1000 / 2 );
+            assert( stats.last_arrival_count[0] == NUM_ITERS );
+            assert( stats.last_arrival_count[1] == 0 );
+            assert( stats.last_arrival_pid[1] == 0 );
+            if (late) {
+                assert( stats.last_arrival_pid[0] == getpid() );
+            }
+
+            // Every participant waits once per episode
+            unsigned int nwaits = 0;
+            for (int i = 0; i < DLB_BARRIER_STATS_HIST_SIZE; ++i) {
+                nwaits += stats.wait_histogram[i];
+            }
+            assert( nwaits == NUM_PROCS * NUM_ITERS );
+
+            error = pthread_barrier_wait(&shdata->barrier);
+            assert(error == 0 || error == PTHREAD_BARRIER_SERIAL_THREAD);
+
+            if (late) {
+                shmem_barrier__print_info(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            }
+            assert( shmem_barrier__detach(barrier) >= 0 );
+            shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            shmem_finalize(handler, NULL);
+            dlb_test__exit(EXIT_SUCCESS);
+        }
+    }
+
+    int wstatus;
+    while(wait(&wstatus) > 0) {
+        if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) {
+            printf("Child return status: %d\n", WEXITSTATUS(wstatus));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    assert( pthread_barrier_destroy(&shdata->barrier) == 0 );
+    shmem_finalize(handler, NULL);
+}
+
+int main(int argc, char **argv) {
+
+    /* Single process */
+    {
+        options_t options;
+        options_init(&options, NULL);
+        debug_init(&options);
+        spd_enter_dlb(NULL);
+        thread_spd->id = getpid();
+
+        dlb_barrier_stats_t stats;
+        assert( shmem_barrier__get_stats(NULL, &stats) == DLB_ERR_UNKNOWN );
+
+        shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+        barrier_t *barrier = shmem_barrier__register("futex", false, true);
+        assert( barrier != NULL );
+        assert( shmem_barrier__get_stats(barrier, NULL) == DLB_ERR_UNKNOWN );
+
+        /* No episodes yet */
+        assert( shmem_barrier__get_stats(barrier, &stats) == DLB_SUCCESS );
+        assert( stats.num_episodes == 0 );
+        assert( stats.skew_avg == 0 );
+        assert( stats.last_arrival_pid[0] == 0 );
+
+        /* With one participant, the skew is always zero */
+        shmem_barrier__barrier(barrier);
+        shmem_barrier__barrier(barrier);
+        assert( shmem_barrier__arrive(barrier) == DLB_SUCCESS );
+        assert( shmem_barrier__test(barrier) == DLB_SUCCESS );
+        assert( shmem_barrier__get_stats(barrier, &stats) == DLB_SUCCESS );
+        assert( stats.num_episodes == 3 );
+        assert( stats.skew_max == 0 );
+        unsigned int nwaits = 0;
+        for (int i = 0; i < DLB_BARRIER_STATS_HIST_SIZE; ++i) {
+            nwaits += stats.wait_histogram[i];
+        }
+        assert( nwaits == 3 );
+        assert( stats.last_arrival_pid[0] == getpid() );
+        assert( stats.last_arrival_count[0] == 3 );
+
+        assert( shmem_barrier__detach(barrier) == 0 );
+        assert( shmem_barrier__get_stats(barrier, &stats) == DLB_ERR_PERM );
+
+        /* A new barrier in the same spot starts with empty statistics */
+        barrier = shmem_barrier__register("pthread", false, false);
+        assert( barrier != NULL );
+        assert( shmem_barrier__get_stats(barrier, &stats) == DLB_SUCCESS );
+        assert( stats.num_episodes == 0 );
+        assert( shmem_barrier__detach(barrier) == 0 );
+
+        shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+        assert( shmem_barrier__get_stats(barrier, &stats) == DLB_ERR_NOSHMEM );
+    }
+
+    /* The statistics entry of a process is cleared when it detaches or dies.
+     * The shmem must have room for the pid of the dead process. */
+    mu_testing_set_sys_size(4);
+    for (int child_dies = 0; child_dies <= 1; ++child_dies) {
+        options_t options;
+        options_init(&options, NULL);
+        debug_init(&options);
+        spd_enter_dlb(NULL);
+        thread_spd->id = getpid();
+
+        shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+        barrier_t *barrier = shmem_barrier__register("futex", false, true);
+        assert( barrier != NULL );
+
+        /* The child arrives the last at one episode */
+        int pipe_to_child[2], pipe_to_parent[2];
+        assert( pipe(pipe_to_child) == 0 && pipe(pipe_to_parent) == 0 );
+        char c = 0;
+        pid_t pid = fork();
+        assert( pid >= 0 );
+        if (pid == 0) {
+            shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            barrier = shmem_barrier__register("futex", false, true);
+            assert( barrier != NULL );
+            assert( write(pipe_to_parent[1], &c, 1) == 1 );
+            assert( read(pipe_to_child[0], &c, 1) == 1 );
+            shmem_barrier__barrier(barrier);
+            if (!child_dies) {
+                assert( shmem_barrier__detach(barrier) == 1 );
+                shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+            }
+            dlb_test__exit(EXIT_SUCCESS);
+        }
+        assert( read(pipe_to_parent[0], &c, 1) == 1 );
+        assert( shmem_barrier__arrive(barrier) == DLB_SUCCESS );
+        assert( write(pipe_to_child[1], &c, 1) == 1 );
+        assert( shmem_barrier__wait(barrier) == DLB_SUCCESS );
+        int wstatus;
+        assert( waitpid(pid, &wstatus, 0) == pid );
+        assert( WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == EXIT_SUCCESS );
+
+        if (child_dies) {
+            /* The next process attaching to the shmem cleans up the dead one */
+            pid = fork();
+            assert( pid >= 0 );
+            if (pid == 0) {
+                shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+                shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+                shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+                dlb_test__exit(EXIT_SUCCESS);
+            }
+            assert( waitpid(pid, &wstatus, 0) == pid );
+            assert( WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == EXIT_SUCCESS );
+        }
+
+        /* The episode is kept, but not the child in the ranking */
+        dlb_barrier_stats_t stats;
+        assert( shmem_barrier__get_stats(barrier, &stats) == DLB_SUCCESS );
+        assert( stats.num_episodes == 1 );
+        assert( stats.last_arrival_pid[0] == 0 );
+
+        for (int i = 0; i < 4; ++i) {
+            close(i < 2 ? pipe_to_child[i] : pipe_to_parent[i-2]);
+        }
+        assert( shmem_barrier__detach(barrier) == 0 );
+        shmem_barrier__finalize(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
+    }
+    mu_finalize();
+
+    /* Several processes, one of them always arrives the last */
+    {
+        run_processes(true, false);
+        run_processes(true, true);
+        run_processes(false, false);
+    }
+
+    return 0;
+}
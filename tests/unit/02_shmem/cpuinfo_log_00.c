@@ -0,0 +1,184 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "unique_shmem.h"
+
+#include "LB_comm/shmem.h"
+#include "LB_comm/shmem_cpuinfo.h"
+#include "LB_comm/shmem_cpuinfo_log.h"
+#include "LB_core/DLB_kernel.h"
+#include "LB_core/spd.h"
+#include "LB_policies/lewi_sim.h"
+#include "apis/dlb_errors.h"
+#include "support/mask_utils.h"
+
+#include <sched.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Record LeWI operations, save a snapshot and replay them through the policy
+
+static void check_free_cpus(const char *shmem_key, void *arg) {
+    const cpu_set_t *expected_free_cpus = arg;
+    assert( !shmem_exists("cpuinfo", shmem_key) );
+    assert( CPU_EQUAL(shmem_cpuinfo_testing__get_free_cpu_set(), expected_free_cpus) );
+}
+
+int main(int argc, char *argv[]) {
+
+    char filename[] = "/tmp/dlb_snapshot_XXXXXX";
+    int fd = mkstemp(filename);
+    assert( fd != -1 );
+    close(fd);
+
+    // Operations are recorded by DLB_kernel with --lewi-record
+    {
+        int cpu = sched_getcpu();
+        cpu_set_t process_mask;
+        CPU_ZERO(&process_mask);
+        CPU_SET(cpu, &process_mask);
+
+        char options[64] = "--lewi --lewi-record --shm-key=";
+        strcat(options, SHMEM_KEY);
+        subprocess_descriptor_t spd;
+        spd_enter_dlb(&spd);
+        assert( Initialize(&spd, 111, 0, &process_mask, options) == DLB_SUCCESS );
+        assert( shmem_cpuinfo_log__exists() );
+        assert( lend_cpu(&spd, cpu) == DLB_SUCCESS );
+        assert( reclaim(&spd) == DLB_SUCCESS );
+
+        // Snapshot all shared memories while the process is running
+        assert( shmem_snapshot__save(filename) == DLB_SUCCESS );
+
+        // The log is removed along with the last process, after saving it
+        assert( Finish(&spd) == DLB_SUCCESS );
+        assert( !shmem_cpuinfo_log__exists() );
+        assert( !shmem_exists("cpuinfolog", SHMEM_KEY) );
+
+        // The saved log contains the whole run, including finalize
+        {
+            char dump_filename[128];
+            snprintf(dump_filename, sizeof(dump_filename),
+                    "DLB_cpuinfolog_%s.dlbsnap", SHMEM_KEY);
+            void *log_shdata;
+            size_t size;
+            assert( shmem_snapshot__load(dump_filename, "cpuinfolog", &log_shdata, &size)
+                    == DLB_SUCCESS );
+            cpuinfo_log_entry_t *entries;
+            int nelems;
+            int64_t dropped;
+            assert( shmem_cpuinfo_log__parse(log_shdata, size, &entries, &nelems, &dropped)
+                    == DLB_SUCCESS );
+            assert( nelems == 4 );
+            assert( entries[3].op == CPUINFO_LOG_FINALIZE && entries[3].pid == 111 );
+            free(entries);
+            free(log_shdata);
+            unlink(dump_filename);
+        }
+
+        // Load the log from the snapshot
+        void *log_shdata;
+        size_t size;
+        assert( shmem_snapshot__load(filename, "cpuinfolog", &log_shdata, &size)
+                == DLB_SUCCESS );
+        assert( shmem_snapshot__load(filename, "nonexistent", &log_shdata, &size)
+                == DLB_ERR_NOENT );
+        cpuinfo_log_entry_t *entries;
+        int nelems;
+        int64_t dropped;
+        assert( shmem_cpuinfo_log__parse(log_shdata, size, &entries, &nelems, &dropped)
+                == DLB_SUCCESS );
+        assert( dropped == 0 );
+        assert( nelems == 3 );
+        assert( entries[0].op == CPUINFO_LOG_INIT && entries[0].pid == 111
+                && CPU_EQUAL(&entries[0].mask, &process_mask) );
+        assert( entries[1].op == CPUINFO_LOG_LEND_CPU && entries[1].arg == cpu );
+        assert( entries[2].op == CPUINFO_LOG_RECLAIM );
+        assert( entries[1].timestamp >= entries[0].timestamp );
+        free(entries);
+
+        // Corrupted data
+        assert( shmem_cpuinfo_log__parse(log_shdata, 8, &entries, &nelems, &dropped)
+                == DLB_ERR_NOCOMP );
+        free(log_shdata);
+
+        // Replay from file, including printing
+        assert( lewi_sim_replay(filename, 0.0, NULL, 0, DLB_COLOR_AUTO) == DLB_SUCCESS );
+        assert( lewi_sim_replay("/nonexistent", 0.0, NULL, 0, DLB_COLOR_AUTO)
+                == DLB_ERR_NOENT );
+    }
+
+    // Replay of a synthetic log through the policy with different options
+    {
+        enum { SYS_SIZE = 4 };
+        mu_init();
+        mu_testing_set_sys_size(SYS_SIZE);
+
+        // P1 owns [0011] and P2 owns [1100]
+        cpu_set_t p1_mask, p2_mask, empty_mask, cpu_3_mask;
+        mu_parse_mask("0-1", &p1_mask);
+        mu_parse_mask("2-3", &p2_mask);
+        CPU_ZERO(&empty_mask);
+        mu_parse_mask("3", &cpu_3_mask);
+
+        // P2 lends its CPUs, P1 borrows as many as possible, P2 reclaims
+        // them and P1 returns them
+        const cpuinfo_log_entry_t entries[] = {
+            { .timestamp = 1, .pid = 111, .op = CPUINFO_LOG_INIT, .mask = p1_mask },
+            { .timestamp = 2, .pid = 222, .op = CPUINFO_LOG_INIT, .mask = p2_mask },
+            { .timestamp = 3, .pid = 222, .op = CPUINFO_LOG_LEND_CPU_MASK, .mask = p2_mask },
+            { .timestamp = 4, .pid = 111, .op = CPUINFO_LOG_BORROW },
+            { .timestamp = 5, .pid = 222, .op = CPUINFO_LOG_RECLAIM },
+            { .timestamp = 6, .pid = 111, .op = CPUINFO_LOG_RETURN },
+            { .timestamp = 7, .pid = 333, .op = CPUINFO_LOG_LEND },
+        };
+        enum { NELEMS = sizeof(entries) / sizeof(entries[0]) };
+
+        // Up to the borrow, P1 takes all the CPUs lent by P2
+        assert( lewi_sim_replay_log(entries, NELEMS, 4, NULL,
+                    check_free_cpus, &empty_mask) == DLB_SUCCESS );
+
+        // With a different policy option, P1 takes only one CPU
+        assert( lewi_sim_replay_log(entries, NELEMS, 4, "--lewi-max-parallelism=3",
+                    check_free_cpus, &cpu_3_mask) == DLB_SUCCESS );
+
+        // Full replay: all CPUs are back to their owners, and the
+        // operation of an unknown process is skipped
+        assert( lewi_sim_replay_log(entries, NELEMS, 0, NULL,
+                    check_free_cpus, &empty_mask) == DLB_SUCCESS );
+
+        // Logs out of the current node size are rejected
+        cpuinfo_log_entry_t large_entry = entries[0];
+        CPU_SET(SYS_SIZE, &large_entry.mask);
+        assert( lewi_sim_replay_log(&large_entry, 1, 0, NULL, NULL, NULL)
+                == DLB_ERR_NOCOMP );
+    }
+
+    unlink(filename);
+
+    return 0;
+}
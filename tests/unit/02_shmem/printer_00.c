@@ -90,9 +90,9 @@ int main(int argc, char *argv[]) {
     assert( shmem_procinfo__init(p2_pid, 0, &p2_mask, NULL, SHMEM_KEY,
                 SHMEM_SIZE_MULTIPLIER) == DLB_SUCCESS );
     shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
-    barrier_t *default_barrier = shmem_barrier__register("Barrier 0", 0);
+    barrier_t *default_barrier = shmem_barrier__register("Barrier 0", 0, false);
     assert( default_barrier != NULL );
-    barrier_t *barrier1 = shmem_barrier__register("Barrier 1", DLB_BARRIER_LEWI_OFF);
+    barrier_t *barrier1 = shmem_barrier__register("Barrier 1", DLB_BARRIER_LEWI_OFF, false);
     assert( barrier1 != NULL );
     /* p1_pid and p2_pid */
     assert( shmem_talp__init(SHMEM_KEY, SHMEM_TALP_SIZE_MULTIPLIER) == DLB_SUCCESS );
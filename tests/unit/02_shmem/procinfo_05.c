@@ -0,0 +1,193 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "unique_shmem.h"
+
+#include "LB_comm/shmem_procinfo.h"
+#include "apis/dlb_errors.h"
+#include "apis/dlb_types.h"
+#include "support/mask_utils.h"
+
+#include <sched.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+// DROM masks applied in staged steps with a migration budget
+
+int main( int argc, char **argv ) {
+
+    enum { SHMEM_SIZE_MULTIPLIER = 1 };
+
+    // 8 CPUs, 2 NUMA nodes: [0-3] [4-7]
+    enum { SYS_NCPUS = 8 };
+    enum { SYS_NCORES = 8 };
+    enum { SYS_NNODES = 2 };
+    mu_init();
+    mu_testing_set_sys(SYS_NCPUS, SYS_NCORES, SYS_NNODES);
+
+    enum { NO_BUDGET = 0 };
+    enum { BUDGET = 2 };
+    const int64_t long_interval = 3600 * 1000000000LL;
+    const int64_t short_interval = 1;
+
+    cpu_set_t process_mask, new_mask, polled_mask, expected_mask;
+    pid_t pid = getpid();
+    pid_t pid2 = pid + 1;
+    int ncpus, migrated_cpus, cross_numa;
+
+    // Initialize with [0,1,4,5]
+    mu_parse_mask("0,1,4,5", &process_mask);
+    assert( shmem_procinfo__init(pid, 0, &process_mask, NULL, SHMEM_KEY,
+                SHMEM_SIZE_MULTIPLIER) == DLB_SUCCESS );
+    assert( shmem_procinfo__setmigrationbudget(pid, BUDGET, long_interval)
+            == DLB_SUCCESS );
+    assert( shmem_procinfo__setmigrationbudget(1, BUDGET, long_interval)
+            == DLB_ERR_NOPROC );
+
+    // Nothing to poll
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_NOUPDT );
+
+    // Move two CPUs in each NUMA node: [0,1,4,5] -> [2,3,6,7]
+    mu_parse_mask("2,3,6,7", &new_mask);
+    assert( shmem_procinfo__setprocessmask(pid, &new_mask, DLB_NO_SYNC, NULL)
+            == DLB_SUCCESS );
+    assert( shmem_procinfo__getfuturemask(pid, &polled_mask) == DLB_SUCCESS );
+    assert( CPU_EQUAL(&polled_mask, &new_mask) );
+
+    // First step: two intra-NUMA migrations
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_SUCCESS );
+    assert( ncpus == 4 );
+    assert( !CPU_EQUAL(&polled_mask, &new_mask) );
+    assert( CPU_COUNT(&polled_mask) == 4 );
+    cpu_set_t node_mask;
+    mu_parse_mask("0-3", &node_mask);
+    CPU_AND(&node_mask, &node_mask, &polled_mask);
+    assert( CPU_COUNT(&node_mask) == 2 );
+    assert( shmem_procinfo__getmigratedcpus(pid, &migrated_cpus, &cross_numa)
+            == DLB_SUCCESS );
+    assert( migrated_cpus == 2 && cross_numa == 0 );
+
+    // Budget exhausted during this interval
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_NOUPDT );
+
+    // A new interval completes the update
+    assert( shmem_procinfo__setmigrationbudget(pid, BUDGET, short_interval)
+            == DLB_SUCCESS );
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_SUCCESS );
+    assert( CPU_EQUAL(&polled_mask, &new_mask) );
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_NOUPDT );
+    assert( shmem_procinfo__getmigratedcpus(pid, &migrated_cpus, &cross_numa)
+            == DLB_SUCCESS );
+    assert( migrated_cpus == 4 && cross_numa == 0 );
+
+    // Cross-NUMA migration with no budget is applied at once: [2,3,6,7] -> [0-3]
+    assert( shmem_procinfo__setmigrationbudget(pid, NO_BUDGET, short_interval)
+            == DLB_SUCCESS );
+    mu_parse_mask("0-3", &new_mask);
+    assert( shmem_procinfo__setprocessmask(pid, &new_mask, DLB_NO_SYNC, NULL)
+            == DLB_SUCCESS );
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_SUCCESS );
+    assert( CPU_EQUAL(&polled_mask, &new_mask) );
+    assert( shmem_procinfo__getmigratedcpus(pid, &migrated_cpus, &cross_numa)
+            == DLB_SUCCESS );
+    assert( migrated_cpus == 6 && cross_numa == 2 );
+
+    // Shrinking with budget 1 removes one CPU per step: [0-3] -> [0]
+    assert( shmem_procinfo__setmigrationbudget(pid, 1, short_interval)
+            == DLB_SUCCESS );
+    mu_parse_mask("0", &new_mask);
+    assert( shmem_procinfo__setprocessmask(pid, &new_mask, DLB_NO_SYNC, NULL)
+            == DLB_SUCCESS );
+    for (int expected_ncpus = 3; expected_ncpus >= 1; --expected_ncpus) {
+        assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_SUCCESS );
+        assert( ncpus == expected_ncpus );
+        assert( CPU_ISSET(0, &polled_mask) );
+        usleep(1);
+    }
+    assert( CPU_EQUAL(&polled_mask, &new_mask) );
+
+    // Stolen CPUs move in matched steps: the victim only releases the CPUs
+    // of the current step. pid: [0] -> [0,4-7], pid2: [4-7] -> []
+    mu_parse_mask("4-7", &process_mask);
+    assert( shmem_procinfo__init(pid2, 0, &process_mask, NULL, SHMEM_KEY,
+                SHMEM_SIZE_MULTIPLIER) == DLB_SUCCESS );
+    assert( shmem_procinfo__setmigrationbudget(pid, BUDGET, long_interval)
+            == DLB_SUCCESS );
+    mu_parse_mask("0,4-7", &new_mask);
+    assert( shmem_procinfo__setprocessmask(pid, &new_mask, DLB_NO_SYNC, NULL)
+            == DLB_SUCCESS );
+    assert( shmem_procinfo__polldrom(pid2, &ncpus, &polled_mask) == DLB_SUCCESS );
+    mu_parse_mask("6,7", &expected_mask);
+    assert( CPU_EQUAL(&polled_mask, &expected_mask) );
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_SUCCESS );
+    mu_parse_mask("0,4,5", &expected_mask);
+    assert( CPU_EQUAL(&polled_mask, &expected_mask) );
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_NOUPDT );
+    assert( shmem_procinfo__polldrom(pid2, &ncpus, &polled_mask) == DLB_NOUPDT );
+
+    // A staged process is not dirty, new requests replace the staged mask
+    mu_parse_mask("0,4", &new_mask);
+    assert( shmem_procinfo__setprocessmask(pid, &new_mask, DLB_NO_SYNC, NULL)
+            == DLB_SUCCESS );
+    assert( shmem_procinfo__getfuturemask(pid, &polled_mask) == DLB_SUCCESS );
+    assert( CPU_EQUAL(&polled_mask, &new_mask) );
+    assert( shmem_procinfo__setmigrationbudget(pid, 1, short_interval)
+            == DLB_SUCCESS );
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_SUCCESS );
+    assert( CPU_EQUAL(&polled_mask, &new_mask) );
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_NOUPDT );
+
+    // A request while a step is pending replaces the final mask only
+    mu_parse_mask("0,4,6,7", &new_mask);
+    assert( shmem_procinfo__setprocessmask(pid, &new_mask, DLB_NO_SYNC, NULL)
+            == DLB_SUCCESS );
+    mu_parse_mask("0,4", &new_mask);
+    assert( shmem_procinfo__setprocessmask(pid, &new_mask, DLB_NO_SYNC, NULL)
+            == DLB_SUCCESS );
+    assert( shmem_procinfo__polldrom(pid2, &ncpus, &polled_mask) == DLB_SUCCESS );
+    mu_parse_mask("7", &expected_mask);
+    assert( CPU_EQUAL(&polled_mask, &expected_mask) );
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_SUCCESS );
+    mu_parse_mask("0,4,6", &expected_mask);
+    assert( CPU_EQUAL(&polled_mask, &expected_mask) );
+    usleep(1);
+    assert( shmem_procinfo__polldrom(pid, &ncpus, &polled_mask) == DLB_SUCCESS );
+    assert( CPU_EQUAL(&polled_mask, &new_mask) );
+    assert( shmem_procinfo__polldrom(pid2, &ncpus, &polled_mask) == DLB_NOUPDT );
+
+    assert( shmem_procinfo__finalize(pid2, false, SHMEM_KEY, SHMEM_SIZE_MULTIPLIER)
+            == DLB_SUCCESS );
+
+    // Unknown process
+    assert( shmem_procinfo__getmigratedcpus(1, &migrated_cpus, &cross_numa)
+            == DLB_ERR_NOPROC );
+
+    // Finalize
+    assert( shmem_procinfo__finalize(pid, false, SHMEM_KEY, SHMEM_SIZE_MULTIPLIER)
+            == DLB_SUCCESS );
+
+    mu_finalize();
+
+    return 0;
+}
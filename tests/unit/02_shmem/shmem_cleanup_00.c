@@ -57,7 +57,7 @@ int main(int argc, char *argv[]) {
                     SHMEM_SIZE_MULTIPLIER) == DLB_SUCCESS );
         assert( shmem_async_init(child_pid, NULL, &process_mask, SHMEM_KEY, 1) == DLB_SUCCESS );
         shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
-        shmem_barrier__register("barrier", 0);
+        shmem_barrier__register("barrier", 0, false);
         ConfigShMem(1, 0, SHMEM_KEY);
 
         /* Invoke _exit so that call assert_shmem destructors are not called */
@@ -75,7 +75,7 @@ int main(int argc, char *argv[]) {
                     SHMEM_SIZE_MULTIPLIER) == DLB_SUCCESS );
         assert( shmem_async_init(child_pid, NULL, &process_mask, SHMEM_KEY, 1) == DLB_SUCCESS );
         shmem_barrier__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER);
-        barrier_t *barrier = shmem_barrier__register("barrier", 0);
+        barrier_t *barrier = shmem_barrier__register("barrier", 0, false);
         assert( barrier != NULL );
         ConfigShMem(1, 0, SHMEM_KEY);
 
@@ -26,11 +26,13 @@
 #include "LB_comm/shmem_async.h"
 #include "LB_comm/shmem_barrier.h"
 #include "LB_comm/shmem_cpuinfo.h"
+#include "LB_comm/shmem_cpuinfo_log.h"
 #include "LB_comm/shmem_lewi_async.h"
 #include "LB_comm/shmem_procinfo.h"
 #include "LB_comm/shmem_talp.h"
 #include "support/mask_utils.h"
 #include "support/atomic.h"
+#include "support/types.h"
 
 #include <sched.h>
 #include <unistd.h>
@@ -127,11 +129,36 @@ static void check_async_version(void) {
 }
 
 static void check_barrier_version(void) {
-    enum { KNOWN_BARRIER_VERSION = 7 };
+    enum { KNOWN_BARRIER_VERSION = 11 };
     enum { KNOWN_BARRIER_NAME_MAX = 32 };
+    enum { KNOWN_BARRIER_MAX_DOMAINS = 8 };
+    enum { KNOWN_BARRIER_MIN_PROCESSES = 64 };
+    enum { KNOWN_BARRIER_STATS_HIST_SIZE = 16 };
     struct KnownBarrierFlags {
         bool flag1:1;
         bool flag2:1;
+        bool flag3:1;
+    };
+    struct DLB_ALIGN_CACHE KnownBarrierDomain {
+        atomic_uint  int1;
+        unsigned int int2;
+    };
+    struct KnownBarrierProcess {
+        pid_t pid;
+        int int1;
+        unsigned int int2;
+        unsigned int int3;
+        atomic_int_least64_t int4;
+    };
+    struct KnownBarrierStats {
+        atomic_int_least64_t int1;
+        atomic_uint int2;
+        unsigned int int3;
+        int64_t int4;
+        int64_t int5;
+        int64_t int6;
+        int64_t int7;
+        atomic_uint int8[KNOWN_BARRIER_STATS_HIST_SIZE];
     };
     struct KnownBarrier {
         char char1[KNOWN_BARRIER_NAME_MAX];
@@ -141,18 +168,29 @@ static void check_barrier_version(void) {
         atomic_uint  int4;
         pthread_barrier_t barrier;
         pthread_rwlock_t rwlock;
+        unsigned int int5;
+        atomic_uint  int6;
+        atomic_uint  int7;
+        atomic_uint  DLB_ALIGN_CACHE int8;
+        struct KnownBarrierDomain domains[KNOWN_BARRIER_MAX_DOMAINS];
+        struct KnownBarrierStats stats;
     };
     struct KnownBarrierShdata {
         bool bool1;
         int int1;
         int int2;
+        int int3;
         struct KnownBarrier barriers[];
+        /* followed by the processes of each barrier */
     };
 
     int version = shmem_barrier__version();
     size_t size = shmem_barrier__size();
     size_t known_size = sizeof(struct KnownBarrierShdata)
-        + sizeof(struct KnownBarrier) * mu_get_system_size();
+        + (sizeof(struct KnownBarrier)
+                + sizeof(struct KnownBarrierProcess)
+                * max_int(mu_get_system_size(), KNOWN_BARRIER_MIN_PROCESSES))
+        * mu_get_system_size();
     fprintf(stderr, "shmem_barrier version %d, size: %zu, known_size: %zu\n",
             version, size, known_size);
     assert( version == KNOWN_BARRIER_VERSION );
@@ -195,6 +233,34 @@ static void check_cpuinfo_version(void) {
     assert( size == known_size );
 }
 
+static void check_cpuinfo_log_version(void) {
+    enum { KNOWN_CPUINFO_LOG_VERSION = 3 };
+    enum { KNOWN_LOG_ENTRIES_PER_CPU = 64 };
+    struct KnownCpuinfoLogEntry {
+        int64_t int1;
+        pid_t pid1;
+        int32_t int2;
+        uint8_t uint1;
+        cpu_set_t mask1;
+    };
+    struct KnownCpuinfoLogShdata {
+        bool bool1;
+        int int1;
+        int int2;
+        int64_t int3;
+        struct KnownCpuinfoLogEntry entries[];
+    };
+
+    int version = shmem_cpuinfo_log__version();
+    size_t size = shmem_cpuinfo_log__size();
+    size_t known_size = sizeof(struct KnownCpuinfoLogShdata)
+        + sizeof(struct KnownCpuinfoLogEntry) * mu_get_system_size() * KNOWN_LOG_ENTRIES_PER_CPU;
+    fprintf(stderr, "shmem_cpuinfo_log version %d, size: %zu, known_size: %zu\n",
+            version, size, known_size);
+    assert( version == KNOWN_CPUINFO_LOG_VERSION );
+    assert( size == known_size );
+}
+
 static void check_lewi_async_version(void) {
     enum {KNOWN_LEWI_ASYNC_VERSION = 3 };
 
@@ -224,7 +290,7 @@ static void check_lewi_async_version(void) {
 }
 
 static void check_procinfo_version(void) {
-    enum { KNOWN_PROCINFO_VERSION = 10 };
+    enum { KNOWN_PROCINFO_VERSION = 12 };
 
     struct DLB_ALIGN_CACHE KnownProcinfo {
         pid_t pid;
@@ -234,6 +300,15 @@ static void check_procinfo_version(void) {
         cpu_set_t mask2;
         cpu_set_t mask3;
         unsigned int int1;
+        // DROM migration fields:
+        bool bool3;
+        cpu_set_t mask4;
+        unsigned int int5;
+        int64_t int64_2;
+        int64_t int64_1;
+        unsigned int int2;
+        unsigned int int3;
+        unsigned int int4;
         // Cpu Usage fields:
         double double1;
         double double2;
@@ -269,7 +344,17 @@ static void check_procinfo_version(void) {
 }
 
 static void check_talp_version(void) {
-    enum { KNOWN_TALP_VERSION = 4 };
+    enum { KNOWN_TALP_VERSION = 5 };
+
+    struct TalpMetrics {
+        pid_t pid;
+        int int1;
+        int int2;
+        int int3;
+        int int4;
+        float float1;
+        int64_t int64[18];
+    };
 
     struct DLB_ALIGN_CACHE TalpRegion {
         char name[DLB_MONITOR_NAME_MAX];
@@ -277,6 +362,8 @@ static void check_talp_version(void) {
         atomic_int_least64_t int2;
         pid_t pid;
         float float1;
+        atomic_uint uint1;
+        struct TalpMetrics metrics;
     };
 
     struct KnownTalpShdata {
@@ -301,6 +388,7 @@ int main(int argc, char **argv) {
     check_async_version();
     check_barrier_version();
     check_cpuinfo_version();
+    check_cpuinfo_log_version();
     check_lewi_async_version();
     check_procinfo_version();
     check_talp_version();
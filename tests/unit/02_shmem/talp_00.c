@@ -45,6 +45,8 @@ int main(int argc, char *argv[]) {
     assert( shmem_talp__get_regionlist(NULL, NULL, 0, NULL) == DLB_ERR_NOSHMEM );
     assert( shmem_talp__get_times(0, NULL, NULL) == DLB_ERR_NOSHMEM );
     assert( shmem_talp__set_times(0, 0, 0) == DLB_ERR_NOSHMEM );
+    assert( shmem_talp__set_metrics(0, NULL) == DLB_ERR_NOSHMEM );
+    assert( shmem_talp__get_metricslist(NULL, NULL, 0, NULL) == DLB_ERR_NOSHMEM );
 
     /* Initialize shared memories for p1_pid and p2_pid */
     assert( shmem_talp__init(SHMEM_KEY, KNOWN_DEFAULT_REGIONS_PER_PROC) == DLB_SUCCESS );
@@ -106,6 +108,26 @@ int main(int argc, char *argv[]) {
                 "nonexistent region") == DLB_SUCCESS );
     assert( nelems == 0 );
 
+    /* Published metrics */
+    shmem_talp_metrics_t metrics_list[max_len];
+    assert( shmem_talp__get_metricslist(metrics_list, &nelems, max_len,
+                "Custom region 1") == DLB_SUCCESS );
+    assert( nelems == 0 );
+    assert( shmem_talp__set_metrics(region_id3, &(const shmem_talp_metrics_t) {
+                .num_cpus = 2, .num_measurements = 1,
+                .mpi_time = 10, .useful_time = 20 }) == DLB_SUCCESS );
+    assert( shmem_talp__set_metrics(3, &(const shmem_talp_metrics_t) {}) == DLB_ERR_NOENT );
+    assert( shmem_talp__get_metricslist(metrics_list, &nelems, max_len,
+                "Custom region 1") == DLB_SUCCESS );
+    assert( nelems == 1 );
+    assert( metrics_list[0].pid == p2_pid
+            && metrics_list[0].num_cpus == 2
+            && metrics_list[0].num_measurements == 1
+            && metrics_list[0].mpi_time == 10
+            && metrics_list[0].useful_time == 20 );
+    assert( shmem_talp__get_times(region_id3, &mpi_time, &useful_time) == DLB_SUCCESS );
+    assert( mpi_time == 10 && useful_time == 20 );
+
     /* Fill up memory from id 3 until mu_get_system_size * KNOWN_DEFAULT_REGIONS_PER_PROC */
     int i;
     int expected_memory_capacity = mu_get_system_size() * KNOWN_DEFAULT_REGIONS_PER_PROC;
@@ -0,0 +1,215 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "unique_shmem.h"
+
+#include "apis/dlb_errors.h"
+#include "LB_policies/lewi_sim.h"
+#include "LB_comm/shmem.h"
+#include "support/mask_utils.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Offline LeWI simulation of small traces with 2 ranks and 4 CPUs per rank
+
+static void write_trace(char *filename, const char *content) {
+    strcpy(filename, "/tmp/dlb_lewisim_XXXXXX");
+    int fd = mkstemp(filename);
+    assert( fd != -1 );
+    assert( write(fd, content, strlen(content)) == (ssize_t)strlen(content) );
+    close(fd);
+}
+
+static bool equal(double a, double b) {
+    return fabs(a - b) < 1e-6;
+}
+
+int main(int argc, char *argv[]) {
+
+    enum { CPUS_PER_RANK = 4 };
+
+    char options_nolewi[64] = "--shm-key=";
+    strcat(options_nolewi, SHMEM_KEY);
+    char options_lewi[64] = "--lewi --shm-key=";
+    strcat(options_lewi, SHMEM_KEY);
+    char options_lend[96] = "--lewi --lewi-ompt=borrow:lend --shm-key=";
+    strcat(options_lend, SHMEM_KEY);
+    char options_keep[96] = "--lewi --lewi-keep-one-cpu --shm-key=";
+    strcat(options_keep, SHMEM_KEY);
+
+    char filename[32];
+    lewi_sim_trace_t *trace;
+    lewi_sim_result_t result;
+
+    /* Trace parsing */
+    {
+        write_trace(filename,
+                "# comment\n"
+                "rank,type,value\n"
+                "\n"
+                "1,compute,2.5\n"
+                "0,serial,1\n"
+                "0, mpi, 0.5\n"
+                "1,barrier\n"
+                "0,barrier\n");
+        assert( lewi_sim_load_trace(filename, &trace) == DLB_SUCCESS );
+        assert( trace->nranks == 2 );
+        assert( trace->nevents[0] == 3 );
+        assert( trace->nevents[1] == 2 );
+        assert( trace->events[0][0].type == LEWI_SIM_SERIAL );
+        assert( trace->events[0][1].type == LEWI_SIM_MPI );
+        assert( equal(trace->events[0][1].value, 0.5) );
+        assert( trace->events[0][2].type == LEWI_SIM_BARRIER );
+        assert( trace->events[1][0].type == LEWI_SIM_COMPUTE );
+        assert( equal(trace->events[1][0].value, 2.5) );
+        lewi_sim_free_trace(trace);
+        unlink(filename);
+
+        // Unknown event type
+        write_trace(filename, "0,compute,1\n0,sleep,1\n");
+        assert( lewi_sim_load_trace(filename, &trace) == DLB_ERR_NOCOMP );
+        unlink(filename);
+
+        // Missing value
+        write_trace(filename, "0,compute\n");
+        assert( lewi_sim_load_trace(filename, &trace) == DLB_ERR_NOCOMP );
+        unlink(filename);
+
+        // Empty trace
+        write_trace(filename, "# nothing\n");
+        assert( lewi_sim_load_trace(filename, &trace) == DLB_ERR_NOCOMP );
+        unlink(filename);
+
+        // Non-existent file
+        assert( lewi_sim_load_trace(filename, &trace) == DLB_ERR_NOENT );
+    }
+
+    /* Serial code and MPI calls progress in wall time */
+    {
+        write_trace(filename,
+                "0,serial,1.0\n"
+                "0,mpi,1.0\n"
+                "1,compute,4.0\n");
+        assert( lewi_sim_load_trace(filename, &trace) == DLB_SUCCESS );
+        unlink(filename);
+
+        assert( lewi_sim_run(trace, CPUS_PER_RANK, options_nolewi, &result) == DLB_SUCCESS );
+        assert( result.ncpus == 8 );
+        assert( equal(result.time_to_solution, 2.0) );
+        assert( equal(result.useful_time, 5.0) );
+        assert( equal(result.wasted_time, 11.0) );
+        lewi_sim_free_trace(trace);
+    }
+
+    /* Imbalanced ranks synchronized with a barrier:
+     *  rank 0: two parallel regions of 4 CPU seconds each
+     *  rank 1: one parallel region of 1 CPU second */
+    {
+        write_trace(filename,
+                "0,compute,4.0\n"
+                "0,compute,4.0\n"
+                "0,barrier\n"
+                "1,compute,1.0\n"
+                "1,barrier\n");
+        assert( lewi_sim_load_trace(filename, &trace) == DLB_SUCCESS );
+        unlink(filename);
+
+        // Without LeWI, rank 0 runs 2 seconds with its 4 CPUs
+        assert( lewi_sim_run(trace, CPUS_PER_RANK, options_nolewi, &result) == DLB_SUCCESS );
+        assert( equal(result.time_to_solution, 2.0) );
+        assert( equal(result.useful_time, 9.0) );
+        assert( equal(result.wasted_time, 7.0) );
+        assert( equal(result.utilization, 9.0 / 16.0) );
+
+        // With the default LeWI options, rank 1 only lends the CPU of the
+        // thread in MPI, which rank 0 borrows for its second parallel region
+        assert( lewi_sim_run(trace, CPUS_PER_RANK, options_lewi, &result) == DLB_SUCCESS );
+        assert( equal(result.time_to_solution, 1.0 + 4.0/5) );
+
+        // Lending the worker CPUs at the end of the parallel region, rank 0
+        // runs its second parallel region with 8 CPUs
+        assert( lewi_sim_run(trace, CPUS_PER_RANK, options_lend, &result) == DLB_SUCCESS );
+        assert( equal(result.time_to_solution, 1.5) );
+        assert( equal(result.useful_time, 9.0) );
+        assert( equal(result.utilization, 9.0 / 12.0) );
+
+        // Keeping the CPU on blocking calls, rank 1 does not lend any CPU
+        assert( lewi_sim_run(trace, CPUS_PER_RANK, options_keep, &result) == DLB_SUCCESS );
+        assert( equal(result.time_to_solution, 2.0) );
+
+        lewi_sim_free_trace(trace);
+    }
+
+    /* The owner reclaims its CPU while the other rank is still using it:
+     *  rank 0: MPI call of 0.5 seconds and a parallel region of 2 CPU seconds
+     *  rank 1: two parallel regions of 1 and 8 CPU seconds */
+    {
+        write_trace(filename,
+                "0,mpi,0.5\n"
+                "0,compute,2.0\n"
+                "1,compute,1.0\n"
+                "1,compute,8.0\n");
+        assert( lewi_sim_load_trace(filename, &trace) == DLB_SUCCESS );
+        unlink(filename);
+
+        // Without LeWI, rank 1 finishes at 0.25 + 2
+        assert( lewi_sim_run(trace, CPUS_PER_RANK, options_nolewi, &result) == DLB_SUCCESS );
+        assert( equal(result.time_to_solution, 2.25) );
+
+        // Rank 1 borrows CPU 0 from the beginning (5 CPUs) and again for its
+        // second parallel region, at 0.2. At 0.5, rank 0 reclaims CPU 0 and
+        // both ranks share it until rank 0 finishes, at 0.5 + 2/3.5. Then
+        // rank 1 keeps running with 5 CPUs.
+        assert( lewi_sim_run(trace, CPUS_PER_RANK, options_lend, &result) == DLB_SUCCESS );
+        double t_rank0 = 0.5 + 2.0/3.5;
+        double remaining_rank1 = 8.0 - 5*0.3 - 4.5*(2.0/3.5);
+        assert( equal(result.time_to_solution, t_rank0 + remaining_rank1/5) );
+        assert( equal(result.useful_time, 11.0) );
+        assert( result.utilization <= 1.0 );
+
+        lewi_sim_free_trace(trace);
+    }
+
+    /* The shared memory of the simulation is not in /dev/shm */
+    assert( !shmem_exists("cpuinfo", SHMEM_KEY) );
+
+    /* The system topology is restored after the simulation */
+    {
+        mu_testing_set_sys_size(2);
+        write_trace(filename, "0,compute,1.0\n1,compute,1.0\n");
+        assert( lewi_sim_load_trace(filename, &trace) == DLB_SUCCESS );
+        unlink(filename);
+        assert( lewi_sim_run(trace, CPUS_PER_RANK, options_lewi, &result) == DLB_SUCCESS );
+        assert( result.ncpus == 8 );
+        assert( mu_get_system_size() == 2 );
+        lewi_sim_free_trace(trace);
+        mu_finalize();
+    }
+
+    return 0;
+}
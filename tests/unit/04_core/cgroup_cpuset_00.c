@@ -0,0 +1,150 @@
+/*********************************************************************************/
+/*  Copyright 2009-2023 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "unique_shmem.h"
+
+#include "LB_core/DLB_kernel.h"
+#include "LB_core/cgroup_cpuset.h"
+#include "LB_core/spd.h"
+#include "LB_comm/shmem_procinfo.h"
+#include "apis/dlb_errors.h"
+#include "support/mask_utils.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+/* Test cgroup v2 cpuset changes translated into DROM mask updates, using a
+ * temporary directory that mimics the cgroup files */
+
+static char cgroup_path[64];
+
+static void write_cgroup_file(const char *filename, const char *content) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", cgroup_path, filename);
+    FILE *fd = fopen(path, "w");
+    assert( fd != NULL );
+    fputs(content, fd);
+    fclose(fd);
+}
+
+static void remove_cgroup_file(const char *filename) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", cgroup_path, filename);
+    unlink(path);
+}
+
+/* Change the cpuset and notify it through cgroup.events, like cgroupfs */
+static void write_cgroup_cpuset(const char *cpuset) {
+    write_cgroup_file("cpuset.cpus.effective", cpuset);
+    write_cgroup_file("cgroup.events", "populated 1\nfrozen 0\n");
+}
+
+/* Poll DROM until the watcher has updated the process mask, or timeout */
+static int wait_drom_update(subprocess_descriptor_t *spd, int *ncpus, cpu_set_t *mask) {
+    enum { MAX_TRIES = 500 };
+    enum { SLEEP_US = 10000 };
+    int error = DLB_NOUPDT;
+    for (int i = 0; i < MAX_TRIES && error == DLB_NOUPDT; ++i) {
+        usleep(SLEEP_US);
+        error = poll_drom(spd, ncpus, mask);
+    }
+    return error;
+}
+
+int main(int argc, char *argv[]) {
+
+    enum { SYS_SIZE = 4 };
+    mu_testing_set_sys_size(SYS_SIZE);
+
+    strcpy(cgroup_path, "/tmp/dlb_cgroup_XXXXXX");
+    assert( mkdtemp(cgroup_path) != NULL );
+    write_cgroup_file("cgroup.events", "populated 1\nfrozen 0\n");
+    write_cgroup_file("cpuset.cpus.effective", "0-3\n");
+
+    cpu_set_t mask;
+
+    /* Read cpuset files */
+    assert( cgroup_cpuset_read(cgroup_path, &mask) == DLB_SUCCESS );
+    assert( CPU_COUNT(&mask) == 4 );
+    assert( cgroup_cpuset_read("/nonexistent", &mask) == DLB_ERR_NOENT );
+
+    char options[256];
+    snprintf(options, sizeof(options), "--drom --drom-cgroup --drom-cgroup-path=%s"
+            " --shm-key=%s", cgroup_path, SHMEM_KEY);
+
+    cpu_set_t process_mask;
+    mu_parse_mask("0-3", &process_mask);
+    subprocess_descriptor_t spd = {.id = getpid()};
+    assert( Initialize(&spd, spd.id, 0, &process_mask, options) == DLB_SUCCESS );
+    assert( spd.cgroup_info != NULL );
+
+    int ncpus;
+    cpu_set_t expected_mask;
+
+    /* Shrink cpuset */
+    write_cgroup_cpuset("0-1\n");
+    assert( wait_drom_update(&spd, &ncpus, &mask) == DLB_SUCCESS );
+    mu_parse_mask("0-1", &expected_mask);
+    assert( ncpus == 2 && CPU_EQUAL(&mask, &expected_mask) );
+
+    /* Events without cpuset changes do not trigger any update */
+    write_cgroup_file("cgroup.events", "populated 1\nfrozen 0\n");
+    usleep(200000);
+    assert( poll_drom(&spd, &ncpus, &mask) == DLB_NOUPDT );
+
+    /* Grow cpuset, the process owned the whole cpuset so it follows it */
+    write_cgroup_cpuset("0-2\n");
+    assert( wait_drom_update(&spd, &ncpus, &mask) == DLB_SUCCESS );
+    mu_parse_mask("0-2", &expected_mask);
+    assert( ncpus == 3 && CPU_EQUAL(&mask, &expected_mask) );
+
+    /* Process mask is not the whole cpuset, only keep the CPUs in it */
+    cpu_set_t old_cpuset, new_cpuset;
+    mu_parse_mask("1-2", &process_mask);
+    assert( shmem_procinfo__setprocessmask(spd.id, &process_mask, DLB_NO_SYNC, NULL)
+            == DLB_SUCCESS );
+    assert( poll_drom(&spd, &ncpus, &mask) == DLB_SUCCESS );
+    mu_parse_mask("0-2", &old_cpuset);
+    mu_parse_mask("0-1,3", &new_cpuset);
+    assert( cgroup_cpuset_update(&spd, &old_cpuset, &new_cpuset) == DLB_SUCCESS );
+    assert( poll_drom(&spd, &ncpus, &mask) == DLB_SUCCESS );
+    mu_parse_mask("1", &expected_mask);
+    assert( ncpus == 1 && CPU_EQUAL(&mask, &expected_mask) );
+
+    /* Disjoint cpuset is ignored */
+    mu_parse_mask("3", &new_cpuset);
+    assert( cgroup_cpuset_update(&spd, &old_cpuset, &new_cpuset) == DLB_NOUPDT );
+
+    assert( Finish(&spd) == DLB_SUCCESS );
+    assert( spd.cgroup_info == NULL );
+
+    remove_cgroup_file("cgroup.events");
+    remove_cgroup_file("cpuset.cpus.effective");
+    assert( rmdir(cgroup_path) == 0 );
+
+    return 0;
+}
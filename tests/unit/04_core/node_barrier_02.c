@@ -0,0 +1,189 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "unique_shmem.h"
+
+#include "LB_core/node_barrier.h"
+#include "LB_core/spd.h"
+#include "LB_core/DLB_kernel.h"
+#include "LB_comm/shmem_barrier.h"
+#include "LB_numThreads/numThreads.h"
+#include "apis/dlb_errors.h"
+#include "apis/dlb_types.h"
+#include "support/options.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Test split-phase node barriers */
+
+struct pthread_args {
+    subprocess_descriptor_t *spd;
+    barrier_t *barrier;
+    useconds_t delay;
+};
+
+/* Arrive after some delay and wait */
+void* barrier_fn(void *arg) {
+    struct pthread_args *pargs = arg;
+    spd_enter_dlb(pargs->spd);
+    usleep(pargs->delay);
+    assert( node_barrier_arrive(pargs->spd, pargs->barrier) == DLB_SUCCESS );
+    assert( node_barrier_wait(pargs->spd, pargs->barrier) == DLB_SUCCESS );
+    return NULL;
+}
+
+/* Callback to count how many times the LeWI module has invoked it */
+static int lewi_ntimes = 0;
+static void cb_count(int num_threads, void *arg) {
+    ++lewi_ntimes;
+}
+
+static void test_split_phase(barrier_t *barrier,
+        subprocess_descriptor_t *spd1, subprocess_descriptor_t *spd2) {
+
+    spd_enter_dlb(spd1);
+    lewi_ntimes = 0;
+
+    /* spd1 arrives first, spd2 arrives and waits: nobody blocks */
+    assert( node_barrier_arrive(spd1, barrier) == DLB_SUCCESS );
+    assert( node_barrier_arrive(spd1, barrier) == DLB_ERR_PERM );
+    assert( node_barrier_test(spd1, barrier) == DLB_NOTED );
+    pthread_t thread;
+    struct pthread_args pargs = {.spd = spd2, .barrier = barrier, .delay = 0};
+    pthread_create(&thread, NULL, barrier_fn, &pargs);
+    pthread_join(thread, NULL);
+    assert( node_barrier_test(spd1, barrier) == DLB_SUCCESS );
+    assert( node_barrier_test(spd1, barrier) == DLB_ERR_PERM );
+    assert( node_barrier_wait(spd1, barrier) == DLB_ERR_PERM );
+    assert( lewi_ntimes == 0 );
+
+    /* Arrive, but do not wait until the other participant has arrived */
+    assert( node_barrier_arrive(spd1, barrier) == DLB_SUCCESS );
+    pargs.delay = 100000;
+    pthread_create(&thread, NULL, barrier_fn, &pargs);
+    pthread_join(thread, NULL);
+    assert( node_barrier_wait(spd1, barrier) == DLB_SUCCESS );
+    assert( lewi_ntimes == 0 );
+
+    /* spd1 waits until spd2 arrives: LeWI is triggered */
+    assert( node_barrier_arrive(spd1, barrier) == DLB_SUCCESS );
+    pthread_create(&thread, NULL, barrier_fn, &pargs);
+    assert( node_barrier_wait(spd1, barrier) == DLB_SUCCESS );
+    pthread_join(thread, NULL);
+    assert( lewi_ntimes > 0 );
+
+    /* Arrivals from consecutive episodes do not mix */
+    for (int i = 0; i < 100; ++i) {
+        pargs.delay = 0;
+        pthread_create(&thread, NULL, barrier_fn, &pargs);
+        assert( node_barrier_arrive(spd1, barrier) == DLB_SUCCESS );
+        assert( node_barrier_wait(spd1, barrier) == DLB_SUCCESS );
+        pthread_join(thread, NULL);
+    }
+
+    /* The monolithic barrier can be used along with the split-phase one */
+    assert( node_barrier_arrive(spd1, barrier) == DLB_SUCCESS );
+    pthread_create(&thread, NULL, barrier_fn, &pargs);
+    pthread_join(thread, NULL);
+    assert( node_barrier_wait(spd1, barrier) == DLB_SUCCESS );
+}
+
+int main(int argc, char *argv[]) {
+
+    subprocess_descriptor_t spd1;
+    subprocess_descriptor_t spd2;
+    char options[256];
+
+    /* Split-phase barriers need the futex implementation */
+    {
+        sprintf(options, "--barrier --shm-size-multiplier=2 --shm-key=%s", SHMEM_KEY);
+        assert( Initialize(&spd1, 111, 0, NULL, options) == DLB_SUCCESS );
+        assert( node_barrier_arrive(&spd1, NULL) == DLB_ERR_NOCOMP );
+        barrier_t *barrier = node_barrier_register(&spd1, "futex", DLB_BARRIER_FUTEX);
+        assert( barrier != NULL );
+        assert( node_barrier_arrive(&spd1, barrier) == DLB_SUCCESS );
+        assert( node_barrier_wait(&spd1, barrier) == DLB_SUCCESS );
+        assert( node_barrier_detach(&spd1, barrier) == 0 );
+        assert( node_barrier_arrive(&spd1, barrier) == DLB_NOUPDT );
+        assert( Finish(&spd1) == DLB_SUCCESS );
+        assert( node_barrier_arrive(&spd1, NULL) == DLB_ERR_NOCOMP );
+    }
+
+    /* Default and named barriers with two processes */
+    {
+        sprintf(options, "--barrier --barrier-futex --lewi --lewi-barrier"
+                " --lewi-affinity=none --shm-size-multiplier=2 --shm-key=%s", SHMEM_KEY);
+        assert( Initialize(&spd1, 111, 0, NULL, options) == DLB_SUCCESS );
+        assert( Initialize(&spd2, 222, 0, NULL, options) == DLB_SUCCESS );
+        assert( pm_callback_set(&spd1.pm, dlb_callback_set_num_threads,
+                    (dlb_callback_t)cb_count, NULL) == DLB_SUCCESS );
+        assert( pm_callback_set(&spd2.pm, dlb_callback_set_num_threads,
+                    (dlb_callback_t)cb_count, NULL) == DLB_SUCCESS );
+
+        test_split_phase(NULL, &spd1, &spd2);
+
+        if (shmem_barrier__get_max_barriers() > 1) {
+            barrier_t *barrier = node_barrier_register(&spd1, "named",
+                    DLB_BARRIER_LEWI_ON);
+            assert( barrier != NULL );
+            assert( node_barrier_register(&spd2, "named", DLB_BARRIER_LEWI_ON)
+                    == barrier );
+            test_split_phase(barrier, &spd1, &spd2);
+        }
+
+        /* A participant cannot detach until it leaves the barrier it has
+         * arrived at */
+        spd_enter_dlb(&spd2);
+        assert( node_barrier_arrive(&spd2, NULL) == DLB_SUCCESS );
+        assert( node_barrier_detach(&spd2, NULL) == DLB_ERR_REQST );
+        struct pthread_args pargs = {.spd = &spd1, .barrier = NULL, .delay = 0};
+        pthread_t thread;
+        pthread_create(&thread, NULL, barrier_fn, &pargs);
+        pthread_join(thread, NULL);
+        assert( node_barrier_wait(&spd2, NULL) == DLB_SUCCESS );
+
+        /* Detaching does not wait for the participants blocked in the
+         * barrier, and releases them */
+        pthread_create(&thread, NULL, barrier_fn, &pargs);
+        usleep(100000);
+        assert( node_barrier_detach(&spd2, NULL) == 1 );
+        pthread_join(thread, NULL);
+        assert( node_barrier_attach(&spd2, NULL) > 0 );
+
+        /* A participant that detaches completes the pending episode */
+        spd_enter_dlb(&spd1);
+        assert( node_barrier_arrive(&spd1, NULL) == DLB_SUCCESS );
+        assert( node_barrier_test(&spd1, NULL) == DLB_NOTED );
+        assert( node_barrier_detach(&spd2, NULL) == 1 );
+        assert( node_barrier_test(&spd1, NULL) == DLB_SUCCESS );
+
+        assert( Finish(&spd1) == DLB_SUCCESS );
+        assert( Finish(&spd2) == DLB_SUCCESS );
+    }
+
+    return 0;
+}
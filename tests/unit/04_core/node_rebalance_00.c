@@ -0,0 +1,189 @@
+/*********************************************************************************/
+/*  Copyright 2009-2023 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "unique_shmem.h"
+
+#include "LB_core/node_rebalance.h"
+#include "LB_comm/shmem_procinfo.h"
+#include "LB_comm/shmem_talp.h"
+#include "apis/dlb_errors.h"
+#include "apis/dlb_talp.h"
+#include "support/mask_utils.h"
+
+#include <sched.h>
+#include <stdint.h>
+#include <assert.h>
+
+// Node rebalancing of CPUs among fake processes registered in the shared memories
+
+int main(int argc, char *argv[]) {
+
+    enum { SHMEM_SIZE_MULTIPLIER = 1 };
+
+    // 8 CPUs, 2 NUMA nodes: [0-3] [4-7]
+    enum { SYS_NCPUS = 8 };
+    enum { SYS_NCORES = 8 };
+    enum { SYS_NNODES = 2 };
+    mu_init();
+    mu_testing_set_sys(SYS_NCPUS, SYS_NCORES, SYS_NNODES);
+
+    /* Distribution of CPUs */
+    {
+        float efficiency[3];
+        int ncpus[3];
+        int new_ncpus[3];
+
+        // Balanced
+        efficiency[0] = 1.0f; efficiency[1] = 1.0f;
+        ncpus[0] = 4; ncpus[1] = 4;
+        node_rebalance_compute_cpus(2, efficiency, ncpus, new_ncpus);
+        assert( new_ncpus[0] == 4 && new_ncpus[1] == 4 );
+
+        // Work: 2 + 4, targets: 2.67 + 5.33
+        efficiency[0] = 0.5f; efficiency[1] = 1.0f;
+        node_rebalance_compute_cpus(2, efficiency, ncpus, new_ncpus);
+        assert( new_ncpus[0] == 3 && new_ncpus[1] == 5 );
+
+        // Every process keeps at least one CPU
+        efficiency[0] = 0.0f; efficiency[1] = 1.0f;
+        node_rebalance_compute_cpus(2, efficiency, ncpus, new_ncpus);
+        assert( new_ncpus[0] == 1 && new_ncpus[1] == 7 );
+
+        // No work at all, keep the current distribution
+        efficiency[0] = 0.0f; efficiency[1] = 0.0f;
+        node_rebalance_compute_cpus(2, efficiency, ncpus, new_ncpus);
+        assert( new_ncpus[0] == 4 && new_ncpus[1] == 4 );
+
+        // Work: 2 + 2 + 1, targets: 3.2 + 3.2 + 1.6
+        efficiency[0] = 1.0f; efficiency[1] = 0.5f; efficiency[2] = 0.5f;
+        ncpus[0] = 2; ncpus[1] = 4; ncpus[2] = 2;
+        node_rebalance_compute_cpus(3, efficiency, ncpus, new_ncpus);
+        assert( new_ncpus[0] == 3 && new_ncpus[1] == 3 && new_ncpus[2] == 2 );
+    }
+
+    /* Fake processes: p1 [0-3], p2 [4-7] */
+    pid_t p1_pid = 111;
+    pid_t p2_pid = 222;
+    cpu_set_t p1_mask, p2_mask, mask;
+    mu_parse_mask("0-3", &p1_mask);
+    mu_parse_mask("4-7", &p2_mask);
+    assert( shmem_procinfo_ext__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER) == DLB_SUCCESS );
+    assert( shmem_procinfo_ext__preinit(p1_pid, &p1_mask, DLB_DROM_FLAGS_NONE) == DLB_SUCCESS );
+    assert( shmem_procinfo_ext__preinit(p2_pid, &p2_mask, DLB_DROM_FLAGS_NONE) == DLB_SUCCESS );
+
+    int p1_region, p2_region;
+    assert( shmem_talp__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER) == DLB_SUCCESS );
+    assert( shmem_talp__init(SHMEM_KEY, SHMEM_SIZE_MULTIPLIER) == DLB_SUCCESS );
+    assert( shmem_talp__register(p1_pid, 4, DLB_GLOBAL_REGION_NAME, &p1_region) == DLB_SUCCESS );
+    assert( shmem_talp__register(p2_pid, 4, DLB_GLOBAL_REGION_NAME, &p2_region) == DLB_SUCCESS );
+
+    int64_t p1_mpi = 0, p1_useful = 0;
+    int64_t p2_mpi = 0, p2_useful = 0;
+
+    node_rebalance_t nr;
+    node_rebalance_init(&nr, NULL, 0.1f, /* dry_run */ true);
+
+    /* First step only takes the initial sample */
+    assert( node_rebalance_step(&nr) == DLB_NOUPDT );
+    assert( nr.nprocs == 2 );
+
+    /* Dry run: p1 efficiency 0.5, p2 efficiency 1.0 */
+    p1_mpi += 50; p1_useful += 50; p2_useful += 100;
+    assert( shmem_talp__set_times(p1_region, p1_mpi, p1_useful) == DLB_SUCCESS );
+    assert( shmem_talp__set_times(p2_region, p2_mpi, p2_useful) == DLB_SUCCESS );
+    assert( node_rebalance_step(&nr) == DLB_SUCCESS );
+    assert( nr.imbalance > 0.24f && nr.imbalance < 0.26f );
+    assert( nr.procs[0].pid == p1_pid && nr.procs[0].new_ncpus == 3 );
+    assert( nr.procs[1].pid == p2_pid && nr.procs[1].new_ncpus == 5 );
+    mu_parse_mask("0-2", &mask);
+    assert( CPU_EQUAL(&nr.procs[0].new_mask, &mask) );
+    mu_parse_mask("3-7", &mask);
+    assert( CPU_EQUAL(&nr.procs[1].new_mask, &mask) );
+    assert( shmem_procinfo__getprocessmask(p1_pid, &mask, DLB_DROM_FLAGS_NONE) == DLB_SUCCESS );
+    assert( CPU_EQUAL(&mask, &p1_mask) );
+    assert( shmem_procinfo__getprocessmask(p2_pid, &mask, DLB_DROM_FLAGS_NONE) == DLB_SUCCESS );
+    assert( CPU_EQUAL(&mask, &p2_mask) );
+
+    /* Apply the same imbalance */
+    nr.dry_run = false;
+    p1_mpi += 50; p1_useful += 50; p2_useful += 100;
+    assert( shmem_talp__set_times(p1_region, p1_mpi, p1_useful) == DLB_SUCCESS );
+    assert( shmem_talp__set_times(p2_region, p2_mpi, p2_useful) == DLB_SUCCESS );
+    assert( node_rebalance_step(&nr) == DLB_SUCCESS );
+    assert( shmem_procinfo__getprocessmask(p1_pid, &mask, DLB_DROM_FLAGS_NONE) == DLB_SUCCESS );
+    mu_parse_mask("0-2", &p1_mask);
+    assert( CPU_EQUAL(&mask, &p1_mask) );
+    assert( shmem_procinfo__getprocessmask(p2_pid, &mask, DLB_DROM_FLAGS_NONE) == DLB_SUCCESS );
+    mu_parse_mask("3-7", &p2_mask);
+    assert( CPU_EQUAL(&mask, &p2_mask) );
+
+    /* Processes have not polled their new masks yet */
+    p1_mpi += 50; p1_useful += 50; p2_useful += 100;
+    assert( shmem_talp__set_times(p1_region, p1_mpi, p1_useful) == DLB_SUCCESS );
+    assert( shmem_talp__set_times(p2_region, p2_mpi, p2_useful) == DLB_SUCCESS );
+    assert( node_rebalance_step(&nr) == DLB_ERR_PDIRTY );
+
+    /* Poll masks */
+    int ncpus;
+    assert( shmem_procinfo__polldrom(p1_pid, &ncpus, &mask) == DLB_SUCCESS );
+    assert( ncpus == 3 && CPU_EQUAL(&mask, &p1_mask) );
+    assert( shmem_procinfo__polldrom(p2_pid, &ncpus, &mask) == DLB_SUCCESS );
+    assert( ncpus == 5 && CPU_EQUAL(&mask, &p2_mask) );
+
+    /* Imbalance below the hysteresis threshold: 0.95 vs 1.0 */
+    p1_mpi += 5; p1_useful += 95; p2_useful += 100;
+    assert( shmem_talp__set_times(p1_region, p1_mpi, p1_useful) == DLB_SUCCESS );
+    assert( shmem_talp__set_times(p2_region, p2_mpi, p2_useful) == DLB_SUCCESS );
+    assert( node_rebalance_step(&nr) == DLB_NOUPDT );
+    assert( nr.imbalance > 0.0f && nr.imbalance < 0.1f );
+
+    /* No new samples */
+    assert( node_rebalance_step(&nr) == DLB_NOUPDT );
+
+    node_rebalance_finalize(&nr);
+
+    /* Invalid batches do not modify any process */
+    pid_t pidlist[2] = {p1_pid, p2_pid};
+    cpu_set_t masks[2];
+    mu_parse_mask("0-3", &masks[0]);
+    mu_parse_mask("3-7", &masks[1]);
+    assert( shmem_procinfo__setprocessmasks(pidlist, masks, 2) == DLB_ERR_PERM );
+    pidlist[1] = p1_pid;
+    mu_parse_mask("4-7", &masks[1]);
+    assert( shmem_procinfo__setprocessmasks(pidlist, masks, 2) == DLB_ERR_PERM );
+    assert( shmem_procinfo__polldrom(p1_pid, &ncpus, &mask) == DLB_NOUPDT );
+    assert( shmem_procinfo__polldrom(p2_pid, &ncpus, &mask) == DLB_NOUPDT );
+    assert( shmem_procinfo__getprocessmask(p1_pid, &mask, DLB_DROM_FLAGS_NONE) == DLB_SUCCESS );
+    assert( CPU_EQUAL(&mask, &p1_mask) );
+    assert( shmem_procinfo__getprocessmask(p2_pid, &mask, DLB_DROM_FLAGS_NONE) == DLB_SUCCESS );
+    assert( CPU_EQUAL(&mask, &p2_mask) );
+
+    /* Finalize */
+    assert( shmem_talp__finalize(p1_pid) == DLB_SUCCESS );
+    assert( shmem_talp__finalize(p2_pid) == DLB_SUCCESS );
+    assert( shmem_procinfo_ext__postfinalize(p1_pid, false) == DLB_SUCCESS );
+    assert( shmem_procinfo_ext__postfinalize(p2_pid, false) == DLB_SUCCESS );
+    assert( shmem_procinfo_ext__finalize() == DLB_SUCCESS );
+
+    return 0;
+}
@@ -38,6 +38,8 @@
 #include "talp/talp_types.h"
 
 #include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdint.h>
@@ -217,12 +219,12 @@ int main(int argc, char *argv[]) {
 
     /* Test reset with open region */
     {
-        assert( talp_info->open_regions == NULL );
+        assert( talp_info->open_regions.size == 0 );
         assert( region_start(&spd, monitor) == DLB_SUCCESS );
-        assert( talp_info->open_regions &&
-                talp_info->open_regions->data == monitor );
+        assert( talp_info->open_regions.size == 1
+                && talp_info->open_regions.monitors[0] == monitor );
         assert( region_reset(&spd, monitor) == DLB_SUCCESS );
-        assert( talp_info->open_regions == NULL );
+        assert( talp_info->open_regions.size == 0 );
         assert( region_stop(&spd, monitor) == DLB_NOUPDT );
     }
 
@@ -279,6 +281,35 @@ int main(int argc, char *argv[]) {
         region_report(&spd, global_monitor);
     }
 
+    /* Test many regions, and regions not stopped in reverse order */
+    {
+        enum { NUM_REGIONS = 1000 };
+        dlb_monitor_t **monitors = malloc(NUM_REGIONS * sizeof(dlb_monitor_t*));
+        char name[DLB_MONITOR_NAME_MAX];
+        for (int i = 0; i < NUM_REGIONS; ++i) {
+            snprintf(name, DLB_MONITOR_NAME_MAX, "Region %d", i);
+            monitors[i] = region_register(&spd, name);
+            assert( monitors[i] != NULL );
+        }
+        for (int i = 0; i < NUM_REGIONS; ++i) {
+            snprintf(name, DLB_MONITOR_NAME_MAX, "Region %d", i);
+            assert( region_register(&spd, name) == monitors[i] );
+        }
+
+        int num_open_regions = talp_info->open_regions.size;
+        for (int i = 0; i < 3; ++i) {
+            assert( region_start(&spd, monitors[i]) == DLB_SUCCESS );
+        }
+        assert( talp_info->open_regions.size == num_open_regions + 3 );
+        assert( region_stop(&spd, monitors[1]) == DLB_SUCCESS );
+        assert( region_stop(&spd, DLB_LAST_OPEN_REGION) == DLB_SUCCESS );
+        assert( !region_is_started(monitors[2]) );
+        assert( region_is_started(monitors[0]) );
+        assert( region_stop(&spd, monitors[0]) == DLB_SUCCESS );
+        assert( talp_info->open_regions.size == num_open_regions );
+        free(monitors);
+    }
+
     /* Test internal monitor */
     {
         dlb_monitor_t *monitor9 = region_register(&spd, "Hidden monitor");
@@ -428,6 +459,34 @@ int main(int argc, char *argv[]) {
         assert( node_metrics.total_useful_time > 0 );
     }
 
+    /* Test non-blocking Collect POP metrics */
+    {
+        dlb_pop_metrics_t pop_metrics;
+        dlb_talp_request_t *request = NULL;
+        assert( talp_icollect_pop_metrics(&spd, NULL, &pop_metrics, &request)
+                == DLB_SUCCESS );
+        assert( request != NULL );
+
+        bool completed;
+        assert( talp_test_request(&request, &completed, false) == DLB_SUCCESS );
+        assert( completed );
+        assert( request == NULL );
+        assert( strcmp(pop_metrics.name, DLB_GLOBAL_REGION_NAME) == 0 );
+        assert( pop_metrics.elapsed_time > 0 );
+
+        /* Null requests complete immediately */
+        assert( talp_test_request(&request, &completed, true) == DLB_SUCCESS );
+        assert( completed );
+
+        /* Wait */
+        assert( talp_icollect_pop_metrics(&spd, global_monitor, &pop_metrics, &request)
+                == DLB_SUCCESS );
+        assert( talp_test_request(&request, &completed, true) == DLB_SUCCESS );
+        assert( completed );
+        assert( request == NULL );
+        assert( pop_metrics.elapsed_time > 0 );
+    }
+
     talp_finalize(&spd);
 
     /* Test --talp-region-select with global region, and finalize with open regions  */
@@ -37,6 +37,7 @@
 #include "talp/talp_mpi.h"
 #include "talp/talp_types.h"
 
+#include <pthread.h>
 #include <sched.h>
 #include <stdint.h>
 #include <string.h>
@@ -45,6 +46,28 @@
 /* Test Global Monitoring Regions with/without LeWI */
 
 enum { USLEEP_TIME = 100000 };
+enum { NUM_THREADS = 200 };
+enum { NUM_UPDATES = 100 };
+
+static atomic_int num_running_threads = 0;
+
+/* Register a new thread sample and update it while the main thread aggregates */
+static void* worker_func(void *arg) {
+    subprocess_descriptor_t *spd = arg;
+    spd_enter_dlb(spd);
+    thread_ctx_set_worker();
+    talp_info_t *talp_info = spd->talp_info;
+    talp_sample_t *sample = talp_sample_get(talp_info);
+    assert( sample != NULL );
+    talp_sample_record_cpuid(talp_info);
+    for (int i = 0; i < NUM_UPDATES; ++i) {
+        talp_sample_set_state(talp_info,
+                i % 2 ? TALP_STATE_USEFUL : TALP_STATE_NOT_USEFUL_OMP_OUT);
+        talp_sample_update(talp_info);
+    }
+    DLB_ATOMIC_SUB(&num_running_threads, 1);
+    return NULL;
+}
 
 int main(int argc, char *argv[]) {
 
@@ -80,9 +103,12 @@ int main(int argc, char *argv[]) {
     assert( global_monitor->elapsed_time == 0 );
     assert( global_monitor->mpi_time == 0 );
     assert( global_monitor->useful_time == 0 );
-    assert( registry->samples[0]->timers.useful == 0 );
-    assert( registry->samples[0]->timers.not_useful_mpi == 0 );
-    assert( registry->samples[0]->state == TALP_STATE_USEFUL );
+    const talp_sample_t *main_sample = talp_sample_registry_get(talp_info, 0);
+    assert( main_sample == talp_sample_get(talp_info) );
+    assert( talp_sample_registry_get(talp_info, 1) == NULL );
+    assert( main_sample->timers.useful == 0 );
+    assert( main_sample->timers.not_useful_mpi == 0 );
+    assert( main_sample->state == TALP_STATE_USEFUL );
     assert( registry->num_samples == 1 );
 
     /* We are getting timestamps before and after talp_into_sync_call / talp_out_of_sync_call
@@ -99,21 +125,21 @@ int main(int argc, char *argv[]) {
     time_before = get_time_in_ns();
     talp_into_sync_call(&spd, no_blocking);
     time_after = get_time_in_ns();
-    assert( registry->samples[0]->last_updated_ts >= time_before
-            && registry->samples[0]->last_updated_ts <= time_after );
-    assert( registry->samples[0]->timers.useful > 0 );
-    assert( registry->samples[0]->timers.not_useful_mpi == 0 );
-    assert( registry->samples[0]->state == TALP_STATE_NOT_USEFUL_MPI );
+    assert( main_sample->last_updated_ts >= time_before
+            && main_sample->last_updated_ts <= time_after );
+    assert( main_sample->timers.useful > 0 );
+    assert( main_sample->timers.not_useful_mpi == 0 );
+    assert( main_sample->state == TALP_STATE_NOT_USEFUL_MPI );
 
     /* Leaving MPI */
     time_before = get_time_in_ns();
     talp_out_of_sync_call(&spd, no_blocking);
     time_after = get_time_in_ns();
-    assert( registry->samples[0]->last_updated_ts >= time_before
-            && registry->samples[0]->last_updated_ts <= time_after );
-    assert( registry->samples[0]->timers.useful > 0 );
-    assert( registry->samples[0]->timers.not_useful_mpi > 0 );
-    assert( registry->samples[0]->state == TALP_STATE_USEFUL );
+    assert( main_sample->last_updated_ts >= time_before
+            && main_sample->last_updated_ts <= time_after );
+    assert( main_sample->timers.useful > 0 );
+    assert( main_sample->timers.not_useful_mpi > 0 );
+    assert( main_sample->state == TALP_STATE_USEFUL );
 
     /* Update regions */
     talp_sample_update(talp_info);
@@ -129,6 +155,14 @@ int main(int argc, char *argv[]) {
     assert( mpi_time == 0 );
     assert( useful_time == 0 );
 
+    /* The global region is still published periodically */
+    talp_info->next_publish_ts = 0;
+    talp_publish_poll(talp_info);
+    assert( talp_info->next_publish_ts > 0 );
+    assert( shmem_talp__get_times(0, &mpi_time, &useful_time) == DLB_SUCCESS );
+    assert( mpi_time == global_monitor->mpi_time );
+    assert( useful_time == global_monitor->useful_time );
+
     /* Enable --talp-external-profiler and test that the global region is updated */
     mpi_time = -1;
     useful_time = -1;
@@ -164,6 +198,53 @@ int main(int argc, char *argv[]) {
     assert( mpi_time == global_monitor->mpi_time  );
     assert( useful_time == global_monitor->useful_time );
 
+    /* Node POP metrics out of the shared memory */
+    spd_enter_dlb(&spd);
+    dlb_pop_metrics_t pop_metrics;
+    assert( talp_query_pop_metrics(NULL, &pop_metrics) == DLB_SUCCESS );
+    assert( pop_metrics.num_nodes == 1 );
+    assert( pop_metrics.num_cpus == global_monitor->num_cpus );
+    assert( pop_metrics.useful_time == global_monitor->useful_time );
+    assert( pop_metrics.mpi_time == global_monitor->mpi_time );
+    assert( pop_metrics.elapsed_time == global_monitor->elapsed_time );
+    assert( talp_query_pop_metrics("Test", &pop_metrics) == DLB_SUCCESS );
+    assert( pop_metrics.useful_time == monitor->useful_time );
+    assert( pop_metrics.mpi_time == monitor->mpi_time );
+    assert( talp_query_pop_metrics("nonexistent region", &pop_metrics) == DLB_ERR_NOENT );
+
+    /* Register many thread samples while the main thread aggregates them */
+    {
+        talp_info->flags.external_profiler = false;
+        DLB_ATOMIC_ST(&num_running_threads, NUM_THREADS);
+        pthread_t threads[NUM_THREADS];
+        for (int i = 0; i < NUM_THREADS; ++i) {
+            pthread_create(&threads[i], NULL, worker_func, &spd);
+        }
+        while (DLB_ATOMIC_LD(&num_running_threads) > 0) {
+            talp_macrosample_t macrosample = {0};
+            talp_sample_update(talp_info);
+            talp_sample_aggregate_all_to_macrosample(talp_info, &macrosample);
+            assert( macrosample.num_samples >= 1
+                    && macrosample.num_samples <= NUM_THREADS + 1 );
+        }
+        for (int i = 0; i < NUM_THREADS; ++i) {
+            pthread_join(threads[i], NULL);
+        }
+
+        /* All samples are published and distinct */
+        assert( registry->num_samples == NUM_THREADS + 1 );
+        assert( talp_sample_registry_get(talp_info, NUM_THREADS + 1) == NULL );
+        for (int i = 0; i <= NUM_THREADS; ++i) {
+            const talp_sample_t *sample_i = talp_sample_registry_get(talp_info, i);
+            assert( sample_i != NULL );
+            assert( i == 0 || sample_i != talp_sample_registry_get(talp_info, i - 1) );
+        }
+        talp_macrosample_t macrosample = {0};
+        talp_sample_update(talp_info);
+        talp_sample_aggregate_all_to_macrosample(talp_info, &macrosample);
+        assert( macrosample.num_samples == NUM_THREADS + 1 );
+    }
+
     spd.options.talp_summary |= SUMMARY_NODE;
     spd.options.talp_summary |= SUMMARY_PROCESS;
     talp_finalize(&spd);
@@ -0,0 +1,213 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "extra_tests.h"
+#include "talp_fixture.h"
+
+#include "LB_core/spd.h"
+#include "LB_core/thread_ctx.h"
+#include "apis/dlb_errors.h"
+#include "support/mytime.h"
+#include "talp/regions.h"
+#include "talp/sample.h"
+#include "talp/talp.h"
+#include "talp/talp_mpi.h"
+#include "talp/talp_types.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <assert.h>
+
+/* Test TALP lazy regions, and compare the cost of starting and stopping a
+ * region with several open regions in eager and lazy modes */
+
+enum { NUM_IDLE_THREADS = 16 };
+
+static void init_talp(subprocess_descriptor_t *spd, bool lazy) {
+    talp_fixture_init(spd, true, "--talp-lazy-regions=%s", lazy ? "yes" : "no");
+
+    talp_info_t *talp_info = spd->talp_info;
+    assert( talp_info->flags.lazy_regions == lazy );
+}
+
+/* Register a worker thread sample that stays out of parallel regions */
+static void* idle_worker_func(void *arg) {
+    subprocess_descriptor_t *spd = arg;
+    spd_enter_dlb(spd);
+    thread_ctx_set_worker();
+    talp_info_t *talp_info = spd->talp_info;
+    assert( talp_sample_get(talp_info) != NULL );
+    talp_sample_record_cpuid(talp_info);
+    talp_sample_set_state(talp_info, TALP_STATE_NOT_USEFUL_OMP_OUT);
+    talp_sample_update(talp_info);
+    return NULL;
+}
+
+static void add_idle_workers(subprocess_descriptor_t *spd, int n) {
+    for (int i = 0; i < n; ++i) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, idle_worker_func, spd);
+        pthread_join(thread, NULL);
+    }
+}
+
+static void mpi_calls(subprocess_descriptor_t *spd, int n) {
+    sync_call_flags_t mpi_flags = { .is_mpi = true };
+    for (int i = 0; i < n; ++i) {
+        talp_into_sync_call(spd, mpi_flags);
+        talp_out_of_sync_call(spd, mpi_flags);
+    }
+}
+
+/* Every nanosecond of a region is either useful or MPI in the main thread,
+ * and idle in the rest */
+static void check_region(const dlb_monitor_t *monitor, int64_t num_mpi_calls,
+        int num_idle_threads) {
+    assert( monitor->num_mpi_calls == num_mpi_calls );
+    assert( monitor->useful_time + monitor->mpi_time == monitor->elapsed_time );
+    assert( monitor->omp_serialization_time == monitor->elapsed_time * num_idle_threads );
+    assert( monitor->num_cpus == 1 );
+}
+
+static void check_nested_regions(bool lazy, int num_idle_threads) {
+
+    subprocess_descriptor_t spd;
+    init_talp(&spd, lazy);
+    talp_info_t *talp_info = spd.talp_info;
+    add_idle_workers(&spd, num_idle_threads);
+
+    dlb_monitor_t *outer = region_register(&spd, "outer");
+    dlb_monitor_t *middle = region_register(&spd, "middle");
+    dlb_monitor_t *inner = region_register(&spd, "inner");
+    dlb_monitor_t *reset = region_register(&spd, "reset");
+
+    assert( region_start(&spd, outer) == DLB_SUCCESS );
+    mpi_calls(&spd, 2);
+    assert( region_start(&spd, middle) == DLB_SUCCESS );
+    mpi_calls(&spd, 3);
+    assert( region_start(&spd, inner) == DLB_SUCCESS );
+    assert( region_start(&spd, reset) == DLB_SUCCESS );
+    mpi_calls(&spd, 1);
+
+    /* Reset an open region, its measurements are still kept in the rest */
+    assert( region_reset(&spd, reset) == DLB_SUCCESS );
+    assert( reset->num_mpi_calls == 0 );
+    mpi_calls(&spd, 1);
+
+    /* Stop middle region before the inner one */
+    assert( region_stop(&spd, middle) == DLB_SUCCESS );
+    check_region(middle, 5, num_idle_threads);
+    mpi_calls(&spd, 1);
+    assert( region_stop(&spd, inner) == DLB_SUCCESS );
+    check_region(inner, 3, num_idle_threads);
+    mpi_calls(&spd, 1);
+
+    /* Open regions are up to date after a report or an explicit update */
+    assert( region_report(&spd, outer) == DLB_SUCCESS );
+    assert( outer->num_mpi_calls == 9 );
+    assert( talp_aggregate_samples_to_regions(talp_info) == DLB_SUCCESS );
+    assert( outer->num_mpi_calls == 9 );
+    assert( outer->num_cpus == 1 );
+
+    /* Restart a region */
+    assert( region_start(&spd, middle) == DLB_SUCCESS );
+    mpi_calls(&spd, 2);
+    assert( region_stop(&spd, middle) == DLB_SUCCESS );
+    check_region(middle, 7, num_idle_threads);
+    assert( middle->num_measurements == 2 );
+
+    assert( region_stop(&spd, outer) == DLB_SUCCESS );
+    check_region(outer, 11, num_idle_threads);
+
+    /* Global region includes MPI_Init, and started before the idle threads */
+    dlb_monitor_t *global_monitor = talp_info->monitor;
+    assert( region_stop(&spd, global_monitor) == DLB_SUCCESS );
+    assert( global_monitor->num_mpi_calls == 12 );
+    assert( global_monitor->useful_time + global_monitor->mpi_time
+            == global_monitor->elapsed_time );
+
+    talp_finalize(&spd);
+}
+
+/* Return the average time, in nanoseconds, of starting and stopping a region
+ * while depth regions are open and some worker threads are idle */
+static int64_t time_start_stop(bool lazy, int depth) {
+
+    enum { NUM_ITERS = 10000 };
+
+    subprocess_descriptor_t spd;
+    init_talp(&spd, lazy);
+    add_idle_workers(&spd, NUM_IDLE_THREADS);
+
+    char name[DLB_MONITOR_NAME_MAX];
+    for (int i = 0; i < depth - 1; ++i) {
+        snprintf(name, DLB_MONITOR_NAME_MAX, "level %d", i);
+        region_start(&spd, region_register(&spd, name));
+    }
+    dlb_monitor_t *monitor = region_register(&spd, "fine-grained");
+
+    int64_t start = get_time_in_ns();
+    for (int i = 0; i < NUM_ITERS; ++i) {
+        region_start(&spd, monitor);
+        region_stop(&spd, monitor);
+    }
+    int64_t elapsed = get_time_in_ns() - start;
+
+    talp_finalize(&spd);
+
+    return elapsed / NUM_ITERS;
+}
+
+int main(int argc, char *argv[]) {
+
+    /* The same measurements are obtained in both modes, also when lazy
+     * regions only gather the sample of the main thread */
+    check_nested_regions(false, 0);
+    check_nested_regions(true, 0);
+    check_nested_regions(false, NUM_IDLE_THREADS);
+    check_nested_regions(true, NUM_IDLE_THREADS);
+
+    /* Lazy regions are not compatible with the external profiler */
+    {
+        subprocess_descriptor_t spd;
+        talp_fixture_init(&spd, false, "--talp-lazy-regions --talp-external-profiler");
+        talp_info_t *talp_info = spd.talp_info;
+        assert( !talp_info->flags.lazy_regions );
+        talp_finalize(&spd);
+    }
+
+    /* Per-call overhead with 1, 10 and 100 enclosing open regions, including
+     * the global region, and idle worker threads */
+    if (DLB_EXTRA_TESTS)
+    {
+        printf("%12s %16s %16s\n", "Open regions", "eager (ns)", "lazy (ns)");
+        for (int depth = 1; depth <= 100; depth *= 10) {
+            int64_t eager_time = time_start_stop(false, depth);
+            int64_t lazy_time = time_start_stop(true, depth);
+            printf("%12d %16"PRId64" %16"PRId64"\n", depth, eager_time, lazy_time);
+        }
+    }
+
+    return 0;
+}
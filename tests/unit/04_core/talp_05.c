@@ -0,0 +1,195 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "extra_tests.h"
+#include "talp_fixture.h"
+
+#include "apis/dlb_errors.h"
+#include "talp/perf_metrics.h"
+#include "talp/regions.h"
+#include "talp/sample.h"
+#include "talp/talp_types.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <assert.h>
+
+/* Test TALP statistical sampling mode, and compare the cost of MPI calls in
+ * exact and sampling modes */
+
+enum { SAMPLING_PERIOD_US = 50 };
+enum { SAMPLING_PERIOD_NEVER_US = 100000000 };
+
+static void init_talp(subprocess_descriptor_t *spd, int sampling_period) {
+    talp_fixture_init(spd, true, "--talp-sampling-period=%d", sampling_period);
+
+    talp_info_t *talp_info = spd->talp_info;
+    assert( talp_info->flags.sampling == (sampling_period > 0) );
+    assert( talp_sample_is_sampled(talp_info) == (sampling_period > 0) );
+}
+
+/* Return the average time, in nanoseconds, of an empty MPI call */
+static int64_t time_mpi_call(int sampling_period) {
+
+    enum { NUM_ITERS = 100000 };
+
+    subprocess_descriptor_t spd;
+    init_talp(&spd, sampling_period);
+
+    sync_call_flags_t mpi_flags = { .is_mpi = true };
+    int64_t start = get_time_in_ns();
+    for (int i = 0; i < NUM_ITERS; ++i) {
+        talp_into_sync_call(&spd, mpi_flags);
+        talp_out_of_sync_call(&spd, mpi_flags);
+    }
+    int64_t elapsed = get_time_in_ns() - start;
+
+    talp_finalize(&spd);
+
+    return elapsed / NUM_ITERS;
+}
+
+int main(int argc, char *argv[]) {
+
+    /* One third of the time in MPI, in calls much shorter than the sampling
+     * period: the sampled MPI time is close to the real one */
+    {
+        enum { NUM_CALLS = 2000 };
+        enum { USEFUL_NS = 40000 };
+        enum { MPI_NS = 20000 };
+
+        subprocess_descriptor_t spd;
+        init_talp(&spd, SAMPLING_PERIOD_US);
+
+        dlb_monitor_t *monitor = region_register(&spd, "sampled");
+        assert( region_start(&spd, monitor) == DLB_SUCCESS );
+        sync_call_flags_t mpi_flags = { .is_mpi = true };
+        for (int i = 0; i < NUM_CALLS; ++i) {
+            busy_wait(USEFUL_NS);
+            talp_into_sync_call(&spd, mpi_flags);
+            busy_wait(MPI_NS);
+            talp_out_of_sync_call(&spd, mpi_flags);
+        }
+        assert( region_stop(&spd, monitor) == DLB_SUCCESS );
+
+        /* Event counts and the total time are exact */
+        assert( monitor->num_mpi_calls == NUM_CALLS );
+        assert( monitor->useful_time + monitor->mpi_time == monitor->elapsed_time );
+
+        monitor_data_t *monitor_data = monitor->_data;
+        assert( monitor_data->sampling.num_ticks > 0 );
+        assert( monitor_data->sampling.mpi_time_variance > 0.0 );
+
+        /* The estimate depends on the scheduling of the timer signals, only
+         * check that it is not degenerate */
+        double mpi_fraction = (double)monitor->mpi_time / monitor->elapsed_time;
+        printf("Sampled MPI fraction: %.3f (%"PRId64" samples)\n",
+                mpi_fraction, monitor_data->sampling.num_ticks);
+        assert( mpi_fraction > 0.05 && mpi_fraction < 0.8 );
+
+        /* Reset also discards sampling statistics */
+        assert( region_reset(&spd, monitor) == DLB_SUCCESS );
+        assert( monitor_data->sampling.num_ticks == 0 );
+
+        talp_finalize(&spd);
+
+        /* The previous action is restored after finalization */
+        struct sigaction action;
+        assert( sigaction(SIGPROF, NULL, &action) == 0 );
+        assert( action.sa_handler == SIG_DFL );
+    }
+
+    /* The time is split according to the observed states: with a period that
+     * never expires, observe the states by raising the signal */
+    {
+        subprocess_descriptor_t spd;
+        init_talp(&spd, SAMPLING_PERIOD_NEVER_US);
+
+        dlb_monitor_t *monitor = region_register(&spd, "raised");
+        assert( region_start(&spd, monitor) == DLB_SUCCESS );
+        sync_call_flags_t mpi_flags = { .is_mpi = true };
+        assert( raise(SIGPROF) == 0 );
+        talp_into_sync_call(&spd, mpi_flags);
+        assert( raise(SIGPROF) == 0 );
+        assert( raise(SIGPROF) == 0 );
+        talp_out_of_sync_call(&spd, mpi_flags);
+        assert( region_stop(&spd, monitor) == DLB_SUCCESS );
+
+        /* One useful and two MPI observations, plus the current useful state */
+        monitor_data_t *monitor_data = monitor->_data;
+        assert( monitor_data->sampling.num_ticks == 3 );
+        assert( monitor->mpi_time == monitor->elapsed_time / 2 );
+        assert( monitor->useful_time + monitor->mpi_time == monitor->elapsed_time );
+        assert( region_get_mpi_time_ci(monitor) > 0 );
+
+        /* With one CPU and no OpenMP, the half-width of the parallel and
+         * communication efficiencies is the relative one of the MPI time */
+        talp_info_t *talp_info = spd.talp_info;
+        pop_base_metrics_t base_metrics;
+        pop_metrics_ci_t ci;
+        perf_metrics__local_monitor_into_base_metrics(&base_metrics, monitor,
+                talp_info->flags);
+        perf_metrics__base_to_pop_metrics_ci(&base_metrics, &ci);
+        double expected_ci = (double)region_get_mpi_time_ci(monitor) / monitor->elapsed_time;
+        assert( fabs(ci.parallel_efficiency - expected_ci) < 1e-3 );
+        assert( fabs(ci.mpi_communication_efficiency - expected_ci) < 1e-3 );
+        assert( ci.mpi_load_balance > 0.0f );
+
+        talp_finalize(&spd);
+    }
+
+    /* Without state changes, the sampling mode is exact */
+    {
+        subprocess_descriptor_t spd;
+        init_talp(&spd, SAMPLING_PERIOD_US);
+        dlb_monitor_t *monitor = region_register(&spd, "useful");
+        assert( region_start(&spd, monitor) == DLB_SUCCESS );
+        busy_wait(1000000);
+        assert( region_stop(&spd, monitor) == DLB_SUCCESS );
+        assert( monitor->mpi_time == 0 );
+        assert( monitor->useful_time == monitor->elapsed_time );
+        monitor_data_t *monitor_data = monitor->_data;
+        assert( monitor_data->sampling.mpi_time_variance == 0.0 );
+        talp_info_t *talp_info = spd.talp_info;
+        pop_base_metrics_t base_metrics;
+        pop_metrics_ci_t ci;
+        perf_metrics__local_monitor_into_base_metrics(&base_metrics, monitor,
+                talp_info->flags);
+        perf_metrics__base_to_pop_metrics_ci(&base_metrics, &ci);
+        assert( ci.parallel_efficiency == 0.0f );
+        assert( ci.mpi_load_balance == 0.0f );
+        talp_finalize(&spd);
+    }
+
+    /* Per-call overhead of an MPI call in exact and sampling modes */
+    if (DLB_EXTRA_TESTS)
+    {
+        printf("%16s %16s\n", "Mode", "MPI call (ns)");
+        printf("%16s %16"PRId64"\n", "exact", time_mpi_call(0));
+        printf("%16s %16"PRId64"\n", "sampling", time_mpi_call(SAMPLING_PERIOD_US));
+    }
+
+    return 0;
+}
@@ -0,0 +1,226 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "extra_tests.h"
+#include "talp_fixture.h"
+
+#include "LB_numThreads/omptool.h"
+#include "apis/dlb_errors.h"
+#include "apis/dlb_talp.h"
+#include "talp/regions.h"
+#include "talp/talp_openmp.h"
+#include "talp/talp_types.h"
+#include "talp/talp_writer.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <assert.h>
+
+/* Test the time series of TALP regions */
+
+enum { TIMESERIES_PERIOD_MS = 10 };
+
+static void init_talp(subprocess_descriptor_t *spd, int period, const char *filename) {
+    talp_fixture_init(spd, true, "--talp-timeseries-period=%d --talp-timeseries-file=%s",
+            period, filename);
+
+    talp_info_t *talp_info = spd->talp_info;
+    assert( talp_info->flags.timeseries == (period > 0) );
+}
+
+static int64_t get_field(const char *line, const char *field) {
+    const char *pos = strstr(line, field);
+    assert( pos != NULL );
+    return strtoll(pos + strlen(field), NULL, 10);
+}
+
+/* Return the average time, in nanoseconds, of an empty MPI call */
+static int64_t time_mpi_call(int period, const char *filename) {
+
+    enum { NUM_ITERS = 100000 };
+
+    subprocess_descriptor_t spd;
+    init_talp(&spd, period, filename);
+
+    sync_call_flags_t mpi_flags = { .is_mpi = true };
+    int64_t start = get_time_in_ns();
+    for (int i = 0; i < NUM_ITERS; ++i) {
+        talp_into_sync_call(&spd, mpi_flags);
+        talp_out_of_sync_call(&spd, mpi_flags);
+    }
+    int64_t elapsed = get_time_in_ns() - start;
+
+    talp_finalize(&spd);
+
+    return elapsed / NUM_ITERS;
+}
+
+int main(int argc, char *argv[]) {
+
+    char filename[64];
+    snprintf(filename, sizeof(filename), "/tmp/talp_06_%d.jsonl", getpid());
+
+    /* Several periods of a process with MPI calls and one region */
+    {
+        enum { NUM_ITERS = 10 };
+        enum { USEFUL_NS = 5000000 };
+        enum { MPI_NS = 1000000 };
+
+        subprocess_descriptor_t spd;
+        int64_t start = get_time_in_ns();
+        init_talp(&spd, TIMESERIES_PERIOD_MS, filename);
+
+        dlb_monitor_t *monitor = region_register(&spd, "timeseries");
+        assert( region_start(&spd, monitor) == DLB_SUCCESS );
+        sync_call_flags_t mpi_flags = { .is_mpi = true };
+        for (int i = 0; i < NUM_ITERS; ++i) {
+            busy_wait(USEFUL_NS);
+            talp_into_sync_call(&spd, mpi_flags);
+            busy_wait(MPI_NS);
+            talp_out_of_sync_call(&spd, mpi_flags);
+        }
+        assert( region_stop(&spd, monitor) == DLB_SUCCESS );
+
+        /* The records of each period are written without waiting for
+         * finalization */
+        struct stat file_stat;
+        int64_t timeout = get_time_in_ns() + 1000000000LL;
+        while ((stat(filename, &file_stat) != 0 || file_stat.st_size == 0)
+                && get_time_in_ns() < timeout) {
+            usleep(1000);
+        }
+        assert( file_stat.st_size > 0 );
+
+        talp_finalize(&spd);
+        talp_writer_finalize();
+        int64_t elapsed = get_time_in_ns() - start;
+
+        /* The increments of each region add up to the totals */
+        FILE *file = fopen(filename, "r");
+        assert( file != NULL );
+        char line[2048];
+        int num_global_lines = 0;
+        int num_region_lines = 0;
+        int64_t global_elapsed = 0;
+        int64_t global_mpi_calls = 0;
+        int64_t region_mpi_calls = 0;
+        while (fgets(line, sizeof(line), file) != NULL) {
+            assert( line[0] == '{' && strchr(line, '}') != NULL );
+            if (strstr(line, "\"region\": \""DLB_GLOBAL_REGION_NAME"\"") != NULL) {
+                ++num_global_lines;
+                global_elapsed += get_field(line, "\"elapsedTime\": ");
+                global_mpi_calls += get_field(line, "\"numMpiCalls\": ");
+            } else if (strstr(line, "\"region\": \"timeseries\"") != NULL) {
+                ++num_region_lines;
+                region_mpi_calls += get_field(line, "\"numMpiCalls\": ");
+            }
+        }
+        fclose(file);
+        unlink(filename);
+
+        printf("Global: %d periods, %"PRId64" ns of %"PRId64" ns\n",
+                num_global_lines, global_elapsed, elapsed);
+        assert( num_global_lines >= 2 );
+        assert( num_region_lines >= 2 );
+        assert( global_mpi_calls == NUM_ITERS + 1 );    /* + MPI_Init */
+        assert( region_mpi_calls == NUM_ITERS );
+        assert( global_elapsed <= elapsed );
+        assert( global_elapsed > elapsed * 0.9 );
+    }
+
+    /* Without MPI calls nor regions, periods are checked at the end of the
+     * OpenMP parallel regions. Region names are escaped */
+    {
+        enum { NUM_PARALLELS = 5 };
+        enum { USEFUL_NS = 5000000 };
+
+        subprocess_descriptor_t spd;
+        init_talp(&spd, TIMESERIES_PERIOD_MS, filename);
+        talp_openmp_init(spd.id, &spd.options);
+        talp_openmp_thread_begin(ompt_thread_initial);
+
+        dlb_monitor_t *monitor = region_register(&spd, "quoted \"name\"\\");
+        assert( region_start(&spd, monitor) == DLB_SUCCESS );
+        assert( region_stop(&spd, monitor) == DLB_SUCCESS );
+
+        for (int i = 0; i < NUM_PARALLELS; ++i) {
+            omptool_parallel_data_t parallel_data = {
+                .level = 1,
+                .requested_parallelism = 1,
+                .actual_parallelism = 1,
+            };
+            talp_openmp_parallel_begin(&parallel_data);
+            talp_openmp_into_parallel_function(&parallel_data, 0);
+            busy_wait(USEFUL_NS);
+            talp_openmp_into_parallel_implicit_barrier(&parallel_data);
+            talp_openmp_parallel_end(&parallel_data);
+        }
+
+        talp_openmp_thread_end();
+        talp_openmp_finalize();
+        talp_finalize(&spd);
+        talp_writer_finalize();
+
+        FILE *file = fopen(filename, "r");
+        assert( file != NULL );
+        char line[2048];
+        int num_global_lines = 0;
+        int num_region_lines = 0;
+        while (fgets(line, sizeof(line), file) != NULL) {
+            if (strstr(line, "\"region\": \""DLB_GLOBAL_REGION_NAME"\"") != NULL) {
+                ++num_global_lines;
+            } else if (strstr(line, "\"region\": \"quoted \\\"name\\\"\\\\\"") != NULL) {
+                ++num_region_lines;
+            }
+        }
+        fclose(file);
+        unlink(filename);
+
+        /* More periods than the last one recorded at finalization */
+        assert( num_global_lines >= 2 );
+        assert( num_region_lines == 1 );
+    }
+
+    /* A disabled time series does not create the file */
+    {
+        subprocess_descriptor_t spd;
+        init_talp(&spd, 0, filename);
+        talp_finalize(&spd);
+        assert( access(filename, F_OK) != 0 );
+    }
+
+    /* Per-call overhead of an MPI call with and without the time series */
+    if (DLB_EXTRA_TESTS)
+    {
+        printf("%16s %16s\n", "Time series", "MPI call (ns)");
+        printf("%16s %16"PRId64"\n", "disabled", time_mpi_call(0, filename));
+        printf("%16s %16"PRId64"\n", "enabled", time_mpi_call(TIMESERIES_PERIOD_MS, filename));
+        unlink(filename);
+    }
+
+    return 0;
+}
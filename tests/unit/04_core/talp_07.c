@@ -0,0 +1,161 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "talp_fixture.h"
+
+#include "apis/dlb_errors.h"
+#include "talp/regions.h"
+#include "talp/talp_types.h"
+
+#include <stdio.h>
+#include <assert.h>
+
+/* Test the TALP breakdown of MPI calls by MPI call */
+
+static void init_talp(subprocess_descriptor_t *spd, bool breakdown, bool lazy) {
+    talp_fixture_init(spd, true, "--talp-mpi-breakdown=%s --talp-lazy-regions=%s",
+            breakdown ? "yes" : "no", lazy ? "yes" : "no");
+
+    talp_info_t *talp_info = spd->talp_info;
+    assert( talp_info->flags.mpi_breakdown == breakdown );
+}
+
+/* Slots of the breakdown, as assigned by the MPI hooks on first use */
+enum {
+    SLOT_OTHER,
+    SLOT_SEND,
+    SLOT_ALLREDUCE,
+    SLOT_WAITALL,
+    SLOT_BCAST,
+};
+
+/* Emulate the MPI hooks: the bytes are added after entering the call */
+static void mpi_call(subprocess_descriptor_t *spd, int slot, int64_t bytes) {
+    sync_call_flags_t mpi_flags = { .is_mpi = true, .mpi_call_slot = slot };
+    talp_into_sync_call(spd, mpi_flags);
+    if (bytes > 0) {
+        talp_mpi_add_bytes(spd, slot, bytes);
+    }
+    busy_wait(1000);
+    talp_out_of_sync_call(spd, mpi_flags);
+}
+
+/* Single thread: the time of all MPI calls is the MPI time */
+static void check_breakdown(const dlb_monitor_t *monitor) {
+    const monitor_data_t *monitor_data = monitor->_data;
+    int64_t num_calls = 0;
+    int64_t time = 0;
+    for (int slot = 0; slot < MPI_NUM_CALL_SLOTS; ++slot) {
+        num_calls += monitor_data->mpi_calls[slot].num_calls;
+        time += monitor_data->mpi_calls[slot].time;
+    }
+    assert( num_calls == monitor->num_mpi_calls );
+    assert( time == monitor->mpi_time );
+}
+
+static void check_regions(bool lazy) {
+
+    subprocess_descriptor_t spd;
+    init_talp(&spd, true, lazy);
+
+    dlb_monitor_t *outer = region_register(&spd, "outer");
+    dlb_monitor_t *inner = region_register(&spd, "inner");
+    const monitor_data_t *outer_data = outer->_data;
+    const monitor_data_t *inner_data = inner->_data;
+
+    assert( region_start(&spd, outer) == DLB_SUCCESS );
+    for (int i = 0; i < 3; ++i) {
+        mpi_call(&spd, SLOT_SEND, 100);
+    }
+    assert( region_start(&spd, inner) == DLB_SUCCESS );
+    mpi_call(&spd, SLOT_ALLREDUCE, 8);
+    mpi_call(&spd, SLOT_ALLREDUCE, 8);
+    mpi_call(&spd, SLOT_WAITALL, 0);
+    assert( region_stop(&spd, inner) == DLB_SUCCESS );
+    assert( region_stop(&spd, outer) == DLB_SUCCESS );
+
+    assert( outer_data->mpi_calls[SLOT_SEND].num_calls == 3 );
+    assert( outer_data->mpi_calls[SLOT_SEND].bytes == 300 );
+    assert( outer_data->mpi_calls[SLOT_SEND].time >= 3000 );
+    assert( outer_data->mpi_calls[SLOT_ALLREDUCE].num_calls == 2 );
+    assert( outer_data->mpi_calls[SLOT_ALLREDUCE].bytes == 16 );
+    assert( outer_data->mpi_calls[SLOT_WAITALL].num_calls == 1 );
+    assert( outer_data->mpi_calls[SLOT_WAITALL].bytes == 0 );
+    assert( outer_data->mpi_calls[SLOT_OTHER].num_calls == 0 );
+    check_breakdown(outer);
+
+    assert( inner_data->mpi_calls[SLOT_SEND].num_calls == 0 );
+    assert( inner_data->mpi_calls[SLOT_ALLREDUCE].num_calls == 2 );
+    assert( inner_data->mpi_calls[SLOT_WAITALL].num_calls == 1 );
+    check_breakdown(inner);
+
+    /* Reset also discards the breakdown */
+    assert( region_reset(&spd, outer) == DLB_SUCCESS );
+    assert( outer_data->mpi_calls[SLOT_SEND].num_calls == 0 );
+    assert( outer_data->mpi_calls[SLOT_SEND].bytes == 0 );
+
+    talp_finalize(&spd);
+}
+
+int main(int argc, char *argv[]) {
+
+    /* Breakdown of nested regions, in eager and lazy modes */
+    check_regions(false);
+    check_regions(true);
+
+    /* Thread-local regions use the same breakdown */
+    {
+        subprocess_descriptor_t spd;
+        init_talp(&spd, true, false);
+        dlb_monitor_t *monitor = region_register(&spd, "local");
+        thread_ctx_set_main(THREAD_MAIN_PARALLEL);
+        assert( region_start(&spd, monitor) == DLB_SUCCESS );
+        mpi_call(&spd, SLOT_BCAST, 64);
+        assert( region_stop(&spd, monitor) == DLB_SUCCESS );
+        thread_ctx_set_main(THREAD_MAIN_SEQUENTIAL);
+        const monitor_data_t *monitor_data = monitor->_data;
+        assert( monitor_data->mpi_calls[SLOT_BCAST].num_calls == 1 );
+        assert( monitor_data->mpi_calls[SLOT_BCAST].bytes == 64 );
+        check_breakdown(monitor);
+        talp_finalize(&spd);
+    }
+
+    /* Without the option, only the total number of MPI calls is counted */
+    {
+        subprocess_descriptor_t spd;
+        init_talp(&spd, false, false);
+        dlb_monitor_t *monitor = region_register(&spd, "disabled");
+        assert( region_start(&spd, monitor) == DLB_SUCCESS );
+        mpi_call(&spd, SLOT_SEND, 100);
+        assert( region_stop(&spd, monitor) == DLB_SUCCESS );
+        assert( monitor->num_mpi_calls == 1 );
+        const monitor_data_t *monitor_data = monitor->_data;
+        for (int slot = 0; slot < MPI_NUM_CALL_SLOTS; ++slot) {
+            assert( monitor_data->mpi_calls[slot].num_calls == 0 );
+            assert( monitor_data->mpi_calls[slot].bytes == 0 );
+        }
+        talp_finalize(&spd);
+    }
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "talp_fixture.h"
+
+#include "LB_numThreads/omptool.h"
+#include "LB_numThreads/omp-tools.h"
+#include "apis/dlb_errors.h"
+#include "support/gtree.h"
+#include "talp/auto_regions.h"
+#include "talp/regions.h"
+#include "talp/talp_openmp.h"
+#include "talp/talp_types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* Test TALP automatic regions of OpenMP parallel constructs */
+
+static void run_parallel(const void *codeptr_ra) {
+    omptool_parallel_data_t parallel_data = {
+        .level = 1,
+        .codeptr_ra = codeptr_ra,
+        .requested_parallelism = 1,
+        .actual_parallelism = 1,
+    };
+    talp_openmp_parallel_begin(&parallel_data);
+    talp_openmp_into_parallel_function(&parallel_data, 0);
+    talp_openmp_into_parallel_implicit_barrier(&parallel_data);
+    talp_openmp_parallel_end(&parallel_data);
+}
+
+static void init(subprocess_descriptor_t *spd, const char *talp_options) {
+    talp_fixture_init(spd, false, "%s", talp_options);
+    talp_openmp_init(spd->id, &spd->options);
+    talp_openmp_thread_begin(ompt_thread_initial);
+}
+
+int main(int argc, char *argv[]) {
+
+    /* Code addresses of two parallel constructs: one in an exported
+     * function, so that it can be symbolized, and one in this executable */
+    const void *codeptr_a = (const char*)&qsort + 1;
+    const void *codeptr_b = (const char*)&main + 2;
+
+    /* Automatic regions enabled */
+    {
+        subprocess_descriptor_t spd;
+        init(&spd, "--talp-openmp-auto-regions");
+        talp_info_t *talp_info = spd.talp_info;
+        assert( g_tree_nnodes(talp_info->regions) == 1 );
+
+        run_parallel(codeptr_a);
+        run_parallel(codeptr_b);
+        run_parallel(codeptr_a);
+
+        /* Parallel constructs without code address do not create regions */
+        run_parallel(NULL);
+        assert( g_tree_nnodes(talp_info->regions) == 3 );
+
+        dlb_monitor_t *monitor_a = auto_region_get(&spd, AUTO_REGION_OPENMP, codeptr_a);
+        dlb_monitor_t *monitor_b = auto_region_get(&spd, AUTO_REGION_OPENMP, codeptr_b);
+        assert( monitor_a != NULL && monitor_b != NULL && monitor_a != monitor_b );
+        assert( strncmp(monitor_a->name, "OpenMP parallel ", 16) == 0 );
+        assert( strncmp(monitor_b->name, "OpenMP parallel ", 16) == 0 );
+        assert( region_register(&spd, monitor_a->name) == monitor_a );
+        assert( !region_is_started(monitor_a) );
+        assert( !region_is_started(monitor_b) );
+
+        assert( talp_aggregate_samples_to_regions(talp_info) == DLB_SUCCESS );
+        assert( monitor_a->num_measurements == 2 );
+        assert( monitor_a->num_omp_parallels == 2 );
+        assert( monitor_b->num_measurements == 1 );
+        assert( monitor_b->num_omp_parallels == 1 );
+        assert( talp_info->monitor->num_omp_parallels == 4 );
+        assert( monitor_a->elapsed_time > 0 );
+
+        /* Symbolization renames the region, which can still be found by name.
+         * The previous name is not modified, since others may be reading it */
+        char location_a[DLB_MONITOR_NAME_MAX];
+        snprintf(location_a, sizeof(location_a), "%s", monitor_a->name);
+        const char *previous_name_a = monitor_a->name;
+        auto_regions_symbolize(&spd);
+        assert( monitor_a->name != previous_name_a );
+        assert( strcmp(previous_name_a, location_a) == 0 );
+        assert( strncmp(monitor_a->name, "OpenMP parallel ", 16) == 0 );
+        assert( strstr(monitor_a->name, "+0x1") != NULL );
+        assert( region_register(&spd, monitor_a->name) == monitor_a );
+        assert( region_register(&spd, monitor_b->name) == monitor_b );
+        assert( g_tree_nnodes(talp_info->regions) == 3 );
+
+        /* Global region cannot be renamed */
+        assert( region_rename(&spd, talp_info->monitor, "Foo") == DLB_NOUPDT );
+
+        talp_openmp_thread_end();
+        talp_openmp_finalize();
+        talp_finalize(&spd);
+
+        /* Caches are invalidated after finalization */
+        init(&spd, "--talp-openmp-auto-regions");
+        talp_info = spd.talp_info;
+        run_parallel(codeptr_a);
+        monitor_a = auto_region_get(&spd, AUTO_REGION_OPENMP, codeptr_a);
+        assert( g_tree_nnodes(talp_info->regions) == 2 );
+        assert( region_register(&spd, monitor_a->name) == monitor_a );
+        assert( talp_aggregate_samples_to_regions(talp_info) == DLB_SUCCESS );
+        assert( monitor_a->num_measurements == 1 );
+
+        talp_openmp_thread_end();
+        talp_openmp_finalize();
+        talp_finalize(&spd);
+    }
+
+    /* Automatic regions disabled */
+    {
+        subprocess_descriptor_t spd;
+        init(&spd, "");
+        talp_info_t *talp_info = spd.talp_info;
+
+        run_parallel(codeptr_a);
+        assert( g_tree_nnodes(talp_info->regions) == 1 );
+
+        talp_openmp_thread_end();
+        talp_openmp_finalize();
+        talp_finalize(&spd);
+    }
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+/*<testinfo>
+    test_generator="gens/basic-generator"
+</testinfo>*/
+
+#include "extra_tests.h"
+#include "talp_fixture.h"
+
+#include "apis/dlb_errors.h"
+#include "support/gtree.h"
+#include "talp/auto_regions.h"
+#include "talp/regions.h"
+#include "talp/talp_types.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+/* Test TALP automatic regions of MPI call sites, and compare the cost of an
+ * MPI call with and without them */
+
+enum { USLEEP_TIME = 1000 };
+
+/* Simulate an MPI call at call_site, as done by the MPI interception */
+static void mpi_call(const subprocess_descriptor_t *spd, const void *call_site) {
+    sync_call_flags_t mpi_flags = { .is_mpi = true };
+    talp_mpi_auto_region_stop(spd);
+    talp_into_sync_call(spd, mpi_flags);
+    usleep(USLEEP_TIME);
+    talp_out_of_sync_call(spd, mpi_flags);
+    talp_mpi_auto_region_start(spd, call_site);
+}
+
+/* Average cost in ns of the TALP hooks of an MPI call, where each call
+ * stops and starts a region if auto_regions */
+static int64_t time_mpi_calls(bool auto_regions) {
+    enum { NUM_ITERS = 100000 };
+
+    subprocess_descriptor_t spd;
+    talp_fixture_init(&spd, true, "--talp-mpi-auto-regions=%s", auto_regions ? "yes" : "no");
+
+    const void *call_site = (const char*)&qsort + 1;
+    sync_call_flags_t mpi_flags = { .is_mpi = true };
+    int64_t start = get_time_in_ns();
+    for (int i = 0; i < NUM_ITERS; ++i) {
+        talp_mpi_auto_region_stop(&spd);
+        talp_into_sync_call(&spd, mpi_flags);
+        talp_out_of_sync_call(&spd, mpi_flags);
+        talp_mpi_auto_region_start(&spd, call_site);
+    }
+    int64_t elapsed = get_time_in_ns() - start;
+
+    talp_mpi_finalize(&spd);
+    talp_finalize(&spd);
+
+    return elapsed / NUM_ITERS;
+}
+
+int main(int argc, char *argv[]) {
+
+    /* Return addresses of four MPI call sites */
+    const void *call_site_a = (const char*)&qsort + 1;
+    const void *call_site_b = (const char*)&qsort + 2;
+    const void *call_site_c = (const char*)&main + 1;
+    const void *call_site_d = (const char*)&main + 2;
+
+    /* Automatic regions enabled, at most 2 regions */
+    {
+        subprocess_descriptor_t spd;
+        talp_fixture_init(&spd, true, "--talp-mpi-auto-regions --talp-auto-regions-max=2");
+        talp_info_t *talp_info = spd.talp_info;
+
+        /* A -> B -> C (overflow) -> D (overflow) -> A -> unknown call site */
+        mpi_call(&spd, call_site_a);
+        usleep(USLEEP_TIME);
+        mpi_call(&spd, call_site_b);
+        usleep(USLEEP_TIME);
+        mpi_call(&spd, call_site_c);
+        usleep(USLEEP_TIME);
+        mpi_call(&spd, call_site_d);
+        usleep(USLEEP_TIME);
+        mpi_call(&spd, call_site_a);
+        usleep(USLEEP_TIME);
+        mpi_call(&spd, NULL);
+        assert( talp_info->mpi_auto_region == NULL );
+
+        /* Global, A, B and overflow */
+        assert( g_tree_nnodes(talp_info->regions) == 4 );
+
+        dlb_monitor_t *monitor_a = auto_region_get(&spd, AUTO_REGION_MPI, call_site_a);
+        dlb_monitor_t *monitor_b = auto_region_get(&spd, AUTO_REGION_MPI, call_site_b);
+        dlb_monitor_t *overflow = auto_region_get(&spd, AUTO_REGION_MPI, call_site_c);
+        assert( auto_region_get(&spd, AUTO_REGION_MPI, call_site_d) == overflow );
+        assert( monitor_a != monitor_b && monitor_a != overflow && monitor_b != overflow );
+        assert( strncmp(monitor_a->name, "After MPI call ", 15) == 0 );
+        assert( strcmp(overflow->name, "After MPI call overflow") == 0 );
+
+        /* Regions measure the code between MPI calls, without MPI time */
+        assert( talp_aggregate_samples_to_regions(talp_info) == DLB_SUCCESS );
+        assert( monitor_a->num_measurements == 2 );
+        assert( monitor_b->num_measurements == 1 );
+        assert( overflow->num_measurements == 2 );
+        assert( monitor_a->useful_time >= 2 * USLEEP_TIME * 1000 );
+        assert( monitor_a->mpi_time == 0 );
+        assert( overflow->mpi_time == 0 );
+        assert( talp_info->monitor->mpi_time >= 6 * USLEEP_TIME * 1000 );
+
+        /* Symbolization renames regions but not the overflow one */
+        auto_regions_symbolize(&spd);
+        assert( strstr(monitor_a->name, "+0x1") != NULL );
+        assert( strcmp(overflow->name, "After MPI call overflow") == 0 );
+        assert( region_register(&spd, monitor_a->name) == monitor_a );
+
+        /* The region after the last call site is stopped on MPI_Finalize */
+        mpi_call(&spd, call_site_b);
+        assert( region_is_started(monitor_b) );
+        talp_mpi_finalize(&spd);
+        assert( !region_is_started(monitor_b) );
+        assert( talp_info->mpi_auto_region == NULL );
+
+        talp_finalize(&spd);
+    }
+
+    /* Automatic regions disabled */
+    {
+        subprocess_descriptor_t spd;
+        talp_fixture_init(&spd, true, "--talp-mpi-auto-regions=no");
+        talp_info_t *talp_info = spd.talp_info;
+
+        mpi_call(&spd, call_site_a);
+        assert( talp_info->mpi_auto_region == NULL );
+        assert( g_tree_nnodes(talp_info->regions) == 1 );
+
+        talp_mpi_finalize(&spd);
+        talp_finalize(&spd);
+    }
+
+    /* Per-call overhead: with automatic regions, every MPI call stops and
+     * starts a region, and each one aggregates the samples of all threads */
+    if (DLB_EXTRA_TESTS)
+    {
+        printf("%18s %18s\n", "no regions (ns)", "auto regions (ns)");
+        printf("%18"PRId64" %18"PRId64"\n", time_mpi_calls(false),
+                time_mpi_calls(true));
+    }
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*********************************************************************************/
+/*  Copyright 2009-2026 Barcelona Supercomputing Center                          */
+/*                                                                               */
+/*  This file is part of the DLB library.                                        */
+/*                                                                               */
+/*  DLB is free software: you can redistribute it and/or modify                  */
+/*  it under the terms of the GNU Lesser General Public License as published by  */
+/*  the Free Software Foundation, either version 3 of the License, or            */
+/*  (at your option) any later version.                                          */
+/*                                                                               */
+/*  DLB is distributed in the hope that it will be useful,                       */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*  GNU Lesser General Public License for more details.                          */
+/*                                                                               */
+/*  You should have received a copy of the GNU Lesser General Public License     */
+/*  along with DLB.  If not, see <https://www.gnu.org/licenses/>.                */
+/*********************************************************************************/
+
+#ifndef TALP_FIXTURE_H
+#define TALP_FIXTURE_H
+
+#include "unique_shmem.h"
+
+#include "LB_core/spd.h"
+#include "LB_core/thread_ctx.h"
+#include "support/mytime.h"
+#include "support/options.h"
+#include "talp/talp.h"
+#include "talp/talp_mpi.h"
+
+#include <sched.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+
+/* Initialize TALP in a single-threaded process pinned to the current CPU, with
+ * the TALP options given as a printf format. If mpi, TALP is also initialized
+ * as if MPI_Init had been called */
+__attribute__((format(printf, 3, 4)))
+static inline void talp_fixture_init(subprocess_descriptor_t *spd, bool mpi,
+        const char *talp_options_fmt, ...) {
+
+    *spd = (const subprocess_descriptor_t) {.id = 111};
+    CPU_ZERO(&spd->process_mask);
+    CPU_SET(sched_getcpu(), &spd->process_mask);
+
+    char options[256];
+    va_list args;
+    va_start(args, talp_options_fmt);
+    int len = vsnprintf(options, sizeof(options), talp_options_fmt, args);
+    va_end(args);
+    assert( len >= 0 && (size_t)len < sizeof(options) );
+    snprintf(&options[len], sizeof(options) - len, " --shm-key=%s", SHMEM_KEY);
+    options_init(&spd->options, options);
+
+    spd_enter_dlb(spd);
+    thread_ctx_set_main(THREAD_MAIN_SEQUENTIAL);
+    talp_init(spd);
+    if (mpi) {
+        talp_mpi_init(spd);
+    }
+}
+
+/* Spin for ns nanoseconds, so that the time is accounted as useful */
+static inline void busy_wait(int64_t ns) {
+    int64_t end = get_time_in_ns() + ns;
+    while (get_time_in_ns() < end);
+}
+
+#endif /* TALP_FIXTURE_H */